@@ -0,0 +1,247 @@
+#include "Benchmark.h"
+
+#include "Compression.h"
+#include "Message.h"
+#include "PositionCodec.h"
+
+#include <string>
+#include <vector>
+
+namespace Bench
+{
+namespace
+{
+void PositionCodecBenchmarks(Runner& runner)
+{
+    using namespace Common;
+
+    // Encoded sizes for a few board sizes, compared with the 8 bytes of a
+    // raw Position.
+    const std::pair<uint32_t, uint32_t> boards[] = {
+        { 64, 64 },
+        { 1024, 1024 },
+        { 100000, 100000 },
+    };
+
+    for (auto [width, height] : boards)
+    {
+        PositionCodec codec(width, height);
+        const std::string prefix = "PositionCodec/" + std::to_string(width)
+            + "x" + std::to_string(height);
+
+        runner.AddCounter(prefix + "/PositionBits", codec.GetPositionBits(), "bits");
+        runner.AddCounter(prefix + "/DeltaBits", codec.GetDeltaBits(), "bits");
+        runner.AddCounter(prefix + "/DeltaFallbackBits", codec.GetDeltaFallbackBits(), "bits");
+        runner.AddCounter(prefix + "/Encoded64Positions", double(codec.GetEncodedSize(64)), "bytes");
+    }
+
+    PositionCodec codec(64, 64);
+
+    // Positions of a player walking around the board, one cell per step
+    constexpr size_t kCount = 256;
+    std::vector<Position> positions;
+    {
+        Position pos(32, 32);
+        uint32_t seed = 7;
+        for (size_t i = 0; i < kCount; ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            switch ((seed >> 16) & 3)
+            {
+            case 0: pos.x = pos.x > 0 ? pos.x - 1 : pos.x; break;
+            case 1: pos.x = pos.x < 63 ? pos.x + 1 : pos.x; break;
+            case 2: pos.y = pos.y > 0 ? pos.y - 1 : pos.y; break;
+            case 3: pos.y = pos.y < 63 ? pos.y + 1 : pos.y; break;
+            }
+            positions.push_back(pos);
+        }
+    }
+
+    std::vector<uint8_t> buffer(kCount * 8);
+    Span<uint8_t> output{ buffer.data(), buffer.size() };
+    Span<const uint8_t> input{ buffer.data(), buffer.size() };
+
+    runner.RunBatch("PositionCodec/Encode", 2, kCount, [&]
+    {
+        BitWriter writer(output);
+        for (const Position& pos : positions)
+        {
+            codec.Encode(writer, pos);
+        }
+        DoNotOptimize(buffer[0]);
+    });
+
+    runner.RunBatch("PositionCodec/Decode", 2, kCount, [&]
+    {
+        BitReader reader(input);
+        Position pos;
+        for (size_t i = 0; i < kCount; ++i)
+        {
+            codec.Decode(reader, pos);
+        }
+        DoNotOptimize(pos);
+    });
+
+    size_t deltaBytes = 0;
+
+    runner.RunBatch("PositionCodec/EncodeDelta", 2, kCount, [&]
+    {
+        BitWriter writer(output);
+        Position previous;
+        for (const Position& pos : positions)
+        {
+            codec.EncodeDelta(writer, previous, pos);
+            previous = pos;
+        }
+        deltaBytes = writer.Size();
+        DoNotOptimize(buffer[0]);
+    });
+
+    runner.RunBatch("PositionCodec/DecodeDelta", 2, kCount, [&]
+    {
+        BitReader reader(input);
+        Position previous;
+        Position pos;
+        for (size_t i = 0; i < kCount; ++i)
+        {
+            codec.DecodeDelta(reader, previous, pos);
+            previous = pos;
+        }
+        DoNotOptimize(pos);
+    });
+
+    runner.AddCounter("PositionCodec/64x64/Walk256/Raw", double(kCount * sizeof(Position)), "bytes");
+    runner.AddCounter("PositionCodec/64x64/Walk256/Absolute", double(codec.GetEncodedSize(kCount)), "bytes");
+    runner.AddCounter("PositionCodec/64x64/Walk256/Delta", double(deltaBytes), "bytes");
+}
+
+// Stream of serialized messages as they would arrive at the server from
+// eight clients pinging, with the occasional login.
+std::vector<std::vector<uint8_t>> SampleTraffic()
+{
+    using namespace Common;
+
+    std::vector<std::vector<uint8_t>> messages;
+
+    for (uint32_t i = 0; i < 1024; ++i)
+    {
+        NetworkBuffer buffer;
+        Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+        size_t size = 0;
+
+        if (i % 64 == 0)
+        {
+            LoginMessage login;
+            login.message.messageId = i / 8;
+            login.session = i % 8 + 1;
+            login.address[0] = 127;
+            login.address[3] = 1;
+            login.port = uint16_t(8081 + i % 8);
+            size = Serializer<LoginMessage>::Serialize(login, data);
+        }
+        else if (i % 2)
+        {
+            PingMessage ping;
+            ping.message.messageId = i / 8;
+            ping.playerId = i % 8 + 1;
+            ping.messageId = i / 16;
+            size = Serializer<PingMessage>::Serialize(ping, data);
+        }
+        else
+        {
+            AcknowledgeMessage ack;
+            ack.message.messageId = i / 8;
+            ack.messageId = i / 16;
+            size = Serializer<AcknowledgeMessage>::Serialize(ack, data);
+        }
+
+        messages.emplace_back(buffer.Data(), buffer.Data() + size);
+    }
+
+    return messages;
+}
+
+void CompressionBenchmarks(Runner& runner)
+{
+    using namespace Common;
+
+    std::vector<std::vector<uint8_t>> messages = SampleTraffic();
+
+    // Per message compression as CompressMessage() would be used today
+    size_t original = 0;
+    size_t compressed = 0;
+    size_t shrunk = 0;
+    {
+        NetworkBuffer output;
+        for (const auto& message : messages)
+        {
+            size_t size = CompressMessage(
+                { message.data(), message.size() },
+                { output.Data(), output.Capacity() });
+
+            original += message.size();
+            compressed += size ? size : message.size();
+            shrunk += size ? 1 : 0;
+        }
+    }
+
+    runner.AddCounter("Compression/Messages/Ratio", double(compressed) / double(original), "ratio");
+    runner.AddCounter("Compression/Messages/Compressed", double(shrunk), "messages");
+    runner.AddCounter("Compression/Messages/Total", double(messages.size()), "messages");
+
+    // The message payloads concatenated into one block, close to what a
+    // large snapshot looks like.
+    std::vector<uint8_t> block;
+    for (const auto& message : messages)
+    {
+        block.insert(block.end(), message.begin() + kMessageHeaderSize, message.end());
+        if (block.size() >= 4 * kNetworkBufferSize)
+        {
+            break;
+        }
+    }
+
+    std::vector<uint8_t> packed(block.size() * 2);
+    std::vector<uint8_t> unpacked(block.size());
+
+    const size_t packedSize = LzCompress(
+        { block.data(), block.size() },
+        { packed.data(), packed.size() });
+
+    runner.AddCounter("Compression/Block/Ratio", double(packedSize) / double(block.size()), "ratio");
+
+    runner.Run("LzCompress/Block", block.size(), [&]
+    {
+        size_t size = LzCompress(
+            { block.data(), block.size() },
+            { packed.data(), packed.size() });
+        DoNotOptimize(size);
+    });
+
+    runner.Run("LzDecompress/Block", block.size(), [&]
+    {
+        size_t size = LzDecompress(
+            { packed.data(), packedSize },
+            { unpacked.data(), unpacked.size() });
+        DoNotOptimize(size);
+    });
+
+    const std::vector<uint8_t>& login = messages.front();
+    NetworkBuffer output;
+
+    runner.Run("CompressMessage/LoginMessage", login.size(), [&]
+    {
+        size_t size = CompressMessage(
+            { login.data(), login.size() },
+            { output.Data(), output.Capacity() });
+        DoNotOptimize(size);
+    });
+}
+}
+
+void CodecBenchmarks(Runner& runner)
+{
+    PositionCodecBenchmarks(runner);
+    CompressionBenchmarks(runner);
+}
+}
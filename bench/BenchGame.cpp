@@ -0,0 +1,307 @@
+#include "Benchmark.h"
+
+#include "Game.h"
+#include "Interest.h"
+#include "Network.h"
+#include "Serializer.h"
+#include "TimingWheel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Bench
+{
+namespace
+{
+// Game with no-op handlers so only the event queue and player table are
+// measured
+class BenchGame final : public Common::Game
+{
+public:
+    BenchGame(Common::Game::Params params)
+        : Game(params)
+    { }
+
+    using Game::CreatePlayer;
+    using Game::GetPlayers;
+    using Game::PlacePlayer;
+    using Game::QueueMove;
+    using Game::FindFreePosition;
+    using Game::GetMovement;
+
+    uint64_t handled{ 0 };
+
+protected:
+    void HandleLogin(LoginEvent*) override { ++handled; }
+    void HandlePing(PingEvent*) override { ++handled; }
+    void HandleAcknowledge(AcknowledgeEvent*) override { ++handled; }
+    void HandleState(StateEvent*) override { ++handled; }
+    void HandleMove(MoveEvent*) override { ++handled; }
+};
+}
+
+void GameBenchmarks(Runner& runner)
+{
+    using namespace Common;
+
+    Game::Params params;
+    BenchGame game(params);
+
+    NetworkMessage msg;
+    msg.address = "127.0.0.1";
+    msg.port = 8081;
+    {
+        PingMessage ping;
+        ping.message.messageId = 1;
+        ping.playerId = 1;
+        ping.messageId = 1;
+
+        Span<uint8_t> data{ msg.buffer.Data(), msg.buffer.Capacity() };
+        msg.buffer.SetOffset(Serializer<PingMessage>::Serialize(ping, data));
+    }
+
+    // A tick worth of pings queued and then dispatched
+    constexpr uint64_t kEventsPerTick = 256;
+
+    runner.RunBatch("Game/QueueAndTick/Ping", msg.buffer.Size(), kEventsPerTick, [&]
+    {
+        for (uint64_t i = 0; i < kEventsPerTick; ++i)
+        {
+            game.OnMessage(Action::Ping, msg);
+        }
+        game.Tick();
+    });
+
+    DoNotOptimize(game.handled);
+
+    // Board storage for a very large map with a cluster of players
+    {
+        Game::Params gridParams;
+        gridParams.width = 100000;
+        gridParams.height = 100000;
+        gridParams.gridBackend = WorldGrid::Backend::Chunked;
+
+        WorldGrid grid(gridParams.width, gridParams.height, gridParams.gridBackend);
+        Player player;
+
+        for (uint32_t i = 0; i < 1024; ++i)
+        {
+            grid.SetPlayer(50000 + (i * 37) % 512, 50000 + (i * 101) % 512, &player);
+        }
+
+        // Players moving around inside the occupied area
+        runner.RunBatch("Game/WorldGrid/Chunked/SetPlayer", 0, 1024, [&]
+        {
+            for (uint32_t i = 0; i < 1024; ++i)
+            {
+                const uint32_t x = 50000 + (i * 53) % 512;
+                const uint32_t y = 50000 + (i * 29) % 512;
+                grid.SetPlayer(x, y, &player);
+                DoNotOptimize(grid.GetPlayer(x + 1, y));
+            }
+        });
+
+        runner.AddCounter("Game/WorldGrid/Chunked/100000x100000/Memory",
+            double(grid.GetMemoryUsage()), "bytes");
+        runner.AddCounter("Game/WorldGrid/Dense/100000x100000/Memory",
+            double(uint64_t(gridParams.width) * gridParams.height * sizeof(PositionState)),
+            "bytes");
+    }
+
+    // Distinct endpoints spread over addresses and ports like real clients
+    constexpr uint32_t kMaxLogins = 100000;
+
+    std::vector<std::string> addresses;
+    addresses.reserve(kMaxLogins);
+    for (uint32_t i = 0; i < kMaxLogins; ++i)
+    {
+        addresses.push_back("10." + std::to_string((i >> 16) & 0xff) + '.'
+            + std::to_string((i >> 8) & 0xff) + '.' + std::to_string(i & 0xff));
+    }
+
+    auto Port = [](uint32_t i) { return 1024 + (i * 7919) % 60000; };
+
+    // Per-login cost should stay flat as the player count grows
+    for (uint32_t count : { 1000u, 10000u, 100000u })
+    {
+        Game::Params loginParams;
+        loginParams.maxPlayers = count;
+
+        runner.RunBatch("Game/CreatePlayer/" + std::to_string(count), 0, count, [&]
+        {
+            BenchGame loginGame(loginParams);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                DoNotOptimize(loginGame.CreatePlayer(addresses[i], Port(i)));
+            }
+        });
+    }
+
+    // Retried logins from endpoints which are already players
+    {
+        Game::Params loginParams;
+        loginParams.maxPlayers = kMaxLogins;
+
+        BenchGame loginGame(loginParams);
+        for (uint32_t i = 0; i < kMaxLogins; ++i)
+        {
+            loginGame.CreatePlayer(addresses[i], Port(i));
+        }
+
+        runner.RunBatch("Game/CreatePlayer/Relogin/100000", 0, kMaxLogins, [&]
+        {
+            for (uint32_t i = 0; i < kMaxLogins; ++i)
+            {
+                DoNotOptimize(loginGame.CreatePlayer(addresses[i], Port(i)));
+            }
+        });
+
+        // Per-tick style sweep reading one hot field of every player
+        const PlayerTable& players = loginGame.GetPlayers();
+        const auto deadline = std::chrono::steady_clock::now();
+
+        runner.RunBatch("Game/PlayerSweep/LastMessage/100000",
+            sizeof(std::chrono::steady_clock::time_point), players.Size(), [&]
+        {
+            Span<const std::chrono::steady_clock::time_point> times
+                = players.GetLastMessages();
+
+            size_t stale = 0;
+            for (size_t i = 0; i < times.size; ++i)
+            {
+                stale += times.data[i] < deadline;
+            }
+            DoNotOptimize(stale);
+        });
+    }
+
+    // Interest sets for a crowd of players spread over a large board
+    {
+        constexpr uint32_t kPlayers = 10000;
+        constexpr uint32_t kSize = 2048;
+        constexpr uint32_t kRadius = 16;
+
+        InterestManager interest(kRadius);
+        std::vector<Position> positions(kPlayers);
+
+        uint32_t seed = 1;
+        auto Random = [&seed](uint32_t range)
+        {
+            seed = seed * 1103515245 + 12345;
+            return (seed >> 8) % range;
+        };
+
+        for (uint32_t id = 0; id < kPlayers; ++id)
+        {
+            positions[id] = Position(Random(kSize), Random(kSize));
+            interest.Update(id, positions[id]);
+        }
+
+        // One step per player per tick, as the movement system would do
+        runner.RunBatch("Game/Interest/Move/10000", 0, kPlayers, [&]
+        {
+            for (uint32_t id = 0; id < kPlayers; ++id)
+            {
+                Position& pos = positions[id];
+                pos.x = std::min(kSize - 1, pos.x + Random(3) - std::min(pos.x, 1u));
+                pos.y = std::min(kSize - 1, pos.y + Random(3) - std::min(pos.y, 1u));
+                interest.Update(id, pos);
+            }
+        });
+
+        const PositionCodec codec(kSize, kSize);
+        uint64_t visible = 0;
+        uint64_t sent = 0;
+        for (uint32_t id = 0; id < kPlayers; ++id)
+        {
+            const size_t count = interest.GetVisible(id).size;
+            visible += count;
+            sent += GetStateMessageBytes(count + 1, codec);
+        }
+
+        const uint64_t broadcast = uint64_t(kPlayers) * GetStateMessageBytes(kPlayers, codec);
+
+        runner.AddCounter("Game/Interest/10000/VisiblePerClient",
+            double(visible) / kPlayers, "players");
+        runner.AddCounter("Game/Interest/10000/BytesPerTick",
+            double(sent), "bytes");
+        runner.AddCounter("Game/Interest/10000/BroadcastBytesPerTick",
+            double(broadcast), "bytes");
+    }
+
+    // Player timeouts pushed back by traffic, then a tick's worth of time
+    // passing with nothing due
+    {
+        constexpr uint32_t kPlayers = 100000;
+        constexpr uint64_t kTimeout = 10000;
+
+        TimingWheel wheel;
+        std::vector<TimerHandle> timeouts;
+        timeouts.reserve(kPlayers);
+
+        for (uint32_t i = 0; i < kPlayers; ++i)
+        {
+            timeouts.push_back(wheel.Schedule(kTimeout + i % 1000, { 0, i }));
+        }
+
+        uint64_t now = 0;
+        runner.RunBatch("Game/TimingWheel/Reschedule/100000", 0, kPlayers, [&]
+        {
+            for (uint32_t i = 0; i < kPlayers; ++i)
+            {
+                wheel.Reschedule(timeouts[i], now + kTimeout + i % 1000);
+            }
+        });
+
+        runner.Run("Game/TimingWheel/AdvanceTick/100000", 0, [&]
+        {
+            now += 30;
+            DoNotOptimize(wheel.Advance(now).size);
+            for (uint32_t i = 0; i < kPlayers; i += 1000)
+            {
+                wheel.Reschedule(timeouts[i], now + kTimeout);
+            }
+        });
+    }
+
+    // A full tick of movement: every player sends one step
+    {
+        constexpr uint32_t kPlayers = 10000;
+
+        Game::Params moveParams;
+        moveParams.width = 1024;
+        moveParams.height = 1024;
+        moveParams.maxPlayers = kPlayers;
+
+        BenchGame moveGame(moveParams);
+        std::vector<PlayerHandle> handles;
+
+        for (uint32_t id = 1; id <= kPlayers; ++id)
+        {
+            PlayerHandle handle = moveGame.CreatePlayer(id);
+            Position pos;
+            moveGame.FindFreePosition(id, pos);
+            moveGame.PlacePlayer(handle, pos);
+            handles.push_back(handle);
+        }
+
+        uint32_t seed = 5;
+        runner.RunBatch("Game/Movement/Tick/10000", 0, kPlayers, [&]
+        {
+            for (PlayerHandle handle : handles)
+            {
+                seed = seed * 1103515245 + 12345;
+                moveGame.QueueMove(handle, Movement((seed >> 8) & 3));
+            }
+            moveGame.Tick();
+        });
+
+        const MovementSystem::Stats& stats = moveGame.GetMovement().GetStats();
+        runner.AddCounter("Game/Movement/Tick/10000/Accepted",
+            stats.requested ? 100.0 * double(stats.accepted) / double(stats.requested) : 0,
+            "%");
+    }
+}
+}
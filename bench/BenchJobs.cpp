@@ -0,0 +1,182 @@
+#include "Benchmark.h"
+
+#include "Game.h"
+#include "JobSystem.h"
+#include "Network.h"
+#include "Serializer.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Bench
+{
+namespace
+{
+// Game with a crowd of players, exposing what a replication job reads
+class CrowdGame final : public Common::Game
+{
+public:
+    CrowdGame(Common::Game::Params params)
+        : Game(params)
+    { }
+
+    using Game::CreatePlayer;
+    using Game::FindFreePosition;
+    using Game::GetInterest;
+    using Game::GetPlayers;
+    using Game::PlacePlayer;
+
+protected:
+    void HandleLogin(LoginEvent*) override { }
+    void HandlePing(PingEvent*) override { }
+    void HandleAcknowledge(AcknowledgeEvent*) override { }
+    void HandleState(StateEvent*) override { }
+    void HandleMove(MoveEvent*) override { }
+};
+
+struct JobScratch
+{
+    Common::NetworkBuffer buffer;
+    Common::StateMessage state;
+    uint32_t checksum{ 0 };
+};
+
+// The state messages a server builds for the players in [begin, end)
+void EncodePlayers(CrowdGame& game, size_t begin, size_t end, JobScratch& scratch)
+{
+    using namespace Common;
+
+    PlayerTable& players = game.GetPlayers();
+    Span<const uint32_t> ids = players.GetIds();
+    StateMessage& state = scratch.state;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        Span<const uint32_t> visible = game.GetInterest().GetVisible(ids.data[i]);
+        size_t next = 0;
+
+        do
+        {
+            state.count = 0;
+
+            for (; next < visible.size && state.count < StateMessage::kMaxEntries; ++next)
+            {
+                const Position& pos = players.GetPosition(players.Find(visible.data[next]));
+                state.entries[state.count++] = { visible.data[next], pos.x, pos.y };
+            }
+
+            const size_t size = Serializer<StateMessage>::Serialize(
+                state,
+                game.GetPositionCodec(),
+                { scratch.buffer.Data(), scratch.buffer.Capacity() });
+
+            scratch.checksum = scratch.checksum * 31 + FNV1A_32(scratch.buffer.Data(), size);
+        } while (next < visible.size);
+    }
+}
+}
+
+void JobBenchmarks(Runner& runner)
+{
+    using namespace Common;
+
+    constexpr uint32_t kPlayers = 10000;
+    constexpr uint32_t kPlayersPerJob = 64;
+
+    Game::Params params;
+    params.width = 512;
+    params.height = 512;
+    params.maxPlayers = kPlayers;
+
+    CrowdGame game(params);
+
+    for (uint32_t id = 1; id <= kPlayers; ++id)
+    {
+        PlayerHandle handle = game.CreatePlayer(id);
+        Position pos;
+        game.FindFreePosition(id, pos);
+        game.PlacePlayer(handle, pos);
+    }
+
+    const size_t jobs = JobSystem::GetJobCount(kPlayers, kPlayersPerJob);
+    std::vector<JobScratch> scratch(jobs);
+
+    // A tick of state encoding over 1 to N threads. The checksums of the
+    // encoded messages, folded in job order, must not change with the
+    // thread count.
+    const uint32_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<uint32_t> counts;
+
+    for (uint32_t threads = 1; threads < cores; threads *= 2)
+    {
+        counts.push_back(threads);
+    }
+    counts.push_back(cores);
+
+    const std::string prefix = "Jobs/Replicate/" + std::to_string(kPlayers) + "/Threads/";
+    uint32_t expected = 0;
+    bool deterministic = true;
+
+    for (uint32_t threads : counts)
+    {
+        JobSystem system(threads);
+        uint32_t checksum = 0;
+
+        runner.RunBatch(prefix + std::to_string(threads), 0, kPlayers, [&]
+        {
+            system.Run(kPlayers, kPlayersPerJob, [&](size_t begin, size_t end, size_t job)
+            {
+                scratch[job].checksum = 0;
+                EncodePlayers(game, begin, end, scratch[job]);
+            });
+
+            checksum = 0;
+            for (const JobScratch& s : scratch)
+            {
+                checksum = checksum * 16777619 + s.checksum;
+            }
+        });
+
+        if (threads == 1)
+        {
+            expected = checksum;
+        }
+
+        deterministic = deterministic && checksum == expected;
+
+        const JobSystem::Stats& stats = system.GetStats();
+        runner.AddCounter(prefix + std::to_string(threads) + "/Stolen",
+            stats.jobs ? 100.0 * double(stats.stolen) / double(stats.jobs) : 0, "%");
+    }
+
+    runner.AddCounter(prefix + "Deterministic", deterministic ? 1 : 0, "bool");
+
+    // Speedup over a single thread, for the thread counts which ran
+    const std::vector<Result>& results = runner.GetResults();
+    auto Find = [&](const std::string& name) -> const Result*
+    {
+        for (const Result& result : results)
+        {
+            if (result.name == name)
+            {
+                return &result;
+            }
+        }
+        return nullptr;
+    };
+
+    if (const Result* single = Find(prefix + "1"))
+    {
+        for (uint32_t threads : counts)
+        {
+            if (const Result* result = Find(prefix + std::to_string(threads)))
+            {
+                runner.AddCounter(prefix + std::to_string(threads) + "/Speedup",
+                    single->nsPerOp / result->nsPerOp, "x");
+            }
+        }
+    }
+}
+}
@@ -0,0 +1,146 @@
+#include "Benchmark.h"
+
+#include "Memory.h"
+#include "Message.h"
+#include "Network.h"
+
+#include <string>
+
+namespace Bench
+{
+void MemoryBenchmarks(Runner& runner)
+{
+    using namespace Common;
+
+    // Each batch fills or drains a whole network buffer so the per-call
+    // overhead of the runner is amortized over many primitive operations.
+    NetworkBuffer buffer;
+    uint8_t* data = buffer.Data();
+    const size_t capacity = buffer.Capacity();
+
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        data[i] = uint8_t(i * 31);
+    }
+
+    constexpr uint64_t kCount8 = kNetworkBufferSize;
+    constexpr uint64_t kCount16 = kNetworkBufferSize / 2;
+    constexpr uint64_t kCount32 = kNetworkBufferSize / 4;
+    constexpr uint64_t kCount64 = kNetworkBufferSize / 8;
+
+    runner.RunBatch("MemoryReader/Read", 1, kCount8 - 1, [&]
+    {
+        MemoryReader reader(data, capacity);
+        uint32_t sum = 0;
+        for (uint64_t i = 0; i + 1 < kCount8; ++i)
+        {
+            sum += reader.Read();
+        }
+        DoNotOptimize(sum);
+    });
+
+    runner.RunBatch("MemoryReader/Read16_BE", 2, kCount16, [&]
+    {
+        MemoryReader reader(data, capacity);
+        uint32_t sum = 0;
+        for (uint64_t i = 0; i < kCount16; ++i)
+        {
+            sum += reader.Read16_BE();
+        }
+        DoNotOptimize(sum);
+    });
+
+    runner.RunBatch("MemoryReader/Read32_BE", 4, kCount32, [&]
+    {
+        MemoryReader reader(data, capacity);
+        uint32_t sum = 0;
+        for (uint64_t i = 0; i < kCount32; ++i)
+        {
+            sum += reader.Read32_BE();
+        }
+        DoNotOptimize(sum);
+    });
+
+    runner.RunBatch("MemoryReader/Read64_BE", 8, kCount64, [&]
+    {
+        MemoryReader reader(data, capacity);
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < kCount64; ++i)
+        {
+            sum += reader.Read64_BE();
+        }
+        DoNotOptimize(sum);
+    });
+
+    runner.RunBatch("MemoryReader/ReadSpan/16", 16, kNetworkBufferSize / 16, [&]
+    {
+        MemoryReader reader(data, capacity);
+        size_t sum = 0;
+        for (uint64_t i = 0; i < kNetworkBufferSize / 16; ++i)
+        {
+            sum += reader.ReadSpan(16).size;
+        }
+        DoNotOptimize(sum);
+    });
+
+    NetworkBuffer output;
+    uint8_t* out = output.Data();
+
+    runner.RunBatch("MemoryWriter/Put16_BE", 2, kCount16, [&]
+    {
+        MemoryWriter writer(out, capacity);
+        for (uint64_t i = 0; i < kCount16; ++i)
+        {
+            writer.Put16_BE(uint16_t(i));
+        }
+        DoNotOptimize(*out);
+    });
+
+    runner.RunBatch("MemoryWriter/Put32_BE", 4, kCount32, [&]
+    {
+        MemoryWriter writer(out, capacity);
+        for (uint64_t i = 0; i < kCount32; ++i)
+        {
+            writer.Put32_BE(uint32_t(i));
+        }
+        DoNotOptimize(*out);
+    });
+
+    runner.RunBatch("MemoryWriter/Put64_BE", 8, kCount64, [&]
+    {
+        MemoryWriter writer(out, capacity);
+        for (uint64_t i = 0; i < kCount64; ++i)
+        {
+            writer.Put64_BE(uint64_t(i));
+        }
+        DoNotOptimize(*out);
+    });
+
+    runner.RunBatch("MemoryWriter/Put/16", 16, kNetworkBufferSize / 16, [&]
+    {
+        MemoryWriter writer(out, capacity);
+        for (uint64_t i = 0; i < kNetworkBufferSize / 16; ++i)
+        {
+            writer.Put(data + i * 16, 16);
+        }
+        DoNotOptimize(*out);
+    });
+
+    runner.Run("MemoryWriter/PutZero/1472", kNetworkBufferSize, [&]
+    {
+        MemoryWriter writer(out, capacity);
+        writer.PutZero(kNetworkBufferSize);
+        DoNotOptimize(*out);
+    });
+
+    // FNV1A_64 over every size a datagram payload can reasonably take
+    for (size_t size : { 8, 16, 32, 64, 128, 256, 512, 1024, 1472 })
+    {
+        runner.Run("FNV1A_64/" + std::to_string(size), size, [&, size]
+        {
+            uint64_t hash = FNV1A_64(data, size);
+            DoNotOptimize(hash);
+        });
+    }
+}
+}
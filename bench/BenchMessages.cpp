@@ -0,0 +1,194 @@
+#include "Benchmark.h"
+
+#include "Message.h"
+#include "Network.h"
+#include "Serializer.h"
+
+#include <string>
+
+namespace Bench
+{
+namespace
+{
+// Encode/decode pair for one message type. The decode benchmark reads the
+// buffer written by a single encode so it only measures parsing.
+template<typename T>
+void SerializerBenchmark(
+    Runner& runner,
+    const std::string& name,
+    T message)
+{
+    using namespace Common;
+
+    NetworkBuffer buffer;
+    Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+
+    const size_t size = Serializer<T>::Serialize(message, data);
+    Span<const uint8_t> input{ buffer.Data(), size };
+
+    runner.Run("Serializer<" + name + ">/Serialize", size, [&]
+    {
+        size_t written = Serializer<T>::Serialize(message, data);
+        DoNotOptimize(written);
+    });
+
+    runner.Run("Serializer<" + name + ">/Deserialize", size, [&]
+    {
+        std::optional<T> result = Serializer<T>::Deserialize(input);
+        DoNotOptimize(result);
+    });
+
+    runner.AddCounter("Serializer<" + name + ">/EncodedSize", double(size), "bytes");
+}
+}
+
+void MessageBenchmarks(Runner& runner)
+{
+    using namespace Common;
+
+    {
+        Message message(Action::Login);
+        message.messageId = 1234;
+
+        // Serializer<Message> leaves the header to the caller, sign it so
+        // the decode side sees a valid message.
+        NetworkBuffer buffer;
+        Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+        size_t size = Serializer<Message>::Serialize(message, data);
+        SerializeHeader(
+            message.header,
+            data.Subspan(0, kMessageHeaderSize),
+            { buffer.Data() + kMessageHeaderSize, size - kMessageHeaderSize });
+
+        Span<const uint8_t> input{ buffer.Data(), size };
+
+        runner.Run("Serializer<Message>/Serialize", size, [&]
+        {
+            size_t written = Serializer<Message>::Serialize(message, data);
+            DoNotOptimize(written);
+        });
+
+        runner.Run("Serializer<Message>/Deserialize", size, [&]
+        {
+            std::optional<Message> result = Serializer<Message>::Deserialize(input);
+            DoNotOptimize(result);
+        });
+
+        runner.AddCounter("Serializer<Message>/EncodedSize", double(size), "bytes");
+
+        // Header validation on its own, this runs for every datagram
+        runner.Run("MessageHeader/Deserialize", kMessageHeaderSize, [&]
+        {
+            MessageHeader header;
+            bool valid = DeserializeHeader(input.Subspan(0, kMessageHeaderSize), header);
+            DoNotOptimize(valid);
+        });
+
+        Span<const uint8_t> payload = input.Subspan(kMessageHeaderSize);
+
+        runner.Run("MessageHeader/Serialize", size, [&]
+        {
+            MessageHeader header;
+            SerializeHeader(header, data.Subspan(0, kMessageHeaderSize), payload);
+            DoNotOptimize(header);
+        });
+    }
+
+    {
+        LoginMessage login;
+        login.message.messageId = 1234;
+        login.session = 42;
+        login.address[0] = 127;
+        login.address[3] = 1;
+        login.port = 8081;
+
+        SerializerBenchmark(runner, "LoginMessage", login);
+    }
+
+    {
+        PingMessage ping;
+        ping.message.messageId = 1234;
+        ping.playerId = 42;
+        ping.messageId = 1200;
+
+        SerializerBenchmark(runner, "PingMessage", ping);
+    }
+
+    {
+        AcknowledgeMessage ack;
+        ack.message.messageId = 1234;
+        ack.messageId = 1200;
+
+        SerializerBenchmark(runner, "AcknowledgeMessage", ack);
+    }
+
+    {
+        // One full state sent to 100 recipients, serialized for each of
+        // them against serialized once and patched per copy
+        constexpr uint32_t kRecipients = 100;
+
+        const PositionCodec codec(64, 64);
+        StateMessage state;
+        state.tick = 1234;
+        state.count = StateMessage::kMaxEntries;
+        for (uint16_t i = 0; i < state.count; ++i)
+        {
+            state.entries[i] = { 1000u + i, 20u + i, 30u + i };
+        }
+
+        NetworkBuffer buffer;
+        NetworkBuffer copy;
+        Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+        Span<uint8_t> output{ copy.Data(), copy.Capacity() };
+
+        const size_t size = Serializer<StateMessage>::Serialize(state, codec, data);
+        const std::string count = std::to_string(kRecipients);
+
+        runner.Run("Broadcast/" + count + "/Serialize", size * kRecipients, [&]
+        {
+            for (uint32_t i = 0; i < kRecipients; ++i)
+            {
+                state.message.messageId = i;
+                size_t written = Serializer<StateMessage>::Serialize(state, codec, output);
+                DoNotOptimize(written);
+            }
+        });
+
+        runner.Run("Broadcast/" + count + "/SerializeCompact", size * kRecipients, [&]
+        {
+            for (uint32_t i = 0; i < kRecipients; ++i)
+            {
+                state.message.messageId = i;
+                size_t written = Serializer<StateMessage>::Serialize(state, codec, output);
+                written = EncodeCompactMessage(
+                    { copy.Data(), written }, CompactHeader::kFlagAck, 1, 2, output);
+                DoNotOptimize(written);
+            }
+        });
+
+        BroadcastMessage broadcast;
+        broadcast.Prepare({ buffer.Data(), size });
+
+        runner.Run("Broadcast/" + count + "/Write", size * kRecipients, [&]
+        {
+            broadcast.Prepare({ buffer.Data(), size });
+            for (uint32_t i = 0; i < kRecipients; ++i)
+            {
+                size_t written = broadcast.Write(i, output);
+                DoNotOptimize(written);
+            }
+        });
+
+        runner.Run("Broadcast/" + count + "/WriteCompact", size * kRecipients, [&]
+        {
+            broadcast.Prepare({ buffer.Data(), size });
+            for (uint32_t i = 0; i < kRecipients; ++i)
+            {
+                size_t written = broadcast.WriteCompact(
+                    i, CompactHeader::kFlagAck, 1, 2, output);
+                DoNotOptimize(written);
+            }
+        });
+    }
+}
+}
@@ -0,0 +1,185 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace Bench
+{
+volatile const void* gSink = nullptr;
+
+namespace
+{
+// Write a string as a JSON string literal. Benchmark names are plain
+// ASCII so only quotes and backslashes need escaping.
+void WriteJsonString(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out << '\\';
+        }
+        out << c;
+    }
+    out << '"';
+}
+}
+
+Runner::Runner(Options options)
+    : mOptions(std::move(options))
+{ }
+
+bool Runner::Enabled(const std::string& name) const
+{
+    return mOptions.filter.empty()
+        || name.find(mOptions.filter) != std::string::npos;
+}
+
+void Runner::Run(
+    const std::string& name,
+    size_t bytesPerOp,
+    const std::function<void()>& fn)
+{
+    RunBatch(name, bytesPerOp, 1, fn);
+}
+
+void Runner::RunBatch(
+    const std::string& name,
+    size_t bytesPerOp,
+    uint64_t count,
+    const std::function<void()>& fn)
+{
+    using namespace std::chrono;
+
+    if (!Enabled(name))
+    {
+        return;
+    }
+
+    // Warm up and find an iteration count which takes about a tenth of
+    // the minimum time so the clock overhead is negligible.
+    uint64_t iterations = 1;
+    for (;;)
+    {
+        auto start = steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            fn();
+        }
+        auto elapsed = steady_clock::now() - start;
+
+        if (elapsed >= mOptions.minTime / 10 || iterations >= (uint64_t(1) << 40))
+        {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    double best = 0;
+    uint64_t total = 0;
+
+    for (uint32_t r = 0; r < std::max<uint32_t>(mOptions.repetitions, 1); ++r)
+    {
+        uint64_t ops = 0;
+        auto start = steady_clock::now();
+        auto elapsed = steady_clock::duration::zero();
+
+        do
+        {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                fn();
+            }
+            ops += iterations * count;
+            elapsed = steady_clock::now() - start;
+        } while (elapsed < mOptions.minTime);
+
+        double ns = double(duration_cast<nanoseconds>(elapsed).count()) / double(ops);
+        if (best == 0 || ns < best)
+        {
+            best = ns;
+            total = ops;
+        }
+    }
+
+    Result result;
+    result.name = name;
+    result.iterations = total;
+    result.nsPerOp = best;
+    result.bytesPerOp = double(bytesPerOp);
+    result.bytesPerSec = best > 0 ? double(bytesPerOp) * 1e9 / best : 0;
+
+    mResults.push_back(result);
+}
+
+void Runner::AddCounter(std::string name, double value, std::string unit)
+{
+    if (!Enabled(name))
+    {
+        return;
+    }
+
+    mCounters.push_back(Counter{ std::move(name), value, std::move(unit) });
+}
+
+void Runner::WriteTable(std::ostream& out) const
+{
+    out << std::left << std::setw(48) << "benchmark"
+        << std::right << std::setw(14) << "ns/op"
+        << std::setw(16) << "MB/s"
+        << std::setw(16) << "iterations" << '\n';
+
+    for (const Result& r : mResults)
+    {
+        out << std::left << std::setw(48) << r.name
+            << std::right << std::fixed << std::setprecision(2)
+            << std::setw(14) << r.nsPerOp
+            << std::setw(16) << r.bytesPerSec / 1e6
+            << std::setw(16) << r.iterations << '\n';
+    }
+
+    if (!mCounters.empty())
+    {
+        out << '\n';
+        for (const Counter& c : mCounters)
+        {
+            out << std::left << std::setw(48) << c.name
+                << std::right << std::setw(14) << c.value
+                << ' ' << c.unit << '\n';
+        }
+    }
+}
+
+void Runner::WriteJson(std::ostream& out) const
+{
+    out << std::setprecision(6) << "{\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < mResults.size(); ++i)
+    {
+        const Result& r = mResults[i];
+
+        out << (i ? ",\n    {" : "\n    {") << "\"name\": ";
+        WriteJsonString(out, r.name);
+        out << ", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << r.nsPerOp
+            << ", \"bytes_per_op\": " << r.bytesPerOp
+            << ", \"bytes_per_sec\": " << r.bytesPerSec << '}';
+    }
+
+    out << "\n  ],\n  \"counters\": [";
+
+    for (size_t i = 0; i < mCounters.size(); ++i)
+    {
+        const Counter& c = mCounters[i];
+
+        out << (i ? ",\n    {" : "\n    {") << "\"name\": ";
+        WriteJsonString(out, c.name);
+        out << ", \"value\": " << c.value << ", \"unit\": ";
+        WriteJsonString(out, c.unit);
+        out << '}';
+    }
+
+    out << "\n  ]\n}\n";
+}
+}
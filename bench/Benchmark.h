@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Bench
+{
+extern volatile const void* gSink;
+
+// Keep the compiler from optimizing away a value computed by a benchmark
+// without adding anything measurable to the loop.
+template<typename T>
+void DoNotOptimize(const T& value)
+{
+    gSink = &value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+struct Options
+{
+    // Minimum wall time spent measuring each benchmark
+    std::chrono::milliseconds minTime{ 200 };
+
+    // Number of measurements taken, the fastest one is reported
+    uint32_t repetitions{ 3 };
+
+    // Only run benchmarks whose name contains this string
+    std::string filter;
+};
+
+struct Result
+{
+    std::string name;
+    uint64_t iterations{ 0 };
+    double nsPerOp{ 0 };
+    double bytesPerOp{ 0 };
+    double bytesPerSec{ 0 };
+};
+
+// Static measurement which is not a timing, such as an encoded size.
+struct Counter
+{
+    std::string name;
+    double value{ 0 };
+    std::string unit;
+};
+
+class Runner final
+{
+public:
+    Runner(const Runner&) = delete;
+    Runner& operator=(const Runner&) = delete;
+
+public:
+    explicit Runner(Options options);
+
+    // Measure fn which performs a single operation touching bytesPerOp
+    // bytes. The function is called repeatedly until the minimum time has
+    // passed and the best repetition is recorded.
+    void Run(
+        const std::string& name,
+        size_t bytesPerOp,
+        const std::function<void()>& fn);
+
+    // Measure fn which performs count operations per call. Used when the
+    // per-operation cost is too small to time through a std::function.
+    void RunBatch(
+        const std::string& name,
+        size_t bytesPerOp,
+        uint64_t count,
+        const std::function<void()>& fn);
+
+    void AddCounter(std::string name, double value, std::string unit);
+
+    const std::vector<Result>& GetResults() const { return mResults; }
+    const std::vector<Counter>& GetCounters() const { return mCounters; }
+
+    void WriteTable(std::ostream& out) const;
+    void WriteJson(std::ostream& out) const;
+
+private:
+    bool Enabled(const std::string& name) const;
+
+private:
+    Options mOptions;
+    std::vector<Result> mResults;
+    std::vector<Counter> mCounters;
+};
+
+// Benchmark suites
+void MemoryBenchmarks(Runner& runner);
+void MessageBenchmarks(Runner& runner);
+void CodecBenchmarks(Runner& runner);
+void GameBenchmarks(Runner& runner);
+void JobBenchmarks(Runner& runner);
+}
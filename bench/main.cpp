@@ -0,0 +1,92 @@
+// Common Includes
+#include "Common.h"
+// Bench Includes
+#include "Benchmark.h"
+// Other Includes
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+void Usage(const char* name)
+{
+    std::cout << "Usage: " << name << " [options]\n"
+        << "  --filter <text>    Only run benchmarks containing <text>\n"
+        << "  --json <path>      Write the results as JSON to <path> ('-' for stdout)\n"
+        << "  --min-time <ms>    Minimum time spent measuring each benchmark\n"
+        << "  --repetitions <n>  Measurements per benchmark, the best is reported\n";
+}
+}
+
+int main(int argc, char** argv)
+{
+    using namespace std::chrono;
+
+    Bench::Options options;
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--filter") == 0 && value)
+        {
+            options.filter = value;
+            ++i;
+        }
+        else if (strcmp(arg, "--json") == 0 && value)
+        {
+            jsonPath = value;
+            ++i;
+        }
+        else if (strcmp(arg, "--min-time") == 0 && value)
+        {
+            options.minTime = milliseconds(std::atoi(value));
+            ++i;
+        }
+        else if (strcmp(arg, "--repetitions") == 0 && value)
+        {
+            options.repetitions = uint32_t(std::atoi(value));
+            ++i;
+        }
+        else
+        {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+
+    Bench::Runner runner(options);
+
+    Bench::MemoryBenchmarks(runner);
+    Bench::MessageBenchmarks(runner);
+    Bench::CodecBenchmarks(runner);
+    Bench::GameBenchmarks(runner);
+    Bench::JobBenchmarks(runner);
+
+    if (jsonPath == "-")
+    {
+        runner.WriteJson(std::cout);
+        return 0;
+    }
+
+    runner.WriteTable(std::cout);
+
+    if (!jsonPath.empty())
+    {
+        std::ofstream out(jsonPath);
+
+        if (!out)
+        {
+            std::cout << "Failed to open '" << jsonPath << "' for writing\n";
+            return 1;
+        }
+
+        runner.WriteJson(out);
+    }
+
+    return 0;
+}
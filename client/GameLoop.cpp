@@ -2,6 +2,7 @@
 
 #include "Network.h"
 
+#include <algorithm>
 #include <iostream>
 
 namespace Client
@@ -9,7 +10,11 @@ namespace Client
 GameLoop::GameLoop(Params params)
     : Game(std::move(params.commonParams))
     , mParams(std::move(params))
-{ }
+    , mSnapshotClock(GetParams().tickInterval)
+{
+    // First attempt on the first tick
+    mLoginTimer = ScheduleTimer(std::chrono::milliseconds(0), TimerKind::Login);
+}
 
 GameLoop::~GameLoop() = default;
 
@@ -18,10 +23,15 @@ void GameLoop::HandleLogin(LoginEvent* ev)
     using namespace Common;
 
     LoginMessage& login = ev->login;
+    const uint32_t messageId = ReceiveHeader(*ev, login.message.messageId);
 
     std::string address = AddressToString(login.address);
-    std::cout << "Received session '" << login.session
-        << "' response from server" << '\n';
+
+    if (GetParams().verbose)
+    {
+        std::cout << "Received session '" << login.session
+            << "' response from server" << '\n';
+    }
 
     if (mState == State::New)
     {
@@ -43,12 +53,21 @@ void GameLoop::HandleLogin(LoginEvent* ev)
         }
 
         // Not filled in by the call to CreatePlayer()
-        mThisPlayer->address = address;
-        mThisPlayer->port = login.port;
+        PlayerInfo& info = GetPlayers().GetInfo(mThisPlayer);
+        info.address = address;
+        info.port = login.port;
 
-        std::cout << "Registered with server as player '" << mThisPlayer->player->GetId()
-            << "'\n";
+        if (GetParams().verbose)
+        {
+            std::cout << "Registered with server as player '"
+                << GetPlayers().GetId(mThisPlayer) << "'\n";
+        }
         mState = State::LoggedIn;
+        mLoginTime = ev->received - mLoginStart;
+        Acknowledge(messageId);
+
+        CancelTimer(mLoginTimer);
+        mPingTimer = ScheduleTimer(kPingInterval, TimerKind::Ping);
     }
     else
     {
@@ -57,9 +76,9 @@ void GameLoop::HandleLogin(LoginEvent* ev)
 
         // use the Created-By-Id variant because we don't have a player address
         // to add.
-        PlayerState* state = Game::CreatePlayer(login.session);
+        PlayerHandle player = Game::CreatePlayer(login.session);
 
-        if (!state)
+        if (!player)
         {
             std::cout << "Conflicted login for new player ID '" << login.session
                 << "' player already exists\n";
@@ -76,20 +95,232 @@ void GameLoop::HandlePing(PingEvent* ev)
 }
 
 void GameLoop::HandleAcknowledge(AcknowledgeEvent* ev)
-{}
-
-bool GameLoop::Tick()
 {
+    using namespace Common;
     using namespace std::chrono;
-    using namespace std::chrono_literals;
 
+    const uint32_t messageId = ReceiveHeader(*ev, ev->ack.message.messageId);
+
+    if (mState != State::LoggedIn)
+    {
+        return;
+    }
+
+    Acknowledge(messageId);
+    mSessionStats.acksReceived += 1;
+
+    const MessageTimes& times = ev->ack.times;
+
+    if (times.echoDelay == MessageTimes::kNoEcho)
+    {
+        return;
+    }
+
+    // Timed from when the reply came off the network, not from when the
+    // tick got round to it
+    const uint32_t received = GetWireTime(ev->received);
+    const uint32_t serverReceived = times.sendTime - times.echoDelay;
+
+    if (!mServerClock.AddSample(times.echoTime, serverReceived, times.sendTime, received))
+    {
+        return;
+    }
+
+    mRtt.AddSample(microseconds(received - times.echoTime - times.echoDelay));
+
+    // Keep the newest for the next ping to echo, replies can be reordered
+    if (!mHasServerTime || int32_t(times.sendTime - mServerTime) > 0)
+    {
+        mHasServerTime = true;
+        mServerTime = times.sendTime;
+        mServerTimeReceived = ev->received;
+    }
+}
+
+void GameLoop::HandleState(StateEvent* ev)
+{
+    using namespace Common;
+
+    const StateMessage& state = ev->state;
+    const uint32_t messageId = ReceiveHeader(*ev, state.message.messageId);
+
+    if (mState != State::LoggedIn)
+    {
+        return;
+    }
+
+    const uint32_t self = GetPlayers().GetId(mThisPlayer);
+
+    Acknowledge(messageId);
+    mSessionStats.statesReceived += 1;
+
+    // Ticks only go forward, anything older was reordered on the way
+    const bool current = int32_t(state.tick - mServerTick) >= 0;
+
+    if (current)
+    {
+        if (state.tick != mServerTick)
+        {
+            AdjustInputLead(state.inputOffset);
+        }
+
+        mServerTick = state.tick;
+        mServerTickTime = std::chrono::steady_clock::now();
+    }
+
+    mSnapshotClock.OnSnapshot(state.tick, std::chrono::steady_clock::now());
+
+    if (state.removedCount > 0)
+    {
+        RemovePlayers(state);
+    }
+
+    for (uint16_t i = 0; i < state.count; ++i)
+    {
+        const StateMessage::Entry& entry = state.entries[i];
+
+        if (!IsValidPosition(entry.x, entry.y))
+        {
+            continue;
+        }
+
+        // Removed after this state was sent, it was held up on the way
+        if (auto removed = mRemoved.find(entry.playerId); removed != mRemoved.end())
+        {
+            if (int32_t(state.tick - removed->second) <= 0)
+            {
+                continue;
+            }
+
+            mRemoved.erase(removed);
+        }
+
+        PlayerHandle player = GetPlayerById(entry.playerId);
+
+        if (!player)
+        {
+            // First time this player has come into view
+            player = Game::CreatePlayer(entry.playerId);
+        }
+
+        // The server is authoritative, a player we still have in the cell
+        // walked out of view since we last heard about it.
+        if (Player* occupant = GetGrid().GetPlayer(entry.x, entry.y);
+            occupant
+            && occupant->GetId() != entry.playerId
+            && occupant->GetId() != self)
+        {
+            mSnapshots.erase(occupant->GetId());
+            RemovePlayer(GetPlayerById(occupant->GetId()));
+        }
+
+        if (entry.playerId == self)
+        {
+            if (current)
+            {
+                Reconcile(state.tick, Position{ entry.x, entry.y });
+            }
+            continue;
+        }
+
+        PlacePlayer(player, Position{ entry.x, entry.y });
+
+        // Reordered states still fill in the snapshot history
+        mSnapshots[entry.playerId].Add(state.tick, Position{ entry.x, entry.y });
+    }
+}
+
+void GameLoop::RemovePlayers(const Common::StateMessage& state)
+{
+    using namespace Common;
+
+    const uint32_t self = GetPlayers().GetId(mThisPlayer);
+
+    for (uint16_t i = 0; i < state.removedCount; ++i)
+    {
+        const uint32_t id = state.removed[i];
+
+        if (id == self)
+        {
+            continue;
+        }
+
+        // Back in view since, this was held up on the way
+        if (auto snapshots = mSnapshots.find(id);
+            snapshots != mSnapshots.end()
+            && snapshots->second.Size() > 0
+            && int32_t(snapshots->second.Get(snapshots->second.Size() - 1).tick
+                - state.tick) > 0)
+        {
+            continue;
+        }
+
+        mSnapshots.erase(id);
+
+        if (PlayerHandle player = GetPlayerById(id))
+        {
+            RemovePlayer(player);
+        }
+
+        mRemoved[id] = state.tick;
+    }
+
+    // Nothing held up for this long is still on its way
+    for (auto it = mRemoved.begin(); it != mRemoved.end();)
+    {
+        if (int32_t(state.tick - it->second) > int32_t(kRemovedTicks))
+        {
+            it = mRemoved.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void GameLoop::HandleMove(MoveEvent* ev)
+{
+    // Moves only flow from clients to the server
+}
+
+void GameLoop::HandleTimer(TimerKind kind, uint64_t data)
+{
+    switch (kind)
+    {
+    case TimerKind::Login:
+        TryLogin();
+
+        // Keep trying until the server answers
+        if (mState == State::New)
+        {
+            mLoginTimer = ScheduleTimer(kLoginInterval, TimerKind::Login);
+        }
+        break;
+    case TimerKind::Ping:
+        TryPing();
+
+        if (mState == State::LoggedIn)
+        {
+            mPingTimer = ScheduleTimer(kPingInterval, TimerKind::Ping);
+        }
+        break;
+    default:
+        Game::HandleTimer(kind, data);
+        break;
+    }
+}
+
+bool GameLoop::Tick()
+{
+    // Login and ping timers fire from here
     bool result = Game::Tick();
 
+    mTicksSinceLeadAdjust += 1;
+
     switch (mState)
     {
     case State::New:
-        TryLogin();
-        break;
     case State::LoggedIn:
         break;
     case State::Disconnected:
@@ -97,31 +328,34 @@ bool GameLoop::Tick()
         break;
     }
 
-    if (result && mState != State::New)
-    {
-        TryPing();
-    }
-
     return result;
 }
 
+void GameLoop::Acknowledge(uint32_t messageId)
+{
+    uint32_t& acked = GetPlayers().GetAckCount(mThisPlayer);
+    acked = std::max(acked, messageId);
+}
+
+uint32_t GameLoop::ReceiveHeader(const Event& ev, uint32_t messageId)
+{
+    return ev.compact ? mServerAcks.Receive(ev.header.sequence) : messageId;
+}
+
+const Common::AckWindow* GameLoop::GetHeaderAcks() const
+{
+    return mParams.compactHeader ? &mServerAcks : nullptr;
+}
+
 void GameLoop::TryLogin()
 {
     using namespace Common;
-    using namespace std::chrono;
-    using namespace std::chrono_literals;
 
     if (mState != State::New)
     {
         return;
     }
 
-    if (steady_clock::now() < mLoginAttemptTime + 500ms)
-    {
-        // Only try to login every 100ms or until we succeed
-        return;
-    }
-
     NetworkBuffer buffer;
     size_t offset = 0;
     {
@@ -146,33 +380,34 @@ void GameLoop::TryLogin()
     }
     buffer.SetOffset(offset);
 
-    if (!SendMessage(
+    if (!SendPacket(
         mParams.serverAddress.c_str(),
         mParams.serverPort,
-        buffer))
+        buffer,
+        GetHeaderAcks()))
     {
         std::cout << "Failed to send login message\n";
         return;
     }
 
-    std::cout << "Sent login message\n";
-    mLoginAttemptTime = steady_clock::now();
+    if (GetParams().verbose)
+    {
+        std::cout << "Sent login message\n";
+    }
+
+    if (mLoginAttempts == 0)
+    {
+        mLoginStart = std::chrono::steady_clock::now();
+    }
+    mLoginAttempts += 1;
 }
 
 void GameLoop::TryPing()
 {
     using namespace Common;
-    using namespace std::chrono;
-    using namespace std::chrono_literals;
 
-    if (mState != State::New)
-    {
-        return;
-    }
-
-    if (steady_clock::now() < mLastPing + 100ms)
+    if (mState != State::LoggedIn)
     {
-        // Only try to ping every 100ms
         return;
     }
 
@@ -182,23 +417,272 @@ void GameLoop::TryPing()
         Span<uint8_t> data(buffer.Data(), buffer.Capacity());
 
         PingMessage ping;
-        ping.message.messageId = mThisPlayer->nextMessage++;
-        ping.messageId = mThisPlayer->ackCount;
-        ping.playerId = mThisPlayer->player->GetId();
+        PlayerTable& players = GetPlayers();
+
+        ping.message.messageId = players.GetNextMessage(mThisPlayer)++;
+        ping.messageId = players.GetAckCount(mThisPlayer);
+        ping.playerId = players.GetId(mThisPlayer);
+
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        ping.times.sendTime = GetWireTime(now);
+
+        if (mHasServerTime)
+        {
+            ping.times.echoTime = mServerTime;
+            ping.times.echoDelay = uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(
+                now - mServerTimeReceived).count());
+        }
 
         offset = Serializer<PingMessage>::Serialize(ping, data);
     }
     buffer.SetOffset(offset);
 
-    if (!SendMessage(
+    if (!SendPacket(
         mParams.serverAddress.c_str(),
         mParams.serverPort,
-        buffer))
+        buffer,
+        GetHeaderAcks()))
     {
         std::cout << "Failed to send ping message\n";
         return;
     }
 
-    mLastPing = steady_clock::now();
+    mSessionStats.pingsSent += 1;
+}
+
+bool GameLoop::SendMove(Common::Movement movement)
+{
+    using namespace Common;
+
+    if (mState != State::LoggedIn)
+    {
+        return false;
+    }
+
+    const uint32_t tick = mPrediction.GetNextTick(EstimateServerTick() + mInputLead);
+
+    NetworkBuffer buffer;
+    {
+        Span<uint8_t> data(buffer.Data(), buffer.Capacity());
+        PlayerTable& players = GetPlayers();
+
+        MoveMessage move;
+        move.message.messageId = players.GetNextMessage(mThisPlayer)++;
+        move.playerId = players.GetId(mThisPlayer);
+        move.tick = tick;
+        move.movement = movement;
+
+        buffer.SetOffset(Serializer<MoveMessage>::Serialize(move, data));
+    }
+
+    if (!SendPacket(
+        mParams.serverAddress.c_str(),
+        mParams.serverPort,
+        buffer,
+        GetHeaderAcks()))
+    {
+        std::cout << "Failed to send move message\n";
+        return false;
+    }
+
+    // Show the move straight away instead of waiting on the server
+    const Position pos = GetPlayers().GetPosition(mThisPlayer);
+    Position next;
+
+    if (IsValidPosition(pos.x, pos.y) && Predict(pos, movement, next))
+    {
+        PlacePlayer(mThisPlayer, next);
+    }
+
+    mPrediction.Push(tick, movement);
+    return true;
+}
+
+bool GameLoop::Predict(
+    Common::Position from,
+    Common::Movement movement,
+    Common::Position& to) const
+{
+    using namespace Common;
+
+    if (!StepPosition(from, movement, GetParams().width, GetParams().height, to))
+    {
+        return false;
+    }
+
+    // The server decides conflicts, but walking into a player we can see
+    // is very likely to be refused.
+    const Player* occupant = GetGrid().GetPlayer(to.x, to.y);
+    return !occupant || occupant->GetId() == GetPlayers().GetId(mThisPlayer);
+}
+
+void GameLoop::Reconcile(uint32_t tick, Common::Position authoritative)
+{
+    using namespace Common;
+
+    const Position predicted = GetPlayers().GetPosition(mThisPlayer);
+
+    mPrediction.Acknowledge(tick);
+
+    Position pos = authoritative;
+    for (size_t i = 0; i < mPrediction.Size(); ++i)
+    {
+        Position next;
+
+        if (Predict(pos, mPrediction.Get(i).movement, next))
+        {
+            pos = next;
+        }
+    }
+
+    if (!IsValidPosition(predicted.x, predicted.y))
+    {
+        // First time we hear where we are, nothing was predicted
+        mPrediction.Reconcile(pos, pos);
+    }
+    else
+    {
+        mPrediction.Reconcile(predicted, pos);
+
+        if (pos.x == predicted.x && pos.y == predicted.y)
+        {
+            return;
+        }
+    }
+
+    // A player we have not heard from this tick may still be in the
+    // replayed cell, the server's cell is always ours.
+    if (!PlacePlayer(mThisPlayer, pos))
+    {
+        PlacePlayer(mThisPlayer, authoritative);
+    }
+}
+
+uint32_t GameLoop::EstimateServerTick() const
+{
+    using namespace std::chrono;
+
+    if (mServerTickTime == steady_clock::time_point{})
+    {
+        return mServerTick;
+    }
+
+    const auto elapsed = steady_clock::now() - mServerTickTime;
+    return mServerTick + uint32_t(elapsed / GetParams().tickInterval);
+}
+
+void GameLoop::AdjustInputLead(int16_t offset)
+{
+    if (offset == 0 || mTicksSinceLeadAdjust < kLeadAdjustInterval)
+    {
+        return;
+    }
+
+    // Close half the gap each time, at least a tick, so a large error is
+    // fixed quickly without overshooting on a noisy estimate.
+    int32_t step = offset / 2;
+    if (step == 0)
+    {
+        step = offset > 0 ? 1 : -1;
+    }
+
+    const int32_t lead = std::clamp(int32_t(mInputLead) - step,
+        0, int32_t(Common::JitterBuffer::kMaxLead));
+
+    if (GetParams().verbose)
+    {
+        std::cout << "Input lead changed from " << mInputLead << " to " << lead
+            << " ticks (offset " << offset << ")\n";
+    }
+
+    mInputLead = uint32_t(lead);
+    mTicksSinceLeadAdjust = 0;
+}
+
+void GameLoop::PrintPredictionStats() const
+{
+    const Common::Prediction::Stats& stats = mPrediction.GetStats();
+
+    std::cout << "Prediction: " << stats.predicted << " inputs predicted, "
+        << stats.reconciled << " states reconciled, " << stats.mispredicted
+        << " mispredicted (" << mPrediction.GetMispredictionRate() * 100.0
+        << "%), corrections moved " << stats.correctionDistance << " cells (max "
+        << stats.maxCorrection << "), " << stats.dropped << " inputs dropped\n";
+}
+
+bool GameLoop::GetRenderPosition(uint32_t playerId, Common::RenderPosition& pos)
+{
+    using namespace Common;
+
+    if (mState != State::LoggedIn)
+    {
+        return false;
+    }
+
+    if (playerId == GetPlayers().GetId(mThisPlayer))
+    {
+        const Position& current = GetPlayers().GetPosition(mThisPlayer);
+
+        if (!IsValidPosition(current.x, current.y))
+        {
+            return false;
+        }
+
+        pos = RenderPosition{ double(current.x), double(current.y) };
+        return true;
+    }
+
+    auto it = mSnapshots.find(playerId);
+
+    if (it == mSnapshots.end())
+    {
+        return false;
+    }
+
+    const double tick = mSnapshotClock.GetRenderTick(std::chrono::steady_clock::now());
+
+    switch (it->second.GetPosition(tick, pos))
+    {
+    case SnapshotBuffer::Sample::None:
+        return false;
+    case SnapshotBuffer::Sample::Interpolated:
+        mInterpolationStats.interpolated += 1;
+        break;
+    case SnapshotBuffer::Sample::Extrapolated:
+        mInterpolationStats.extrapolated += 1;
+        break;
+    case SnapshotBuffer::Sample::Held:
+        mInterpolationStats.held += 1;
+        break;
+    }
+
+    return true;
+}
+
+void GameLoop::PrintInterpolationStats() const
+{
+    const InterpolationStats& stats = mInterpolationStats;
+
+    std::cout << "Interpolation: " << stats.interpolated << " interpolated, "
+        << stats.extrapolated << " extrapolated, " << stats.held << " held (delay "
+        << mSnapshotClock.GetDelay() << " ticks, jitter " << mSnapshotClock.GetJitter()
+        << " ticks)\n";
+}
+
+uint32_t GameLoop::GetServerTime(std::chrono::steady_clock::time_point time) const
+{
+    return mServerClock.ToRemote(GetWireTime(time));
+}
+
+void GameLoop::PrintClockStats() const
+{
+    using namespace std::chrono;
+
+    std::cout << "Round trip over " << mRtt.GetSampleCount() << " pings: srtt "
+        << duration_cast<microseconds>(mRtt.GetSmoothedRtt()).count() << "us, rttvar "
+        << duration_cast<microseconds>(mRtt.GetRttVariance()).count() << "us, min "
+        << duration_cast<microseconds>(mRtt.GetMinRtt()).count() << "us, rto "
+        << duration_cast<milliseconds>(mRtt.GetRto()).count() << "ms, server clock offset "
+        << int32_t(mServerClock.GetOffset()) << "us\n";
 }
 }
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "Game.h"
+#include "Interpolation.h"
+#include "Prediction.h"
+#include "RttEstimator.h"
+
+#include <unordered_map>
 
 namespace Client
 {
@@ -23,6 +28,9 @@ public:
         uint32_t clientPort;
         std::string serverAddress;
         uint32_t serverPort;
+        // Send the compact header, which the server answers in kind. Off
+        // for servers which only speak version 1.
+        bool compactHeader{ true };
     };
 
     GameLoop(Params params);
@@ -32,22 +40,153 @@ public:
     void HandleLogin(LoginEvent* ev) override;
     void HandlePing(PingEvent* ev) override;
     void HandleAcknowledge(AcknowledgeEvent* ev) override;
+    void HandleState(StateEvent* ev) override;
+    void HandleMove(MoveEvent* ev) override;
+    void HandleTimer(TimerKind kind, uint64_t data) override;
 
 public:
     bool Tick() override;
 
+    // Ask the server to move this client's player one cell. The move is
+    // stamped for the server tick it should arrive just ahead of.
+    bool SendMove(Common::Movement movement);
+
+    // Server tick running now, extrapolated from the last state received
+    uint32_t EstimateServerTick() const;
+
+    // Ticks ahead of the server that inputs are stamped for
+    uint32_t GetInputLead() const { return mInputLead; }
+
+    const Common::Prediction::Stats& GetPredictionStats() const
+    {
+        return mPrediction.GetStats();
+    }
+    void PrintPredictionStats() const;
+
+    // Where to draw a player now. Remote players are drawn a little in the
+    // past between the snapshots received for them, this client's player
+    // where prediction has put it. Returns false for unknown players.
+    bool GetRenderPosition(uint32_t playerId, Common::RenderPosition& pos);
+
+    // How the remote player positions handed out were produced
+    struct InterpolationStats
+    {
+        uint64_t interpolated{ 0 };
+        uint64_t extrapolated{ 0 };
+        uint64_t held{ 0 };
+    };
+
+    const InterpolationStats& GetInterpolationStats() const { return mInterpolationStats; }
+    void PrintInterpolationStats() const;
+
+    // Round trips to the server, timed by the ping exchange
+    const Common::RttEstimator& GetRtt() const { return mRtt; }
+
+    // The server's clock relative to ours
+    const Common::ClockOffsetEstimator& GetServerClock() const { return mServerClock; }
+
+    // Server clock at the given time, in the microseconds it stamps
+    // messages with. Only meaningful once GetServerClock() has an offset.
+    uint32_t GetServerTime(std::chrono::steady_clock::time_point time) const;
+
+    void PrintClockStats() const;
+
+    bool IsLoggedIn() const { return mState == State::LoggedIn; }
+
+    // Time from the first login attempt to the server's answer, zero until
+    // logged in
+    std::chrono::steady_clock::duration GetLoginTime() const { return mLoginTime; }
+    uint32_t GetLoginAttempts() const { return mLoginAttempts; }
+
+    // Traffic of the session, a ping with no acknowledgement was lost on
+    // the way there or back
+    struct SessionStats
+    {
+        uint64_t pingsSent{ 0 };
+        uint64_t acksReceived{ 0 };
+        uint64_t statesReceived{ 0 };
+    };
+
+    const SessionStats& GetSessionStats() const { return mSessionStats; }
+
 private:
     void TryLogin();
     void TryPing();
 
+    // Note a message from the server, the next ping acknowledges it
+    void Acknowledge(uint32_t messageId);
+
+    // Take the sequence from a compact header so the next message sent
+    // acknowledges it. Returns the full message id.
+    uint32_t ReceiveHeader(const Event& ev, uint32_t messageId);
+
+    // Acknowledgements to send the server, null when sending version 1
+    const Common::AckWindow* GetHeaderAcks() const;
+
+    // Follow the server's feedback on how early our inputs arrive
+    void AdjustInputLead(int16_t offset);
+
+    // Step this client's player locally if the cell looks free
+    bool Predict(Common::Position from, Common::Movement movement, Common::Position& to) const;
+
+    // Rebuild this client's position from the server's position at tick
+    // and the inputs the server has not run yet
+    void Reconcile(uint32_t tick, Common::Position authoritative);
+
+    // Forget the players the server removed from our view
+    void RemovePlayers(const Common::StateMessage& state);
+
 private:
     Params mParams;
     State mState{ State::New };
-    PlayerState* mThisPlayer{ nullptr };
+    Common::PlayerHandle mThisPlayer;
 
 private:
-    std::chrono::steady_clock::time_point mLoginAttemptTime;
+    static constexpr std::chrono::milliseconds kLoginInterval{ 500 };
+    static constexpr std::chrono::milliseconds kPingInterval{ 100 };
+
+    Common::TimerHandle mLoginTimer;
     uint32_t mLoginAttempts{ 0 };
-    std::chrono::steady_clock::time_point mLastPing;
+    std::chrono::steady_clock::time_point mLoginStart;
+    std::chrono::steady_clock::duration mLoginTime{ 0 };
+    SessionStats mSessionStats;
+    Common::TimerHandle mPingTimer;
+
+    // Messages received from the server
+    Common::AckWindow mServerAcks;
+
+    Common::RttEstimator mRtt;
+    Common::ClockOffsetEstimator mServerClock;
+    // Newest server timestamp received, echoed by the next ping
+    uint32_t mServerTime{ 0 };
+    std::chrono::steady_clock::time_point mServerTimeReceived;
+    bool mHasServerTime{ false };
+
+private:
+    // Inputs are stamped this many ticks ahead until the server says
+    // otherwise
+    static constexpr uint32_t kInitialInputLead = 2;
+
+    // Ticks between lead adjustments, so the effect of one change has
+    // time to show up in the feedback before the next
+    static constexpr uint32_t kLeadAdjustInterval = 8;
+
+    uint32_t mServerTick{ 0 };
+    std::chrono::steady_clock::time_point mServerTickTime;
+    uint32_t mInputLead{ kInitialInputLead };
+    uint32_t mTicksSinceLeadAdjust{ 0 };
+
+    Common::Prediction mPrediction;
+
+    // Snapshots of every remote player in view, by player id
+    std::unordered_map<uint32_t, Common::SnapshotBuffer> mSnapshots;
+
+    // Ticks a removal keeps older states from bringing the player back
+    static constexpr uint32_t kRemovedTicks = 64;
+
+    // Tick each recently removed player was removed at, by player id
+    std::unordered_map<uint32_t, uint32_t> mRemoved;
+    Common::SnapshotClock mSnapshotClock;
+    InterpolationStats mInterpolationStats;
 };
 }
@@ -6,6 +6,8 @@
 #include "GameLoop.h"
 #include "Tests.h"
 // Other Includes
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <Windows.h>
 
@@ -20,6 +22,21 @@ int main(int argc, char** argv)
     using namespace std::chrono_literals;
     using namespace Common;
 
+    uint32_t room = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--room") == 0 && i + 1 < argc)
+        {
+            room = uint32_t(strtoul(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--room <id>]\n";
+            return 1;
+        }
+    }
+
     auto CtrlHandler = [](DWORD ev) -> BOOL
     {
         switch (ev)
@@ -53,6 +70,7 @@ int main(int argc, char** argv)
     params.serverPort = 8088;
     params.clientAddress = "127.0.0.1";
     params.clientPort = 8081;
+    params.commonParams.room = room;
     Client::GameLoop game(params);
 
     UdpServer server(params.clientAddress, params.clientPort);
@@ -67,27 +85,16 @@ int main(int argc, char** argv)
         server.OnRecv(
             [&game](Common::NetworkMessage& msg)
             {
-                Span<const uint8_t> data(msg.buffer.Data(), msg.buffer.Size());
-                std::optional<Message> result = Serializer<Message>::Deserialize(data);
-
-                if (!result)
-                {
-                    std::cout << "invalid message received from '" << msg.address << "'";
-                }
-                else
-                {
-                    std::cout << "received message type '" << uint32_t(result->action) << "' from '"
-                        << msg.address << ':' << msg.port << "' (payload="
-                        << result->header.payloadSize << ", hash=" << result->header.hash
-                        << ")" << '\n';
-
-                    game.OnMessage(result->action, msg);
-                }
+                game.OnReceive(msg);
             });
 
         shutdownFn = [&server] { server.Shutdown(); };
     }
 
-    server.Run(30ms, [&game]() -> bool { return game.Tick(); });
+    server.Run(params.commonParams.tickInterval, [&game]() -> bool { return game.Tick(); });
+
+    game.PrintPredictionStats();
+    game.PrintInterpolationStats();
+    game.PrintClockStats();
     return 0;
 }
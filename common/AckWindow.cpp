@@ -0,0 +1,62 @@
+#include "AckWindow.h"
+
+namespace Common
+{
+uint32_t ExpandSequence(uint16_t sequence, uint32_t reference)
+{
+    return reference + uint32_t(int16_t(sequence - uint16_t(reference)));
+}
+
+uint32_t AckWindow::Receive(uint16_t sequence)
+{
+    if (!mHasReceived)
+    {
+        mHasReceived = true;
+        mLatest = sequence;
+        mBits = 0;
+        return mLatest;
+    }
+
+    const uint32_t full = ExpandSequence(sequence, mLatest);
+    const int32_t ahead = int32_t(full - mLatest);
+
+    if (ahead > 0)
+    {
+        // Slide the window forward, the previous newest becomes a bit
+        const uint32_t shift = uint32_t(ahead);
+        mBits = shift < kBits ? mBits << shift : 0;
+
+        if (shift <= kBits)
+        {
+            mBits |= 1u << (shift - 1);
+        }
+
+        mLatest = full;
+    }
+    else if (ahead < 0 && uint32_t(-ahead) <= kBits)
+    {
+        mBits |= 1u << (uint32_t(-ahead) - 1);
+    }
+
+    return full;
+}
+
+bool AckWindow::IsReceived(uint32_t sequence) const
+{
+    if (!mHasReceived)
+    {
+        return false;
+    }
+
+    const int32_t behind = int32_t(mLatest - sequence);
+
+    if (behind == 0)
+    {
+        return true;
+    }
+
+    return behind > 0
+        && uint32_t(behind) <= kBits
+        && (mBits & (1u << (uint32_t(behind) - 1))) != 0;
+}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Common.h"
+
+namespace Common
+{
+// The full sequence number closest to reference whose low 16 bits are
+// sequence, for widening the sequences carried by compact headers
+uint32_t ExpandSequence(uint16_t sequence, uint32_t reference);
+
+// Sequences received from one peer, in the form every compact header
+// sends them back: the newest one and a bit for each of the 32 before it.
+class AckWindow final
+{
+public:
+    static constexpr uint32_t kBits = 32;
+
+public:
+    AckWindow() = default;
+
+    // Note a message from the peer. Returns its full sequence number,
+    // widened around the newest received.
+    uint32_t Receive(uint16_t sequence);
+
+    // Whether sequence arrived, as far as the window reaches back
+    bool IsReceived(uint32_t sequence) const;
+
+    bool HasReceived() const { return mHasReceived; }
+    uint32_t GetLatest() const { return mLatest; }
+    uint16_t GetAck() const { return uint16_t(mLatest); }
+    uint32_t GetAckBits() const { return mBits; }
+
+private:
+    bool mHasReceived{ false };
+    uint32_t mLatest{ 0 };
+    // Bit n is set when mLatest - 1 - n arrived
+    uint32_t mBits{ 0 };
+};
+}
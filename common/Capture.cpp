@@ -0,0 +1,448 @@
+#include "Capture.h"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+namespace Common
+{
+namespace
+{
+// Size of the first mapping, doubled every time the capture outgrows it
+constexpr uint64_t kInitialCaptureSize = 16 * 1024 * 1024;
+
+constexpr uint64_t Align8(uint64_t value)
+{
+    return (value + 7) & ~uint64_t(7);
+}
+
+constexpr uint64_t kCaptureDataStart = Align8(sizeof(CaptureFileHeader));
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    Close();
+}
+
+bool CaptureWriter::Open(const std::string& path)
+{
+    using namespace std::chrono;
+
+    if (mFile)
+    {
+        return false;
+    }
+
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        const int err = int(GetLastError());
+
+        std::cout << "Failed to create capture file '" << path << "': [" << err
+            << "] " << ErrorToString(err) << '\n';
+
+        return false;
+    }
+
+    mFile = file;
+    mPath = path;
+
+    if (!Map(kInitialCaptureSize))
+    {
+        CloseHandle(mFile);
+        mFile = nullptr;
+        return false;
+    }
+
+    auto* header = reinterpret_cast<CaptureFileHeader*>(mView);
+    memset(header, 0, sizeof(CaptureFileHeader));
+    memcpy(header->magic, CaptureFileHeader::kMagic, sizeof(header->magic));
+    header->version = CaptureFileHeader::kVersion;
+    header->headerSize = uint32_t(kCaptureDataStart);
+    header->dataEnd = kCaptureDataStart;
+
+    mStart = steady_clock::now();
+    mIndex.clear();
+
+    std::cout << "Capturing received datagrams to '" << path << "'\n";
+    return true;
+}
+
+bool CaptureWriter::Map(uint64_t capacity)
+{
+    assert(mFile);
+    assert(!mView);
+
+    // Mapping a section larger than the file extends the file to match
+    HANDLE mapping = CreateFileMappingW(
+        mFile,
+        nullptr,
+        PAGE_READWRITE,
+        DWORD(capacity >> 32),
+        DWORD(capacity),
+        nullptr);
+
+    if (!mapping)
+    {
+        const int err = int(GetLastError());
+
+        std::cout << "Failed to map capture file '" << mPath << "': [" << err
+            << "] " << ErrorToString(err) << '\n';
+
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size_t(capacity));
+
+    if (!view)
+    {
+        const int err = int(GetLastError());
+
+        std::cout << "Failed to map view of capture file '" << mPath << "': [" << err
+            << "] " << ErrorToString(err) << '\n';
+
+        CloseHandle(mapping);
+        return false;
+    }
+
+    mMapping = mapping;
+    mView = static_cast<uint8_t*>(view);
+    mCapacity = capacity;
+
+    return true;
+}
+
+void CaptureWriter::Unmap()
+{
+    if (mView)
+    {
+        UnmapViewOfFile(mView);
+        mView = nullptr;
+    }
+    if (mMapping)
+    {
+        CloseHandle(mMapping);
+        mMapping = nullptr;
+    }
+    mCapacity = 0;
+}
+
+bool CaptureWriter::Reserve(uint64_t size)
+{
+    if (size <= mCapacity)
+    {
+        return true;
+    }
+
+    uint64_t capacity = mCapacity;
+    while (capacity < size)
+    {
+        capacity *= 2;
+    }
+
+    // The header lives inside the mapping so everything written so far is
+    // carried over by the file itself.
+    FlushViewOfFile(mView, 0);
+    Unmap();
+
+    return Map(capacity);
+}
+
+bool CaptureWriter::Append(
+    std::chrono::steady_clock::time_point time,
+    const uint8_t address[4],
+    uint32_t port,
+    Span<const uint8_t> data)
+{
+    using namespace std::chrono;
+
+    if (!IsOpen())
+    {
+        return false;
+    }
+
+    assert(data.size <= UINT16_MAX);
+
+    const uint64_t offset = reinterpret_cast<CaptureFileHeader*>(mView)->dataEnd;
+    const uint64_t size = Align8(sizeof(CaptureRecord) + data.size);
+
+    if (!Reserve(offset + size))
+    {
+        // We lost the mapping, stop capturing rather than corrupt the file
+        std::cout << "Capture to '" << mPath << "' stopped, unable to grow the file\n";
+        CloseHandle(mFile);
+        mFile = nullptr;
+        return false;
+    }
+
+    auto* header = reinterpret_cast<CaptureFileHeader*>(mView);
+    auto* record = reinterpret_cast<CaptureRecord*>(mView + offset);
+
+    record->timestamp = time > mStart
+        ? uint64_t(duration_cast<nanoseconds>(time - mStart).count())
+        : 0;
+    memcpy(record->address, address, sizeof(record->address));
+    record->port = uint16_t(port);
+    record->size = uint16_t(data.size);
+
+    uint8_t* payload = mView + offset + sizeof(CaptureRecord);
+    memcpy(payload, data.data, data.size);
+    memset(payload + data.size, 0, size - sizeof(CaptureRecord) - data.size);
+
+    if (header->recordCount % kCaptureIndexStride == 0)
+    {
+        mIndex.push_back({ record->timestamp, header->recordCount, offset });
+    }
+
+    header->recordCount += 1;
+    header->dataEnd = offset + size;
+
+    return true;
+}
+
+bool CaptureWriter::Close()
+{
+    if (!mFile)
+    {
+        return false;
+    }
+
+    bool result = false;
+
+    if (IsOpen())
+    {
+        const uint64_t indexOffset = reinterpret_cast<CaptureFileHeader*>(mView)->dataEnd;
+        const uint64_t indexSize = mIndex.size() * sizeof(CaptureIndexEntry);
+
+        if (Reserve(indexOffset + indexSize))
+        {
+            auto* header = reinterpret_cast<CaptureFileHeader*>(mView);
+
+            if (indexSize)
+            {
+                memcpy(mView + indexOffset, mIndex.data(), indexSize);
+            }
+            header->indexOffset = indexOffset;
+            header->indexCount = mIndex.size();
+
+            std::cout << "Closed capture '" << mPath << "' with " << header->recordCount
+                << " records\n";
+
+            FlushViewOfFile(mView, 0);
+            Unmap();
+
+            // Drop the unused tail of the last mapping
+            LARGE_INTEGER end;
+            end.QuadPart = LONGLONG(indexOffset + indexSize);
+            result = SetFilePointerEx(mFile, end, nullptr, FILE_BEGIN)
+                && SetEndOfFile(mFile);
+        }
+    }
+
+    Unmap();
+    CloseHandle(mFile);
+    mFile = nullptr;
+    mIndex.clear();
+
+    return result;
+}
+
+uint64_t CaptureWriter::GetRecordCount() const
+{
+    return IsOpen()
+        ? reinterpret_cast<const CaptureFileHeader*>(mView)->recordCount
+        : 0;
+}
+
+CaptureReader::~CaptureReader()
+{
+    Close();
+}
+
+bool CaptureReader::Open(const std::string& path)
+{
+    Close();
+
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        const int err = int(GetLastError());
+
+        std::cout << "Failed to open capture file '" << path << "': [" << err
+            << "] " << ErrorToString(err) << '\n';
+
+        return false;
+    }
+
+    mFile = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || uint64_t(size.QuadPart) < kCaptureDataStart)
+    {
+        std::cout << "Capture file '" << path << "' is too small\n";
+        Close();
+        return false;
+    }
+
+    mSize = uint64_t(size.QuadPart);
+    mMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mMapping)
+    {
+        mView = static_cast<const uint8_t*>(
+            MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    }
+
+    if (!mView)
+    {
+        const int err = int(GetLastError());
+
+        std::cout << "Failed to map capture file '" << path << "': [" << err
+            << "] " << ErrorToString(err) << '\n';
+
+        Close();
+        return false;
+    }
+
+    const auto* header = reinterpret_cast<const CaptureFileHeader*>(mView);
+
+    if (memcmp(header->magic, CaptureFileHeader::kMagic, sizeof(header->magic)) != 0
+        || header->version != CaptureFileHeader::kVersion
+        || header->headerSize < sizeof(CaptureFileHeader)
+        || header->dataEnd > mSize
+        || header->dataEnd < header->headerSize)
+    {
+        std::cout << "Capture file '" << path << "' has an invalid header\n";
+        Close();
+        return false;
+    }
+
+    mDataStart = header->headerSize;
+    mDataEnd = header->dataEnd;
+    mRecordCount = header->recordCount;
+    mOffset = mDataStart;
+
+    // The index is optional, a capture which was never closed has none
+    if (header->indexOffset >= header->dataEnd
+        && header->indexCount <= (mSize - header->indexOffset) / sizeof(CaptureIndexEntry))
+    {
+        mIndex = Span<const CaptureIndexEntry>(
+            reinterpret_cast<const CaptureIndexEntry*>(mView + header->indexOffset),
+            size_t(header->indexCount));
+    }
+
+    return true;
+}
+
+void CaptureReader::Close()
+{
+    if (mView)
+    {
+        UnmapViewOfFile(mView);
+        mView = nullptr;
+    }
+    if (mMapping)
+    {
+        CloseHandle(mMapping);
+        mMapping = nullptr;
+    }
+    if (mFile)
+    {
+        CloseHandle(mFile);
+        mFile = nullptr;
+    }
+
+    mSize = 0;
+    mDataStart = 0;
+    mDataEnd = 0;
+    mRecordCount = 0;
+    mOffset = 0;
+    mIndex = {};
+}
+
+bool CaptureReader::Next(Record& record)
+{
+    if (!mView || mOffset + sizeof(CaptureRecord) > mDataEnd)
+    {
+        return false;
+    }
+
+    const auto* entry = reinterpret_cast<const CaptureRecord*>(mView + mOffset);
+    const uint64_t end = mOffset + sizeof(CaptureRecord) + entry->size;
+
+    if (end > mDataEnd)
+    {
+        return false;
+    }
+
+    record.timestamp = entry->timestamp;
+    memcpy(record.address, entry->address, sizeof(record.address));
+    record.port = entry->port;
+    record.data = Span<const uint8_t>(
+        mView + mOffset + sizeof(CaptureRecord),
+        entry->size);
+
+    mOffset = Align8(end);
+    return true;
+}
+
+void CaptureReader::Rewind()
+{
+    mOffset = mDataStart;
+}
+
+void CaptureReader::SeekTime(uint64_t timestamp)
+{
+    Rewind();
+
+    // Jump to the closest indexed record before the timestamp
+    const CaptureIndexEntry* begin = mIndex.data;
+    const CaptureIndexEntry* end = mIndex.data + mIndex.size;
+    const CaptureIndexEntry* it = std::upper_bound(begin, end, timestamp,
+        [](uint64_t value, const CaptureIndexEntry& entry)
+        {
+            return value < entry.timestamp;
+        });
+
+    if (it != begin)
+    {
+        mOffset = (it - 1)->offset;
+    }
+
+    // Then scan forward to the first record at or after it
+    for (;;)
+    {
+        const uint64_t offset = mOffset;
+        Record record;
+
+        if (!Next(record))
+        {
+            break;
+        }
+        if (record.timestamp >= timestamp)
+        {
+            mOffset = offset;
+            break;
+        }
+    }
+}
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Common.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Common
+{
+// Packet capture file. Every datagram the server receives is appended as
+// a record holding a monotonic timestamp, the source endpoint and the raw
+// bytes. The file is written through a memory mapping so appending a
+// record is a copy into the page cache with no system call.
+//
+// Layout (host byte order):
+//   CaptureFileHeader
+//   CaptureRecord, payload, padding to 8 bytes   (repeated)
+//   CaptureIndexEntry                            (indexCount entries)
+//
+// The header keeps recordCount/dataEnd current after every append, so a
+// capture that was never closed can still be read back. The index is only
+// written by Close() and holds one entry every kCaptureIndexStride records
+// for seeking by time.
+#pragma pack(push, 1)
+struct CaptureFileHeader
+{
+    static constexpr uint8_t kMagic[8] = { 'U', 'D', 'P', 'C', 'A', 'P', 0, 0 };
+    static constexpr uint32_t kVersion = 1;
+
+    uint8_t magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t recordCount;
+    uint64_t dataEnd;      // Offset one past the last record
+    uint64_t indexOffset;  // Zero if the capture was not closed
+    uint64_t indexCount;
+};
+
+struct CaptureRecord
+{
+    uint64_t timestamp;  // Nanoseconds since the capture started
+    uint8_t address[4];  // IPv4 source address, network order
+    uint16_t port;       // Source port
+    uint16_t size;       // Number of payload bytes following the record
+};
+
+struct CaptureIndexEntry
+{
+    uint64_t timestamp;
+    uint64_t record;
+    uint64_t offset;
+};
+#pragma pack(pop)
+
+constexpr size_t kCaptureIndexStride = 64;
+
+// Appends received datagrams to a capture file.
+class CaptureWriter final
+{
+public:
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+public:
+    CaptureWriter() = default;
+    ~CaptureWriter();
+
+    bool Open(const std::string& path);
+    bool Append(
+        std::chrono::steady_clock::time_point time,
+        const uint8_t address[4],
+        uint32_t port,
+        Span<const uint8_t> data);
+    // Write the index and truncate the file to its final size
+    bool Close();
+
+    bool IsOpen() const { return mView != nullptr; }
+    uint64_t GetRecordCount() const;
+
+private:
+    bool Map(uint64_t capacity);
+    void Unmap();
+    // Grow the mapping so at least size bytes of the file are mapped
+    bool Reserve(uint64_t size);
+
+private:
+    std::string mPath;
+    void* mFile{ nullptr };
+    void* mMapping{ nullptr };
+    uint8_t* mView{ nullptr };
+    uint64_t mCapacity{ 0 };
+    std::chrono::steady_clock::time_point mStart;
+    std::vector<CaptureIndexEntry> mIndex;
+};
+
+// Reads the records of a capture file through a read-only mapping. The
+// record payloads point directly into the mapping.
+class CaptureReader final
+{
+public:
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+public:
+    struct Record
+    {
+        uint64_t timestamp{ 0 };
+        uint8_t address[4] = { 0, 0, 0, 0 };
+        uint32_t port{ 0 };
+        Span<const uint8_t> data;
+    };
+
+public:
+    CaptureReader() = default;
+    ~CaptureReader();
+
+    bool Open(const std::string& path);
+    void Close();
+
+    uint64_t GetRecordCount() const { return mRecordCount; }
+
+    // Read the next record, returns false at the end of the capture
+    bool Next(Record& record);
+
+    // Start reading from the first record
+    void Rewind();
+
+    // Position the reader at the first record at or after timestamp
+    void SeekTime(uint64_t timestamp);
+
+private:
+    void* mFile{ nullptr };
+    void* mMapping{ nullptr };
+    const uint8_t* mView{ nullptr };
+    uint64_t mSize{ 0 };
+    uint64_t mDataStart{ 0 };
+    uint64_t mDataEnd{ 0 };
+    uint64_t mRecordCount{ 0 };
+    uint64_t mOffset{ 0 };
+    Span<const CaptureIndexEntry> mIndex;
+};
+}
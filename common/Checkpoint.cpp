@@ -0,0 +1,356 @@
+#include "Checkpoint.h"
+
+#include "Message.h"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+namespace Common
+{
+namespace
+{
+constexpr uint64_t Align8(uint64_t value)
+{
+    return (value + 7) & ~uint64_t(7);
+}
+
+constexpr uint64_t kCheckpointPlayersStart = Align8(sizeof(CheckpointHeader));
+
+uint32_t PlayersChecksum(const void* players, uint64_t count)
+{
+    return FNV1A_32(players, size_t(count * sizeof(CheckpointPlayer)));
+}
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    Close();
+}
+
+bool CheckpointWriter::Open(const std::string& path)
+{
+    if (IsOpen())
+    {
+        return false;
+    }
+
+    mPath = path;
+    mPending = false;
+    mStopping = false;
+    mThread = std::thread([this] { Work(); });
+
+    std::cout << "Writing checkpoints to '" << path << "'\n";
+    return true;
+}
+
+void CheckpointWriter::Close()
+{
+    if (!IsOpen())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+
+    mCond.notify_all();
+    mThread.join();
+}
+
+bool CheckpointWriter::Begin(
+    size_t playerCount,
+    CheckpointHeader*& header,
+    Span<CheckpointPlayer>& players)
+{
+    std::lock_guard lock(mMutex);
+
+    if (!IsOpen() || mPending)
+    {
+        ++mStats.skipped;
+        return false;
+    }
+
+    const uint64_t size = kCheckpointPlayersStart + playerCount * sizeof(CheckpointPlayer);
+
+    // Keeps its capacity, only a growing game allocates
+    mStaging.assign(size_t(size), 0);
+
+    header = reinterpret_cast<CheckpointHeader*>(mStaging.data());
+    memcpy(header->magic, CheckpointHeader::kMagic, sizeof(header->magic));
+    header->version = CheckpointHeader::kVersion;
+    header->headerSize = uint32_t(sizeof(CheckpointHeader));
+    header->fileSize = size;
+    header->playerCount = playerCount;
+    header->playersOffset = kCheckpointPlayersStart;
+    header->playerSize = uint32_t(sizeof(CheckpointPlayer));
+
+    players = Span<CheckpointPlayer>(
+        reinterpret_cast<CheckpointPlayer*>(mStaging.data() + kCheckpointPlayersStart),
+        playerCount);
+
+    return true;
+}
+
+void CheckpointWriter::Commit()
+{
+    {
+        std::lock_guard lock(mMutex);
+        assert(!mPending);
+        mPending = true;
+    }
+
+    mCond.notify_all();
+}
+
+void CheckpointWriter::Wait()
+{
+    std::unique_lock lock(mMutex);
+    mCond.wait(lock, [this] { return !mPending; });
+}
+
+CheckpointWriter::Stats CheckpointWriter::GetStats() const
+{
+    std::lock_guard lock(mMutex);
+    return mStats;
+}
+
+void CheckpointWriter::Work()
+{
+    using namespace std::chrono;
+
+    std::unique_lock lock(mMutex);
+
+    while (true)
+    {
+        mCond.wait(lock, [this] { return mPending || mStopping; });
+
+        if (!mPending)
+        {
+            return;
+        }
+
+        lock.unlock();
+
+        const steady_clock::time_point start = steady_clock::now();
+
+        auto* header = reinterpret_cast<CheckpointHeader*>(mStaging.data());
+        header->checksum = PlayersChecksum(
+            mStaging.data() + header->playersOffset,
+            header->playerCount);
+
+        const bool written = Write(mStaging);
+        const steady_clock::duration elapsed = steady_clock::now() - start;
+
+        lock.lock();
+
+        mStats.written += written ? 1 : 0;
+        mStats.failed += written ? 0 : 1;
+        mStats.lastSize = written ? mStaging.size() : mStats.lastSize;
+        mStats.maxWriteTime = std::max(mStats.maxWriteTime, elapsed);
+        mPending = false;
+
+        mCond.notify_all();
+    }
+}
+
+bool CheckpointWriter::Write(const std::vector<uint8_t>& data)
+{
+    const std::string temporary = mPath + ".tmp";
+
+    HANDLE file = CreateFileA(
+        temporary.c_str(),
+        GENERIC_READ | GENERIC_WRITE,
+        0,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        const int err = int(GetLastError());
+
+        std::cout << "Failed to create checkpoint file '" << temporary << "': [" << err
+            << "] " << ErrorToString(err) << '\n';
+
+        return false;
+    }
+
+    const uint64_t size = data.size();
+
+    // Mapping a section larger than the file extends the file to match
+    HANDLE mapping = CreateFileMappingW(
+        file,
+        nullptr,
+        PAGE_READWRITE,
+        DWORD(size >> 32),
+        DWORD(size),
+        nullptr);
+
+    void* view = mapping
+        ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size_t(size))
+        : nullptr;
+
+    bool result = view != nullptr;
+
+    if (view)
+    {
+        memcpy(view, data.data(), data.size());
+        result = FlushViewOfFile(view, 0) && FlushFileBuffers(file);
+        UnmapViewOfFile(view);
+    }
+    else
+    {
+        const int err = int(GetLastError());
+
+        std::cout << "Failed to map checkpoint file '" << temporary << "': [" << err
+            << "] " << ErrorToString(err) << '\n';
+    }
+
+    if (mapping)
+    {
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+
+    // Only a whole checkpoint replaces the previous one
+    if (result && !MoveFileExA(
+        temporary.c_str(),
+        mPath.c_str(),
+        MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        const int err = int(GetLastError());
+
+        std::cout << "Failed to replace checkpoint '" << mPath << "': [" << err
+            << "] " << ErrorToString(err) << '\n';
+
+        result = false;
+    }
+
+    if (!result)
+    {
+        DeleteFileA(temporary.c_str());
+    }
+
+    return result;
+}
+
+CheckpointReader::~CheckpointReader()
+{
+    Close();
+}
+
+bool CheckpointReader::Open(const std::string& path)
+{
+    Close();
+
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        const int err = int(GetLastError());
+
+        std::cout << "Failed to open checkpoint '" << path << "': [" << err
+            << "] " << ErrorToString(err) << '\n';
+
+        return false;
+    }
+
+    mFile = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || uint64_t(size.QuadPart) < sizeof(CheckpointHeader))
+    {
+        std::cout << "Checkpoint '" << path << "' is too small\n";
+        Close();
+        return false;
+    }
+
+    mMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mMapping)
+    {
+        mView = static_cast<const uint8_t*>(
+            MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    }
+
+    if (!mView)
+    {
+        const int err = int(GetLastError());
+
+        std::cout << "Failed to map checkpoint '" << path << "': [" << err
+            << "] " << ErrorToString(err) << '\n';
+
+        Close();
+        return false;
+    }
+
+    const auto* header = reinterpret_cast<const CheckpointHeader*>(mView);
+    const uint64_t fileSize = uint64_t(size.QuadPart);
+
+    if (memcmp(header->magic, CheckpointHeader::kMagic, sizeof(header->magic)) != 0
+        || header->version != CheckpointHeader::kVersion
+        || header->headerSize < sizeof(CheckpointHeader)
+        || header->fileSize != fileSize
+        || header->playerSize != sizeof(CheckpointPlayer)
+        || header->playersOffset < header->headerSize
+        || header->playersOffset > fileSize
+        || header->playerCount > (fileSize - header->playersOffset) / sizeof(CheckpointPlayer))
+    {
+        std::cout << "Checkpoint '" << path << "' has an invalid header\n";
+        Close();
+        return false;
+    }
+
+    const uint8_t* players = mView + header->playersOffset;
+
+    if (PlayersChecksum(players, header->playerCount) != header->checksum)
+    {
+        std::cout << "Checkpoint '" << path << "' is corrupt\n";
+        Close();
+        return false;
+    }
+
+    mHeader = header;
+    mPlayers = Span<const CheckpointPlayer>(
+        reinterpret_cast<const CheckpointPlayer*>(players),
+        size_t(header->playerCount));
+
+    return true;
+}
+
+void CheckpointReader::Close()
+{
+    if (mView)
+    {
+        UnmapViewOfFile(mView);
+        mView = nullptr;
+    }
+    if (mMapping)
+    {
+        CloseHandle(mMapping);
+        mMapping = nullptr;
+    }
+    if (mFile)
+    {
+        CloseHandle(mFile);
+        mFile = nullptr;
+    }
+
+    mHeader = nullptr;
+    mPlayers = {};
+}
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "Common.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Common
+{
+// Checkpoint of a game, for resuming it after a restart. Every field is a
+// fixed size, so a checkpoint is used straight from a read-only mapping
+// of the file without parsing it.
+//
+// Layout (host byte order):
+//   CheckpointHeader
+//   CheckpointPlayer   (playerCount entries, at playersOffset)
+//
+// The board is not stored, the occupied cells are those of the players,
+// so the size of a checkpoint and the time to resume from it follow the
+// number of players and not the size of the board. Each checkpoint is
+// written to a temporary file which then replaces the previous one, so
+// the file on disk is always a whole checkpoint.
+#pragma pack(push, 1)
+struct CheckpointHeader
+{
+    static constexpr uint8_t kMagic[8] = { 'G', 'A', 'M', 'E', 'C', 'K', 'P', 'T' };
+    static constexpr uint32_t kVersion = 1;
+
+    uint8_t magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    // Board the checkpoint was taken on
+    uint32_t width;
+    uint32_t height;
+    // Next tick the game runs
+    uint32_t tick;
+    // Id the next player to log in gets
+    uint32_t nextPlayerId;
+    uint64_t playerCount;
+    uint64_t playersOffset;
+    // Size of one player record, so a changed layout is caught
+    uint32_t playerSize;
+    // FNV-1a of the player records
+    uint32_t checksum;
+};
+
+struct CheckpointPlayer
+{
+    uint32_t id;
+    // UINT32_MAX while the player is not on the board
+    uint32_t x;
+    uint32_t y;
+    // Message id the next message to the player gets
+    uint32_t nextMessage;
+    uint8_t address[4];  // IPv4 address, network order
+    uint16_t port;
+    uint8_t compact;
+    uint8_t reserved;
+};
+#pragma pack(pop)
+
+// Writes checkpoints on a thread of its own. The caller fills in a staging
+// buffer, which costs a copy of the players, and the file is written while
+// the game carries on ticking.
+class CheckpointWriter final
+{
+public:
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+public:
+    struct Stats
+    {
+        uint64_t written{ 0 };
+        // Not taken as the previous checkpoint was still being written
+        uint64_t skipped{ 0 };
+        uint64_t failed{ 0 };
+        uint64_t lastSize{ 0 };
+        std::chrono::steady_clock::duration maxWriteTime{ 0 };
+    };
+
+public:
+    CheckpointWriter() = default;
+    ~CheckpointWriter();
+
+    bool Open(const std::string& path);
+
+    // Finish the checkpoint being written and stop the thread
+    void Close();
+
+    bool IsOpen() const { return mThread.joinable(); }
+
+    // Staging buffer for a checkpoint of playerCount players, with the
+    // layout fields of the header set. Returns false, and the checkpoint
+    // is skipped, while the previous one is still being written.
+    bool Begin(
+        size_t playerCount,
+        CheckpointHeader*& header,
+        Span<CheckpointPlayer>& players);
+
+    // Hand the staging buffer to the thread, which seals and writes it
+    void Commit();
+
+    // Wait until the thread is done with the last checkpoint committed
+    void Wait();
+
+    Stats GetStats() const;
+
+private:
+    void Work();
+    bool Write(const std::vector<uint8_t>& data);
+
+private:
+    std::string mPath;
+    std::thread mThread;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCond;
+    // Owned by the thread from Commit() until it clears mPending
+    std::vector<uint8_t> mStaging;
+    bool mPending{ false };
+    bool mStopping{ false };
+    Stats mStats;
+};
+
+// Maps a checkpoint read-only. The header and the player records point
+// into the mapping, they are valid until Close().
+class CheckpointReader final
+{
+public:
+    CheckpointReader(const CheckpointReader&) = delete;
+    CheckpointReader& operator=(const CheckpointReader&) = delete;
+
+public:
+    CheckpointReader() = default;
+    ~CheckpointReader();
+
+    // Map the file and check it is a whole checkpoint of this version
+    bool Open(const std::string& path);
+    void Close();
+
+    const CheckpointHeader* GetHeader() const { return mHeader; }
+    Span<const CheckpointPlayer> GetPlayers() const { return mPlayers; }
+
+private:
+    void* mFile{ nullptr };
+    void* mMapping{ nullptr };
+    const uint8_t* mView{ nullptr };
+    const CheckpointHeader* mHeader{ nullptr };
+    Span<const CheckpointPlayer> mPlayers;
+};
+}
@@ -0,0 +1,330 @@
+#include "Compression.h"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+
+namespace Common
+{
+namespace
+{
+// Serialized payload shapes (everything after the MessageHeader) for the
+// messages we send most often. Fields which vary per message are left as
+// their most common values: small big endian counters, loopback addresses
+// and zeroed 64-bit identifiers. Entries near the end are the most
+// frequent. State entries are bit packed and vary per tick, so only the
+// fields ahead of them are worth keeping.
+constexpr uint8_t kLzDictionary[] = {
+    // Runs of zeros found in unused and 64-bit fields
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    // Login: action, messageId, session, address, port
+    0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x01, 0x7F, 0x00, 0x00, 0x01,
+    0x1F, 0x91,
+    // Acknowledge: action, messageId, acknowledged messageId
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+    // Ping: action, messageId, playerId, acknowledged messageId
+    0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x01,
+    // State: action, messageId, tick, inputOffset, a full count
+    0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x01,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x20,
+};
+
+constexpr size_t kLzDictionarySize = sizeof(kLzDictionary);
+
+// Distances are encoded in 16 bits which bounds the reachable history
+constexpr size_t kLzMaxDistance = 0xFFFF;
+
+static_assert(kLzDictionarySize + kLzMaxInputSize < 0xFFFF,
+    "Virtual positions must fit in the 16-bit hash table");
+
+constexpr uint32_t kLzHashBits = 11;
+constexpr size_t kLzHashSize = size_t(1) << kLzHashBits;
+
+using HashTable = std::array<uint16_t, kLzHashSize>;
+
+uint32_t Hash(uint32_t value)
+{
+    return (value * 2654435761u) >> (32 - kLzHashBits);
+}
+
+// The input is addressed as if it immediately followed the dictionary.
+// This lets matches cross from the dictionary into the input.
+struct History
+{
+    const uint8_t* input{ nullptr };
+    size_t size{ 0 };
+
+    uint8_t At(size_t v) const
+    {
+        return v < kLzDictionarySize
+            ? kLzDictionary[v]
+            : input[v - kLzDictionarySize];
+    }
+
+    uint32_t Load32(size_t v) const
+    {
+        if (v >= kLzDictionarySize)
+        {
+            uint32_t value;
+            memcpy(&value, input + (v - kLzDictionarySize), sizeof(value));
+            return value;
+        }
+
+        uint8_t bytes[4] = { At(v), At(v + 1), At(v + 2), At(v + 3) };
+        uint32_t value;
+        memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+};
+
+// Hash table with every dictionary position already inserted. Built once
+// and copied at the start of each block.
+const HashTable& GetDictionaryTable()
+{
+    static const HashTable table = []
+    {
+        HashTable t;
+        t.fill(0);
+
+        History history;
+        for (size_t v = 0; v + kLzMinMatch <= kLzDictionarySize; ++v)
+        {
+            t[Hash(history.Load32(v))] = uint16_t(v + 1);
+        }
+        return t;
+    }();
+
+    return table;
+}
+
+class SequenceWriter final
+{
+public:
+    SequenceWriter(Span<uint8_t> output)
+        : mData(output.data)
+        , mEnd(output.data + output.size)
+        , mOut(output.data)
+    { }
+
+    size_t Size() const { return mOverflow ? 0 : size_t(mOut - mData); }
+
+    void Write(
+        const uint8_t* literals,
+        size_t literalCount,
+        size_t distance,
+        size_t matchLength)
+    {
+        const size_t matchCode = matchLength ? matchLength - kLzMinMatch : 0;
+
+        Put(uint8_t((Nibble(literalCount) << 4) | Nibble(matchCode)));
+        PutLength(literalCount);
+        PutBytes(literals, literalCount);
+
+        if (matchLength)
+        {
+            Put(uint8_t(distance));
+            Put(uint8_t(distance >> 8));
+            PutLength(matchCode);
+        }
+    }
+
+private:
+    static size_t Nibble(size_t value) { return value < 15 ? value : 15; }
+
+    void Put(uint8_t value)
+    {
+        if (mOut >= mEnd)
+        {
+            mOverflow = true;
+            return;
+        }
+        *mOut++ = value;
+    }
+
+    void PutBytes(const uint8_t* data, size_t size)
+    {
+        if (size_t(mEnd - mOut) < size)
+        {
+            mOverflow = true;
+            return;
+        }
+        memcpy(mOut, data, size);
+        mOut += size;
+    }
+
+    // Lengths of 15 or more continue in extra bytes after the token
+    void PutLength(size_t value)
+    {
+        if (value < 15)
+        {
+            return;
+        }
+        for (value -= 15; value >= 255; value -= 255)
+        {
+            Put(255);
+        }
+        Put(uint8_t(value));
+    }
+
+private:
+    uint8_t* mData{ nullptr };
+    uint8_t* mEnd{ nullptr };
+    uint8_t* mOut{ nullptr };
+    bool mOverflow{ false };
+};
+}
+
+Span<const uint8_t> GetLzDictionary()
+{
+    return { kLzDictionary, kLzDictionarySize };
+}
+
+size_t LzCompress(Span<const uint8_t> input, Span<uint8_t> output)
+{
+    if (input.size == 0 || input.size > kLzMaxInputSize)
+    {
+        return 0;
+    }
+
+    HashTable table = GetDictionaryTable();
+    History history{ input.data, input.size };
+    SequenceWriter writer(output);
+
+    const size_t end = kLzDictionarySize + input.size;
+    size_t anchor = kLzDictionarySize;
+    size_t v = kLzDictionarySize;
+
+    while (v + kLzMinMatch <= end)
+    {
+        const uint32_t value = history.Load32(v);
+        const uint32_t h = Hash(value);
+        const size_t candidate = table[h];
+
+        table[h] = uint16_t(v + 1);
+
+        if (candidate == 0
+            || v - (candidate - 1) > kLzMaxDistance
+            || history.Load32(candidate - 1) != value)
+        {
+            ++v;
+            continue;
+        }
+
+        // Extend the match as far as the input allows
+        const size_t match = candidate - 1;
+        size_t length = kLzMinMatch;
+
+        while (v + length < end && history.At(match + length) == history.At(v + length))
+        {
+            ++length;
+        }
+
+        writer.Write(
+            input.data + (anchor - kLzDictionarySize),
+            v - anchor,
+            v - match,
+            length);
+
+        v += length;
+        anchor = v;
+    }
+
+    // Trailing literals which did not end in a match
+    writer.Write(
+        input.data + (anchor - kLzDictionarySize),
+        end - anchor,
+        0, 0);
+
+    return writer.Size();
+}
+
+size_t LzDecompress(Span<const uint8_t> input, Span<uint8_t> output)
+{
+    const uint8_t* ip = input.data;
+    const uint8_t* const ie = input.data + input.size;
+    size_t o = 0;
+
+    auto ReadLength = [&](size_t value, size_t& length) -> bool
+    {
+        length = value;
+        if (value < 15)
+        {
+            return true;
+        }
+        for (;;)
+        {
+            if (ip >= ie || length > kLzMaxInputSize)
+            {
+                return false;
+            }
+            const uint8_t next = *ip++;
+            length += next;
+            if (next != 255)
+            {
+                return true;
+            }
+        }
+    };
+
+    while (ip < ie)
+    {
+        const uint8_t token = *ip++;
+
+        size_t literals = 0;
+        if (!ReadLength(token >> 4, literals)
+            || size_t(ie - ip) < literals
+            || output.size - o < literals)
+        {
+            return 0;
+        }
+
+        memcpy(output.data + o, ip, literals);
+        ip += literals;
+        o += literals;
+
+        if (ip == ie)
+        {
+            // The last sequence has no match
+            break;
+        }
+        if (ie - ip < 2)
+        {
+            return 0;
+        }
+
+        const size_t distance = size_t(ip[0]) | (size_t(ip[1]) << 8);
+        ip += 2;
+
+        size_t length = 0;
+        if (!ReadLength(token & 0x0F, length))
+        {
+            return 0;
+        }
+        length += kLzMinMatch;
+
+        if (distance == 0
+            || distance > kLzDictionarySize + o
+            || output.size - o < length)
+        {
+            return 0;
+        }
+
+        // Copy byte by byte, the match may overlap the bytes being written
+        // or start inside the dictionary.
+        size_t v = kLzDictionarySize + o - distance;
+        for (size_t i = 0; i < length; ++i, ++v)
+        {
+            output.data[o++] = v < kLzDictionarySize
+                ? kLzDictionary[v]
+                : output.data[v - kLzDictionarySize];
+        }
+    }
+
+    return o;
+}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Common.h"
+
+namespace Common
+{
+// Small LZ77 family block codec used to shrink message payloads. The
+// format is a sequence of (literals, match) pairs similar to LZ4: a token
+// byte holds the literal count in the high nibble and the match length in
+// the low nibble, both extended with 255 continuation bytes, followed by
+// the literals and a 16-bit little endian match distance. The final
+// sequence carries literals only.
+//
+// Matches may reach back into a static dictionary which is logically
+// placed in front of every block. The dictionary holds the serialized
+// shapes of our messages so even a single small message finds matches.
+
+// Largest block the codec will accept as input
+constexpr size_t kLzMaxInputSize = 32 * 1024;
+
+// Shortest match worth encoding
+constexpr size_t kLzMinMatch = 4;
+
+// Static dictionary shared by both ends of the connection. Changing the
+// contents is a protocol change.
+Span<const uint8_t> GetLzDictionary();
+
+// Compress input into output. Returns the compressed size or 0 if the
+// output span is too small to hold the result.
+size_t LzCompress(Span<const uint8_t> input, Span<uint8_t> output);
+
+// Decompress input into output. Returns the decompressed size or 0 if the
+// input is malformed or the output span is too small.
+size_t LzDecompress(Span<const uint8_t> input, Span<uint8_t> output);
+}
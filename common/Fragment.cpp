@@ -0,0 +1,311 @@
+#include "Fragment.h"
+
+#include "Memory.h"
+#include "Network.h"
+
+#include <algorithm>
+
+namespace Common
+{
+namespace
+{
+// The checksum covers the header after it and the data
+constexpr size_t kChecksumOffset = 1 + sizeof(uint32_t);
+
+uint64_t GetSenderKey(const uint8_t address[4], uint32_t source)
+{
+    const uint64_t ip = (uint64_t(address[0]) << 24)
+        | (uint64_t(address[1]) << 16)
+        | (uint64_t(address[2]) << 8)
+        | uint64_t(address[3]);
+
+    return (ip << 32) | source;
+}
+}
+
+bool IsFragment(Span<const uint8_t> input)
+{
+    return input.size >= kFragmentHeaderSize && input.data[0] == FragmentHeader::kMagic;
+}
+
+size_t WriteFragment(
+    Span<const uint8_t> message,
+    uint32_t source,
+    uint16_t group,
+    uint32_t index,
+    Span<uint8_t> output)
+{
+    const size_t count = GetFragmentCount(message.size);
+
+    if (message.size == 0 || message.size > kMaxMessageSize || index >= count)
+    {
+        return 0;
+    }
+
+    const size_t offset = index * kFragmentPayload;
+    const size_t chunk = std::min(kFragmentPayload, message.size - offset);
+    const size_t size = kFragmentHeaderSize + chunk;
+
+    if (output.size < size)
+    {
+        return 0;
+    }
+
+    MemoryWriter writer(output.data, kFragmentHeaderSize);
+    output.data[0] = FragmentHeader::kMagic;
+    writer.Put32_BE(kChecksumOffset, source);
+    writer.Put16_BE(group);
+    {
+        const uint8_t fields[] = { uint8_t(index), uint8_t(count) };
+        writer.Put(fields, sizeof(fields));
+    }
+    writer.Put16_BE(uint16_t(message.size));
+
+    memcpy(output.data + kFragmentHeaderSize, message.data + offset, chunk);
+
+    const uint32_t checksum = FNV1A_32(
+        output.data + kChecksumOffset,
+        size - kChecksumOffset);
+
+    writer.Put32_BE(1, checksum);
+
+    return size;
+}
+
+bool ReadFragment(
+    Span<const uint8_t> input,
+    FragmentHeader& header,
+    Span<const uint8_t>& data)
+{
+    if (!IsFragment(input))
+    {
+        return false;
+    }
+
+    MemoryReader reader(input.data, kFragmentHeaderSize);
+
+    header.magic = reader.Read();
+    header.checksum = reader.Read32_BE();
+    header.source = reader.Read32_BE();
+    header.group = reader.Read16_BE();
+    header.index = reader.Read();
+    header.count = reader.Read();
+    header.size = reader.Read16_BE();
+
+    if (header.size == 0
+        || header.size > kMaxMessageSize
+        || header.count != GetFragmentCount(header.size)
+        || header.index >= header.count)
+    {
+        return false;
+    }
+
+    // Every piece but the last is full, so each lands at a fixed offset
+    const size_t offset = header.index * kFragmentPayload;
+    const size_t chunk = std::min(kFragmentPayload, size_t(header.size) - offset);
+
+    if (input.size != kFragmentHeaderSize + chunk)
+    {
+        return false;
+    }
+
+    if (header.checksum != FNV1A_32(input.data + kChecksumOffset, input.size - kChecksumOffset))
+    {
+        return false;
+    }
+
+    data = input.Subspan(kFragmentHeaderSize);
+    return true;
+}
+
+FragmentAssembler::Result FragmentAssembler::Add(
+    const std::string& address,
+    Span<const uint8_t> input,
+    Clock::time_point now,
+    Span<const uint8_t>& message)
+{
+    if (mComplete)
+    {
+        if (mPool.size() < kMaxPooled)
+        {
+            mPool.push_back(std::move(mComplete));
+        }
+        mComplete.reset();
+    }
+
+    FragmentHeader header;
+    Span<const uint8_t> data;
+    uint8_t ip[4];
+
+    if (!ReadFragment(input, header, data) || !StringToAddress(address.c_str(), ip))
+    {
+        ++mStats.invalid;
+        return Result::Invalid;
+    }
+
+    ++mStats.fragments;
+
+    const uint64_t key = GetSenderKey(ip, header.source);
+    auto it = mSenders.find(key);
+
+    if (it == mSenders.end())
+    {
+        if (mSenders.size() >= kMaxSenders)
+        {
+            ++mStats.dropped;
+            return Result::Dropped;
+        }
+
+        it = mSenders.emplace(key, Sender{}).first;
+    }
+
+    Sender& sender = it->second;
+    Partial* partial = nullptr;
+
+    for (Partial& p : sender.partials)
+    {
+        if (p.buffer && p.group == header.group)
+        {
+            partial = &p;
+            break;
+        }
+    }
+
+    if (partial)
+    {
+        if (partial->count != header.count || partial->size != header.size)
+        {
+            ++mStats.invalid;
+            return Result::Invalid;
+        }
+
+        if (partial->received & (1u << header.index))
+        {
+            ++mStats.duplicates;
+            return Result::Duplicate;
+        }
+    }
+    else
+    {
+        // Take a free slot, or give up on the oldest message
+        for (Partial& p : sender.partials)
+        {
+            if (!p.buffer)
+            {
+                partial = &p;
+                break;
+            }
+
+            if (!partial || p.started < partial->started)
+            {
+                partial = &p;
+            }
+        }
+
+        if (partial->buffer)
+        {
+            ++mStats.evicted;
+            Free(*partial);
+        }
+
+        partial->group = header.group;
+        partial->count = header.count;
+        partial->size = header.size;
+        partial->received = 0;
+        partial->started = now;
+        partial->buffer = Allocate();
+    }
+
+    memcpy(partial->buffer.get() + header.index * kFragmentPayload, data.data, data.size);
+    partial->received |= 1u << header.index;
+
+    const uint32_t all = header.count == 32 ? UINT32_MAX : (1u << header.count) - 1;
+
+    if (partial->received != all)
+    {
+        return Result::Incomplete;
+    }
+
+    ++mStats.messages;
+
+    mComplete = std::move(partial->buffer);
+    message = { mComplete.get(), partial->size };
+    *partial = Partial{};
+
+    const bool empty = std::none_of(
+        sender.partials.begin(),
+        sender.partials.end(),
+        [](const Partial& p) { return bool(p.buffer); });
+
+    if (empty)
+    {
+        mSenders.erase(it);
+    }
+
+    return Result::Complete;
+}
+
+void FragmentAssembler::Expire(Clock::time_point now)
+{
+    for (auto it = mSenders.begin(); it != mSenders.end();)
+    {
+        bool empty = true;
+
+        for (Partial& partial : it->second.partials)
+        {
+            if (!partial.buffer)
+            {
+                continue;
+            }
+
+            if (now - partial.started >= kTimeout)
+            {
+                ++mStats.expired;
+                Free(partial);
+                continue;
+            }
+
+            empty = false;
+        }
+
+        it = empty ? mSenders.erase(it) : std::next(it);
+    }
+}
+
+size_t FragmentAssembler::GetPartialCount() const
+{
+    size_t count = 0;
+
+    for (const auto& [key, sender] : mSenders)
+    {
+        for (const Partial& partial : sender.partials)
+        {
+            count += partial.buffer ? 1 : 0;
+        }
+    }
+
+    return count;
+}
+
+std::unique_ptr<uint8_t[]> FragmentAssembler::Allocate()
+{
+    if (mPool.empty())
+    {
+        return std::make_unique<uint8_t[]>(kMaxMessageSize);
+    }
+
+    std::unique_ptr<uint8_t[]> buffer = std::move(mPool.back());
+    mPool.pop_back();
+    return buffer;
+}
+
+void FragmentAssembler::Free(Partial& partial)
+{
+    if (mPool.size() < kMaxPooled)
+    {
+        mPool.push_back(std::move(partial.buffer));
+    }
+
+    partial = Partial{};
+}
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "Common.h"
+#include "Message.h"
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Common
+{
+// Header of one piece of a message too large for a single datagram. The
+// pieces of a message share its group and are told apart by index, the
+// source is a random number picked by each sender so two senders behind
+// one address do not mix their groups. The checksum covers everything
+// after it.
+#pragma pack(push, 1)
+struct FragmentHeader
+{
+    // Never the first byte of a version 1 or compact header
+    static constexpr uint8_t kMagic = 0xB3;
+
+    uint8_t magic{ kMagic };
+    uint32_t checksum{ 0 };
+    uint32_t source{ 0 };
+    uint16_t group{ 0 };
+    uint8_t index{ 0 };
+    uint8_t count{ 0 };
+    // Size of the whole message
+    uint16_t size{ 0 };
+};
+#pragma pack(pop)
+
+constexpr size_t kFragmentHeaderSize = sizeof(FragmentHeader);
+
+// Message bytes carried by every fragment but the last. Leaves room for
+// a room header in front of the fragment.
+constexpr size_t kFragmentPayload
+    = kNetworkBufferSize - kRoomHeaderSize - kFragmentHeaderSize;
+
+constexpr size_t kMaxFragments
+    = (kMaxMessageSize + kFragmentPayload - 1) / kFragmentPayload;
+
+static_assert(kMaxMessageSize <= UINT16_MAX, "fragment sizes are 16-bit");
+static_assert(kMaxFragments <= 32, "received fragments are tracked in a 32-bit mask");
+
+constexpr size_t GetFragmentCount(size_t size)
+{
+    return (size + kFragmentPayload - 1) / kFragmentPayload;
+}
+
+// Returns true if the datagram starts with a fragment header
+bool IsFragment(Span<const uint8_t> input);
+
+// Write fragment index of message into output. Returns the size of the
+// fragment, or 0 if the message is larger than kMaxMessageSize or output
+// can not hold the fragment.
+size_t WriteFragment(
+    Span<const uint8_t> message,
+    uint32_t source,
+    uint16_t group,
+    uint32_t index,
+    Span<uint8_t> output);
+
+// Validate a fragment and find the piece of the message it carries
+bool ReadFragment(
+    Span<const uint8_t> input,
+    FragmentHeader& header,
+    Span<const uint8_t>& data);
+
+// Puts fragmented messages back together.
+//
+// Each fragment is copied once, straight to its place in a contiguous
+// buffer taken from a pool, and the finished message is handed out from
+// that buffer. Every sender has a few messages in flight at most, the
+// oldest giving way to a new one, and partial messages which stop
+// receiving fragments are dropped after kTimeout.
+class FragmentAssembler final
+{
+public:
+    FragmentAssembler(const FragmentAssembler&) = delete;
+    FragmentAssembler& operator=(const FragmentAssembler&) = delete;
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Partial messages per sender, bounding a sender to this many times
+    // kMaxMessageSize bytes
+    static constexpr uint32_t kMaxPartials = 4;
+
+    // Senders with partial messages at once
+    static constexpr uint32_t kMaxSenders = 64;
+
+    // Free buffers kept for reuse
+    static constexpr uint32_t kMaxPooled = 16;
+
+    static constexpr std::chrono::milliseconds kTimeout{ 1000 };
+
+    enum class Result : uint32_t
+    {
+        // Held until the rest arrives
+        Incomplete,
+        // The last missing fragment, the message is whole
+        Complete,
+        // Seen already
+        Duplicate,
+        // Not a valid fragment
+        Invalid,
+        // No room for another sender
+        Dropped
+    };
+
+    struct Stats
+    {
+        uint64_t fragments{ 0 };
+        uint64_t messages{ 0 };
+        uint64_t duplicates{ 0 };
+        uint64_t invalid{ 0 };
+        // Partial messages given up on, timed out or pushed out
+        uint64_t expired{ 0 };
+        uint64_t evicted{ 0 };
+        uint64_t dropped{ 0 };
+    };
+
+public:
+    FragmentAssembler() = default;
+
+    // Add a fragment from address. On Complete message holds the whole
+    // message until the next call.
+    Result Add(
+        const std::string& address,
+        Span<const uint8_t> input,
+        Clock::time_point now,
+        Span<const uint8_t>& message);
+
+    // Drop partial messages older than kTimeout
+    void Expire(Clock::time_point now);
+
+    size_t GetPartialCount() const;
+    size_t GetPooledCount() const { return mPool.size(); }
+
+    const Stats& GetStats() const { return mStats; }
+
+private:
+    struct Partial
+    {
+        uint16_t group{ 0 };
+        uint8_t count{ 0 };
+        uint16_t size{ 0 };
+        uint32_t received{ 0 };
+        Clock::time_point started;
+        // Null when the slot is free
+        std::unique_ptr<uint8_t[]> buffer;
+    };
+
+    struct Sender
+    {
+        std::array<Partial, kMaxPartials> partials;
+    };
+
+    std::unique_ptr<uint8_t[]> Allocate();
+    void Free(Partial& partial);
+
+private:
+    // Keyed by IPv4 address and source
+    std::unordered_map<uint64_t, Sender> mSenders;
+    std::vector<std::unique_ptr<uint8_t[]>> mPool;
+    // Last message completed, returned to the pool on the next call
+    std::unique_ptr<uint8_t[]> mComplete;
+    Stats mStats;
+};
+}
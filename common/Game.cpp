@@ -2,117 +2,814 @@
 
 #include "Network.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
+#include <random>
+#include <type_traits>
 
 namespace Common
 {
 Game::Game(Params params)
     : mParams(params)
+    , mPositionCodec(params.width, params.height)
+    , mTimerEpoch(std::chrono::steady_clock::now())
+    , mGrid(params.width, params.height, params.gridBackend)
+    , mInterest(params.interestRadius)
+    , mMovement(params.width, params.height)
 {
-    mState = std::make_unique<PositionState[]>(
-        params.height * params.width);
+    static_assert(std::is_trivially_destructible_v<EventRecord>,
+        "Clearing the event buffer must not run destructors");
 
-    for (uint32_t i = 0; i < mParams.height; ++i)
-    {
-        for (uint32_t j = 0; j < mParams.width; ++j)
-        {
-            PositionState* p = GetPosition(j, i);
-            p->pos = Position{ j, i };
-        }
-    }
+    // The event buffer never grows past this so queueing never allocates
+    mEvents.reserve(mParams.maxEventsPerTick);
+
+    mPlayers.Reserve(mParams.maxPlayers);
+    mEndpoints.reserve(mParams.maxPlayers);
+
+    mFragmentSource = std::random_device{}();
+
+    mJobs = std::make_unique<JobSystem>(std::max(mParams.jobThreads, 1u));
 }
 
 Game::~Game()
 { }
 
-std::pair<Game::PlayerState*, bool> Game::CreatePlayer(
+std::pair<PlayerHandle, bool> Game::CreatePlayer(
     const std::string& address,
     uint32_t port)
 {
     using namespace std::chrono;
 
-    for (auto& [id, state] : mPlayers)
+    uint64_t key = 0;
+
+    if (!GetEndpointKey(address, port, key))
+    {
+        return std::make_pair(PlayerHandle{}, false);
+    }
+
+    auto [endpoint, added] = mEndpoints.try_emplace(key);
+
+    if (!added)
+    {
+        assert(mPlayers.IsAlive(endpoint->second));
+        return std::make_pair(endpoint->second, false);
+    }
+
+    uint32_t id = mNextPlayerId++;
+    PlayerHandle handle = mPlayers.Insert(id);
+
+    {
+        assert(handle);
+        PlayerInfo& info = mPlayers.GetInfo(handle);
+        info.player = std::make_unique<Player>(id, *this);
+        info.address = address;
+        info.port = port;
+        info.connectStart = steady_clock::now();
+        info.timeout = ScheduleTimer(
+            mParams.playerTimeout,
+            TimerKind::PlayerTimeout,
+            handle.Pack());
+        mPlayers.GetLastMessage(handle) = steady_clock::now();
+    }
+
+    endpoint->second = handle;
+    return std::make_pair(handle, true);
+}
+
+PlayerHandle Game::GetPlayerByEndpoint(
+    const std::string& address,
+    uint32_t port) const
+{
+    uint64_t key = 0;
+
+    if (!GetEndpointKey(address, port, key))
+    {
+        return {};
+    }
+
+    if (auto it = mEndpoints.find(key); it != mEndpoints.end())
     {
-        if (state.address == address && state.port == port)
+        return it->second;
+    }
+    return {};
+}
+
+bool Game::RemovePlayer(PlayerHandle handle)
+{
+    if (!mPlayers.IsAlive(handle))
+    {
+        return false;
+    }
+
+    const Position& pos = mPlayers.GetPosition(handle);
+
+    if (IsValidPosition(pos.x, pos.y))
+    {
+        SetPositionPlayer(pos.x, pos.y, nullptr);
+        mMovement.GetOccupancy().Clear(pos.x, pos.y);
+    }
+    mInterest.Remove(mPlayers.GetId(handle));
+
+    PlayerInfo& info = mPlayers.GetInfo(handle);
+    mTimers.Cancel(info.timeout);
+    mTimers.Cancel(info.retransmit);
+
+    // Players created by id only have an endpoint if one was assigned
+    // afterwards, and it may not be the one indexed, so check the owner.
+    uint64_t key = 0;
+
+    if (GetEndpointKey(info.address, info.port, key))
+    {
+        if (auto endpoint = mEndpoints.find(key);
+            endpoint != mEndpoints.end() && endpoint->second == handle)
         {
-            return std::make_pair(&state, false);
+            mEndpoints.erase(endpoint);
         }
     }
 
-    uint32_t id = mNextPlayerId++;
-    auto [it, inserted] = mPlayers.try_emplace(id, PlayerState{});
-    PlayerState* state = &it->second;
+    return mPlayers.Remove(handle);
+}
 
+bool Game::GetEndpointKey(
+    const std::string& address,
+    uint32_t port,
+    uint64_t& key)
+{
+    uint8_t bytes[4] = { 0 };
+
+    if (port > UINT16_MAX || !StringToAddress(address.c_str(), bytes))
     {
-        assert(inserted);
-        state->player = std::make_unique<Player>(id, *this);
-        state->address = address;
-        state->port = port;
-        state->connectStart = steady_clock::now();
-        state->lastMessage = steady_clock::now();
+        return false;
     }
 
-    return std::make_pair(state, true);
+    uint32_t ip = 0;
+    memcpy(&ip, bytes, sizeof(ip));
+
+    key = (uint64_t(ip) << 16) | port;
+    return true;
 }
 
-Game::PlayerState* Game::CreatePlayer(uint32_t id)
+PlayerHandle Game::CreatePlayer(uint32_t id)
 {
     using namespace std::chrono;
 
-    PlayerState* state = GetPlayerById(id);
+    PlayerHandle handle = mPlayers.Insert(id);
 
-    if (!state)
+    if (handle)
     {
-        auto [it, inserted] = mPlayers.try_emplace(id, PlayerState{});
-        PlayerState* state = &it->second;
+        PlayerInfo& info = mPlayers.GetInfo(handle);
+        info.player = std::make_unique<Player>(id, *this);
+        info.connectStart = steady_clock::now();
+        mPlayers.GetLastMessage(handle) = steady_clock::now();
+    }
+
+    return handle;
+}
 
-        state->player = std::make_unique<Player>(id, *this);
-        state->connectStart = steady_clock::now();
-        state->lastMessage = steady_clock::now();
+void Game::TouchPlayer(PlayerHandle handle)
+{
+    assert(mPlayers.IsAlive(handle));
+
+    mPlayers.GetLastMessage(handle) = std::chrono::steady_clock::now();
+    RescheduleTimer(mPlayers.GetInfo(handle).timeout, mParams.playerTimeout);
+}
 
-        return state;
+bool Game::SendPacket(
+    const char* address,
+    uint32_t port,
+    const NetworkBuffer& buffer,
+    const AckWindow* acks)
+{
+    const NetworkBuffer* packet = &buffer;
+
+    if (acks)
+    {
+        if (mCompactBuffer.Capacity() < buffer.Size())
+        {
+            mCompactBuffer = NetworkBuffer(kMaxMessageSize);
+        }
+
+        size_t size = EncodeCompactMessage(
+            { buffer.Data(), buffer.Size() },
+            acks->HasReceived() ? CompactHeader::kFlagAck : 0,
+            acks->GetAck(),
+            acks->GetAckBits(),
+            { mCompactBuffer.Data(), mCompactBuffer.Capacity() });
+
+        if (size)
+        {
+            mCompactBuffer.SetOffset(size);
+            packet = &mCompactBuffer;
+        }
     }
 
-    return nullptr;
+    // Compressed messages can not go compact, so one is only sent when it
+    // comes out smaller than the packet it replaces
+    if (mParams.compressThreshold && buffer.Size() > mParams.compressThreshold)
+    {
+        if (mCompressBuffer.Capacity() < buffer.Size())
+        {
+            mCompressBuffer = NetworkBuffer(kMaxMessageSize);
+        }
+
+        size_t size = CompressMessage(
+            { buffer.Data(), buffer.Size() },
+            { mCompressBuffer.Data(), std::min(mCompressBuffer.Capacity(), packet->Size() - 1) });
+
+        if (size)
+        {
+            mCompressBuffer.SetOffset(size);
+            packet = &mCompressBuffer;
+        }
+    }
+
+    const size_t limit = kNetworkBufferSize - (mParams.room ? kRoomHeaderSize : 0);
+
+    // Nearly every message fits a datagram and goes out as is
+    if (packet->Size() <= limit)
+    {
+        return SendDatagram(address, port, *packet);
+    }
+
+    return SendFragments(address, port, { packet->Data(), packet->Size() });
 }
 
-Game::PlayerState* Game::GetPlayerById(uint32_t id)
+size_t Game::Broadcast(const NetworkBuffer& buffer, Span<const PlayerHandle> players)
 {
-    if (auto it = mPlayers.find(id); it != mPlayers.end())
+    if (!mBroadcast.Prepare({ buffer.Data(), buffer.Size() }))
+    {
+        return 0;
+    }
+
+    const size_t header = mParams.room ? kRoomHeaderSize : 0;
+    const size_t slot = header + std::max(mBroadcast.GetSize(), mBroadcast.GetCompactSize());
+
+    mBroadcastStats.broadcasts += 1;
+
+    // Too large for one datagram, every copy goes out on its own in
+    // fragments
+    if (slot > kNetworkBufferSize)
     {
-        return &it->second;
+        NetworkBuffer copy(mBroadcast.GetSize());
+        size_t sent = 0;
+
+        for (size_t i = 0; i < players.size; ++i)
+        {
+            PlayerHandle player = players.data[i];
+            PlayerInfo& info = mPlayers.GetInfo(player);
+
+            copy.SetOffset(mBroadcast.Write(mPlayers.GetNextMessage(player)++,
+                { copy.Data(), copy.Capacity() }));
+
+            if (SendPacket(info.address.c_str(), info.port, copy,
+                info.compact ? &info.acks : nullptr))
+            {
+                sent += 1;
+                mBroadcastStats.bytes += copy.Size();
+            }
+        }
+
+        mBroadcastStats.copies += sent;
+        mBroadcastStats.failed += players.size - sent;
+        return sent;
+    }
+
+    if (mBroadcastData.size() < players.size * slot)
+    {
+        mBroadcastData.resize(players.size * slot);
     }
-    return nullptr;
+    mBroadcastBatch.clear();
+
+    for (size_t i = 0; i < players.size; ++i)
+    {
+        PlayerHandle player = players.data[i];
+        const PlayerInfo& info = mPlayers.GetInfo(player);
+        Span<uint8_t> output{ mBroadcastData.data() + i * slot, slot };
+        const uint32_t messageId = mPlayers.GetNextMessage(player)++;
+
+        if (header)
+        {
+            WriteRoomHeader(mParams.room, output);
+        }
+
+        size_t size = 0;
+
+        if (info.compact)
+        {
+            size = mBroadcast.WriteCompact(
+                messageId,
+                info.acks.HasReceived() ? CompactHeader::kFlagAck : 0,
+                info.acks.GetAck(),
+                info.acks.GetAckBits(),
+                output.Subspan(header));
+        }
+
+        // As with SendPacket(), what can not go compact goes as is
+        if (size == 0)
+        {
+            size = mBroadcast.Write(messageId, output.Subspan(header));
+        }
+
+        mBroadcastBatch.push_back(Datagram{ info.address.c_str(), info.port,
+            { output.data, header + size } });
+        mBroadcastStats.bytes += header + size;
+    }
+
+    size_t sent = 0;
+
+    if (mParams.dryRun)
+    {
+        sent = mBroadcastBatch.size();
+        mDryRunStats.datagrams += sent;
+
+        for (const Datagram& datagram : mBroadcastBatch)
+        {
+            mDryRunStats.bytes += datagram.data.size;
+        }
+    }
+    else
+    {
+        sent = SendMessages({ mBroadcastBatch.data(), mBroadcastBatch.size() });
+    }
+
+    mBroadcastStats.copies += sent;
+    mBroadcastStats.failed += players.size - sent;
+    return sent;
+}
+
+bool Game::SendFragments(const char* address, uint32_t port, Span<const uint8_t> data)
+{
+    if (data.size > kMaxMessageSize)
+    {
+        std::cout << "message of " << data.size << " bytes is too large to send to '"
+            << address << "'\n";
+        return false;
+    }
+
+    const uint16_t group = mNextFragmentGroup++;
+    const size_t count = GetFragmentCount(data.size);
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        const size_t size = WriteFragment(
+            data,
+            mFragmentSource,
+            group,
+            uint32_t(index),
+            { mFragmentBuffer.Data(), mFragmentBuffer.Capacity() });
+
+        assert(size);
+        mFragmentBuffer.SetOffset(size);
+
+        if (!SendDatagram(address, port, mFragmentBuffer))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Game::SendDatagram(const char* address, uint32_t port, const NetworkBuffer& buffer)
+{
+    if (mParams.dryRun)
+    {
+        mDryRunStats.datagrams += 1;
+        mDryRunStats.bytes += (mParams.room ? kRoomHeaderSize : 0) + buffer.Size();
+        return true;
+    }
+
+    if (!mParams.room)
+    {
+        return mParams.sendSocket != kInvalidSocket
+            ? SendMessage(mParams.sendSocket, address, port, buffer)
+            : SendMessage(address, port, buffer);
+    }
+
+    if (mRoomBuffer.Capacity() == 0)
+    {
+        mRoomBuffer = NetworkBuffer();
+    }
+
+    assert(kRoomHeaderSize + buffer.Size() <= mRoomBuffer.Capacity());
+
+    WriteRoomHeader(mParams.room, { mRoomBuffer.Data(), mRoomBuffer.Capacity() });
+    memcpy(mRoomBuffer.Data() + kRoomHeaderSize, buffer.Data(), buffer.Size());
+    mRoomBuffer.SetOffset(kRoomHeaderSize + buffer.Size());
+
+    return mParams.sendSocket != kInvalidSocket
+        ? SendMessage(mParams.sendSocket, address, port, mRoomBuffer)
+        : SendMessage(address, port, mRoomBuffer);
+}
+
+uint32_t Game::GetWireTime(std::chrono::steady_clock::time_point time) const
+{
+    using namespace std::chrono;
+
+    return uint32_t(duration_cast<microseconds>(time - mTimerEpoch).count());
+}
+
+uint64_t Game::GetTimerTime(std::chrono::steady_clock::time_point time) const
+{
+    using namespace std::chrono;
+
+    return uint64_t(duration_cast<milliseconds>(time - mTimerEpoch).count());
+}
+
+TimerHandle Game::ScheduleTimer(
+    std::chrono::steady_clock::duration delay,
+    TimerKind kind,
+    uint64_t data)
+{
+    using namespace std::chrono;
+
+    const uint64_t when = GetTimerTime(steady_clock::now())
+        + uint64_t(ceil<milliseconds>(delay).count());
+
+    return mTimers.Schedule(when, TimingWheel::Timer{ uint32_t(kind), data });
+}
+
+bool Game::RescheduleTimer(TimerHandle handle, std::chrono::steady_clock::duration delay)
+{
+    using namespace std::chrono;
+
+    const uint64_t when = GetTimerTime(steady_clock::now())
+        + uint64_t(ceil<milliseconds>(delay).count());
+
+    return mTimers.Reschedule(handle, when);
 }
 
-const Game::PlayerState* Game::GetPlayerById(uint32_t id) const
+bool Game::CancelTimer(TimerHandle handle)
 {
-    if (auto it = mPlayers.find(id); it != mPlayers.end())
+    return mTimers.Cancel(handle);
+}
+
+void Game::AdvanceTimers()
+{
+    Span<const TimingWheel::Timer> expired
+        = mTimers.Advance(GetTimerTime(std::chrono::steady_clock::now()));
+
+    for (size_t i = 0; i < expired.size; ++i)
     {
-        return &it->second;
+        HandleTimer(TimerKind(expired.data[i].kind), expired.data[i].data);
     }
-    return nullptr;
 }
 
-Game::PositionState* Game::GetPosition(
+void Game::HandleTimer(TimerKind kind, uint64_t data)
+{
+    if (kind != TimerKind::PlayerTimeout)
+    {
+        return;
+    }
+
+    PlayerHandle handle = PlayerHandle::Unpack(data);
+
+    if (!mPlayers.IsAlive(handle))
+    {
+        return;
+    }
+
+    std::cout << "Player '" << mPlayers.GetId(handle) << "' timed out after "
+        << mParams.playerTimeout.count() << "ms without a message\n";
+
+    mTimedOutPlayers += 1;
+    RemovePlayer(handle);
+}
+
+PlayerHandle Game::GetPlayerById(uint32_t id) const
+{
+    return mPlayers.Find(id);
+}
+
+const Game::PositionState* Game::GetPosition(
     uint32_t x,
     uint32_t y) const
 {
-    assert(mState);
     assert(IsValidPosition(x, y));
-    return &mState[y * mParams.height + x];
+    return mGrid.Find(x, y);
+}
+
+void Game::SetPositionPlayer(uint32_t x, uint32_t y, Player* player)
+{
+    assert(IsValidPosition(x, y));
+    mGrid.SetPlayer(x, y, player);
+}
+
+bool Game::PlacePlayer(PlayerHandle handle, Position pos)
+{
+    if (!mPlayers.IsAlive(handle) || !IsValidPosition(pos.x, pos.y))
+    {
+        return false;
+    }
+
+    Player* player = mPlayers.GetInfo(handle).player.get();
+    Player* occupant = mGrid.GetPlayer(pos.x, pos.y);
+
+    if (occupant && occupant != player)
+    {
+        return false;
+    }
+
+    Position& current = mPlayers.GetPosition(handle);
+
+    OccupancyBitboard& occupancy = mMovement.GetOccupancy();
+
+    if (IsValidPosition(current.x, current.y))
+    {
+        SetPositionPlayer(current.x, current.y, nullptr);
+        occupancy.Clear(current.x, current.y);
+    }
+
+    SetPositionPlayer(pos.x, pos.y, player);
+    occupancy.Set(pos.x, pos.y);
+    current = pos;
+    player->SetPosition(pos);
+
+    mInterest.Update(mPlayers.GetId(handle), pos);
+    return true;
+}
+
+bool Game::QueueMove(PlayerHandle handle, Movement movement)
+{
+    if (!mPlayers.IsAlive(handle))
+    {
+        return false;
+    }
+
+    const Position& pos = mPlayers.GetPosition(handle);
+
+    return IsValidPosition(pos.x, pos.y)
+        && mMovement.Queue(mPlayers.GetId(handle), pos, movement);
+}
+
+JitterBuffer::Result Game::QueueInput(PlayerHandle handle, uint32_t tick, Movement movement)
+{
+    assert(mPlayers.IsAlive(handle));
+
+    JitterBuffer& inputs = mPlayers.GetInfo(handle).inputs;
+    const bool wasEmpty = inputs.IsEmpty();
+
+    JitterBuffer::Result result = inputs.Push(tick, mTick, movement);
+
+    switch (result)
+    {
+    case JitterBuffer::Result::Buffered:
+        mInputStats.buffered += 1;
+        break;
+    case JitterBuffer::Result::Late:
+        mInputStats.late += 1;
+        break;
+    case JitterBuffer::Result::TooEarly:
+        mInputStats.tooEarly += 1;
+        break;
+    case JitterBuffer::Result::Full:
+        mInputStats.full += 1;
+        break;
+    }
+
+    if (wasEmpty && !inputs.IsEmpty())
+    {
+        mPendingInputs.push_back(handle);
+    }
+
+    return result;
+}
+
+void Game::ReleaseInputs()
+{
+    size_t kept = 0;
+
+    for (size_t i = 0; i < mPendingInputs.size(); ++i)
+    {
+        PlayerHandle handle = mPendingInputs[i];
+
+        if (!mPlayers.IsAlive(handle))
+        {
+            continue;
+        }
+
+        JitterBuffer& inputs = mPlayers.GetInfo(handle).inputs;
+        Movement movement;
+
+        if (inputs.Pop(mTick, movement))
+        {
+            mInputStats.released += 1;
+            QueueMove(handle, movement);
+        }
+
+        if (!inputs.IsEmpty())
+        {
+            mPendingInputs[kept++] = handle;
+        }
+    }
+
+    mPendingInputs.resize(kept);
+}
+
+void Game::ApplyMoves()
+{
+    if (!mMovement.GetQueuedCount())
+    {
+        return;
+    }
+
+    // Accepted moves come back in the order the bitboard applied them, so
+    // replaying them keeps every target free when its player arrives.
+    Span<const MovementSystem::Move> moves = mMovement.Resolve();
+
+    for (size_t i = 0; i < moves.size; ++i)
+    {
+        const MovementSystem::Move& move = moves.data[i];
+        PlayerHandle handle = mPlayers.Find(move.playerId);
+
+        [[maybe_unused]] bool placed = PlacePlayer(handle, move.to);
+        assert(placed);
+    }
+}
+
+bool Game::FindFreePosition(uint32_t seed, Position& pos) const
+{
+    // Bounded probe so a crowded board fails fast instead of scanning
+    // every cell.
+    constexpr uint32_t kMaxProbes = 1024;
+
+    const uint64_t cells = uint64_t(mParams.width) * mParams.height;
+
+    if (cells == 0)
+    {
+        return false;
+    }
+
+    uint64_t cell = (uint64_t(seed) * 2654435761u) % cells;
+
+    for (uint32_t i = 0; i < kMaxProbes && i < cells; ++i)
+    {
+        const uint32_t x = uint32_t(cell % mParams.width);
+        const uint32_t y = uint32_t(cell / mParams.width);
+
+        if (!mGrid.GetPlayer(x, y))
+        {
+            pos = Position{ x, y };
+            return true;
+        }
+
+        cell = (cell + 1) % cells;
+    }
+
+    return false;
+}
+
+void Game::RunPlayerJobs(const JobSystem::JobFn& fn)
+{
+    mJobs->Run(mPlayers.Size(), std::max(mParams.playersPerJob, 1u), fn);
+}
+
+size_t Game::GetPlayerJobCount() const
+{
+    return JobSystem::GetJobCount(mPlayers.Size(), std::max(mParams.playersPerJob, 1u));
 }
 
 bool Game::IsValidPosition(uint32_t x, uint32_t y) const
 {
-    return x < mParams.width && y < mParams.height;
+    return mGrid.IsValid(x, y);
 }
 
-void Game::OnMessage(Action action, NetworkMessage& msg)
+bool Game::OnReceive(const NetworkMessage& msg)
 {
     Span<const uint8_t> data(msg.buffer.Data(), msg.buffer.Size());
 
+    // A game which is not one of several rooms takes whatever is sent to
+    // it, whichever room it was addressed to
+    if (IsRoomAddressed(data))
+    {
+        data = data.Subspan(kRoomHeaderSize);
+    }
+
+    if (IsFragment(data))
+    {
+        // The reassembled message stays valid until the next fragment, it
+        // is decoded from there like any other
+        switch (mFragments.Add(msg.address, data, std::chrono::steady_clock::now(), data))
+        {
+        case FragmentAssembler::Result::Complete:
+            break;
+        case FragmentAssembler::Result::Invalid:
+            std::cout << "invalid fragment received from '" << msg.address << "'\n";
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    if (mExpandBuffer.Capacity() < kMaxMessageSize
+        && (IsCompressed(data) || IsCompact(data)))
+    {
+        mExpandBuffer = NetworkBuffer(kMaxMessageSize);
+    }
+
+    CompactHeader compact;
+    const bool isCompact = IsCompact(data);
+
+    if (isCompact)
+    {
+        // Compact messages are never compressed, the expanded message is
+        // read as is
+        size_t size = DecodeCompactMessage(
+            data,
+            { mExpandBuffer.Data(), mExpandBuffer.Capacity() },
+            compact);
+
+        if (!size)
+        {
+            std::cout << "invalid compact message received from '"
+                << msg.address << "'\n";
+            return false;
+        }
+
+        mExpandBuffer.SetOffset(size);
+        data = { mExpandBuffer.Data(), mExpandBuffer.Size() };
+    }
+    else if (IsCompressed(data))
+    {
+
+        size_t size = DecompressMessage(
+            data,
+            { mExpandBuffer.Data(), mExpandBuffer.Capacity() });
+
+        if (!size)
+        {
+            std::cout << "invalid compressed message received from '"
+                << msg.address << "'\n";
+            return false;
+        }
+
+        mExpandBuffer.SetOffset(size);
+        data = { mExpandBuffer.Data(), mExpandBuffer.Size() };
+    }
+
+    std::optional<Message> result = Serializer<Message>::Deserialize(data);
+
+    if (!result)
+    {
+        std::cout << "invalid message received from '" << msg.address << "'";
+        return false;
+    }
+
+    if (mParams.verbose)
+    {
+        std::cout << "received message type '" << uint32_t(result->action) << "' from '"
+            << msg.address << ':' << msg.port << "' (payload="
+            << result->header.payloadSize << ", hash=" << result->header.hash
+            << ")" << '\n';
+    }
+
+    QueueMessage(result->action, msg, data, isCompact ? &compact : nullptr);
+    return true;
+}
+
+void Game::OnMessage(Action action, const NetworkMessage& msg)
+{
+    QueueMessage(
+        action,
+        msg,
+        { msg.buffer.Data(), msg.buffer.Size() });
+}
+
+template<typename T>
+T* Game::QueueEvent(Action action, const NetworkMessage& msg, const CompactHeader* compact)
+{
+    if (mEvents.size() >= mParams.maxEventsPerTick)
+    {
+        ++mDroppedEvents;
+        return nullptr;
+    }
+
+    T& ev = std::get<T>(mEvents.emplace_back(std::in_place_type<T>));
+    ev.action = action;
+    ev.port = msg.port;
+    ev.received = std::chrono::steady_clock::now();
+
+    const size_t length = std::min(msg.address.size(), kAddressStringLength - 1);
+    memcpy(ev.address, msg.address.data(), length);
+    ev.address[length] = '\0';
+
+    if (compact)
+    {
+        ev.compact = true;
+        ev.header = *compact;
+    }
+
+    return &ev;
+}
+
+void Game::QueueMessage(
+    Action action,
+    const NetworkMessage& msg,
+    Span<const uint8_t> data,
+    const CompactHeader* compact)
+{
     switch (action)
     {
     case Action::Login:
@@ -126,12 +823,10 @@ void Game::OnMessage(Action action, NetworkMessage& msg)
             return;
         }
 
-        auto ev = std::make_unique<LoginEvent>();
-        ev->action = action;
-        ev->msg = std::move(msg);
-        ev->login = std::move(*login);
-
-        mEvents.emplace_back(std::move(ev));
+        if (LoginEvent* ev = QueueEvent<LoginEvent>(action, msg, compact))
+        {
+            ev->login = *login;
+        }
         break;
     }
     case Action::Ping:
@@ -145,12 +840,10 @@ void Game::OnMessage(Action action, NetworkMessage& msg)
             return;
         }
 
-        auto ev = std::make_unique<PingEvent>();
-        ev->action = action;
-        ev->msg = std::move(msg);
-        ev->ping = std::move(*ping);
-
-        mEvents.emplace_back(std::move(ev));
+        if (PingEvent* ev = QueueEvent<PingEvent>(action, msg, compact))
+        {
+            ev->ping = *ping;
+        }
         break;
     }
     case Action::Acknowledge:
@@ -165,12 +858,45 @@ void Game::OnMessage(Action action, NetworkMessage& msg)
             return;
         }
 
-        auto ev = std::make_unique<AcknowledgeEvent>();
-        ev->action = action;
-        ev->msg = std::move(msg);
-        ev->ack = std::move(*ack);
+        if (AcknowledgeEvent* ev = QueueEvent<AcknowledgeEvent>(action, msg, compact))
+        {
+            ev->ack = *ack;
+        }
+        break;
+    }
+    case Action::Move:
+    {
+        std::optional<MoveMessage> move = Serializer<MoveMessage>::Deserialize(data);
+
+        if (!move)
+        {
+            std::cout << "Failed to parse move message from '" << msg.address << ':'
+                << msg.port << "'\n";
+            return;
+        }
+
+        if (MoveEvent* ev = QueueEvent<MoveEvent>(action, msg, compact))
+        {
+            ev->move = *move;
+        }
+        break;
+    }
+    case Action::State:
+    {
+        std::optional<StateMessage> state = Serializer<StateMessage>::Deserialize(
+            data, GetPositionCodec());
+
+        if (!state)
+        {
+            std::cout << "Failed to parse state message from '" << msg.address << ':'
+                << msg.port << "'\n";
+            return;
+        }
 
-        mEvents.emplace_back(std::move(ev));
+        if (StateEvent* ev = QueueEvent<StateEvent>(action, msg, compact))
+        {
+            ev->state = *state;
+        }
         break;
     }
     default:
@@ -180,25 +906,181 @@ void Game::OnMessage(Action action, NetworkMessage& msg)
 
 bool Game::Tick()
 {
-    while (!mEvents.empty())
+    for (EventRecord& record : mEvents)
+    {
+        if (auto* login = std::get_if<LoginEvent>(&record))
+        {
+            HandleLogin(login);
+        }
+        else if (auto* ping = std::get_if<PingEvent>(&record))
+        {
+            HandlePing(ping);
+        }
+        else if (auto* ack = std::get_if<AcknowledgeEvent>(&record))
+        {
+            HandleAcknowledge(ack);
+        }
+        else if (auto* state = std::get_if<StateEvent>(&record))
+        {
+            HandleState(state);
+        }
+        else if (auto* move = std::get_if<MoveEvent>(&record))
+        {
+            HandleMove(move);
+        }
+    }
+
+    // Records are trivially destructible so this only resets the size and
+    // keeps the reserved storage for the next tick.
+    mEvents.clear();
+
+    mFragments.Expire(std::chrono::steady_clock::now());
+    AdvanceTimers();
+    ReleaseInputs();
+    ApplyMoves();
+
+    mTick += 1;
+
+    if (mCheckpoints.IsOpen() && mParams.checkpointInterval
+        && mTick % mParams.checkpointInterval == 0)
+    {
+        WriteCheckpoint();
+    }
+
+    return true;
+}
+
+bool Game::StartCheckpoints(const std::string& path)
+{
+    return mCheckpoints.Open(path);
+}
+
+void Game::StopCheckpoints()
+{
+    if (!mCheckpoints.IsOpen())
+    {
+        return;
+    }
+
+    mCheckpoints.Wait();
+    WriteCheckpoint();
+    mCheckpoints.Close();
+}
+
+void Game::WriteCheckpoint()
+{
+    CheckpointHeader* header = nullptr;
+    Span<CheckpointPlayer> players;
+
+    if (!mCheckpoints.Begin(mPlayers.Size(), header, players))
+    {
+        return;
+    }
+
+    header->width = mParams.width;
+    header->height = mParams.height;
+    header->tick = mTick;
+    header->nextPlayerId = mNextPlayerId;
+
+    Span<const uint32_t> ids = mPlayers.GetIds();
+    Span<Position> positions = mPlayers.GetPositions();
+    Span<uint32_t> nextMessages = mPlayers.GetNextMessages();
+
+    for (size_t i = 0; i < players.size; ++i)
+    {
+        const PlayerInfo& info = mPlayers.GetInfo(mPlayers.GetHandle(i));
+        CheckpointPlayer& player = players.data[i];
+
+        player.id = ids.data[i];
+        player.x = positions.data[i].x;
+        player.y = positions.data[i].y;
+        player.nextMessage = nextMessages.data[i];
+        player.port = uint16_t(info.port);
+        player.compact = info.compact ? 1 : 0;
+
+        // Players created by id alone have no endpoint and keep zeros
+        StringToAddress(info.address.c_str(), player.address);
+    }
+
+    mCheckpoints.Commit();
+}
+
+bool Game::RestoreCheckpoint(const std::string& path)
+{
+    using namespace std::chrono;
+
+    assert(mPlayers.Size() == 0);
+
+    CheckpointReader reader;
+
+    if (!reader.Open(path))
+    {
+        return false;
+    }
+
+    const CheckpointHeader& header = *reader.GetHeader();
+
+    if (header.width != mParams.width || header.height != mParams.height)
+    {
+        std::cout << "Checkpoint '" << path << "' is of a " << header.width << 'x'
+            << header.height << " board, not " << mParams.width << 'x'
+            << mParams.height << '\n';
+        return false;
+    }
+
+    Span<const CheckpointPlayer> players = reader.GetPlayers();
+    uint32_t nextPlayerId = header.nextPlayerId;
+
+    mPlayers.Reserve(players.size);
+    mEndpoints.reserve(players.size);
+
+    for (size_t i = 0; i < players.size; ++i)
     {
-        std::unique_ptr<Event> ev = std::move(mEvents.front());
-        mEvents.pop_front();
+        const CheckpointPlayer& record = players.data[i];
+        PlayerHandle handle = CreatePlayer(record.id);
 
-        switch (ev->action)
+        if (!handle)
         {
-        case Action::Login:
-            HandleLogin(static_cast<LoginEvent*>(ev.get()));
-            break;
-        case Action::Ping:
-            HandlePing(static_cast<PingEvent*>(ev.get()));
-            break;
-        case Action::Acknowledge:
-            HandleAcknowledge(static_cast<AcknowledgeEvent*>(ev.get()));
-            break;
+            continue;
         }
+
+        PlayerInfo& info = mPlayers.GetInfo(handle);
+
+        if (record.port != 0)
+        {
+            uint64_t key = 0;
+
+            info.address = AddressToString(record.address);
+            info.port = record.port;
+
+            if (GetEndpointKey(info.address, info.port, key))
+            {
+                mEndpoints.emplace(key, handle);
+            }
+        }
+
+        info.compact = record.compact != 0;
+        info.timeout = ScheduleTimer(
+            mParams.playerTimeout,
+            TimerKind::PlayerTimeout,
+            handle.Pack());
+
+        mPlayers.GetNextMessage(handle) = record.nextMessage;
+
+        if (IsValidPosition(record.x, record.y))
+        {
+            PlacePlayer(handle, Position(record.x, record.y));
+        }
+
+        nextPlayerId = std::max(nextPlayerId, record.id + 1);
     }
 
+    mTick = header.tick;
+    mNextPlayerId = nextPlayerId;
+
+    std::cout << "Restored " << mPlayers.Size() << " players at tick " << mTick
+        << " from checkpoint '" << path << "'\n";
+
     return true;
 }
 }
@@ -1,13 +1,23 @@
 #pragma once
 
+#include "Checkpoint.h"
 #include "Common.h"
+#include "Fragment.h"
+#include "Interest.h"
+#include "JobSystem.h"
 #include "Message.h"
+#include "Movement.h"
 #include "Player.h"
+#include "PlayerTable.h"
+#include "PositionCodec.h"
+#include "TimingWheel.h"
+#include "WorldGrid.h"
 
 #include <chrono>
-#include <deque>
 #include <memory>
 #include <unordered_map>
+#include <variant>
+#include <vector>
 
 namespace Common
 {
@@ -35,6 +45,63 @@ public:
         // Duration to assume lack of any network traffic is a timeout.
         std::chrono::milliseconds playerTimeout{
             std::chrono::milliseconds(2000) };
+
+        // Storage for the board cells. Chunked only allocates the parts of
+        // the board which are in use and suits very large maps.
+        WorldGrid::Backend gridBackend{ WorldGrid::Backend::Dense };
+
+        // Players see, and are sent updates about, other players within
+        // this many cells on each axis.
+        uint32_t interestRadius{ 16 };
+
+        // Maximum number of events queued between two ticks. Messages
+        // arriving once the queue is full are dropped.
+        uint32_t maxEventsPerTick{ 1024 };
+
+        // Time between two simulation ticks
+        std::chrono::milliseconds tickInterval{
+            std::chrono::milliseconds(30) };
+
+        // Room to address sent datagrams to, on a server hosting several.
+        // Zero sends them without a room header and such a server hands
+        // them to its first room.
+        uint32_t room{ 0 };
+
+        // Threads running the per-player jobs of a tick, the loop thread
+        // included. One runs every job on the loop thread.
+        uint32_t jobThreads{ 1 };
+
+        // Players handled by one job
+        uint32_t playersPerJob{ 64 };
+
+        // Ticks between two checkpoints, once StartCheckpoints() is called
+        uint32_t checkpointInterval{ 100 };
+
+        // Log every message received and the routine steps of a session.
+        // Off where many games share a console, as in a load test.
+        bool verbose{ true };
+
+        // Socket to send every datagram from. A socket is created for each
+        // datagram when none is given.
+        Socket sendSocket{ kInvalidSocket };
+
+        // Messages larger than this many bytes are sent compressed when
+        // that makes them smaller. Zero never compresses.
+        uint32_t compressThreshold{ 128 };
+
+        // Count the datagrams instead of sending them, as when replaying a
+        // capture whose clients are not there to receive the replies.
+        bool dryRun{ false };
+    };
+
+    // Totals for the inputs passed through the per-client jitter buffers
+    struct InputStats
+    {
+        uint64_t buffered{ 0 };
+        uint64_t late{ 0 };
+        uint64_t tooEarly{ 0 };
+        uint64_t full{ 0 };
+        uint64_t released{ 0 };
     };
 
 public:
@@ -43,14 +110,73 @@ public:
 
     const Params& GetParams() const { return mParams; }
     Params& GetParams() { return mParams; }
-    virtual void OnMessage(Action action, NetworkMessage& msg);
+
+    // Codec for any message carrying board coordinates. Derived from the
+    // board dimensions in Params when the game is created.
+    const PositionCodec& GetPositionCodec() const { return mPositionCodec; }
+
+    virtual void OnMessage(Action action, const NetworkMessage& msg);
+
+    // Validate a datagram read from the network, expanding it if it was
+    // compressed or sent with the compact header, and pass it on to
+    // OnMessage(). Returns false if the datagram was not a valid message.
+    bool OnReceive(const NetworkMessage& msg);
     virtual bool Tick();
 
+    // Number of messages dropped because the event queue was full
+    uint64_t GetDroppedEvents() const { return mDroppedEvents; }
+
+    // Simulation tick currently being run, or to be run by the next call
+    // to Tick(). Inputs are stamped with the tick they are meant for.
+    uint32_t GetTick() const { return mTick; }
+
+    const InputStats& GetInputStats() const { return mInputStats; }
+
+    // Players removed for going quiet longer than the player timeout
+    uint64_t GetTimedOutPlayers() const { return mTimedOutPlayers; }
+
+    size_t GetTimerCount() const { return mTimers.Size(); }
+
+    JobSystem::Stats GetJobStats() const { return mJobs->GetStats(); }
+
+    // Write a checkpoint of the game to path every checkpointInterval
+    // ticks. The tick copies the players, the file is written on a thread
+    // of its own.
+    bool StartCheckpoints(const std::string& path);
+
+    // Write a last checkpoint of the game as it is now, wait for it and
+    // stop
+    void StopCheckpoints();
+
+    // Resume a game from a checkpoint: its players, their endpoints and
+    // positions, the tick and the id counters. Only the connection state
+    // starts over. The game must not have any players yet.
+    //
+    // The records are read from the mapped file without parsing, but each
+    // player is then rebuilt one at a time as a login would: its Player,
+    // endpoint, timeout timer and place on the grid, occupancy bitboard
+    // and interest index. Resuming is O(players), independent of the board
+    // size only, and nothing is mapped back into the player arrays in bulk.
+    bool RestoreCheckpoint(const std::string& path);
+
+    CheckpointWriter::Stats GetCheckpointStats() const { return mCheckpoints.GetStats(); }
+
 protected:
+    // Events are decoded copies of the message and its source endpoint.
+    // They never reference the NetworkMessage they were parsed from so the
+    // receive buffer can be reused as soon as OnMessage() returns.
     struct Game::Event
     {
-        NetworkMessage msg;
         Action action{ Action::None };
+        char address[kAddressStringLength] = { 0 };
+        uint32_t port{ 0 };
+        // Set when the message came with a compact header, which holds
+        // its 16-bit sequence and the peer's acknowledgements
+        bool compact{ false };
+        CompactHeader header;
+        // When the message was read off the network, for timestamps which
+        // should not count the wait for the next tick
+        std::chrono::steady_clock::time_point received;
     };
 
     struct AcknowledgeEvent : public Game::Event
@@ -68,60 +194,246 @@ protected:
         PingMessage ping;
     };
 
+    struct StateEvent : public Game::Event
+    {
+        StateMessage state;
+    };
+
+    struct MoveEvent : public Game::Event
+    {
+        MoveMessage move;
+    };
+
+    // Tagged, fixed size record holding any one event. Records are stored
+    // by value in a buffer reserved up front and reused every tick.
+    using EventRecord = std::variant<
+        AcknowledgeEvent,
+        LoginEvent,
+        PingEvent,
+        StateEvent,
+        MoveEvent>;
+
+    // Kinds of timer run by the game wheel. The base game handles player
+    // timeouts, the loops handle their own kinds and pass the rest on.
+    enum class TimerKind : uint32_t
+    {
+        PlayerTimeout,
+        Retransmit,
+        Login,
+        Ping
+    };
+
 protected:
     virtual void HandleLogin(LoginEvent* ev) = 0;
     virtual void HandlePing(PingEvent* ev) = 0;
     virtual void HandleAcknowledge(AcknowledgeEvent* ev) = 0;
+    virtual void HandleState(StateEvent* ev) = 0;
+    virtual void HandleMove(MoveEvent* ev) = 0;
+
+    // Called from Tick() for every timer which came due
+    virtual void HandleTimer(TimerKind kind, uint64_t data);
 
 protected:
-    struct PlayerState
+    // Timers on the game wheel, with a resolution of a millisecond. They
+    // fire from Tick() so they are never late by more than a tick.
+    TimerHandle ScheduleTimer(
+        std::chrono::steady_clock::duration delay,
+        TimerKind kind,
+        uint64_t data = 0);
+    bool RescheduleTimer(TimerHandle handle, std::chrono::steady_clock::duration delay);
+    bool CancelTimer(TimerHandle handle);
+    bool IsTimerPending(TimerHandle handle) const { return mTimers.IsPending(handle); }
+
+    // Note traffic from a player, pushing its timeout back
+    void TouchPlayer(PlayerHandle handle);
+
+    // Microseconds since the game was created, the clock of the
+    // timestamps sent in messages. Wraps every 71 minutes.
+    uint32_t GetWireTime(std::chrono::steady_clock::time_point time) const;
+
+    // Send a serialized message, rewritten with the compact header when
+    // acks is given. The header then acknowledges what acks holds. A
+    // message over Params::compressThreshold goes compressed instead when
+    // that is smaller, and one which does not fit a datagram goes out in
+    // fragments.
+    bool SendPacket(
+        const char* address,
+        uint32_t port,
+        const NetworkBuffer& buffer,
+        const AckWindow* acks);
+
+    const FragmentAssembler::Stats& GetFragmentStats() const { return mFragments.GetStats(); }
+
+    // Send one serialized message to every player in players. The message
+    // is hashed once and each copy only gets the player's next message id
+    // and, for compact players, its acknowledgements, before the copies go
+    // out together in one batch. Returns the number of copies sent.
+    size_t Broadcast(const NetworkBuffer& buffer, Span<const PlayerHandle> players);
+
+    struct BroadcastStats
     {
-        // Player which this state represents
-        std::unique_ptr<Player> player;
-        // Network Information
-        std::string address;
-        uint32_t port{ 0 };
-        // Connection time
-        std::chrono::steady_clock::time_point connectStart;
-        // Last Message time
-        std::chrono::steady_clock::time_point lastMessage;
-        // Message state
-        uint32_t nextMessage{ 0 };
-        uint32_t ackCount{ 0 };
-        // Message Buffer
-        std::unordered_map<uint32_t, NetworkBuffer> messages;
+        uint64_t broadcasts{ 0 };
+        uint64_t copies{ 0 };
+        uint64_t bytes{ 0 };
+        uint64_t failed{ 0 };
     };
 
-    struct PositionState
+    const BroadcastStats& GetBroadcastStats() const { return mBroadcastStats; }
+
+    // Datagrams held back by Params::dryRun
+    struct DryRunStats
     {
-        // Position in the game
-        Position pos;
-        // Player at this poistion (if one is currently there)
-        Player* player{ nullptr };
+        uint64_t datagrams{ 0 };
+        uint64_t bytes{ 0 };
     };
 
+    const DryRunStats& GetDryRunStats() const { return mDryRunStats; }
+
+protected:
+    using PositionState = Common::PositionState;
+
     bool IsValidPosition(uint32_t x, uint32_t y) const;
-    PositionState* GetPosition(uint32_t x, uint32_t y) const;
+    // Cell at x, y or nullptr where the Chunked backend has not allocated
+    // it, in which case the cell is empty. Never allocates.
+    const PositionState* GetPosition(uint32_t x, uint32_t y) const;
+
+    // Occupy a cell with a player, or vacate it with nullptr
+    void SetPositionPlayer(uint32_t x, uint32_t y, Player* player);
+
+    const WorldGrid& GetGrid() const { return mGrid; }
+
+    // Move a player to a free cell, keeping the grid, the player table and
+    // the interest sets in step. Fails if the cell is taken.
+    bool PlacePlayer(PlayerHandle handle, Position pos);
+
+    // Find a free cell for a new player, probing from a spot derived from
+    // seed so the same seed always gives the same answer on the same board.
+    bool FindFreePosition(uint32_t seed, Position& pos) const;
+
+    const InterestManager& GetInterest() const { return mInterest; }
 
-    const PlayerState* GetPlayerById(uint32_t id) const;
-    PlayerState* GetPlayerById(uint32_t id);
+    // Queue a step for a placed player. Every queued move is resolved
+    // together at the end of Tick(). Returns false if the player is not
+    // on the board or the step would leave it.
+    bool QueueMove(PlayerHandle handle, Movement movement);
 
-    // Used by the Server Loop
-    std::pair<PlayerState*, bool> CreatePlayer(
+    const MovementSystem& GetMovement() const { return mMovement; }
+
+    // Hold a step in the player's jitter buffer until the tick it is
+    // stamped for, then queue it with QueueMove().
+    JitterBuffer::Result QueueInput(PlayerHandle handle, uint32_t tick, Movement movement);
+
+    const PlayerTable& GetPlayers() const { return mPlayers; }
+    PlayerTable& GetPlayers() { return mPlayers; }
+
+    // Run fn over the rows of the player table in jobs of playersPerJob,
+    // spread over the job threads, and wait for them. A job only writes
+    // to its own players and its own slot of any per-job results.
+    void RunPlayerJobs(const JobSystem::JobFn& fn);
+    size_t GetPlayerJobCount() const;
+
+    PlayerHandle GetPlayerById(uint32_t id) const;
+
+    // Used by the Server Loop. Returns the existing player when the
+    // endpoint is already logged in, or an invalid handle if the address
+    // is not a valid IPv4 address.
+    std::pair<PlayerHandle, bool> CreatePlayer(
         const std::string& address,
         uint32_t port);
 
+    PlayerHandle GetPlayerByEndpoint(const std::string& address, uint32_t port) const;
+
+    // Remove a player and its endpoint entry
+    bool RemovePlayer(PlayerHandle handle);
+
     // Used by the Client Loop
-    PlayerState* CreatePlayer(uint32_t id);
+    PlayerHandle CreatePlayer(uint32_t id);
+
+private:
+    template<typename T>
+    T* QueueEvent(Action action, const NetworkMessage& msg, const CompactHeader* compact);
+    void QueueMessage(
+        Action action,
+        const NetworkMessage& msg,
+        Span<const uint8_t> data,
+        const CompactHeader* compact = nullptr);
+
+    // Split a message too large for one datagram into fragments
+    bool SendFragments(const char* address, uint32_t port, Span<const uint8_t> data);
+
+    // Send one datagram, behind a room header if Params names a room
+    bool SendDatagram(const char* address, uint32_t port, const NetworkBuffer& buffer);
+
+    // Fire every timer which has come due
+    void AdvanceTimers();
+
+    // Milliseconds since the game was created, the unit of the wheel
+    uint64_t GetTimerTime(std::chrono::steady_clock::time_point time) const;
+
+    // Move the inputs due this tick from the jitter buffers to the
+    // movement system
+    void ReleaseInputs();
+
+    // Resolve the queued moves and apply the accepted ones to the board
+    void ApplyMoves();
+
+    // Copy the game into the checkpoint writer, unless it is still busy
+    // with the last one
+    void WriteCheckpoint();
+
+    // Pack an IPv4 address and port into a single endpoint index key
+    static bool GetEndpointKey(
+        const std::string& address,
+        uint32_t port,
+        uint64_t& key);
 
 private:
     Params mParams;
-    std::deque<std::unique_ptr<Event>> mEvents;
+    PositionCodec mPositionCodec;
+    std::vector<EventRecord> mEvents;
+    uint64_t mDroppedEvents{ 0 };
+    uint32_t mTick{ 0 };
+    InputStats mInputStats;
+    uint64_t mTimedOutPlayers{ 0 };
+    std::chrono::steady_clock::time_point mTimerEpoch;
+    TimingWheel mTimers;
+    // Holds an expanded compressed or compact message while it is decoded
+    NetworkBuffer mExpandBuffer{ 0 };
+    // Holds a message rewritten with the compact header while it is sent
+    NetworkBuffer mCompactBuffer;
+    // Holds a compressed message while it is sent
+    NetworkBuffer mCompressBuffer{ 0 };
+    // Holds each fragment of a large message while it is sent
+    NetworkBuffer mFragmentBuffer;
+    // Holds a datagram behind its room header while it is sent
+    NetworkBuffer mRoomBuffer{ 0 };
+    FragmentAssembler mFragments;
+    // Tells the fragments of this game apart from those of other senders
+    // at the same address, as every send uses a fresh port
+    uint32_t mFragmentSource{ 0 };
+    uint16_t mNextFragmentGroup{ 0 };
+    // Copies of the message being broadcast, one slot per recipient, and
+    // the batch pointing into them
+    BroadcastMessage mBroadcast;
+    std::vector<uint8_t> mBroadcastData;
+    std::vector<Datagram> mBroadcastBatch;
+    BroadcastStats mBroadcastStats;
+    DryRunStats mDryRunStats;
 
 private:
     // Game State
-    std::unique_ptr<PositionState[]> mState;
-    std::unordered_map<uint32_t, PlayerState> mPlayers;
+    WorldGrid mGrid;
+    InterestManager mInterest;
+    MovementSystem mMovement;
+    PlayerTable mPlayers;
+    // Players which may have inputs in their jitter buffer. Handles of
+    // removed players are skipped and dropped on the next release.
+    std::vector<PlayerHandle> mPendingInputs;
+    // Endpoint key to player for players created from the network. Kept
+    // in step with mPlayers so a login is a single hash lookup.
+    std::unordered_map<uint64_t, PlayerHandle> mEndpoints;
+    std::unique_ptr<JobSystem> mJobs;
+    CheckpointWriter mCheckpoints;
     uint32_t mNextPlayerId{ 1 };
 };
 }
@@ -0,0 +1,175 @@
+#include "Interest.h"
+
+#include <algorithm>
+
+namespace Common
+{
+InterestManager::InterestManager(uint32_t radius)
+    : mRadius(radius)
+    , mBucketSize(std::max<uint32_t>(radius, 1))
+{ }
+
+uint64_t InterestManager::BucketKey(Position pos) const
+{
+    return (uint64_t(pos.y / mBucketSize) << 32) | (pos.x / mBucketSize);
+}
+
+bool InterestManager::IsVisible(Position a, Position b) const
+{
+    const uint32_t dx = a.x > b.x ? a.x - b.x : b.x - a.x;
+    const uint32_t dy = a.y > b.y ? a.y - b.y : b.y - a.y;
+
+    return dx <= mRadius && dy <= mRadius;
+}
+
+void InterestManager::Insert(std::vector<uint32_t>& visible, uint32_t id)
+{
+    auto it = std::lower_bound(visible.begin(), visible.end(), id);
+
+    if (it == visible.end() || *it != id)
+    {
+        visible.insert(it, id);
+    }
+}
+
+void InterestManager::Erase(std::vector<uint32_t>& visible, uint32_t id)
+{
+    auto it = std::lower_bound(visible.begin(), visible.end(), id);
+
+    if (it != visible.end() && *it == id)
+    {
+        visible.erase(it);
+    }
+}
+
+void InterestManager::RemoveFromBucket(const Entry& entry)
+{
+    std::vector<Member>& members = mBuckets[entry.bucket];
+
+    // Swap the last member into the hole and fix up its slot
+    if (entry.slot + 1 != members.size())
+    {
+        members[entry.slot] = members.back();
+        mEntries[members[entry.slot].id].slot = entry.slot;
+    }
+    members.pop_back();
+
+    if (members.empty())
+    {
+        mBuckets.erase(entry.bucket);
+    }
+}
+
+void InterestManager::Update(uint32_t id, Position pos)
+{
+    auto [it, added] = mEntries.try_emplace(id);
+    Entry& entry = it->second;
+
+    const uint64_t bucket = BucketKey(pos);
+
+    if (added || entry.bucket != bucket)
+    {
+        if (!added)
+        {
+            RemoveFromBucket(entry);
+        }
+
+        std::vector<Member>& members = mBuckets[bucket];
+        entry.bucket = bucket;
+        entry.slot = uint32_t(members.size());
+        members.push_back({ id, pos });
+    }
+    else
+    {
+        mBuckets[bucket][entry.slot].pos = pos;
+    }
+
+    entry.pos = pos;
+
+    // Everyone in range of the new position
+    mCandidates.clear();
+
+    const uint64_t bx = pos.x / mBucketSize;
+    const uint64_t by = pos.y / mBucketSize;
+
+    for (uint64_t y = by > 0 ? by - 1 : 0; y <= by + 1; ++y)
+    {
+        for (uint64_t x = bx > 0 ? bx - 1 : 0; x <= bx + 1; ++x)
+        {
+            auto b = mBuckets.find((y << 32) | x);
+
+            if (b == mBuckets.end())
+            {
+                continue;
+            }
+
+            for (const Member& other : b->second)
+            {
+                if (other.id != id && IsVisible(pos, other.pos))
+                {
+                    mCandidates.push_back(other.id);
+                }
+            }
+        }
+    }
+
+    std::sort(mCandidates.begin(), mCandidates.end());
+
+    // Walk the old and new sets together, telling each player that left
+    // or entered range about this one. Visibility is symmetric.
+    const std::vector<uint32_t>& previous = entry.visible;
+    size_t i = 0;
+    size_t j = 0;
+
+    while (i < previous.size() || j < mCandidates.size())
+    {
+        if (j == mCandidates.size()
+            || (i < previous.size() && previous[i] < mCandidates[j]))
+        {
+            Erase(mEntries[previous[i]].visible, id);
+            ++i;
+        }
+        else if (i == previous.size() || mCandidates[j] < previous[i])
+        {
+            Insert(mEntries[mCandidates[j]].visible, id);
+            ++j;
+        }
+        else
+        {
+            ++i;
+            ++j;
+        }
+    }
+
+    entry.visible.assign(mCandidates.begin(), mCandidates.end());
+}
+
+void InterestManager::Remove(uint32_t id)
+{
+    auto it = mEntries.find(id);
+
+    if (it == mEntries.end())
+    {
+        return;
+    }
+
+    Entry& entry = it->second;
+
+    for (uint32_t other : entry.visible)
+    {
+        Erase(mEntries[other].visible, id);
+    }
+
+    RemoveFromBucket(entry);
+    mEntries.erase(it);
+}
+
+Span<const uint32_t> InterestManager::GetVisible(uint32_t id) const
+{
+    if (auto it = mEntries.find(id); it != mEntries.end())
+    {
+        return { it->second.visible.data(), it->second.visible.size() };
+    }
+    return {};
+}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Common.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace Common
+{
+// Area of interest tracking. Every player sees the players within radius
+// cells of it on each axis (a square window on the board), and the
+// visible sets are kept up to date as players are added, moved and
+// removed.
+//
+// Players are bucketed on a coarse grid of radius sized buckets, so the
+// players that can see a cell are always within the 3x3 buckets around
+// it. A move only visits those buckets around the new position plus the
+// player's previous visible set, so its cost follows local density rather
+// than the total number of players.
+class InterestManager final
+{
+public:
+    InterestManager(const InterestManager&) = delete;
+    InterestManager& operator=(const InterestManager&) = delete;
+
+public:
+    explicit InterestManager(uint32_t radius);
+
+    uint32_t GetRadius() const { return mRadius; }
+
+    // Place a player, or move it if it is already tracked
+    void Update(uint32_t id, Position pos);
+    void Remove(uint32_t id);
+
+    bool IsVisible(Position a, Position b) const;
+
+    // Ids of the players visible to id, sorted and not including id itself.
+    // Empty if the player is not tracked.
+    Span<const uint32_t> GetVisible(uint32_t id) const;
+
+    size_t Size() const { return mEntries.size(); }
+
+private:
+    struct Entry
+    {
+        Position pos;
+        uint64_t bucket{ 0 };
+        // Index of this player in its bucket
+        uint32_t slot{ 0 };
+        std::vector<uint32_t> visible;
+    };
+
+    // Buckets keep a copy of each position so finding candidates does not
+    // need to look up every neighbour's entry.
+    struct Member
+    {
+        uint32_t id{ 0 };
+        Position pos;
+    };
+
+    uint64_t BucketKey(Position pos) const;
+    void RemoveFromBucket(const Entry& entry);
+
+    // Add or remove id from the sorted visible list of another player
+    static void Insert(std::vector<uint32_t>& visible, uint32_t id);
+    static void Erase(std::vector<uint32_t>& visible, uint32_t id);
+
+private:
+    uint32_t mRadius{ 0 };
+    uint32_t mBucketSize{ 1 };
+    std::unordered_map<uint32_t, Entry> mEntries;
+    std::unordered_map<uint64_t, std::vector<Member>> mBuckets;
+
+    // Scratch space reused by Update()
+    std::vector<uint32_t> mCandidates;
+};
+}
@@ -0,0 +1,183 @@
+#include "Interpolation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Common
+{
+namespace
+{
+// Cells a walk would need to get from a to b
+uint32_t Distance(Position a, Position b)
+{
+    const uint32_t dx = a.x > b.x ? a.x - b.x : b.x - a.x;
+    const uint32_t dy = a.y > b.y ? a.y - b.y : b.y - a.y;
+    return dx + dy;
+}
+
+RenderPosition ToRender(Position pos)
+{
+    return { double(pos.x), double(pos.y) };
+}
+}
+
+void SnapshotBuffer::Add(uint32_t tick, Position pos)
+{
+    // Walk back from the newest to find where the snapshot goes, most
+    // arrive in order and stop straight away.
+    uint32_t index = mCount;
+    while (index > 0 && int32_t(Get(index - 1).tick - tick) > 0)
+    {
+        --index;
+    }
+
+    if (index > 0 && Get(index - 1).tick == tick)
+    {
+        return;
+    }
+
+    if (mCount == kCapacity)
+    {
+        if (index == 0)
+        {
+            // Older than anything held
+            return;
+        }
+
+        mHead = (mHead + 1) % kCapacity;
+        mCount -= 1;
+        index -= 1;
+    }
+
+    for (uint32_t i = mCount; i > index; --i)
+    {
+        mSnapshots[(mHead + i) % kCapacity] = mSnapshots[(mHead + i - 1) % kCapacity];
+    }
+
+    mSnapshots[(mHead + index) % kCapacity] = Snapshot{ tick, pos };
+    mCount += 1;
+}
+
+const SnapshotBuffer::Snapshot& SnapshotBuffer::Get(size_t index) const
+{
+    assert(index < mCount);
+    return mSnapshots[(mHead + index) % kCapacity];
+}
+
+SnapshotBuffer::Sample SnapshotBuffer::GetPosition(double tick, RenderPosition& pos) const
+{
+    if (mCount == 0)
+    {
+        return Sample::None;
+    }
+
+    const Snapshot& oldest = Get(0);
+    const Snapshot& newest = Get(mCount - 1);
+
+    if (tick < double(oldest.tick))
+    {
+        pos = ToRender(oldest.pos);
+        return Sample::Held;
+    }
+
+    if (tick >= double(newest.tick))
+    {
+        pos = ToRender(newest.pos);
+
+        if (mCount < 2 || tick == double(newest.tick))
+        {
+            return mCount < 2 ? Sample::Held : Sample::Interpolated;
+        }
+
+        // Keep going the way the last two snapshots went
+        const Snapshot& previous = Get(mCount - 2);
+        const uint32_t ticks = newest.tick - previous.tick;
+
+        if (Distance(previous.pos, newest.pos) > ticks)
+        {
+            return Sample::Held;
+        }
+
+        const double t = std::min(tick - double(newest.tick), kMaxExtrapolation) / ticks;
+        pos.x += (double(newest.pos.x) - double(previous.pos.x)) * t;
+        pos.y += (double(newest.pos.y) - double(previous.pos.y)) * t;
+        return Sample::Extrapolated;
+    }
+
+    size_t next = mCount - 1;
+    while (next > 0 && double(Get(next - 1).tick) > tick)
+    {
+        --next;
+    }
+
+    const Snapshot& a = Get(next - 1);
+    const Snapshot& b = Get(next);
+    const uint32_t ticks = b.tick - a.tick;
+
+    pos = ToRender(a.pos);
+
+    // Spawns and teleports snap instead of sliding across the board
+    if (Distance(a.pos, b.pos) > ticks)
+    {
+        return Sample::Held;
+    }
+
+    const double t = (tick - double(a.tick)) / ticks;
+    pos.x += (double(b.pos.x) - double(a.pos.x)) * t;
+    pos.y += (double(b.pos.y) - double(a.pos.y)) * t;
+    return Sample::Interpolated;
+}
+
+SnapshotClock::SnapshotClock(std::chrono::steady_clock::duration interval)
+    : mInterval(interval)
+{
+    assert(mInterval.count() > 0);
+}
+
+double SnapshotClock::ToTicks(std::chrono::steady_clock::time_point time) const
+{
+    using namespace std::chrono;
+
+    return duration<double>(time.time_since_epoch()) / duration<double>(mInterval);
+}
+
+void SnapshotClock::OnSnapshot(uint32_t tick, std::chrono::steady_clock::time_point arrival)
+{
+    const double sample = double(tick) - ToTicks(arrival);
+
+    if (!mHasSnapshot)
+    {
+        mHasSnapshot = true;
+        mLastTick = tick;
+        mOffset = sample;
+        mJitter = 0.0;
+        mRenderTick = double(tick) - mDelay;
+        return;
+    }
+
+    // Reordered snapshots say nothing new about the clock
+    if (int32_t(tick - mLastTick) <= 0)
+    {
+        return;
+    }
+    mLastTick = tick;
+
+    const double error = sample - mOffset;
+    mOffset += error / 16.0;
+    mJitter += (std::abs(error) - mJitter) / 16.0;
+
+    const double target = std::clamp(kMinDelay + 2.0 * mJitter, kMinDelay, kMaxDelay);
+    mDelay += std::clamp(target - mDelay, -kMaxDelayStep, kMaxDelayStep);
+}
+
+double SnapshotClock::GetRenderTick(std::chrono::steady_clock::time_point now)
+{
+    if (!mHasSnapshot)
+    {
+        return 0.0;
+    }
+
+    mRenderTick = std::max(mRenderTick, ToTicks(now) + mOffset - mDelay);
+    return mRenderTick;
+}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Common.h"
+
+#include <array>
+#include <chrono>
+
+namespace Common
+{
+// Board position with a fractional part, for drawing a player between
+// cells
+struct RenderPosition
+{
+    double x{ 0.0 };
+    double y{ 0.0 };
+};
+
+// Recent authoritative positions of one remote player, indexed by the
+// server tick they are from. Sampling between two snapshots interpolates,
+// sampling past the newest continues its motion for a short while and
+// then holds it.
+class SnapshotBuffer final
+{
+public:
+    static constexpr uint32_t kCapacity = 32;
+
+    // Ticks to keep moving past the newest snapshot before stopping
+    static constexpr double kMaxExtrapolation = 2.0;
+
+    enum class Sample : uint32_t
+    {
+        None,
+        Interpolated,
+        Extrapolated,
+        // Outside the snapshots, or across a jump no walk could make
+        Held
+    };
+
+    struct Snapshot
+    {
+        uint32_t tick{ 0 };
+        Position pos;
+    };
+
+public:
+    SnapshotBuffer() = default;
+
+    // Add the position at tick. Snapshots may arrive out of order, a tick
+    // already held is ignored and the oldest is dropped when full.
+    void Add(uint32_t tick, Position pos);
+
+    Sample GetPosition(double tick, RenderPosition& pos) const;
+
+    size_t Size() const { return mCount; }
+    const Snapshot& Get(size_t index) const;
+
+private:
+    // Ring sorted by tick, mHead is the oldest
+    std::array<Snapshot, kCapacity> mSnapshots;
+    uint32_t mHead{ 0 };
+    uint32_t mCount{ 0 };
+};
+
+// Maps local time onto the server's ticks from the arrival of snapshots,
+// and picks how far behind the newest snapshot remote players are drawn.
+//
+// The delay follows the jitter of the arrivals, so a steady link is drawn
+// a little over a tick behind while a jittery one waits long enough to
+// nearly always have a snapshot on both sides. The returned tick never
+// goes backwards.
+class SnapshotClock final
+{
+public:
+    // Delay bounds in ticks
+    static constexpr double kMinDelay = 1.0;
+    static constexpr double kMaxDelay = 6.0;
+
+    // Largest change of the delay per snapshot, so motion slows or speeds
+    // up a little instead of jumping
+    static constexpr double kMaxDelayStep = 0.1;
+
+public:
+    explicit SnapshotClock(std::chrono::steady_clock::duration interval);
+
+    void OnSnapshot(uint32_t tick, std::chrono::steady_clock::time_point arrival);
+
+    // Server tick to draw remote players at
+    double GetRenderTick(std::chrono::steady_clock::time_point now);
+
+    double GetDelay() const { return mDelay; }
+    double GetJitter() const { return mJitter; }
+
+private:
+    double ToTicks(std::chrono::steady_clock::time_point time) const;
+
+private:
+    std::chrono::steady_clock::duration mInterval;
+    bool mHasSnapshot{ false };
+    uint32_t mLastTick{ 0 };
+    // Server tick minus local time, both in ticks
+    double mOffset{ 0.0 };
+    double mJitter{ 0.0 };
+    double mDelay{ kMinDelay };
+    double mRenderTick{ 0.0 };
+};
+}
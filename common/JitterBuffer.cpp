@@ -0,0 +1,111 @@
+#include "JitterBuffer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace Common
+{
+JitterBuffer::Result JitterBuffer::Push(uint32_t tick, uint32_t now, Movement movement)
+{
+    const int32_t lead = int32_t(tick - now);
+
+    if (lead > int32_t(kMaxLead))
+    {
+        return Result::TooEarly;
+    }
+
+    // Late inputs still count towards the estimate, they are the reason
+    // the client needs to aim further ahead.
+    AddSample(lead);
+
+    if (lead < 0)
+    {
+        tick = now;
+    }
+
+    auto begin = mInputs.begin();
+    auto end = begin + mCount;
+    auto it = std::lower_bound(begin, end, tick,
+        [](const Input& input, uint32_t value) { return input.tick < value; });
+
+    if (lead < 0)
+    {
+        // Runs on the first tick from now without an input, the inputs
+        // which arrived in time keep theirs
+        for (; it != end && it->tick == tick; ++it)
+        {
+            tick += 1;
+        }
+    }
+    else if (it != end && it->tick == tick)
+    {
+        it->movement = movement;
+        return Result::Buffered;
+    }
+
+    if (mCount == kCapacity)
+    {
+        return Result::Full;
+    }
+
+    std::move_backward(it, end, end + 1);
+    *it = Input{ tick, movement };
+    mCount += 1;
+
+    return lead < 0 ? Result::Late : Result::Buffered;
+}
+
+bool JitterBuffer::Pop(uint32_t tick, Movement& movement)
+{
+    if (mCount == 0 || mInputs[0].tick > tick)
+    {
+        return false;
+    }
+
+    movement = mInputs[0].movement;
+
+    std::move(mInputs.begin() + 1, mInputs.begin() + mCount, mInputs.begin());
+    mCount -= 1;
+
+    return true;
+}
+
+void JitterBuffer::AddSample(int32_t lead)
+{
+    const int32_t sample = std::max(lead, -int32_t(kMaxLead)) * kScale;
+
+    if (!mHasSample)
+    {
+        mLead = sample;
+        mJitter = 0;
+        mHasSample = true;
+        return;
+    }
+
+    const int32_t error = sample - mLead;
+    mLead += error / 8;
+    mJitter += (std::abs(error) - mJitter) / 4;
+}
+
+uint32_t JitterBuffer::GetTargetLead() const
+{
+    // Two deviations ahead covers nearly every input without adding much
+    // delay when the link is steady.
+    const int32_t target = (2 * mJitter + kScale - 1) / kScale;
+    return uint32_t(std::min(target, int32_t(kMaxTargetLead)));
+}
+
+int32_t JitterBuffer::GetLeadError() const
+{
+    if (!mHasSample)
+    {
+        return 0;
+    }
+
+    const int32_t error = mLead - int32_t(GetTargetLead()) * kScale;
+
+    return error >= 0
+        ? (error + kScale / 2) / kScale
+        : -((-error + kScale / 2) / kScale);
+}
+}
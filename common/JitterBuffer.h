@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Common.h"
+
+#include <array>
+
+namespace Common
+{
+// Holds the inputs of one client until the simulation tick they were
+// stamped for, so network jitter changes how early an input waits rather
+// than which tick it lands on.
+//
+// Every input records how many ticks ahead of the simulation it arrived
+// (its lead). The buffer keeps a smoothed lead and its mean deviation, the
+// same way TCP tracks round trip times, and from those works out how far
+// ahead the client should aim so jittery inputs still arrive in time. The
+// difference is reported back to the client so it can adjust.
+class JitterBuffer final
+{
+public:
+    // Most inputs waiting at once, one per tick
+    static constexpr uint32_t kCapacity = 16;
+
+    // Inputs stamped further ahead than this are dropped
+    static constexpr uint32_t kMaxLead = 32;
+
+    // Upper bound on the lead asked of a client, however bad its jitter
+    static constexpr uint32_t kMaxTargetLead = 8;
+
+    enum class Result : uint32_t
+    {
+        // Waiting for its tick
+        Buffered,
+        // Its tick has passed, it runs on the first tick from the current
+        // one which has no input yet
+        Late,
+        // Stamped more than kMaxLead ticks ahead and dropped
+        TooEarly,
+        // No room left and dropped
+        Full
+    };
+
+    struct Input
+    {
+        uint32_t tick{ 0 };
+        Movement movement{ Movement::Left };
+    };
+
+public:
+    JitterBuffer() = default;
+
+    // Add an input stamped for tick while the simulation is on now. A
+    // second input for the same tick replaces the first, unless it is late:
+    // late inputs never replace one which arrived in time.
+    Result Push(uint32_t tick, uint32_t now, Movement movement);
+
+    // Take the earliest input due on or before tick. Returns false if
+    // nothing is due.
+    bool Pop(uint32_t tick, Movement& movement);
+
+    bool IsEmpty() const { return mCount == 0; }
+    size_t Size() const { return mCount; }
+
+    // Ticks ahead the client should stamp its inputs, from the measured
+    // jitter. Zero until an input has arrived.
+    uint32_t GetTargetLead() const;
+
+    // How many ticks earlier than the target inputs are arriving. Positive
+    // means the client can stamp inputs closer to the current tick,
+    // negative means they are cutting it too fine and should aim further
+    // ahead.
+    int32_t GetLeadError() const;
+
+private:
+    // Smoothed values are kept in 1/16th of a tick
+    static constexpr int32_t kScale = 16;
+
+    void AddSample(int32_t lead);
+
+private:
+    // Sorted by tick
+    std::array<Input, kCapacity> mInputs;
+    uint32_t mCount{ 0 };
+
+    bool mHasSample{ false };
+    int32_t mLead{ 0 };
+    int32_t mJitter{ 0 };
+};
+}
@@ -0,0 +1,171 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Common
+{
+JobSystem::JobSystem(uint32_t threads)
+{
+    assert(threads > 0);
+
+    for (uint32_t i = 0; i < threads; ++i)
+    {
+        mQueues.push_back(std::make_unique<Queue>());
+    }
+
+    // The caller is thread 0
+    for (uint32_t i = 1; i < threads; ++i)
+    {
+        mThreads.emplace_back([this, i] { Work(i); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+
+    mCond.notify_all();
+
+    for (std::thread& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+void JobSystem::Run(size_t count, size_t jobSize, const JobFn& fn)
+{
+    assert(jobSize > 0);
+    assert(mPending == 0);
+
+    const size_t jobs = GetJobCount(count, jobSize);
+
+    if (jobs == 0)
+    {
+        return;
+    }
+
+    mBatches += 1;
+    mJobs += jobs;
+
+    // Nothing to share out, skip the queues altogether
+    if (mQueues.size() == 1 || jobs == 1)
+    {
+        for (size_t i = 0; i < jobs; ++i)
+        {
+            fn(i * jobSize, std::min(count, (i + 1) * jobSize), i);
+        }
+        return;
+    }
+
+    mPending = jobs;
+
+    // Deal the jobs out, each thread starting from the back of its deque
+    // with the last job dealt to it
+    for (size_t i = 0; i < jobs; ++i)
+    {
+        Queue& queue = *mQueues[i % mQueues.size()];
+        std::lock_guard lock(queue.mutex);
+        queue.jobs.push_back({ &fn, i * jobSize, std::min(count, (i + 1) * jobSize), i });
+    }
+
+    {
+        std::lock_guard lock(mMutex);
+        mBatch += 1;
+    }
+
+    mCond.notify_all();
+
+    Job job;
+
+    while (Pop(0, job) || Steal(0, job))
+    {
+        Execute(job);
+    }
+
+    // The last jobs are running elsewhere
+    while (mPending.load(std::memory_order_acquire) != 0)
+    {
+        std::this_thread::yield();
+    }
+}
+
+JobSystem::Stats JobSystem::GetStats() const
+{
+    Stats stats;
+    stats.batches = mBatches;
+    stats.jobs = mJobs;
+    stats.stolen = mStolen.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool JobSystem::Pop(uint32_t thread, Job& job)
+{
+    Queue& queue = *mQueues[thread];
+    std::lock_guard lock(queue.mutex);
+
+    if (queue.jobs.empty())
+    {
+        return false;
+    }
+
+    job = queue.jobs.back();
+    queue.jobs.pop_back();
+    return true;
+}
+
+bool JobSystem::Steal(uint32_t thread, Job& job)
+{
+    // Start with the next thread along so thieves spread over the victims
+    for (size_t i = 1; i < mQueues.size(); ++i)
+    {
+        Queue& queue = *mQueues[(thread + i) % mQueues.size()];
+        std::lock_guard lock(queue.mutex);
+
+        if (!queue.jobs.empty())
+        {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+            mStolen.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JobSystem::Execute(const Job& job)
+{
+    (*job.fn)(job.begin, job.end, job.index);
+    mPending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::Work(uint32_t thread)
+{
+    uint64_t seen = 0;
+
+    while (true)
+    {
+        Job job;
+
+        if (Pop(thread, job) || Steal(thread, job))
+        {
+            Execute(job);
+            continue;
+        }
+
+        std::unique_lock lock(mMutex);
+        mCond.wait(lock, [&] { return mStopping || mBatch != seen; });
+
+        if (mStopping)
+        {
+            return;
+        }
+
+        seen = mBatch;
+    }
+}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Common.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Common
+{
+// Runs a batch of jobs over a fixed set of threads and waits for them.
+//
+// Every thread has its own deque of jobs, and a batch is dealt out over
+// them evenly. A thread works through its own deque from the back and,
+// once it runs dry, steals from the front of the others, so the threads
+// finishing early take over the jobs of those running late. The thread
+// calling Run() is the first of the threads and returns once the whole
+// batch is done.
+//
+// The items a job covers depend only on the item count and job size,
+// never on the number of threads. Jobs which only write to their own
+// items, and to their own slot for anything summed up afterwards, give
+// the same results on any number of threads.
+class JobSystem final
+{
+public:
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+public:
+    // Called with the items [begin, end) of one job and its index
+    using JobFn = std::function<void(size_t begin, size_t end, size_t job)>;
+
+    struct Stats
+    {
+        uint64_t batches{ 0 };
+        uint64_t jobs{ 0 };
+        // Run by another thread than the one they were dealt to
+        uint64_t stolen{ 0 };
+    };
+
+public:
+    // threads counts the caller, with one every job runs on the caller
+    explicit JobSystem(uint32_t threads);
+    ~JobSystem();
+
+    uint32_t GetThreadCount() const { return uint32_t(mQueues.size()); }
+
+    static size_t GetJobCount(size_t count, size_t jobSize)
+    {
+        return (count + jobSize - 1) / jobSize;
+    }
+
+    // Run fn over [0, count) in jobs of jobSize items. Only one thread
+    // calls Run() at a time and jobs do not call it themselves.
+    void Run(size_t count, size_t jobSize, const JobFn& fn);
+
+    // Read by the thread calling Run()
+    Stats GetStats() const;
+
+private:
+    struct Job
+    {
+        const JobFn* fn{ nullptr };
+        size_t begin{ 0 };
+        size_t end{ 0 };
+        size_t index{ 0 };
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    bool Pop(uint32_t thread, Job& job);
+    bool Steal(uint32_t thread, Job& job);
+    void Execute(const Job& job);
+    void Work(uint32_t thread);
+
+private:
+    std::vector<std::unique_ptr<Queue>> mQueues;
+    std::vector<std::thread> mThreads;
+
+    // Jobs of the current batch still to finish
+    std::atomic<size_t> mPending{ 0 };
+
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    // Bumped for every batch so sleeping threads know to look again
+    uint64_t mBatch{ 0 };
+    bool mStopping{ false };
+
+    uint64_t mBatches{ 0 };
+    uint64_t mJobs{ 0 };
+    std::atomic<uint64_t> mStolen{ 0 };
+};
+}
@@ -0,0 +1,304 @@
+#pragma once
+
+#include "Common.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace Common
+{
+// Bounds checked big endian reader over a block of memory.
+class MemoryReader final
+{
+public:
+    MemoryReader(const void* data, size_t size)
+        : mData(static_cast<const uint8_t*>(data))
+        , mSize(size)
+    { }
+
+    ~MemoryReader() = default;
+
+    size_t Offset() const { return mOffset; }
+
+    size_t Remaining() const { return mSize - mOffset; }
+
+    void Reset() { Seek(0); }
+
+    void Seek(size_t offset)
+    {
+        assert(offset < mSize);
+        mOffset = offset;
+    }
+
+    void Skip(size_t count)
+    {
+        Seek(mOffset + count);
+    }
+
+    size_t Size() const { return mSize; }
+
+    Span<const uint8_t> GetSpan() const
+    {
+        return { mData + mOffset, Remaining() };
+    }
+
+public:
+    uint8_t Read() { return Read(mOffset); }
+    uint8_t Read(size_t offset)
+    {
+        if (offset <= mSize)
+        {
+            Seek(offset);
+            return mData[mOffset++];
+        }
+        return 0;
+    }
+
+    uint16_t Read16_BE()
+    {
+        if (mOffset + 2 <= mSize)
+        {
+            uint16_t value = (uint16_t(mData[mOffset]) << 8)
+                + uint16_t(mData[mOffset + 1]);
+
+            mOffset += 2;
+            return value;
+        }
+        return 0;
+    }
+    uint16_t Read16_BE(size_t offset)
+    {
+        if (offset + 2 <= mSize)
+        {
+            Seek(offset);
+            uint16_t value = (uint16_t(mData[mOffset]) << 8)
+                + uint16_t(mData[mOffset + 1]);
+
+            mOffset += 2;
+            return value;
+        }
+        return 0;
+    }
+
+    uint32_t Read32_BE()
+    {
+        if (mOffset + 4 <= mSize)
+        {
+            uint32_t value = (uint32_t(mData[mOffset]) << 24)
+                + (uint32_t(mData[mOffset + 1]) << 16)
+                + (uint32_t(mData[mOffset + 2]) << 8)
+                + uint32_t(mData[mOffset + 3]);
+
+            mOffset += 4;
+            return value;
+        }
+        return 0;
+    }
+    uint32_t Read32_BE(size_t offset)
+    {
+        if (offset + 4 <= mSize)
+        {
+            Seek(offset);
+            uint32_t value = (uint32_t(mData[mOffset]) << 24)
+                + (uint32_t(mData[mOffset + 1]) << 16)
+                + (uint32_t(mData[mOffset + 2]) << 8)
+                + uint32_t(mData[mOffset + 3]);
+
+            mOffset += 4;
+            return value;
+        }
+        return 0;
+    }
+
+    uint64_t Read64_BE()
+    {
+        if (mOffset + 8 <= mSize)
+        {
+            uint64_t value = uint64_t(uint64_t(mData[mOffset]) << 56)
+                + uint64_t(uint64_t(mData[mOffset + 1]) << 48)
+                + uint64_t(uint64_t(mData[mOffset + 2]) << 40)
+                + uint64_t(uint64_t(mData[mOffset + 3]) << 32)
+                + uint64_t(uint64_t(mData[mOffset + 4]) << 24)
+                + uint64_t(uint64_t(mData[mOffset + 5]) << 16)
+                + uint64_t(uint64_t(mData[mOffset + 6]) << 8)
+                + uint64_t(mData[mOffset + 7]);
+
+            mOffset += 8;
+            return value;
+        }
+        return 0;
+    }
+    uint64_t Read64_BE(size_t offset)
+    {
+        if (offset + 4 <= mSize)
+        {
+            Seek(offset);
+            uint64_t value = uint64_t(uint64_t(mData[mOffset]) << 56)
+                + uint64_t(uint64_t(mData[mOffset + 1]) << 48)
+                + uint64_t(uint64_t(mData[mOffset + 2]) << 40)
+                + uint64_t(uint64_t(mData[mOffset + 3]) << 32)
+                + uint64_t(uint64_t(mData[mOffset + 4]) << 24)
+                + uint64_t(uint64_t(mData[mOffset + 5]) << 16)
+                + uint64_t(uint64_t(mData[mOffset + 6]) << 8)
+                + uint64_t(mData[mOffset + 7]);
+
+            mOffset += 8;
+            return value;
+        }
+        return 0;
+    }
+
+    Span<const uint8_t> ReadSpan(size_t length)
+    {
+        return ReadSpan(mOffset, length);
+    }
+    Span<const uint8_t> ReadSpan(size_t offset, size_t length)
+    {
+        if (offset + length <= mSize)
+        {
+            Seek(offset);
+            Span<const uint8_t> data{
+                mData + mOffset,
+                length
+            };
+
+            mOffset += length;
+            return data;
+        }
+        return {};
+    }
+
+    
+private:
+    const uint8_t* mData{ nullptr };
+    size_t mSize{ 0 };
+    size_t mOffset{ 0 };
+};
+
+// Bounds checked big endian writer over a block of memory.
+class MemoryWriter final
+{
+public:
+    MemoryWriter(void* data, size_t size)
+        : mData(static_cast<uint8_t*>(data))
+        , mSize(size)
+    { }
+
+    ~MemoryWriter() = default;
+
+    size_t Offset() const { return mOffset; }
+
+    size_t Remaining() const { return mSize - mOffset; }
+
+    void Reset() { Seek(0); }
+
+    void Seek(size_t offset)
+    {
+        assert(offset < mSize);
+        mOffset = offset;
+    }
+
+    void Skip(size_t count)
+    {
+        Seek(mOffset + count);
+    }
+
+    size_t Size() const { return mSize; }
+
+    Span<const uint8_t> GetSpan() const
+    {
+        return { mData + mOffset, Remaining() };
+    }
+
+public:
+    void Put(
+        const void* data,
+        size_t size)
+    {
+        Put(mOffset, data, size);
+    }
+    void Put(
+        size_t offset,
+        const void* data,
+        size_t size)
+    {
+        if (offset + size <= mSize)
+        {
+            Seek(offset);
+
+            memcpy(mData + mOffset, data, size);
+            mOffset += size;
+        }
+    }
+
+    void Put16_BE(uint16_t value)
+    {
+        Put16_BE(mOffset, value);
+    }
+    void Put16_BE(size_t offset, uint16_t value)
+    {
+        uint8_t values[2] = {
+            uint8_t(value >> 8),
+            uint8_t(value)
+        };
+
+        Put(offset, values, sizeof(values));
+    }
+
+    void Put32_BE(uint32_t value)
+    {
+        Put32_BE(mOffset, value);
+    }
+    void Put32_BE(size_t offset, uint32_t value)
+    {
+        uint8_t values[4] = {
+            uint8_t(value >> 24),
+            uint8_t(value >> 16),
+            uint8_t(value >> 8),
+            uint8_t(value)
+        };
+
+        Put(offset, values, sizeof(values));
+    }
+
+    void Put64_BE(uint64_t value)
+    {
+        Put64_BE(mOffset, value);
+    }
+    void Put64_BE(size_t offset, uint64_t value)
+    {
+        uint8_t values[8] = {
+            uint8_t(value >> 56),
+            uint8_t(value >> 48),
+            uint8_t(value >> 40),
+            uint8_t(value >> 32),
+            uint8_t(value >> 24),
+            uint8_t(value >> 16),
+            uint8_t(value >> 8),
+            uint8_t(value)
+        };
+
+        Put(offset, values, sizeof(values));
+    }
+
+    void PutZero(size_t count)
+    {
+        PutZero(mOffset, count);
+    }
+    void PutZero(size_t offset, size_t count)
+    {
+        if (offset + count <= mSize)
+        {
+            Seek(offset);
+
+            memset(mData + mOffset, 0, count);
+            mOffset += count;
+        }
+    }
+
+private:
+    uint8_t* mData{ nullptr };
+    size_t mSize{ 0 };
+    size_t mOffset{ 0 };
+};
+}
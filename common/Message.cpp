@@ -1,364 +1,483 @@
 #include "Message.h"
 
+#include "Compression.h"
+#include "Memory.h"
+
+#include <algorithm>
+
 namespace Common
 {
-uint64_t FNV1A_64(const void* data, size_t size)
+namespace
 {
-    static constexpr uint64_t kFnv1aSeed{ 14695981039346656037ULL };
-    static constexpr uint64_t kFnv1aPrime{ 1099511628211ULL };
+constexpr uint32_t kFnv1a32Seed{ 2166136261u };
+constexpr uint32_t kFnv1a32Prime{ 16777619u };
+constexpr uint64_t kFnv1a64Seed{ 14695981039346656037ULL };
+constexpr uint64_t kFnv1a64Prime{ 1099511628211ULL };
 
-    const auto* d = static_cast<const uint8_t*>(data);
-    uint64_t seed = kFnv1aSeed;
+// Offset of the checksum in a compact header, the fields before it are
+// covered by it
+constexpr size_t kCompactChecksumOffset = kCompactHeaderSize - sizeof(uint32_t);
 
+// Action and message id, the fields of a Message after its header
+constexpr size_t kMessageFieldsSize = kMessageSize - kMessageHeaderSize;
+
+uint32_t Fnv1a32(uint32_t hash, const uint8_t* data, size_t size)
+{
     while (size-- > 0)
     {
-        seed = (seed ^ *d++) * kFnv1aPrime;
+        hash = (hash ^ *data++) * kFnv1a32Prime;
     }
 
-    return seed;
+    return hash;
 }
 
-class MemoryReader final
+uint64_t Fnv1a64(uint64_t hash, const uint8_t* data, size_t size)
 {
-public:
-    MemoryReader(const void* data, size_t size)
-        : mData(static_cast<const uint8_t*>(data))
-        , mSize(size)
-    { }
-
-    ~MemoryReader() = default;
+    while (size-- > 0)
+    {
+        hash = (hash ^ *data++) * kFnv1a64Prime;
+    }
 
-    size_t Offset() const { return mOffset; }
+    return hash;
+}
 
-    size_t Remaining() const { return mSize - mOffset; }
+// Hash of a compact message, skipping the checksum field itself. The header
+// comes first unless payloadFirst is set.
+uint32_t CompactChecksum(Span<const uint8_t> message, bool payloadFirst)
+{
+    assert(message.size >= kCompactHeaderSize);
 
-    void Reset() { Seek(0); }
+    const uint8_t* payload = message.data + kCompactHeaderSize;
+    const size_t payloadSize = message.size - kCompactHeaderSize;
 
-    void Seek(size_t offset)
+    if (!payloadFirst)
     {
-        assert(offset < mSize);
-        mOffset = offset;
+        uint32_t hash = Fnv1a32(kFnv1a32Seed, message.data, kCompactChecksumOffset);
+        return Fnv1a32(hash, payload, payloadSize);
     }
 
-    void Skip(size_t count)
+    uint32_t hash = Fnv1a32(kFnv1a32Seed, payload, payloadSize);
+    return Fnv1a32(hash, message.data, kCompactChecksumOffset);
+}
+
+// Hash of the body of an uncompressed message, the payload first and then
+// the action and message id
+uint64_t MessageHash(Span<const uint8_t> data)
+{
+    if (data.size < kMessageFieldsSize)
     {
-        Seek(mOffset + count);
+        return Fnv1a64(kFnv1a64Seed, data.data, data.size);
     }
 
-    size_t Size() const { return mSize; }
+    uint64_t hash = Fnv1a64(
+        kFnv1a64Seed,
+        data.data + kMessageFieldsSize,
+        data.size - kMessageFieldsSize);
+    return Fnv1a64(hash, data.data, kMessageFieldsSize);
+}
+}
+
+uint32_t FNV1A_32(const void* data, size_t size)
+{
+    return Fnv1a32(kFnv1a32Seed, static_cast<const uint8_t*>(data), size);
+}
+
+uint64_t FNV1A_64(const void* data, size_t size)
+{
+    return Fnv1a64(kFnv1a64Seed, static_cast<const uint8_t*>(data), size);
+}
+
+bool DeserializeHeader(
+    Span<const uint8_t> data,
+    MessageHeader& header)
+{
+    assert(data.size >= kMessageHeaderSize);
+    MemoryReader reader(data.data, data.size);
+
+    // Read the two magic bytes
+    header.magic[0] = reader.Read();
+    header.magic[1] = reader.Read();
+    // Read the flags
+    header.flags = reader.Read();
+    // Read the hash value
+    header.hash = reader.Read64_BE();
+    // Read the payload size
+    header.payloadSize = reader.Read32_BE();
+
+    assert(reader.Remaining() == 0);
+
+    constexpr uint8_t kKnownFlags =
+        MessageHeader::kFlagCompressed | MessageHeader::kFlagPayloadFirst;
+
+    return header.magic[0] == MessageHeader::kMagicBytes[0]
+        && header.magic[1] == MessageHeader::kMagicBytes[1]
+        && (header.flags & ~kKnownFlags) == 0
+        && header.hash > 0
+        && header.payloadSize > 0;
+}
+
+void SerializeHeader(
+    MessageHeader& header,
+    Span<uint8_t> buffer,
+    Span<const uint8_t> data)
+{
+    assert(buffer.size >= kMessageHeaderSize);
+    MemoryWriter writer(buffer.data, kMessageHeaderSize);
 
-    Span<const uint8_t> GetSpan() const
+    // Set the magic bytes (byte-0 and byte-1)
+    header.magic[0] = MessageHeader::kMagicBytes[0];
+    header.magic[1] = MessageHeader::kMagicBytes[1];
     {
-        return { mData + mOffset, Remaining() };
+        writer.Put(header.magic, sizeof(header.magic));
     }
-
-public:
-    uint8_t Read() { return Read(mOffset); }
-    uint8_t Read(size_t offset)
+    // Set the flags describing the payload
     {
-        if (offset <= mSize)
-        {
-            Seek(offset);
-            return mData[mOffset++];
-        }
-        return 0;
+        writer.Put(&header.flags, sizeof(header.flags));
     }
-
-    uint16_t Read16_BE()
+    // Set the message FNV1A-64 hash
+    header.hash = (header.flags & MessageHeader::kFlagPayloadFirst)
+        ? MessageHash(data)
+        : FNV1A_64(data.data, data.size);
     {
-        if (mOffset + 2 <= mSize)
-        {
-            uint16_t value = (uint16_t(mData[mOffset]) << 8)
-                + uint16_t(mData[mOffset + 1]);
-
-            mOffset += 2;
-            return value;
-        }
-        return 0;
+        writer.Put64_BE(header.hash);
     }
-    uint16_t Read16_BE(size_t offset)
+    // set the payload size
+    header.payloadSize = data.size;
     {
-        if (offset + 2 <= mSize)
-        {
-            Seek(offset);
-            uint16_t value = (uint16_t(mData[mOffset]) << 8)
-                + uint16_t(mData[mOffset + 1]);
-
-            mOffset += 2;
-            return value;
-        }
-        return 0;
+        writer.Put32_BE(header.payloadSize);
     }
+}
+bool IsCompressed(Span<const uint8_t> input)
+{
+    MessageHeader header;
 
-    uint32_t Read32_BE()
-    {
-        if (mOffset + 4 <= mSize)
-        {
-            uint32_t value = (uint32_t(mData[mOffset]) << 24)
-                + (uint32_t(mData[mOffset + 1]) << 16)
-                + (uint32_t(mData[mOffset + 2]) << 8)
-                + uint32_t(mData[mOffset + 3]);
+    return input.size > kMessageHeaderSize
+        && DeserializeHeader(input.Subspan(0, kMessageHeaderSize), header)
+        && (header.flags & MessageHeader::kFlagCompressed);
+}
 
-            mOffset += 4;
-            return value;
-        }
+size_t CompressMessage(Span<const uint8_t> input, Span<uint8_t> output)
+{
+    constexpr size_t kSizePrefix = 4;
+
+    MessageHeader header;
+
+    if (input.size <= kMessageHeaderSize
+        || !DeserializeHeader(input.Subspan(0, kMessageHeaderSize), header)
+        || (header.flags & MessageHeader::kFlagCompressed))
+    {
         return 0;
     }
-    uint32_t Read32_BE(size_t offset)
+
+    // The compressed message must come out smaller than the original,
+    // anything else and we just send the original.
+    const size_t limit = std::min(output.size, input.size - 1);
+
+    if (limit <= kMessageHeaderSize + kSizePrefix)
     {
-        if (offset + 4 <= mSize)
-        {
-            Seek(offset);
-            uint32_t value = (uint32_t(mData[mOffset]) << 24)
-                + (uint32_t(mData[mOffset + 1]) << 16)
-                + (uint32_t(mData[mOffset + 2]) << 8)
-                + uint32_t(mData[mOffset + 3]);
-
-            mOffset += 4;
-            return value;
-        }
         return 0;
     }
 
-    uint64_t Read64_BE()
+    Span<const uint8_t> payload = input.Subspan(kMessageHeaderSize);
+    Span<uint8_t> body = output.Subspan(kMessageHeaderSize, limit);
+
+    // The uncompressed size is sent ahead of the compressed data so the
+    // receiver can validate the expanded message.
+    MemoryWriter writer(body.data, body.size);
+    writer.Put32_BE(uint32_t(payload.size));
+
+    size_t compressed = LzCompress(payload, body.Subspan(kSizePrefix));
+
+    if (compressed == 0)
     {
-        if (mOffset + 8 <= mSize)
-        {
-            uint64_t value = uint64_t(uint64_t(mData[mOffset]) << 56)
-                + uint64_t(uint64_t(mData[mOffset + 1]) << 48)
-                + uint64_t(uint64_t(mData[mOffset + 2]) << 40)
-                + uint64_t(uint64_t(mData[mOffset + 3]) << 32)
-                + uint64_t(uint64_t(mData[mOffset + 4]) << 24)
-                + uint64_t(uint64_t(mData[mOffset + 5]) << 16)
-                + uint64_t(uint64_t(mData[mOffset + 6]) << 8)
-                + uint64_t(mData[mOffset + 7]);
-
-            mOffset += 8;
-            return value;
-        }
         return 0;
     }
-    uint64_t Read64_BE(size_t offset)
+
+    Span<uint8_t> headerData = output.Subspan(0, kMessageHeaderSize);
+    Span<const uint8_t> data{ body.data, kSizePrefix + compressed };
+
+    header.flags = MessageHeader::kFlagCompressed;
+    SerializeHeader(header, headerData, data);
+
+    return kMessageHeaderSize + data.size;
+}
+
+size_t DecompressMessage(Span<const uint8_t> input, Span<uint8_t> output)
+{
+    constexpr size_t kSizePrefix = 4;
+
+    MessageHeader header;
+
+    if (input.size <= kMessageHeaderSize + kSizePrefix
+        || !DeserializeHeader(input.Subspan(0, kMessageHeaderSize), header)
+        || !(header.flags & MessageHeader::kFlagCompressed)
+        || header.payloadSize > input.size - kMessageHeaderSize)
     {
-        if (offset + 4 <= mSize)
-        {
-            Seek(offset);
-            uint64_t value = uint64_t(uint64_t(mData[mOffset]) << 56)
-                + uint64_t(uint64_t(mData[mOffset + 1]) << 48)
-                + uint64_t(uint64_t(mData[mOffset + 2]) << 40)
-                + uint64_t(uint64_t(mData[mOffset + 3]) << 32)
-                + uint64_t(uint64_t(mData[mOffset + 4]) << 24)
-                + uint64_t(uint64_t(mData[mOffset + 5]) << 16)
-                + uint64_t(uint64_t(mData[mOffset + 6]) << 8)
-                + uint64_t(mData[mOffset + 7]);
-
-            mOffset += 8;
-            return value;
-        }
         return 0;
     }
 
-    Span<const uint8_t> ReadSpan(size_t length)
+    Span<const uint8_t> body = input.Subspan(
+        kMessageHeaderSize,
+        kMessageHeaderSize + header.payloadSize);
+    MemoryReader reader(body.data, body.size);
+
+    const size_t size = reader.Read32_BE();
+
+    if (size == 0
+        || size > kMaxMessageSize - kMessageHeaderSize
+        || size > output.size - std::min(output.size, kMessageHeaderSize))
     {
-        return ReadSpan(mOffset, length);
+        return 0;
     }
-    Span<const uint8_t> ReadSpan(size_t offset, size_t length)
+
+    Span<uint8_t> payload = output.Subspan(
+        kMessageHeaderSize,
+        kMessageHeaderSize + size);
+
+    if (LzDecompress(body.Subspan(kSizePrefix), payload) != size)
     {
-        if (offset + length <= mSize)
-        {
-            Seek(offset);
-            Span<const uint8_t> data{
-                mData + mOffset,
-                length
-            };
-
-            mOffset += length;
-            return data;
-        }
-        return {};
+        return 0;
     }
 
-    
-private:
-    const uint8_t* mData{ nullptr };
-    size_t mSize{ 0 };
-    size_t mOffset{ 0 };
-};
-
-class MemoryWriter final
-{
-public:
-    MemoryWriter(void* data, size_t size)
-        : mData(static_cast<uint8_t*>(data))
-        , mSize(size)
-    { }
+    // Rewrite the header as if the message was never compressed
+    Span<uint8_t> headerData = output.Subspan(0, kMessageHeaderSize);
+    Span<const uint8_t> data{ payload.data, payload.size };
 
-    ~MemoryWriter() = default;
+    header.flags = 0;
+    SerializeHeader(header, headerData, data);
 
-    size_t Offset() const { return mOffset; }
+    return kMessageHeaderSize + size;
+}
 
-    size_t Remaining() const { return mSize - mOffset; }
+bool IsCompact(Span<const uint8_t> input)
+{
+    return input.size >= kCompactHeaderSize && input.data[0] == CompactHeader::kMagic;
+}
 
-    void Reset() { Seek(0); }
+bool IsRoomAddressed(Span<const uint8_t> input)
+{
+    return input.size >= kRoomHeaderSize && input.data[0] == RoomHeader::kMagic;
+}
 
-    void Seek(size_t offset)
+size_t WriteRoomHeader(uint32_t room, Span<uint8_t> output)
+{
+    if (output.size < kRoomHeaderSize)
     {
-        assert(offset < mSize);
-        mOffset = offset;
+        return 0;
     }
 
-    void Skip(size_t count)
+    output.data[0] = RoomHeader::kMagic;
+    MemoryWriter(output.data, kRoomHeaderSize).Put32_BE(1, room);
+    return kRoomHeaderSize;
+}
+
+bool ReadRoomHeader(Span<const uint8_t> input, uint32_t& room)
+{
+    if (!IsRoomAddressed(input))
     {
-        Seek(mOffset + count);
+        return false;
     }
 
-    size_t Size() const { return mSize; }
+    room = MemoryReader(input.data, kRoomHeaderSize).Read32_BE(1);
+    return true;
+}
 
-    Span<const uint8_t> GetSpan() const
-    {
-        return { mData + mOffset, Remaining() };
-    }
+size_t EncodeCompactMessage(
+    Span<const uint8_t> input,
+    uint8_t flags,
+    uint16_t ack,
+    uint32_t ackBits,
+    Span<uint8_t> output)
+{
+    MessageHeader header;
 
-public:
-    void Put(
-        const void* data,
-        size_t size)
+    if (input.size < kMessageSize
+        || !DeserializeHeader(input.Subspan(0, kMessageHeaderSize), header)
+        || (header.flags & MessageHeader::kFlagCompressed)
+        || header.payloadSize > input.size)
     {
-        Put(mOffset, data, size);
+        return 0;
     }
-    void Put(
-        size_t offset,
-        const void* data,
-        size_t size)
-    {
-        if (offset + size <= mSize)
-        {
-            Seek(offset);
 
-            memcpy(mData + mOffset, data, size);
-            mOffset += size;
-        }
-    }
+    const size_t payloadSize = input.size - kMessageSize;
 
-    void Put16_BE(uint16_t value)
+    if (output.size < kCompactHeaderSize + payloadSize)
     {
-        Put16_BE(mOffset, value);
+        return 0;
     }
-    void Put16_BE(size_t offset, uint16_t value)
-    {
-        uint8_t values[2] = {
-            uint8_t(value >> 8),
-            uint8_t(value)
-        };
 
-        Put(offset, values, sizeof(values));
-    }
+    // Read what the compact header keeps before the payload moves, the
+    // output may overlap the input
+    MemoryReader reader(input.data + kMessageHeaderSize, kMessageSize - kMessageHeaderSize);
+    const uint32_t action = reader.Read32_BE();
+    const uint32_t messageId = reader.Read32_BE();
 
-    void Put32_BE(uint32_t value)
+    if (action > UINT8_MAX)
     {
-        Put32_BE(mOffset, value);
+        return 0;
     }
-    void Put32_BE(size_t offset, uint32_t value)
+
+    memmove(output.data + kCompactHeaderSize, input.data + kMessageSize, payloadSize);
+
+    MemoryWriter writer(output.data, kCompactHeaderSize);
     {
-        uint8_t values[4] = {
-            uint8_t(value >> 24),
-            uint8_t(value >> 16),
-            uint8_t(value >> 8),
-            uint8_t(value)
+        const uint8_t fields[] = {
+            CompactHeader::kMagic,
+            uint8_t(flags & CompactHeader::kFlagAck),
+            uint8_t(action)
         };
-
-        Put(offset, values, sizeof(values));
+        writer.Put(fields, sizeof(fields));
     }
+    writer.Put16_BE(uint16_t(messageId));
+    writer.Put16_BE(ack);
+    writer.Put32_BE(ackBits);
+
+    const size_t size = kCompactHeaderSize + payloadSize;
+    writer.Put32_BE(CompactChecksum({ output.data, size }, false));
+
+    return size;
+}
 
-    void Put64_BE(uint64_t value)
+size_t DecodeCompactMessage(
+    Span<const uint8_t> input,
+    Span<uint8_t> output,
+    CompactHeader& header)
+{
+    if (!IsCompact(input))
     {
-        Put64_BE(mOffset, value);
+        return 0;
     }
-    void Put64_BE(size_t offset, uint64_t value)
-    {
-        uint8_t values[8] = {
-            uint8_t(value >> 56),
-            uint8_t(value >> 48),
-            uint8_t(value >> 40),
-            uint8_t(value >> 32),
-            uint8_t(value >> 24),
-            uint8_t(value >> 16),
-            uint8_t(value >> 8),
-            uint8_t(value)
-        };
 
-        Put(offset, values, sizeof(values));
-    }
+    MemoryReader reader(input.data, kCompactHeaderSize);
+
+    header.magic = reader.Read();
+    header.flags = reader.Read();
+    header.action = reader.Read();
+    header.sequence = reader.Read16_BE();
+    header.ack = reader.Read16_BE();
+    header.ackBits = reader.Read32_BE();
+    header.checksum = reader.Read32_BE();
+
+    const size_t payloadSize = input.size - kCompactHeaderSize;
+
+    constexpr uint8_t kKnownFlags =
+        CompactHeader::kFlagAck | CompactHeader::kFlagPayloadFirst;
 
-    void PutZero(size_t count)
+    if ((header.flags & ~kKnownFlags) != 0
+        || header.checksum != CompactChecksum(
+            input,
+            (header.flags & CompactHeader::kFlagPayloadFirst) != 0)
+        || output.size < kMessageSize + payloadSize)
     {
-        PutZero(mOffset, count);
+        return 0;
     }
-    void PutZero(size_t offset, size_t count)
-    {
-        if (offset + count <= mSize)
-        {
-            Seek(offset);
 
-            memset(mData + mOffset, 0, count);
-            mOffset += count;
-        }
-    }
+    memcpy(output.data + kMessageSize, input.data + kCompactHeaderSize, payloadSize);
 
-private:
-    uint8_t* mData{ nullptr };
-    size_t mSize{ 0 };
-    size_t mOffset{ 0 };
-};
+    MemoryWriter writer(output.data + kMessageHeaderSize, kMessageSize - kMessageHeaderSize);
+    writer.Put32_BE(header.action);
+    writer.Put32_BE(header.sequence);
 
-bool DeserializeHeader(
-    Span<const uint8_t> data,
-    MessageHeader& header)
+    // Sign it as the version 1 sender would have
+    MessageHeader v1 = { { 0, 0 }, 0, 0, 0 };
+    Span<const uint8_t> data{
+        output.data + kMessageHeaderSize,
+        kMessageSize - kMessageHeaderSize + payloadSize
+    };
+    SerializeHeader(v1, output.Subspan(0, kMessageHeaderSize), data);
+
+    return kMessageSize + payloadSize;
+}
+
+bool BroadcastMessage::Prepare(Span<const uint8_t> message)
 {
-    assert(data.size >= kMessageHeaderSize);
-    MemoryReader reader(data.data, data.size);
+    MessageHeader header;
 
-    // Read the two magic bytes
-    header.magic[0] = reader.Read();
-    header.magic[1] = reader.Read();
-    // Read the hash value
-    header.hash = reader.Read64_BE();
-    // Read the payload size
-    header.payloadSize = reader.Read32_BE();
+    mPrepared = message.size >= kMessageSize
+        && DeserializeHeader(message.Subspan(0, kMessageHeaderSize), header)
+        && !(header.flags & MessageHeader::kFlagCompressed)
+        && header.payloadSize <= message.size;
 
-    assert(reader.Remaining() == 0);
+    if (!mPrepared)
+    {
+        return false;
+    }
 
-    return header.magic[0] == MessageHeader::kMagicBytes[0]
-        && header.magic[1] == MessageHeader::kMagicBytes[1]
-        && header.hash > 0
-        && header.payloadSize > 0;
+    mAction = MemoryReader(message.data + kMessageHeaderSize, kMessageFieldsSize).Read32_BE();
+    mPayload = { message.data + kMessageSize, message.size - kMessageSize };
+    mPayloadHash = Fnv1a64(kFnv1a64Seed, mPayload.data, mPayload.size);
+    mCompactHash = Fnv1a32(kFnv1a32Seed, mPayload.data, mPayload.size);
+
+    return true;
 }
 
-void SerializeHeader(
-    MessageHeader& header,
-    Span<uint8_t> buffer,
-    Span<const uint8_t> data)
+size_t BroadcastMessage::Write(uint32_t messageId, Span<uint8_t> output) const
 {
-    assert(buffer.size >= kMessageHeaderSize);
-    MemoryWriter writer(buffer.data, kMessageHeaderSize);
+    const size_t size = GetSize();
 
-    // Set the magic bytes (byte-0 and byte-1)
-    header.magic[0] = MessageHeader::kMagicBytes[0];
-    header.magic[1] = MessageHeader::kMagicBytes[1];
+    if (!mPrepared || output.size < size)
     {
-        writer.Put(header.magic, sizeof(header.magic));
+        return 0;
     }
-    // Set the message FNV1A-64 hash
-    header.hash = FNV1A_64(data.data, data.size);
+
+    uint8_t fields[kMessageFieldsSize];
     {
-        writer.Put64_BE(header.hash);
+        MemoryWriter writer(fields, sizeof(fields));
+        writer.Put32_BE(mAction);
+        writer.Put32_BE(messageId);
     }
-    // set the payload size
-    header.payloadSize = data.size;
+
+    MemoryWriter writer(output.data, kMessageSize);
     {
-        writer.Put32_BE(header.payloadSize);
+        const uint8_t start[] = {
+            MessageHeader::kMagicBytes[0],
+            MessageHeader::kMagicBytes[1],
+            MessageHeader::kFlagPayloadFirst
+        };
+        writer.Put(start, sizeof(start));
     }
+    writer.Put64_BE(Fnv1a64(mPayloadHash, fields, sizeof(fields)));
+    writer.Put32_BE(uint32_t(kMessageFieldsSize + mPayload.size));
+    writer.Put(fields, sizeof(fields));
+
+    memcpy(output.data + kMessageSize, mPayload.data, mPayload.size);
+
+    return size;
 }
+
+size_t BroadcastMessage::WriteCompact(
+    uint32_t messageId,
+    uint8_t flags,
+    uint16_t ack,
+    uint32_t ackBits,
+    Span<uint8_t> output) const
+{
+    const size_t size = GetCompactSize();
+
+    if (!mPrepared || mAction > UINT8_MAX || output.size < size)
+    {
+        return 0;
+    }
+
+    MemoryWriter writer(output.data, kCompactHeaderSize);
+    {
+        const uint8_t fields[] = {
+            CompactHeader::kMagic,
+            uint8_t((flags & CompactHeader::kFlagAck) | CompactHeader::kFlagPayloadFirst),
+            uint8_t(mAction)
+        };
+        writer.Put(fields, sizeof(fields));
+    }
+    writer.Put16_BE(uint16_t(messageId));
+    writer.Put16_BE(ack);
+    writer.Put32_BE(ackBits);
+    writer.Put32_BE(Fnv1a32(mCompactHash, output.data, kCompactChecksumOffset));
+
+    memcpy(output.data + kCompactHeaderSize, mPayload.data, mPayload.size);
+
+    return size;
+}
+
 template<>
 static std::optional<Message> Serializer<Message>::Deserialize(
     Span<const uint8_t> input)
@@ -376,7 +495,12 @@ static std::optional<Message> Serializer<Message>::Deserialize(
     {
         return std::nullopt;
     }
-    if (header.payloadSize > kNetworkBufferSize
+    if (header.flags & MessageHeader::kFlagCompressed)
+    {
+        // Must be expanded with DecompressMessage() first
+        return std::nullopt;
+    }
+    if (header.payloadSize > kMaxMessageSize
         || header.payloadSize > input.size)
     {
         return std::nullopt;
@@ -489,7 +613,7 @@ static size_t Serializer<LoginMessage>::Serialize(
     Message& message = login.message;
     Span<uint8_t> messageData = output.Subspan(0, kMessageSize);
     size_t messageSize = Serializer<Message>::Serialize(message, messageData);
-    size_t payloadSize = messageSize + writer.Offset();
+    size_t payloadSize = messageSize - kMessageHeaderSize + writer.Offset();
 
     // Lastly we writte the hashed and final header value
     Span<uint8_t> headerData = messageData.Subspan(0, kMessageHeaderSize);
@@ -528,7 +652,7 @@ Serializer<PingMessage>::Deserialize(
     Span<const uint8_t> data = input.Subspan(kMessageSize);
     MemoryReader reader(data.data, data.size);
 
-    if (reader.Size() < kPingMessageSize - kMessageSize)
+    if (reader.Size() < kPingMessagePayload - kMessageTimesSize)
     {
         return {};
     }
@@ -536,6 +660,13 @@ Serializer<PingMessage>::Deserialize(
     ping.playerId = reader.Read32_BE();
     ping.messageId = reader.Read64_BE();
 
+    if (reader.Remaining() >= kMessageTimesSize)
+    {
+        ping.times.sendTime = reader.Read32_BE();
+        ping.times.echoTime = reader.Read32_BE();
+        ping.times.echoDelay = reader.Read32_BE();
+    }
+
     return ping;
 }
 
@@ -558,12 +689,15 @@ static size_t Serializer<PingMessage>::Serialize(
     // Write the entries for the ping message
     writer.Put32_BE(ping.playerId);
     writer.Put64_BE(ping.messageId);
+    writer.Put32_BE(ping.times.sendTime);
+    writer.Put32_BE(ping.times.echoTime);
+    writer.Put32_BE(ping.times.echoDelay);
 
     // Now we serialize the entries for the Message member
     Span<uint8_t> messageData = output.Subspan(0, kMessageSize);
     Message& message = ping.message;
     size_t messageSize = Serializer<Message>::Serialize(message, messageData);
-    size_t payloadSize = messageSize + writer.Offset();
+    size_t payloadSize = messageSize - kMessageHeaderSize + writer.Offset();
 
     assert(messageSize == kMessageSize);
 
@@ -603,13 +737,20 @@ Serializer<AcknowledgeMessage>::Deserialize(
     Span<const uint8_t> data = input.Subspan(kMessageSize);
     MemoryReader reader(data.data, data.size);
 
-    if (reader.Size() < kAckMessageSize - kMessageSize)
+    if (reader.Size() < kAckMessagePayload - kMessageTimesSize)
     {
         return {};
     }
 
     ack.messageId = reader.Read64_BE();
 
+    if (reader.Remaining() >= kMessageTimesSize)
+    {
+        ack.times.sendTime = reader.Read32_BE();
+        ack.times.echoTime = reader.Read32_BE();
+        ack.times.echoDelay = reader.Read32_BE();
+    }
+
     return ack;
 }
 
@@ -631,12 +772,15 @@ static size_t Serializer<AcknowledgeMessage>::Serialize(
 
     // Write the entries for the login message
     writer.Put64_BE(ack.messageId);
+    writer.Put32_BE(ack.times.sendTime);
+    writer.Put32_BE(ack.times.echoTime);
+    writer.Put32_BE(ack.times.echoDelay);
 
     // Now we serialize the entries for the Message member
     Span<uint8_t> messageData = output.Subspan(0, kMessageSize);
     Message& message = ack.message;
     size_t messageSize = Serializer<Message>::Serialize(message, messageData);
-    size_t payloadSize = messageSize + writer.Offset();
+    size_t payloadSize = messageSize - kMessageHeaderSize + writer.Offset();
 
     assert(messageSize == kMessageSize);
 
@@ -653,4 +797,222 @@ static size_t Serializer<AcknowledgeMessage>::Serialize(
 }
 
 template class Serializer<AcknowledgeMessage>;
+
+std::optional<StateMessage> Serializer<StateMessage>::Deserialize(
+    Span<const uint8_t> input,
+    const PositionCodec& codec)
+{
+    std::optional<Message> result = Serializer<Message>::Deserialize(input);
+
+    if (!result || result->action != Action::State)
+    {
+        return std::nullopt;
+    }
+
+    StateMessage state;
+    {
+        state.message = std::move(*result);
+    }
+
+    Span<const uint8_t> data = input.Subspan(kMessageSize);
+    MemoryReader reader(data.data, data.size);
+
+    if (reader.Size() < kStateMessageSize - kMessageSize)
+    {
+        return {};
+    }
+
+    state.tick = reader.Read32_BE();
+    state.inputOffset = int16_t(reader.Read16_BE());
+    state.count = reader.Read16_BE();
+    state.removedCount = reader.Read16_BE();
+
+    if (state.count > StateMessage::kMaxEntries
+        || state.removedCount > StateMessage::kMaxRemoved
+        || reader.Remaining()
+            < (state.count * GetStateEntryBits(codec) + state.removedCount * 32 + 7) / 8)
+    {
+        return {};
+    }
+
+    // The entries are bit packed after the fixed fields
+    BitReader bits(data.Subspan(kStateMessageSize - kMessageSize));
+
+    for (uint16_t i = 0; i < state.count; ++i)
+    {
+        StateMessage::Entry& entry = state.entries[i];
+        Position pos;
+
+        entry.playerId = bits.Read(32);
+
+        if (!codec.Decode(bits, pos))
+        {
+            return {};
+        }
+
+        entry.x = pos.x;
+        entry.y = pos.y;
+    }
+
+    for (uint16_t i = 0; i < state.removedCount; ++i)
+    {
+        state.removed[i] = bits.Read(32);
+    }
+
+    return state;
+}
+
+size_t Serializer<StateMessage>::Serialize(
+    StateMessage& state,
+    const PositionCodec& codec,
+    Span<uint8_t> output)
+{
+    assert(state.count <= StateMessage::kMaxEntries);
+    assert(state.removedCount <= StateMessage::kMaxRemoved);
+
+    if (output.size < GetStateMessageBytes(state.count, codec) + state.removedCount * 4u)
+    {
+        return 0;
+    }
+
+    // Pointer to and counter for the amount of data we can store
+    // in the buffer and still have enough room for the message
+    // header.
+    Span<uint8_t> payloadData = output.Subspan(kMessageSize);
+    MemoryWriter writer(payloadData.data, payloadData.size);
+
+    // Write the entries for the state message
+    writer.Put32_BE(state.tick);
+    writer.Put16_BE(uint16_t(state.inputOffset));
+    writer.Put16_BE(state.count);
+    writer.Put16_BE(state.removedCount);
+
+    BitWriter bits(payloadData.Subspan(writer.Offset()));
+
+    for (uint16_t i = 0; i < state.count; ++i)
+    {
+        const StateMessage::Entry& entry = state.entries[i];
+
+        if (!bits.Put(entry.playerId, 32)
+            || !codec.Encode(bits, Position(entry.x, entry.y)))
+        {
+            return 0;
+        }
+    }
+
+    for (uint16_t i = 0; i < state.removedCount; ++i)
+    {
+        if (!bits.Put(state.removed[i], 32))
+        {
+            return 0;
+        }
+    }
+
+    const size_t payloadWritten = writer.Offset() + bits.Size();
+
+    // Now we serialize the entries for the Message member
+    Span<uint8_t> messageData = output.Subspan(0, kMessageSize);
+    Message& message = state.message;
+    size_t messageSize = Serializer<Message>::Serialize(message, messageData);
+    size_t payloadSize = messageSize - kMessageHeaderSize + payloadWritten;
+
+    assert(messageSize == kMessageSize);
+
+    // Lastly we writte the hashed and final header value
+    Span<uint8_t> headerData = output.Subspan(0, kMessageHeaderSize);
+    Span<const uint8_t> payload{
+        output.data + kMessageHeaderSize,
+        payloadSize
+    };
+    SerializeHeader(message.header, headerData, payload);
+
+    // We return the number of bytes written to the buffer
+    return kMessageSize + payloadWritten;
+}
+
+template<>
+static std::optional<MoveMessage>
+Serializer<MoveMessage>::Deserialize(
+    Span<const uint8_t> input)
+{
+    std::optional<Message> result = Serializer<Message>::Deserialize(input);
+
+    if (!result || result->action != Action::Move)
+    {
+        return std::nullopt;
+    }
+
+    MoveMessage move;
+    {
+        move.message = std::move(*result);
+    }
+
+    Span<const uint8_t> data = input.Subspan(kMessageSize);
+    MemoryReader reader(data.data, data.size);
+
+    if (reader.Size() < kMoveMessagePayload)
+    {
+        return {};
+    }
+
+    move.playerId = reader.Read32_BE();
+    move.tick = reader.Read32_BE();
+
+    const uint8_t movement = reader.Read();
+
+    if (movement > uint8_t(Movement::Down))
+    {
+        return {};
+    }
+
+    move.movement = Movement(movement);
+
+    return move;
+}
+
+template<>
+static size_t Serializer<MoveMessage>::Serialize(
+    MoveMessage& move,
+    Span<uint8_t> output)
+{
+    if (output.size < kMoveMessageSize)
+    {
+        return 0;
+    }
+
+    // Pointer to and counter for the amount of data we can store
+    // in the buffer and still have enough room for the message
+    // header.
+    Span<uint8_t> payloadData = output.Subspan(kMessageSize);
+    MemoryWriter writer(payloadData.data, payloadData.size);
+
+    // Write the entries for the move message
+    writer.Put32_BE(move.playerId);
+    writer.Put32_BE(move.tick);
+    {
+        const uint8_t movement = uint8_t(move.movement);
+        writer.Put(&movement, sizeof(movement));
+    }
+
+    // Now we serialize the entries for the Message member
+    Span<uint8_t> messageData = output.Subspan(0, kMessageSize);
+    Message& message = move.message;
+    size_t messageSize = Serializer<Message>::Serialize(message, messageData);
+    size_t payloadSize = messageSize - kMessageHeaderSize + writer.Offset();
+
+    assert(messageSize == kMessageSize);
+
+    // Lastly we writte the hashed and final header value
+    Span<uint8_t> headerData = output.Subspan(0, kMessageHeaderSize);
+    Span<const uint8_t> payload{
+        output.data + kMessageHeaderSize,
+        payloadSize
+    };
+    SerializeHeader(message.header, headerData, payload);
+
+    // We return the number of bytes written to the buffer
+    return kMessageSize + writer.Offset();
+}
+
+template class Serializer<MoveMessage>;
 }
@@ -2,6 +2,7 @@
 
 #include "Common.h"
 #include "Network.h"
+#include "PositionCodec.h"
 
 #include <optional>
 
@@ -14,6 +15,8 @@ namespace Common
         Acknowledge,
         Login,
         Ping,
+        State,
+        Move,
     };
 
     // Define a message header which should encapsulate the payload
@@ -24,7 +27,15 @@ namespace Common
     {
         static constexpr uint8_t kMagicBytes[2] = { 0xBE, 0xEF };
 
+        // The payload following the header is LZ compressed
+        static constexpr uint8_t kFlagCompressed = 0x01;
+        // The hash covers the payload first and the action and message id
+        // last, as BroadcastMessage writes it. Without it the body is
+        // hashed in order, which every older peer expects.
+        static constexpr uint8_t kFlagPayloadFirst = 0x02;
+
         uint8_t magic[2];
+        uint8_t flags;
         uint64_t hash;
         uint32_t payloadSize;
     };
@@ -32,15 +43,39 @@ namespace Common
 
     constexpr size_t kMessageHeaderSize = sizeof(MessageHeader);
 
+    // Largest message accepted once a compressed payload is expanded. This
+    // is larger than a NetworkBuffer since compression is what lets these
+    // messages fit in a single datagram.
+    constexpr size_t kMaxMessageSize = 16 * kNetworkBufferSize;
+
     bool DeserializeHeader(
         Span<const uint8_t> data,
         MessageHeader& header);
 
+    // Sign data with the header. The data is hashed in order unless the
+    // header has kFlagPayloadFirst set.
     void SerializeHeader(
         MessageHeader& header,
         Span<uint8_t> buffer,
         Span<const uint8_t> data);
 
+    // FNV-1a 64-bit hash used to sign message payloads
+    uint64_t FNV1A_64(const void* data, size_t size);
+
+    // Returns true if the serialized message has a compressed payload.
+    // Compressed messages must be expanded with DecompressMessage() before
+    // they can be handed to a Serializer.
+    bool IsCompressed(Span<const uint8_t> input);
+
+    // Compress the payload of a serialized message into output. Returns
+    // the size of the compressed message or 0 if compressing would not
+    // save any bytes, in which case the original message should be sent.
+    size_t CompressMessage(Span<const uint8_t> input, Span<uint8_t> output);
+
+    // Expand a compressed message into output. Returns the size of the
+    // uncompressed message or 0 if the message could not be expanded.
+    size_t DecompressMessage(Span<const uint8_t> input, Span<uint8_t> output);
+
     // Basic Message type that all other messages inherit from.
     // This contains the basic values for the header, action type,
     // and the data span which has been validated to match the message
@@ -48,7 +83,7 @@ namespace Common
 #pragma pack(push, 1)
     struct Message
     {
-        MessageHeader header = { { 0, 0 }, 0, 0 };
+        MessageHeader header = { { 0, 0 }, 0, 0, 0 };
         Action action{ Action::None }; // uint32_t
         uint32_t messageId = 0;
         // Span<const uint8_t> data;
@@ -60,6 +95,134 @@ namespace Common
 
     constexpr size_t kMessageSize = sizeof(Message); // kMessageHeaderSize + 8;
 
+    // Version 2 header, sent in place of the MessageHeader and the action
+    // and id of the Message. The sequence is the low 16 bits of the message
+    // id and every packet acknowledges the newest sequence received from
+    // the other side along with the 32 before it, bit n of ackBits
+    // standing for ack - 1 - n. The payload runs to the end of the
+    // datagram and is covered by the checksum with the rest of the header.
+#pragma pack(push, 1)
+    struct CompactHeader
+    {
+        // Never the first byte of a version 1 header
+        static constexpr uint8_t kMagic = 0xB2;
+
+        // ack and ackBits are set, clear until something was received
+        static constexpr uint8_t kFlagAck = 0x01;
+        // The checksum covers the payload before the header, as
+        // BroadcastMessage writes it. Without it the header comes first,
+        // which every older peer expects.
+        static constexpr uint8_t kFlagPayloadFirst = 0x02;
+
+        uint8_t magic{ kMagic };
+        uint8_t flags{ 0 };
+        uint8_t action{ 0 };
+        uint16_t sequence{ 0 };
+        uint16_t ack{ 0 };
+        uint32_t ackBits{ 0 };
+        uint32_t checksum{ 0 };
+    };
+#pragma pack(pop)
+
+    constexpr size_t kCompactHeaderSize = sizeof(CompactHeader);
+
+    // FNV-1a 32-bit hash used to sign compact messages
+    uint32_t FNV1A_32(const void* data, size_t size);
+
+    // Returns true if the datagram starts with a compact header
+    bool IsCompact(Span<const uint8_t> input);
+
+    // Rewrite a serialized version 1 message with the compact header,
+    // carrying the given acknowledgements. output may be the input buffer.
+    // Returns the size of the compact message or 0 if the message can not
+    // be sent compact, as is the case for compressed messages, in which
+    // case the original message should be sent.
+    size_t EncodeCompactMessage(
+        Span<const uint8_t> input,
+        uint8_t flags,
+        uint16_t ack,
+        uint32_t ackBits,
+        Span<uint8_t> output);
+
+    // Expand a compact message into the version 1 message a Serializer
+    // reads, with the sequence as its message id. Returns the size of the
+    // expanded message or 0 if the datagram is not a valid compact message.
+    size_t DecodeCompactMessage(
+        Span<const uint8_t> input,
+        Span<uint8_t> output,
+        CompactHeader& header);
+
+    // A serialized message going out to many recipients. The payload is
+    // hashed once when the message is prepared. Each copy only writes the
+    // header fields of its recipient and folds them into that hash, which
+    // works because the copies are signed with kFlagPayloadFirst. A copy
+    // reads back as the message Serialize() and EncodeCompactMessage()
+    // would have written, only its hash differs. Peers built before the
+    // flag existed drop the copies. The prepared message must outlive the
+    // copies being written.
+    class BroadcastMessage final
+    {
+    public:
+        // Take a message written by a Serializer. Returns false if it is
+        // not one, as is the case for a compressed message.
+        bool Prepare(Span<const uint8_t> message);
+
+        bool IsPrepared() const { return mPrepared; }
+
+        // Size of a version 1 copy, and of a compact one
+        size_t GetSize() const { return kMessageSize + mPayload.size; }
+        size_t GetCompactSize() const { return kCompactHeaderSize + mPayload.size; }
+
+        // Write the version 1 copy for one recipient. Returns its size or 0
+        // if output is too small.
+        size_t Write(uint32_t messageId, Span<uint8_t> output) const;
+
+        // Write the compact copy for one recipient, carrying its
+        // acknowledgements. Returns its size or 0 if output is too small or
+        // the action does not fit a compact header.
+        size_t WriteCompact(
+            uint32_t messageId,
+            uint8_t flags,
+            uint16_t ack,
+            uint32_t ackBits,
+            Span<uint8_t> output) const;
+
+    private:
+        bool mPrepared{ false };
+        uint32_t mAction{ 0 };
+        Span<const uint8_t> mPayload;
+        // FNV-1a state after the payload, for each header
+        uint64_t mPayloadHash{ 0 };
+        uint32_t mCompactHash{ 0 };
+    };
+
+    // Prefix naming the room a datagram is for, when the server hosts
+    // several. Comes before any other header and is taken off before the
+    // room sees the datagram.
+#pragma pack(push, 1)
+    struct RoomHeader
+    {
+        // Never the first byte of any other header
+        static constexpr uint8_t kMagic = 0xB4;
+
+        uint8_t magic{ kMagic };
+        uint32_t room{ 0 };
+    };
+#pragma pack(pop)
+
+    constexpr size_t kRoomHeaderSize = sizeof(RoomHeader);
+
+    // Returns true if the datagram starts with a room header
+    bool IsRoomAddressed(Span<const uint8_t> input);
+
+    // Write a room header to the start of output. Returns its size or 0 if
+    // output is too small.
+    size_t WriteRoomHeader(uint32_t room, Span<uint8_t> output);
+
+    // Read the room a datagram is for. Returns false if it has no room
+    // header.
+    bool ReadRoomHeader(Span<const uint8_t> input, uint32_t& room);
+
     // Defines a Login message which is the basic message to initiate a
     // game session. This is like a new player joining the game.
 #pragma pack(push, 1)
@@ -79,8 +242,27 @@ namespace Common
     constexpr size_t kLoginMessageSize = sizeof(LoginMessage);  // kMessageSize + 10;
     constexpr size_t kLoginMessagePayload = kLoginMessageSize - kMessageSize;
 
+    // Timestamps of the keepalive exchange, in microseconds of the
+    // sender's clock. Each side echoes the newest sendTime it received
+    // along with how long it held it, so both ends can time the round
+    // trip and the client can work out the server's clock.
+#pragma pack(push, 1)
+    struct MessageTimes
+    {
+        // Nothing to echo yet
+        static constexpr uint32_t kNoEcho{ uint32_t(~0) };
+
+        uint32_t sendTime{ 0 };
+        uint32_t echoTime{ 0 };
+        uint32_t echoDelay{ kNoEcho };
+    };
+#pragma pack(pop)
+
+    constexpr size_t kMessageTimesSize = sizeof(MessageTimes);
+
     // Defines a Ping messsage. The value of the ping is the last
-    // acknowledged mesage ID from the other side.
+    // acknowledged mesage ID from the other side. Peers older than the
+    // timestamps send it without them.
 #pragma pack(push, 1)
     struct PingMessage
     {
@@ -89,29 +271,114 @@ namespace Common
         Message message;
         uint32_t playerId{ kInvalidPlayer };
         uint64_t messageId{ 0 };
+        MessageTimes times;
 
         PingMessage() : message(Action::Ping) { }
     };
 #pragma pack(pop)
 
-    constexpr size_t kPingMessageSize = sizeof(PingMessage);  // kMessageSize + 12;
+    constexpr size_t kPingMessageSize = sizeof(PingMessage);  // kMessageSize + 24;
     constexpr size_t kPingMessagePayload = kPingMessageSize - kMessageSize;
 
     // Defines a Pong/Acknowledge messsage. The value of the messageId is the last
-    // mesage ID from the other side.
+    // mesage ID from the other side. Sent back for every ping, echoing its
+    // timestamp.
 #pragma pack(push, 1)
     struct AcknowledgeMessage
     {
         Message message;
         uint64_t messageId{ 0 };
+        MessageTimes times;
 
         AcknowledgeMessage() : message(Action::Acknowledge) { }
     };
 #pragma pack(pop)
 
-    constexpr size_t kAckMessageSize = sizeof(AcknowledgeMessage);  // kMessageSize + 8;
+    constexpr size_t kAckMessageSize = sizeof(AcknowledgeMessage);  // kMessageSize + 20;
     constexpr size_t kAckMessagePayload = kAckMessageSize - kMessageSize;
 
+    // Defines a State message carrying the positions of players the
+    // receiver can see. Visible sets larger than kMaxEntries are split
+    // across several messages. On the wire each entry is its 32 bit player
+    // id followed by its position packed with the session's PositionCodec,
+    // the entries running on from one another bit by bit. The ids of the
+    // removed players follow the entries, 32 bits each.
+#pragma pack(push, 1)
+    struct StateMessage
+    {
+        static constexpr uint16_t kMaxEntries = 32;
+        static constexpr uint16_t kMaxRemoved = 32;
+
+        struct Entry
+        {
+            uint32_t playerId{ 0 };
+            uint32_t x{ 0 };
+            uint32_t y{ 0 };
+        };
+
+        Message message;
+        // Next tick the server will run. The positions are the result of
+        // every tick before it.
+        uint32_t tick{ 0 };
+        // Ticks earlier than needed the receiver's inputs are arriving.
+        // Negative when they arrive too late and should be sent earlier.
+        int16_t inputOffset{ 0 };
+        uint16_t count{ 0 };
+        // Players the receiver should forget as of tick, they left its
+        // view or the game
+        uint16_t removedCount{ 0 };
+        Entry entries[kMaxEntries];
+        uint32_t removed[kMaxRemoved]{};
+
+        StateMessage() : message(Action::State) { }
+    };
+#pragma pack(pop)
+
+    // Size of a State message holding no entries
+    constexpr size_t kStateMessageSize = kMessageSize + 10;
+
+    // Bits of one State entry on a board encoded with codec
+    inline size_t GetStateEntryBits(const PositionCodec& codec)
+    {
+        return 32 + codec.GetPositionBits();
+    }
+
+    // Number of bytes needed to send count entries as State messages which
+    // remove nobody
+    inline size_t GetStateMessageBytes(size_t count, const PositionCodec& codec)
+    {
+        const size_t bits = GetStateEntryBits(codec);
+        const size_t full = count / StateMessage::kMaxEntries;
+        const size_t rest = count % StateMessage::kMaxEntries;
+
+        size_t bytes = full * (kStateMessageSize + (StateMessage::kMaxEntries * bits + 7) / 8);
+
+        if (rest > 0 || full == 0)
+        {
+            bytes += kStateMessageSize + (rest * bits + 7) / 8;
+        }
+
+        return bytes;
+    }
+
+    // Defines a Move message, a single step of the sending player. The
+    // server holds it until the tick it is stamped for and applies it in a
+    // batch with every other move for that tick.
+#pragma pack(push, 1)
+    struct MoveMessage
+    {
+        Message message;
+        uint32_t playerId{ PingMessage::kInvalidPlayer };
+        uint32_t tick{ 0 };
+        Movement movement{ Movement::Left };  // uint8_t
+
+        MoveMessage() : message(Action::Move) { }
+    };
+#pragma pack(pop)
+
+    constexpr size_t kMoveMessageSize = sizeof(MoveMessage);  // kMessageSize + 9;
+    constexpr size_t kMoveMessagePayload = kMoveMessageSize - kMessageSize;
+
     // Parse a Message from the NetworkMessage. The data pointed to in the
     // Message object and any subsequent message types is owned by the
     // given NetworkMessage and that object must outlive the returned Message.
@@ -121,4 +388,19 @@ namespace Common
         static std::optional<T> Deserialize(Span<const uint8_t> input);
         static size_t Serialize(T& message, Span<uint8_t> output);
     };
+
+    // State entries are packed with the codec of the board both ends play
+    // on (see Game::GetPositionCodec()). Entries off that board are not
+    // sent and do not read back.
+    template<>
+    struct Serializer<StateMessage>
+    {
+        static std::optional<StateMessage> Deserialize(
+            Span<const uint8_t> input,
+            const PositionCodec& codec);
+        static size_t Serialize(
+            StateMessage& message,
+            const PositionCodec& codec,
+            Span<uint8_t> output);
+    };
 }
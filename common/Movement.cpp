@@ -0,0 +1,188 @@
+#include "Movement.h"
+
+#include <algorithm>
+
+namespace Common
+{
+bool StepPosition(
+    Position from,
+    Movement movement,
+    uint32_t width,
+    uint32_t height,
+    Position& to)
+{
+    to = from;
+
+    switch (movement)
+    {
+    case Movement::Left:
+        if (from.x == 0) { return false; }
+        to.x -= 1;
+        break;
+    case Movement::Right:
+        if (from.x + 1 >= width) { return false; }
+        to.x += 1;
+        break;
+    case Movement::Up:
+        if (from.y == 0) { return false; }
+        to.y -= 1;
+        break;
+    case Movement::Down:
+        if (from.y + 1 >= height) { return false; }
+        to.y += 1;
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+OccupancyBitboard::OccupancyBitboard(uint32_t width, uint32_t height)
+    : mWidth(width)
+    , mHeight(height)
+    , mStride((size_t(width) + 63) / 64)
+    , mWords(mStride * height, 0)
+{ }
+
+MovementSystem::MovementSystem(uint32_t width, uint32_t height)
+    : mWidth(width)
+    , mHeight(height)
+    , mOccupancy(width, height)
+{ }
+
+bool MovementSystem::Queue(uint32_t playerId, Position from, Movement movement)
+{
+    Position to;
+
+    if (!StepPosition(from, movement, mWidth, mHeight, to))
+    {
+        return false;
+    }
+
+    Request request;
+    request.move = Move{ playerId, from, to };
+    request.target = (uint64_t(to.y) << 32) | to.x;
+    request.sequence = mSequence++;
+
+    mQueue.push_back(request);
+    return true;
+}
+
+Span<const MovementSystem::Move> MovementSystem::Resolve()
+{
+    mAccepted.clear();
+
+    // Only the latest input from each player counts
+    std::sort(mQueue.begin(), mQueue.end(),
+        [](const Request& a, const Request& b)
+        {
+            return a.move.playerId != b.move.playerId
+                ? a.move.playerId < b.move.playerId
+                : a.sequence > b.sequence;
+        });
+
+    mQueue.erase(
+        std::unique(mQueue.begin(), mQueue.end(),
+            [](const Request& a, const Request& b)
+            {
+                return a.move.playerId == b.move.playerId;
+            }),
+        mQueue.end());
+
+    mStats.requested += mQueue.size();
+
+    // Group moves for the same cell together, lowest player id first
+    std::sort(mQueue.begin(), mQueue.end(),
+        [](const Request& a, const Request& b)
+        {
+            return a.target != b.target
+                ? a.target < b.target
+                : a.move.playerId < b.move.playerId;
+        });
+
+    for (uint32_t round = 0; round < kMaxRounds; ++round)
+    {
+        bool progress = false;
+
+        // Row word holding the targets being looked at, loaded once for
+        // every target in it as the queue is sorted by row then column
+        uint64_t wordKey = UINT64_MAX;
+        uint64_t word = 0;
+
+        for (size_t i = 0; i < mQueue.size();)
+        {
+            size_t end = i + 1;
+            while (end < mQueue.size() && mQueue[end].target == mQueue[i].target)
+            {
+                ++end;
+            }
+
+            // The first pending request in the group is the lowest id
+            size_t first = i;
+            while (first < end && mQueue[first].done)
+            {
+                ++first;
+            }
+
+            if (first < end)
+            {
+                const Move& move = mQueue[first].move;
+                const uint64_t key = mQueue[first].target >> 6;
+
+                if (key != wordKey)
+                {
+                    wordKey = key;
+                    word = mOccupancy.GetRow(move.to.x & ~63u, move.to.y);
+                }
+
+                const uint64_t bit = uint64_t(1) << (move.to.x & 63);
+
+                if (!(word & bit))
+                {
+                    mOccupancy.Clear(move.from.x, move.from.y);
+                    mOccupancy.Set(move.to.x, move.to.y);
+                    mAccepted.push_back(move);
+                    mStats.accepted += 1;
+
+                    // Keep the loaded word in step, a sideways move also
+                    // frees a cell in it
+                    word |= bit;
+                    if (move.from.y == move.to.y && (move.from.x >> 6) == (move.to.x >> 6))
+                    {
+                        word &= ~(uint64_t(1) << (move.from.x & 63));
+                    }
+
+                    for (size_t j = first; j < end; ++j)
+                    {
+                        if (!mQueue[j].done && j != first)
+                        {
+                            mStats.conflicts += 1;
+                        }
+                        mQueue[j].done = true;
+                    }
+
+                    progress = true;
+                }
+            }
+
+            i = end;
+        }
+
+        if (!progress)
+        {
+            break;
+        }
+    }
+
+    for (const Request& request : mQueue)
+    {
+        mStats.blocked += !request.done;
+    }
+
+    mQueue.clear();
+    mSequence = 0;
+
+    return { mAccepted.data(), mAccepted.size() };
+}
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "Common.h"
+
+#include <vector>
+
+namespace Common
+{
+// Cell one step from from on a width by height board. Returns false if
+// the step would leave the board.
+bool StepPosition(
+    Position from,
+    Movement movement,
+    uint32_t width,
+    uint32_t height,
+    Position& to);
+
+// One bit per board cell, set when a player stands in it. The board is
+// stored row-major in 64 bit words, each row padded to a whole word, so a
+// cell test is one word load and mask. Storage is allocated up front for
+// the whole board: 128 KiB for 1024x1024. It mirrors the players held in
+// WorldGrid so MovementSystem reads rows of bits rather than the cells.
+class OccupancyBitboard final
+{
+public:
+    OccupancyBitboard(const OccupancyBitboard&) = delete;
+    OccupancyBitboard& operator=(const OccupancyBitboard&) = delete;
+
+public:
+    OccupancyBitboard(uint32_t width, uint32_t height);
+
+    bool Test(uint32_t x, uint32_t y) const
+    {
+        return (mWords[GetIndex(x, y)] >> (x & 63)) & 1;
+    }
+
+    void Set(uint32_t x, uint32_t y)
+    {
+        mWords[GetIndex(x, y)] |= uint64_t(1) << (x & 63);
+    }
+
+    void Clear(uint32_t x, uint32_t y)
+    {
+        mWords[GetIndex(x, y)] &= ~(uint64_t(1) << (x & 63));
+    }
+
+    // 64 cells of row y starting at x, which must be a multiple of 64.
+    // Bit n is cell x + n.
+    uint64_t GetRow(uint32_t x, uint32_t y) const
+    {
+        assert((x & 63) == 0);
+        return mWords[GetIndex(x, y)];
+    }
+
+    // Words in a row of the board
+    size_t GetStride() const { return mStride; }
+
+    size_t GetMemoryUsage() const { return mWords.size() * sizeof(uint64_t); }
+
+private:
+    size_t GetIndex(uint32_t x, uint32_t y) const
+    {
+        assert(x < mWidth && y < mHeight);
+        return size_t(y) * mStride + (x >> 6);
+    }
+
+private:
+    uint32_t mWidth{ 0 };
+    uint32_t mHeight{ 0 };
+    size_t mStride{ 0 };
+    std::vector<uint64_t> mWords;
+};
+
+// Applies the movement inputs of a tick as one batch.
+//
+// Inputs are queued as they arrive, keeping only the latest per player.
+// Resolve() then orders them by target cell and player id and accepts a
+// move when its target is free in the bitboard. Targets sharing a row
+// word are tested against one load of that word. When several players
+// want the same free cell the lowest player id gets it. Moves blocked by
+// a player who moves away later in the batch are retried for a few
+// rounds so lines of players can advance together. The result only
+// depends on the set of inputs, not on the order they arrived in.
+class MovementSystem final
+{
+public:
+    MovementSystem(const MovementSystem&) = delete;
+    MovementSystem& operator=(const MovementSystem&) = delete;
+
+public:
+    struct Move
+    {
+        uint32_t playerId{ 0 };
+        Position from;
+        Position to;
+    };
+
+    struct Stats
+    {
+        uint64_t requested{ 0 };
+        uint64_t accepted{ 0 };
+        // Lost a same-cell conflict to a lower player id
+        uint64_t conflicts{ 0 };
+        // Target cell stayed occupied
+        uint64_t blocked{ 0 };
+    };
+
+    // Number of passes over the remaining moves before giving up on them
+    static constexpr uint32_t kMaxRounds = 8;
+
+public:
+    MovementSystem(uint32_t width, uint32_t height);
+
+    OccupancyBitboard& GetOccupancy() { return mOccupancy; }
+    const OccupancyBitboard& GetOccupancy() const { return mOccupancy; }
+
+    // Queue a move of the player standing at from. Moves off the board
+    // are dropped. Returns false if the move was dropped.
+    bool Queue(uint32_t playerId, Position from, Movement movement);
+
+    size_t GetQueuedCount() const { return mQueue.size(); }
+
+    // Resolve every queued move against the bitboard, updating it, and
+    // clear the queue. Returns the accepted moves in the order they were
+    // applied, which is safe to replay against the board.
+    Span<const Move> Resolve();
+
+    const Stats& GetStats() const { return mStats; }
+
+private:
+    struct Request
+    {
+        Move move;
+        uint64_t target{ 0 };
+        uint32_t sequence{ 0 };
+        bool done{ false };
+    };
+
+private:
+    uint32_t mWidth{ 0 };
+    uint32_t mHeight{ 0 };
+    OccupancyBitboard mOccupancy;
+    std::vector<Request> mQueue;
+    std::vector<Move> mAccepted;
+    uint32_t mSequence{ 0 };
+    Stats mStats;
+};
+}
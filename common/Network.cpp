@@ -35,6 +35,11 @@ std::string AddressToString(const void* address)
     return str;
 }
 
+bool StringToAddress(const char* str, uint8_t address[4])
+{
+    return inet_pton(AF_INET, str, address) == 1;
+}
+
 bool CreateSocketPair(Socket& reader, Socket& writer)
 {
     Socket listener{ kInvalidSocket };
@@ -194,33 +199,36 @@ bool DrainSocket(Socket sock)
     return true;
 }
 
-bool SendMessage(
-    const char* address,
-    uint32_t port,
-    const NetworkBuffer& buffer)
+namespace
+{
+Socket CreateSendSocket()
 {
-    assert(buffer.Size() <= kNetworkBufferSize);
-    SockAddrStorage storage = { 0 };
-
-    auto* sockaddr = ToSockAddr(storage.data(), address, port);
-    int socklen = storage.size();
-
     Socket sock = WSASocketW(AF_INET, SOCK_DGRAM, IPPROTO_UDP, nullptr, 0, 0);
     if (sock == kInvalidSocket)
     {
         int err = WSAGetLastError();
         std::cout << "Failed to create client socket: [" << err
             << "] " << ErrorToString(err) << '\n';
-
-        return false;
     }
 
-    SCOPE_GUARD([&] { closesocket(sock); });
+    return sock;
+}
+
+bool SendTo(
+    Socket sock,
+    const char* address,
+    uint32_t port,
+    Span<const uint8_t> data)
+{
+    assert(data.size <= kNetworkBufferSize);
+    SockAddrStorage storage = { 0 };
+
+    auto* sockaddr = ToSockAddr(storage.data(), address, port);
+    int socklen = storage.size();
 
     WSABUF buf;
-    buf.buf = reinterpret_cast<char*>(
-        const_cast<uint8_t*>(buffer.Data()));
-    buf.len = static_cast<unsigned long>(buffer.Size());
+    buf.buf = reinterpret_cast<char*>(const_cast<uint8_t*>(data.data));
+    buf.len = static_cast<unsigned long>(data.size);
 
     DWORD bytesSent = 0;
     int result = WSASendTo(
@@ -243,6 +251,57 @@ bool SendMessage(
 
     return true;
 }
+}
+
+bool SendMessage(
+    const char* address,
+    uint32_t port,
+    const NetworkBuffer& buffer)
+{
+    Socket sock = CreateSendSocket();
+    if (sock == kInvalidSocket)
+    {
+        return false;
+    }
+
+    SCOPE_GUARD([&] { closesocket(sock); });
+
+    return SendTo(sock, address, port, { buffer.Data(), buffer.Size() });
+}
+
+bool SendMessage(
+    Socket sock,
+    const char* address,
+    uint32_t port,
+    const NetworkBuffer& buffer)
+{
+    return SendTo(sock, address, port, { buffer.Data(), buffer.Size() });
+}
+
+size_t SendMessages(Span<const Datagram> datagrams)
+{
+    if (datagrams.size == 0)
+    {
+        return 0;
+    }
+
+    Socket sock = CreateSendSocket();
+    if (sock == kInvalidSocket)
+    {
+        return 0;
+    }
+
+    SCOPE_GUARD([&] { closesocket(sock); });
+
+    size_t sent = 0;
+    for (size_t i = 0; i < datagrams.size; ++i)
+    {
+        const Datagram& datagram = datagrams.data[i];
+        sent += SendTo(sock, datagram.address, datagram.port, datagram.data);
+    }
+
+    return sent;
+}
 
 bool SetNonBlocking(Socket sock)
 {
@@ -36,6 +36,8 @@ constexpr Socket kInvalidSocket = Socket(~0);
 // Address Handling
 using SockAddrStorage = std::array<uint8_t, sizeof(sockaddr_storage)>;
 constexpr size_t kAddr4SockLen = sizeof(sockaddr_in);
+// Longest dotted IPv4 address plus the terminator ("255.255.255.255")
+constexpr size_t kAddressStringLength = 16;
 
 // Message Handling
 // Network Buffer is 1472. The standard MTU is 1500 bytes, a UDP header
@@ -56,6 +58,14 @@ public:
         , mOffset(0)
     { }
 
+    // Buffer for messages which are larger than a single datagram, such
+    // as an expanded compressed message.
+    explicit NetworkBuffer(size_t capacity)
+        : mBuffer(std::make_unique<uint8_t[]>(capacity))
+        , mSize(capacity)
+        , mOffset(0)
+    { }
+
     NetworkBuffer(NetworkBuffer&& other) noexcept
         : mBuffer(std::move(other.mBuffer))
         , mSize(std::exchange(other.mSize, 0))
@@ -122,6 +132,9 @@ struct NetworkMessage
 
 std::string AddressToString(const void* address);
 
+// Parse a dotted IPv4 address into its four network order bytes
+bool StringToAddress(const char* str, uint8_t address[4]);
+
 bool CreateSocketPair(Socket& reader, Socket& writer);
 
 bool DrainSocket(Socket sock);
@@ -134,6 +147,26 @@ bool SendMessage(
     uint32_t port,
     const NetworkBuffer& buf);
 
+// Send an encoded NetworkBuffer from a socket the caller owns
+bool SendMessage(
+    Socket sock,
+    const char* address,
+    uint32_t port,
+    const NetworkBuffer& buf);
+
+// One datagram of a batch handed to SendMessages()
+struct Datagram
+{
+    const char* address{ nullptr };
+    uint32_t port{ 0 };
+    Span<const uint8_t> data;
+};
+
+// Send a batch of datagrams through one socket, created for the batch the
+// way SendMessage() creates one per message. A datagram which fails is
+// reported and skipped. Returns the number sent.
+size_t SendMessages(Span<const Datagram> datagrams);
+
 bool SetNonBlocking(Socket sock);
 
 sockaddr* ToSockAddr(
@@ -47,6 +47,11 @@ uint32_t Player::GetY() const
     return mPos.y;
 }
 
+void Player::SetPosition(Position pos)
+{
+    mPos = pos;
+}
+
 bool Player::IsValid() const
 {
     return mId != kInvalidPlayerId;
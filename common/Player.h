@@ -23,6 +23,7 @@ public:
     uint32_t GetId() const;
     uint32_t GetX() const;
     uint32_t GetY() const;
+    void SetPosition(Position pos);
 
     const Game& GetGame() const;
     Game& GetGame();
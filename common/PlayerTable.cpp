@@ -0,0 +1,124 @@
+#include "PlayerTable.h"
+
+namespace Common
+{
+namespace
+{
+// Move the last element of a dense array into index and drop the last
+template<typename T>
+void SwapRemove(std::vector<T>& values, size_t index)
+{
+    if (index + 1 != values.size())
+    {
+        values[index] = std::move(values.back());
+    }
+    values.pop_back();
+}
+}
+
+void PlayerTable::Reserve(size_t capacity)
+{
+    mSlots.reserve(capacity);
+    mIdToSlot.reserve(capacity);
+    mSlotOf.reserve(capacity);
+    mIds.reserve(capacity);
+    mLastMessage.reserve(capacity);
+    mNextMessage.reserve(capacity);
+    mAckCount.reserve(capacity);
+    mPositions.reserve(capacity);
+    mInfo.reserve(capacity);
+}
+
+PlayerHandle PlayerTable::Insert(uint32_t id)
+{
+    uint32_t index = uint32_t(mSlots.size());
+
+    if (!mFreeSlots.empty())
+    {
+        index = mFreeSlots.back();
+    }
+
+    auto [it, inserted] = mIdToSlot.try_emplace(id, index);
+
+    if (!inserted)
+    {
+        return {};
+    }
+
+    if (index == mSlots.size())
+    {
+        mSlots.emplace_back();
+    }
+    else
+    {
+        mFreeSlots.pop_back();
+    }
+
+    Slot& slot = mSlots[index];
+    slot.dense = uint32_t(mIds.size());
+
+    mSlotOf.push_back(index);
+    mIds.push_back(id);
+    mLastMessage.emplace_back();
+    mNextMessage.push_back(0);
+    mAckCount.push_back(0);
+    mPositions.emplace_back();
+    mInfo.emplace_back();
+
+    return PlayerHandle{ index, slot.generation };
+}
+
+bool PlayerTable::Remove(PlayerHandle handle)
+{
+    if (!IsAlive(handle))
+    {
+        return false;
+    }
+
+    Slot& slot = mSlots[handle.index];
+    const uint32_t dense = slot.dense;
+
+    mIdToSlot.erase(mIds[dense]);
+
+    // The last player takes over the hole, so its slot has to follow it
+    mSlots[mSlotOf.back()].dense = dense;
+
+    SwapRemove(mSlotOf, dense);
+    SwapRemove(mIds, dense);
+    SwapRemove(mLastMessage, dense);
+    SwapRemove(mNextMessage, dense);
+    SwapRemove(mAckCount, dense);
+    SwapRemove(mPositions, dense);
+    SwapRemove(mInfo, dense);
+
+    slot.dense = kFreeSlot;
+    slot.generation += 1;
+    mFreeSlots.push_back(handle.index);
+
+    return true;
+}
+
+PlayerHandle PlayerTable::Find(uint32_t id) const
+{
+    if (auto it = mIdToSlot.find(id); it != mIdToSlot.end())
+    {
+        return PlayerHandle{ it->second, mSlots[it->second].generation };
+    }
+    return {};
+}
+
+bool PlayerTable::IsAlive(PlayerHandle handle) const
+{
+    return handle.index < mSlots.size()
+        && mSlots[handle.index].dense != kFreeSlot
+        && mSlots[handle.index].generation == handle.generation;
+}
+
+PlayerHandle PlayerTable::GetHandle(size_t index) const
+{
+    assert(index < mSlotOf.size());
+
+    const uint32_t slot = mSlotOf[index];
+    return PlayerHandle{ slot, mSlots[slot].generation };
+}
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "AckWindow.h"
+#include "Common.h"
+#include "JitterBuffer.h"
+#include "Network.h"
+#include "Player.h"
+#include "PriorityAccumulator.h"
+#include "RetransmitBuffer.h"
+#include "RttEstimator.h"
+#include "SendPacer.h"
+#include "TimingWheel.h"
+
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Common
+{
+// Reference to a player in a PlayerTable. The generation is bumped every
+// time a slot is freed so a handle kept past RemovePlayer() no longer
+// resolves instead of aliasing whoever reuses the slot.
+struct PlayerHandle
+{
+    static constexpr uint32_t kInvalidIndex{ UINT32_MAX };
+
+    uint32_t index{ kInvalidIndex };
+    uint32_t generation{ 0 };
+
+    explicit operator bool() const { return index != kInvalidIndex; }
+
+    bool operator==(const PlayerHandle& other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const PlayerHandle& other) const { return !(*this == other); }
+
+    // Round trip through one integer, for timers which carry a player
+    uint64_t Pack() const { return (uint64_t(generation) << 32) | index; }
+    static PlayerHandle Unpack(uint64_t value)
+    {
+        return PlayerHandle{ uint32_t(value), uint32_t(value >> 32) };
+    }
+};
+
+// Per-player data which is not touched by per-tick sweeps.
+struct PlayerInfo
+{
+    // Player which this state represents
+    std::unique_ptr<Player> player;
+    // Network Information
+    std::string address;
+    uint32_t port{ 0 };
+    // Connection time
+    std::chrono::steady_clock::time_point connectStart;
+    // Reliable messages the client has not acknowledged yet
+    RetransmitBuffer reliable;
+    // Messages received from the player, acknowledged in every compact
+    // header sent back to it
+    AckWindow acks;
+    // The player sends compact headers and is answered with them
+    bool compact{ false };
+    // State waiting to be sent to the player at the rate its link takes
+    SendPacer pacer;
+    // Which of the players it can see the player is sent next
+    PriorityAccumulator priority;
+    // Round trips to the player, timed by the ping exchange
+    RttEstimator rtt;
+    // Inputs waiting for the tick they were stamped for
+    JitterBuffer inputs;
+    // Fires when the player has been silent for the player timeout
+    TimerHandle timeout;
+    // Fires when the oldest unacknowledged message is due again
+    TimerHandle retransmit;
+};
+
+// Dense generational slot map holding every player in the game.
+//
+// Live players are packed at the front of parallel arrays, one array per
+// hot field, so a sweep over all players is a linear scan of exactly the
+// fields it reads. Removal swaps the last player into the hole. Handles
+// index a stable slot which records where the player currently lives in
+// the dense arrays.
+class PlayerTable final
+{
+public:
+    PlayerTable(const PlayerTable&) = delete;
+    PlayerTable& operator=(const PlayerTable&) = delete;
+
+public:
+    PlayerTable() = default;
+
+    void Reserve(size_t capacity);
+
+    // Add a player with the given id. Returns an invalid handle if the id
+    // is already in use.
+    PlayerHandle Insert(uint32_t id);
+    bool Remove(PlayerHandle handle);
+
+    PlayerHandle Find(uint32_t id) const;
+    bool IsAlive(PlayerHandle handle) const;
+
+    size_t Size() const { return mIds.size(); }
+
+    // Handle of the player stored at a dense index, for sweeps which need
+    // to act on what they find.
+    PlayerHandle GetHandle(size_t index) const;
+
+    // Hot fields of a single player. The handle must be alive.
+    uint32_t GetId(PlayerHandle handle) const { return mIds[Dense(handle)]; }
+
+    std::chrono::steady_clock::time_point& GetLastMessage(PlayerHandle handle)
+    {
+        return mLastMessage[Dense(handle)];
+    }
+    uint32_t& GetNextMessage(PlayerHandle handle) { return mNextMessage[Dense(handle)]; }
+    uint32_t& GetAckCount(PlayerHandle handle) { return mAckCount[Dense(handle)]; }
+    Position& GetPosition(PlayerHandle handle) { return mPositions[Dense(handle)]; }
+
+    PlayerInfo& GetInfo(PlayerHandle handle) { return mInfo[Dense(handle)]; }
+    const PlayerInfo& GetInfo(PlayerHandle handle) const { return mInfo[Dense(handle)]; }
+
+    // Hot fields of every player, indexed densely from 0 to Size()
+    Span<const uint32_t> GetIds() const { return { mIds.data(), mIds.size() }; }
+    Span<const std::chrono::steady_clock::time_point> GetLastMessages() const
+    {
+        return { mLastMessage.data(), mLastMessage.size() };
+    }
+    Span<uint32_t> GetNextMessages() { return { mNextMessage.data(), mNextMessage.size() }; }
+    Span<uint32_t> GetAckCounts() { return { mAckCount.data(), mAckCount.size() }; }
+    Span<Position> GetPositions() { return { mPositions.data(), mPositions.size() }; }
+
+private:
+    static constexpr uint32_t kFreeSlot{ UINT32_MAX };
+
+    struct Slot
+    {
+        // Index into the dense arrays, kFreeSlot when unused
+        uint32_t dense{ kFreeSlot };
+        uint32_t generation{ 0 };
+    };
+
+    uint32_t Dense(PlayerHandle handle) const
+    {
+        assert(IsAlive(handle));
+        return mSlots[handle.index].dense;
+    }
+
+private:
+    std::vector<Slot> mSlots;
+    std::vector<uint32_t> mFreeSlots;
+    std::unordered_map<uint32_t, uint32_t> mIdToSlot;
+
+    // Dense arrays, all the same size
+    std::vector<uint32_t> mSlotOf;
+    std::vector<uint32_t> mIds;
+    std::vector<std::chrono::steady_clock::time_point> mLastMessage;
+    std::vector<uint32_t> mNextMessage;
+    std::vector<uint32_t> mAckCount;
+    std::vector<Position> mPositions;
+    std::vector<PlayerInfo> mInfo;
+};
+}
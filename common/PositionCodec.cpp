@@ -0,0 +1,208 @@
+#include "PositionCodec.h"
+
+#include <cassert>
+
+namespace Common
+{
+namespace
+{
+uint32_t ZigZagEncode(int32_t value)
+{
+    return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+int32_t ZigZagDecode(uint32_t value)
+{
+    return int32_t(value >> 1) ^ -int32_t(value & 1);
+}
+
+// Returns true if the signed value can be zig-zag encoded in bits
+bool FitsSigned(int64_t value, uint32_t bits)
+{
+    const int64_t limit = int64_t(1) << (bits - 1);
+    return value >= -limit && value < limit;
+}
+}
+
+BitWriter::BitWriter(Span<uint8_t> buffer)
+    : mBuffer(buffer)
+{ }
+
+bool BitWriter::Put(uint32_t value, uint32_t bits)
+{
+    assert(bits <= 32);
+
+    if (mOverflow || mBitOffset + bits > mBuffer.size * 8)
+    {
+        mOverflow = true;
+        return false;
+    }
+
+    while (bits > 0)
+    {
+        const size_t index = mBitOffset / 8;
+        const uint32_t used = uint32_t(mBitOffset % 8);
+        const uint32_t available = 8 - used;
+        const uint32_t count = bits < available ? bits : available;
+
+        const uint32_t chunk = uint32_t(uint64_t(value) >> (bits - count))
+            & ((1u << count) - 1);
+
+        if (used == 0)
+        {
+            // First write into this byte, clear any stale contents
+            mBuffer.data[index] = 0;
+        }
+
+        mBuffer.data[index] |= uint8_t(chunk << (available - count));
+
+        bits -= count;
+        mBitOffset += count;
+    }
+
+    return true;
+}
+
+BitReader::BitReader(Span<const uint8_t> buffer)
+    : mBuffer(buffer)
+{ }
+
+uint32_t BitReader::Read(uint32_t bits)
+{
+    assert(bits <= 32);
+
+    if (mOverflow || mBitOffset + bits > mBuffer.size * 8)
+    {
+        mOverflow = true;
+        return 0;
+    }
+
+    uint32_t value = 0;
+
+    while (bits > 0)
+    {
+        const size_t index = mBitOffset / 8;
+        const uint32_t used = uint32_t(mBitOffset % 8);
+        const uint32_t available = 8 - used;
+        const uint32_t count = bits < available ? bits : available;
+
+        const uint32_t chunk = (uint32_t(mBuffer.data[index]) >> (available - count))
+            & ((1u << count) - 1);
+
+        value = uint32_t(uint64_t(value) << count) | chunk;
+
+        bits -= count;
+        mBitOffset += count;
+    }
+
+    return value;
+}
+
+PositionCodec::PositionCodec(uint32_t width, uint32_t height)
+    : mWidth(width)
+    , mHeight(height)
+    , mBitsX(BitsFor(width))
+    , mBitsY(BitsFor(height))
+{ }
+
+size_t PositionCodec::GetEncodedSize(size_t count) const
+{
+    return (count * GetPositionBits() + 7) / 8;
+}
+
+bool PositionCodec::IsValid(const Position& pos) const
+{
+    return pos.x < mWidth && pos.y < mHeight;
+}
+
+bool PositionCodec::Encode(BitWriter& writer, const Position& pos) const
+{
+    if (!IsValid(pos))
+    {
+        return false;
+    }
+
+    return writer.Put(pos.x, mBitsX)
+        && writer.Put(pos.y, mBitsY);
+}
+
+bool PositionCodec::Decode(BitReader& reader, Position& pos) const
+{
+    Position result;
+    result.x = reader.Read(mBitsX);
+    result.y = reader.Read(mBitsY);
+
+    if (reader.Overflow() || !IsValid(result))
+    {
+        return false;
+    }
+
+    pos = result;
+    return true;
+}
+
+bool PositionCodec::EncodeDelta(
+    BitWriter& writer,
+    const Position& previous,
+    const Position& pos) const
+{
+    if (!IsValid(pos))
+    {
+        return false;
+    }
+
+    if (IsValid(previous))
+    {
+        const int64_t dx = int64_t(pos.x) - int64_t(previous.x);
+        const int64_t dy = int64_t(pos.y) - int64_t(previous.y);
+
+        if (FitsSigned(dx, kDeltaBits) && FitsSigned(dy, kDeltaBits))
+        {
+            return writer.Put(1, 1)
+                && writer.Put(ZigZagEncode(int32_t(dx)), kDeltaBits)
+                && writer.Put(ZigZagEncode(int32_t(dy)), kDeltaBits);
+        }
+    }
+
+    // The displacement is too large (or there is no previous value) so we
+    // fall back to sending the absolute position.
+    return writer.Put(0, 1)
+        && Encode(writer, pos);
+}
+
+bool PositionCodec::DecodeDelta(
+    BitReader& reader,
+    const Position& previous,
+    Position& pos) const
+{
+    const uint32_t isDelta = reader.Read(1);
+
+    if (reader.Overflow())
+    {
+        return false;
+    }
+    if (!isDelta)
+    {
+        return Decode(reader, pos);
+    }
+    if (!IsValid(previous))
+    {
+        return false;
+    }
+
+    const int32_t dx = ZigZagDecode(reader.Read(kDeltaBits));
+    const int32_t dy = ZigZagDecode(reader.Read(kDeltaBits));
+
+    Position result;
+    result.x = uint32_t(int64_t(previous.x) + dx);
+    result.y = uint32_t(int64_t(previous.y) + dy);
+
+    if (reader.Overflow() || !IsValid(result))
+    {
+        return false;
+    }
+
+    pos = result;
+    return true;
+}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Common.h"
+
+namespace Common
+{
+// Number of bits required to represent every value in [0, count).
+constexpr uint32_t BitsFor(uint32_t count)
+{
+    uint32_t bits = 0;
+
+    while (count > 1 && bits < 32 && (uint64_t(1) << bits) < count)
+    {
+        ++bits;
+    }
+
+    return bits;
+}
+
+// Writes values into a byte span a few bits at a time. Values are written
+// most significant bit first and the writer never reads past the span.
+class BitWriter final
+{
+public:
+    BitWriter(Span<uint8_t> buffer);
+
+    // Number of bits written so far
+    size_t BitOffset() const { return mBitOffset; }
+
+    // Number of bytes touched by the written bits
+    size_t Size() const { return (mBitOffset + 7) / 8; }
+
+    // True if a write was dropped because the span was too small
+    bool Overflow() const { return mOverflow; }
+
+    bool Put(uint32_t value, uint32_t bits);
+
+private:
+    Span<uint8_t> mBuffer;
+    size_t mBitOffset{ 0 };
+    bool mOverflow{ false };
+};
+
+// Reads values written by the BitWriter.
+class BitReader final
+{
+public:
+    BitReader(Span<const uint8_t> buffer);
+
+    size_t BitOffset() const { return mBitOffset; }
+    size_t Remaining() const { return mBuffer.size * 8 - mBitOffset; }
+
+    // True if a read requested more bits than were available
+    bool Overflow() const { return mOverflow; }
+
+    uint32_t Read(uint32_t bits);
+
+private:
+    Span<const uint8_t> mBuffer;
+    size_t mBitOffset{ 0 };
+    bool mOverflow{ false };
+};
+
+// Encodes positions on a board of known size with the minimum number of
+// bits per axis. The codec is derived from the board dimensions when the
+// game session starts so both ends agree on the bit widths. A 64x64 board
+// needs 6 bits per axis instead of the 32 held in a Position.
+class PositionCodec final
+{
+public:
+    // Deltas are sent as zig-zag encoded signed values of this many bits per
+    // axis which covers a displacement of [-8, 7] cells.
+    static constexpr uint32_t kDeltaBits = 4;
+
+public:
+    PositionCodec() = default;
+    PositionCodec(uint32_t width, uint32_t height);
+
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+
+    uint32_t GetBitsX() const { return mBitsX; }
+    uint32_t GetBitsY() const { return mBitsY; }
+
+    // Bits used by an absolute position
+    uint32_t GetPositionBits() const { return mBitsX + mBitsY; }
+
+    // Bits used by a delta encoded position when the displacement fits in
+    // kDeltaBits, otherwise the delta encoding falls back to an absolute
+    // position. Both include the one bit selector.
+    uint32_t GetDeltaBits() const { return 1 + 2 * kDeltaBits; }
+    uint32_t GetDeltaFallbackBits() const { return 1 + GetPositionBits(); }
+
+    // Number of bytes required to hold count absolute positions
+    size_t GetEncodedSize(size_t count) const;
+
+    bool IsValid(const Position& pos) const;
+
+    bool Encode(BitWriter& writer, const Position& pos) const;
+    bool Decode(BitReader& reader, Position& pos) const;
+
+    bool EncodeDelta(
+        BitWriter& writer,
+        const Position& previous,
+        const Position& pos) const;
+    bool DecodeDelta(
+        BitReader& reader,
+        const Position& previous,
+        Position& pos) const;
+
+private:
+    uint32_t mWidth{ 0 };
+    uint32_t mHeight{ 0 };
+    uint32_t mBitsX{ 0 };
+    uint32_t mBitsY{ 0 };
+};
+}
@@ -0,0 +1,74 @@
+#include "Prediction.h"
+
+#include <algorithm>
+
+namespace Common
+{
+void Prediction::Push(uint32_t tick, Movement movement)
+{
+    if (mCount == kCapacity)
+    {
+        mHead = (mHead + 1) % kCapacity;
+        mCount -= 1;
+        mStats.dropped += 1;
+    }
+
+    mInputs[(mHead + mCount) % kCapacity] = Input{ tick, movement };
+    mCount += 1;
+    mStats.predicted += 1;
+}
+
+void Prediction::Acknowledge(uint32_t tick)
+{
+    while (mCount && int32_t(mInputs[mHead].tick - tick) < 0)
+    {
+        mHead = (mHead + 1) % kCapacity;
+        mCount -= 1;
+    }
+}
+
+const Prediction::Input& Prediction::Get(size_t index) const
+{
+    assert(index < mCount);
+    return mInputs[(mHead + index) % kCapacity];
+}
+
+uint32_t Prediction::GetNextTick(uint32_t tick) const
+{
+    if (mCount == 0)
+    {
+        return tick;
+    }
+
+    const uint32_t last = Get(mCount - 1).tick;
+    return int32_t(tick - last) > 0 ? tick : last + 1;
+}
+
+void Prediction::Reconcile(Position predicted, Position corrected)
+{
+    mStats.reconciled += 1;
+
+    if (predicted.x == corrected.x && predicted.y == corrected.y)
+    {
+        return;
+    }
+
+    const uint32_t dx = predicted.x > corrected.x
+        ? predicted.x - corrected.x
+        : corrected.x - predicted.x;
+    const uint32_t dy = predicted.y > corrected.y
+        ? predicted.y - corrected.y
+        : corrected.y - predicted.y;
+
+    mStats.mispredicted += 1;
+    mStats.correctionDistance += uint64_t(dx) + dy;
+    mStats.maxCorrection = std::max(mStats.maxCorrection, dx + dy);
+}
+
+double Prediction::GetMispredictionRate() const
+{
+    return mStats.reconciled
+        ? double(mStats.mispredicted) / double(mStats.reconciled)
+        : 0.0;
+}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Common.h"
+
+#include <array>
+
+namespace Common
+{
+// Inputs a client has applied to its own player ahead of the server, kept
+// until an authoritative state shows the server has run them.
+//
+// Inputs are held in a fixed ring in the order they were sent. When a
+// state for server tick T arrives every input stamped before T is already
+// part of it, and the rest are replayed on top of the server's position to
+// get the new predicted position.
+class Prediction final
+{
+public:
+    // Most inputs in flight at once. When full the oldest input is
+    // forgotten, which only matters if the server never answers.
+    static constexpr uint32_t kCapacity = 64;
+
+    struct Input
+    {
+        uint32_t tick{ 0 };
+        Movement movement{ Movement::Left };
+    };
+
+    struct Stats
+    {
+        // Inputs applied locally before the server saw them
+        uint64_t predicted{ 0 };
+        // Authoritative states checked against the prediction
+        uint64_t reconciled{ 0 };
+        // States where the prediction had to be corrected
+        uint64_t mispredicted{ 0 };
+        // Sum and worst of the cells moved by corrections
+        uint64_t correctionDistance{ 0 };
+        uint32_t maxCorrection{ 0 };
+        // Inputs forgotten because the ring was full
+        uint64_t dropped{ 0 };
+    };
+
+public:
+    Prediction() = default;
+
+    // Record an input which was applied locally
+    void Push(uint32_t tick, Movement movement);
+
+    // Forget the inputs stamped before tick, the server has run them
+    void Acknowledge(uint32_t tick);
+
+    size_t Size() const { return mCount; }
+    bool IsEmpty() const { return mCount == 0; }
+
+    // Unacknowledged input by age, 0 being the oldest
+    const Input& Get(size_t index) const;
+
+    // Tick the next input should be stamped for at the earliest. The
+    // server runs one input per player per tick so each input gets its
+    // own tick.
+    uint32_t GetNextTick(uint32_t tick) const;
+
+    // Count a reconciliation which moved the prediction from predicted to
+    // corrected
+    void Reconcile(Position predicted, Position corrected);
+
+    const Stats& GetStats() const { return mStats; }
+
+    // Fraction of reconciliations which needed a correction
+    double GetMispredictionRate() const;
+
+private:
+    std::array<Input, kCapacity> mInputs;
+    uint32_t mHead{ 0 };
+    uint32_t mCount{ 0 };
+    Stats mStats;
+};
+}
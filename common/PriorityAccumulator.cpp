@@ -0,0 +1,141 @@
+#include "PriorityAccumulator.h"
+
+#include <algorithm>
+
+namespace Common
+{
+namespace
+{
+// Cells a king's move away, which is how the interest radius is measured
+uint32_t Distance(Position a, Position b)
+{
+    const uint32_t dx = a.x > b.x ? a.x - b.x : b.x - a.x;
+    const uint32_t dy = a.y > b.y ? a.y - b.y : b.y - a.y;
+    return std::max(dx, dy);
+}
+
+bool HasMoved(const PriorityAccumulator::Entry& entry)
+{
+    return entry.pos.x != entry.sent.x || entry.pos.y != entry.sent.y;
+}
+}
+
+void PriorityAccumulator::Update(
+    uint32_t tick,
+    Position self,
+    uint32_t radius,
+    Span<const uint32_t> visible,
+    Span<const Position> positions)
+{
+    assert(visible.size == positions.size);
+
+    // Both lists are sorted by id, so keeping the entries of players still
+    // in view and starting new ones is a single merge
+    mMerged.clear();
+    mMerged.reserve(visible.size);
+    mLeft.clear();
+
+    size_t old = 0;
+    for (size_t i = 0; i < visible.size; ++i)
+    {
+        while (old < mEntries.size() && mEntries[old].id < visible.data[i])
+        {
+            mLeft.push_back(mEntries[old++].id);
+        }
+
+        if (old < mEntries.size() && mEntries[old].id == visible.data[i])
+        {
+            mMerged.push_back(mEntries[old++]);
+        }
+        else
+        {
+            // Never sent, so it counts as having moved
+            Entry entry;
+            entry.id = visible.data[i];
+            entry.lastSent = tick;
+            mMerged.push_back(entry);
+        }
+
+        Entry& entry = mMerged.back();
+        entry.pos = positions.data[i];
+
+        const uint32_t distance = std::min(Distance(self, entry.pos), radius);
+        const float gain = float(radius + 1 - distance) / float(radius + 1);
+        entry.priority += HasMoved(entry) ? gain : gain * kIdleWeight;
+    }
+
+    for (; old < mEntries.size(); ++old)
+    {
+        mLeft.push_back(mEntries[old].id);
+    }
+
+    mEntries.swap(mMerged);
+    mStats.updates += 1;
+}
+
+Span<const PriorityAccumulator::Entry> PriorityAccumulator::Select(uint32_t tick, size_t count)
+{
+    count = std::min(count, mEntries.size());
+
+    mOrder.resize(mEntries.size());
+    for (size_t i = 0; i < mOrder.size(); ++i)
+    {
+        mOrder[i] = uint32_t(i);
+    }
+
+    // Ties go to the lower id so the pick does not depend on the order
+    // entries were added in
+    std::partial_sort(mOrder.begin(), mOrder.begin() + count, mOrder.end(),
+        [this](uint32_t a, uint32_t b)
+        {
+            if (mEntries[a].priority != mEntries[b].priority)
+            {
+                return mEntries[a].priority > mEntries[b].priority;
+            }
+            return mEntries[a].id < mEntries[b].id;
+        });
+
+    mSelected.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        Entry& entry = mEntries[mOrder[i]];
+        const uint32_t age = tick - entry.lastSent;
+
+        mStats.totalAge += age;
+        mStats.maxAge = std::max(mStats.maxAge, age);
+
+        entry.priority = 0.0f;
+        entry.lastSent = tick;
+        entry.sent = entry.pos;
+        mSelected.push_back(entry);
+    }
+
+    mStats.selected += count;
+    mStats.deferred += mEntries.size() - count;
+
+    return { mSelected.data(), mSelected.size() };
+}
+
+uint32_t PriorityAccumulator::GetAge(uint32_t id, uint32_t tick) const
+{
+    auto it = std::lower_bound(mEntries.begin(), mEntries.end(), id,
+        [](const Entry& entry, uint32_t id) { return entry.id < id; });
+
+    if (it == mEntries.end() || it->id != id)
+    {
+        return 0;
+    }
+
+    return tick - it->lastSent;
+}
+
+uint32_t PriorityAccumulator::GetMaxAge(uint32_t tick) const
+{
+    uint32_t age = 0;
+    for (const Entry& entry : mEntries)
+    {
+        age = std::max(age, tick - entry.lastSent);
+    }
+    return age;
+}
+}
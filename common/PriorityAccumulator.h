@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Common.h"
+
+#include <vector>
+
+namespace Common
+{
+// Picks which of the players one client can see go into its next state
+// message when they do not all fit.
+//
+// Every visible player has a priority which grows each tick, faster the
+// closer it is to the client and faster again when it moved since the
+// client last heard of it. The players with the highest priority are sent
+// and start over from zero, so a far or idle player is sent less often but
+// is never starved for good. How long each has waited is kept for tuning.
+class PriorityAccumulator final
+{
+public:
+    PriorityAccumulator(const PriorityAccumulator&) = delete;
+    PriorityAccumulator& operator=(const PriorityAccumulator&) = delete;
+
+public:
+    // Gain of a player which has not moved since it was last sent,
+    // against one which has
+    static constexpr float kIdleWeight = 0.25f;
+
+    struct Entry
+    {
+        uint32_t id{ 0 };
+        float priority{ 0.0f };
+        // Tick it was last sent, or came into view
+        uint32_t lastSent{ 0 };
+        // Position as of the last Update() and as last sent
+        Position pos;
+        Position sent;
+    };
+
+    struct Stats
+    {
+        uint64_t updates{ 0 };
+        // Entries picked and entries left waiting, over every Select()
+        uint64_t selected{ 0 };
+        uint64_t deferred{ 0 };
+        // Sum of the ages of the picked entries, for the average wait
+        uint64_t totalAge{ 0 };
+        // Longest any entry waited before it was picked
+        uint32_t maxAge{ 0 };
+    };
+
+public:
+    PriorityAccumulator() = default;
+    PriorityAccumulator(PriorityAccumulator&&) = default;
+    PriorityAccumulator& operator=(PriorityAccumulator&&) = default;
+
+    // Bring the entries in line with what the client sees at tick and add
+    // the tick's gain to each. visible is sorted by id, positions holds
+    // their positions in the same order and self is the client's own
+    // position. Distances are weighed against the interest radius.
+    void Update(
+        uint32_t tick,
+        Position self,
+        uint32_t radius,
+        Span<const uint32_t> visible,
+        Span<const Position> positions);
+
+    // Take up to count entries with the highest priority, highest first,
+    // and mark them as sent at tick. The span is valid until the next
+    // call.
+    Span<const Entry> Select(uint32_t tick, size_t count);
+
+    // Ticks the entity has waited at tick since it was last sent, 0 if it
+    // is not in view
+    uint32_t GetAge(uint32_t id, uint32_t tick) const;
+
+    // Longest wait of any entity in view at tick
+    uint32_t GetMaxAge(uint32_t tick) const;
+
+    Span<const Entry> GetEntries() const { return { mEntries.data(), mEntries.size() }; }
+
+    // Ids which dropped out of view in the last Update(), sorted. Sent or
+    // not, as the client may have heard of them from an announcement.
+    Span<const uint32_t> GetLeft() const { return { mLeft.data(), mLeft.size() }; }
+
+    size_t Size() const { return mEntries.size(); }
+
+    const Stats& GetStats() const { return mStats; }
+
+private:
+    // Sorted by id
+    std::vector<Entry> mEntries;
+    std::vector<Entry> mMerged;
+    std::vector<uint32_t> mOrder;
+    std::vector<Entry> mSelected;
+    std::vector<uint32_t> mLeft;
+    Stats mStats;
+};
+}
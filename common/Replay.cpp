@@ -0,0 +1,90 @@
+#include "Replay.h"
+
+#include "Network.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <thread>
+
+namespace Common
+{
+Replay::Replay(CaptureReader& reader, Game& game)
+    : mReader(reader)
+    , mGame(game)
+{ }
+
+Replay::Stats Replay::Run(
+    Pacing pacing,
+    std::chrono::steady_clock::duration interval)
+{
+    using namespace std::chrono;
+
+    assert(interval.count() > 0);
+
+    Stats stats;
+    const uint64_t step = uint64_t(duration_cast<nanoseconds>(interval).count());
+    uint64_t nextTick = step;
+
+    auto Tick = [&]() -> bool
+    {
+        auto start = steady_clock::now();
+        bool result = mGame.Tick();
+        auto elapsed = steady_clock::now() - start;
+
+        stats.ticks += 1;
+        stats.tickTime += elapsed;
+        stats.maxTickTime = std::max(stats.maxTickTime, elapsed);
+
+        return result;
+    };
+
+    mReader.Rewind();
+    const auto start = steady_clock::now();
+
+    NetworkMessage msg;
+    CaptureReader::Record record;
+
+    while (mReader.Next(record))
+    {
+        // Run every tick which would have happened before this datagram
+        // arrived.
+        while (record.timestamp >= nextTick)
+        {
+            if (!Tick())
+            {
+                stats.wallTime = steady_clock::now() - start;
+                return stats;
+            }
+            nextTick += step;
+        }
+
+        if (pacing == Pacing::Original)
+        {
+            std::this_thread::sleep_until(start + nanoseconds(record.timestamp));
+        }
+
+        auto receiveStart = steady_clock::now();
+
+        memcpy(msg.buffer.Data(), record.data.data,
+            std::min(record.data.size, msg.buffer.Capacity()));
+        msg.buffer.SetOffset(std::min(record.data.size, msg.buffer.Capacity()));
+        msg.address = AddressToString(record.address);
+        msg.port = record.port;
+
+        if (!mGame.OnReceive(msg))
+        {
+            stats.rejected += 1;
+        }
+
+        stats.records += 1;
+        stats.receiveTime += steady_clock::now() - receiveStart;
+    }
+
+    // Process whatever arrived after the last tick
+    Tick();
+
+    stats.wallTime = steady_clock::now() - start;
+    return stats;
+}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Capture.h"
+#include "Game.h"
+
+#include <chrono>
+
+namespace Common
+{
+// Feeds the datagrams of a capture file into a Game as if they had been
+// received from the network, ticking the game on the capture's clock. The
+// tick cadence follows the capture timestamps in both modes so the events
+// processed by each Tick() match what the live server saw. The game is
+// expected to run with Params::dryRun so its replies do not go out to the
+// captured addresses.
+class Replay final
+{
+public:
+    Replay(const Replay&) = delete;
+    Replay& operator=(const Replay&) = delete;
+
+public:
+    enum class Pacing : uint32_t
+    {
+        // Sleep between records to reproduce the captured timing
+        Original = 0,
+        // Feed records back to back to measure throughput
+        Fast
+    };
+
+    struct Stats
+    {
+        uint64_t records{ 0 };
+        uint64_t rejected{ 0 };
+        uint64_t ticks{ 0 };
+        std::chrono::steady_clock::duration wallTime{ 0 };
+        std::chrono::steady_clock::duration receiveTime{ 0 };
+        std::chrono::steady_clock::duration tickTime{ 0 };
+        std::chrono::steady_clock::duration maxTickTime{ 0 };
+    };
+
+public:
+    Replay(CaptureReader& reader, Game& game);
+
+    // Replay the whole capture ticking the game every interval of capture
+    // time. Stops early if Tick() returns false.
+    Stats Run(Pacing pacing, std::chrono::steady_clock::duration interval);
+
+private:
+    CaptureReader& mReader;
+    Game& mGame;
+};
+}
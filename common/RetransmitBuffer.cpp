@@ -0,0 +1,146 @@
+#include "RetransmitBuffer.h"
+
+#include <algorithm>
+
+namespace Common
+{
+RetransmitBuffer::Entry* RetransmitBuffer::Slot(uint32_t sequence) const
+{
+    return mEntries ? &mEntries[sequence % kCapacity] : nullptr;
+}
+
+void RetransmitBuffer::Release(Entry& entry)
+{
+    assert(entry.used);
+
+    entry.used = false;
+    entry.data.clear();
+    mSize -= 1;
+}
+
+void RetransmitBuffer::Add(
+    uint32_t sequence,
+    Span<const uint8_t> data,
+    Clock::time_point now,
+    Clock::duration timeout)
+{
+    if (!mEntries)
+    {
+        mEntries = std::make_unique<Entry[]>(kCapacity);
+    }
+
+    Entry& entry = *Slot(sequence);
+
+    if (entry.used)
+    {
+        mStats.evicted += 1;
+        Release(entry);
+    }
+
+    entry.sequence = sequence;
+    entry.used = true;
+    entry.sends = 1;
+    entry.timeout = timeout;
+    entry.deadline = now + timeout;
+    entry.data.assign(data.data, data.data + data.size);
+
+    mSize += 1;
+    mStats.stored += 1;
+}
+
+bool RetransmitBuffer::Acknowledge(uint32_t sequence)
+{
+    Entry* entry = Slot(sequence);
+
+    if (!entry || !entry->used || entry->sequence != sequence)
+    {
+        return false;
+    }
+
+    Release(*entry);
+    mStats.acknowledged += 1;
+    return true;
+}
+
+size_t RetransmitBuffer::AcknowledgeUpTo(uint32_t sequence)
+{
+    size_t released = 0;
+
+    for (uint32_t i = 0; mSize && mEntries && i < kCapacity; ++i)
+    {
+        Entry& entry = mEntries[i];
+
+        if (entry.used && int32_t(entry.sequence - sequence) <= 0)
+        {
+            Release(entry);
+            released += 1;
+        }
+    }
+
+    mStats.acknowledged += released;
+    return released;
+}
+
+Span<const uint8_t> RetransmitBuffer::Find(uint32_t sequence) const
+{
+    const Entry* entry = Slot(sequence);
+
+    if (!entry || !entry->used || entry->sequence != sequence)
+    {
+        return {};
+    }
+
+    return { entry->data.data(), entry->data.size() };
+}
+
+Span<const uint32_t> RetransmitBuffer::TakeDue(Clock::time_point now)
+{
+    mDue.clear();
+
+    for (uint32_t i = 0; mSize && mEntries && i < kCapacity; ++i)
+    {
+        Entry& entry = mEntries[i];
+
+        if (!entry.used || entry.deadline > now)
+        {
+            continue;
+        }
+
+        if (entry.sends >= kMaxSends)
+        {
+            mStats.abandoned += 1;
+            Release(entry);
+            continue;
+        }
+
+        entry.sends += 1;
+        entry.timeout = std::min<Clock::duration>(entry.timeout * 2, kMaxTimeout);
+        entry.deadline = now + entry.timeout;
+
+        mDue.push_back(entry.sequence);
+    }
+
+    std::sort(mDue.begin(), mDue.end(),
+        [](uint32_t a, uint32_t b) { return int32_t(a - b) < 0; });
+
+    mStats.resent += mDue.size();
+    return { mDue.data(), mDue.size() };
+}
+
+std::optional<RetransmitBuffer::Clock::time_point> RetransmitBuffer::GetNextDeadline() const
+{
+    std::optional<Clock::time_point> next;
+
+    for (uint32_t i = 0; mSize && mEntries && i < kCapacity; ++i)
+    {
+        const Entry& entry = mEntries[i];
+
+        if (entry.used && (!next || entry.deadline < *next))
+        {
+            next = entry.deadline;
+        }
+    }
+
+    return next;
+}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Common.h"
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace Common
+{
+// Copies of the reliable messages sent to one peer which it has not
+// acknowledged yet.
+//
+// Messages live in a fixed ring indexed by sequence number modulo its
+// capacity, so storing, finding and acknowledging a message never
+// searches. A message still waiting when its slot comes around again is
+// given up on. Every message has its own retransmission timeout which
+// doubles on each resend, so only the messages which are actually overdue
+// go out again.
+class RetransmitBuffer final
+{
+public:
+    RetransmitBuffer(const RetransmitBuffer&) = delete;
+    RetransmitBuffer& operator=(const RetransmitBuffer&) = delete;
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr uint32_t kCapacity = 32;
+
+    // Sends of one message, the first included, before giving up on it
+    static constexpr uint32_t kMaxSends = 8;
+
+    // Ceiling for a backed off timeout
+    static constexpr std::chrono::milliseconds kMaxTimeout{ 2000 };
+
+    struct Stats
+    {
+        uint64_t stored{ 0 };
+        uint64_t acknowledged{ 0 };
+        uint64_t resent{ 0 };
+        // Overwritten by a newer message in the same slot
+        uint64_t evicted{ 0 };
+        // Sent kMaxSends times without an acknowledgement
+        uint64_t abandoned{ 0 };
+    };
+
+public:
+    RetransmitBuffer() = default;
+    RetransmitBuffer(RetransmitBuffer&&) = default;
+    RetransmitBuffer& operator=(RetransmitBuffer&&) = default;
+
+    // Keep a copy of a message which was just sent, to be sent again if
+    // it is not acknowledged within timeout
+    void Add(
+        uint32_t sequence,
+        Span<const uint8_t> data,
+        Clock::time_point now,
+        Clock::duration timeout);
+
+    // The peer has the message with this sequence
+    bool Acknowledge(uint32_t sequence);
+
+    // The peer has every message up to and including sequence. Returns the
+    // number of messages released.
+    size_t AcknowledgeUpTo(uint32_t sequence);
+
+    // Copy of a message still waiting for an acknowledgement. Empty if it
+    // is not held.
+    Span<const uint8_t> Find(uint32_t sequence) const;
+
+    // Sequences of the messages overdue at now, oldest first. Their
+    // timeouts are doubled as the caller is expected to resend them, and
+    // messages out of sends are dropped instead. The span is valid until
+    // the next call.
+    Span<const uint32_t> TakeDue(Clock::time_point now);
+
+    // When the next message comes due, if any are held
+    std::optional<Clock::time_point> GetNextDeadline() const;
+
+    size_t Size() const { return mSize; }
+    bool IsEmpty() const { return mSize == 0; }
+
+    const Stats& GetStats() const { return mStats; }
+
+private:
+    struct Entry
+    {
+        uint32_t sequence{ 0 };
+        bool used{ false };
+        uint32_t sends{ 0 };
+        Clock::duration timeout{ 0 };
+        Clock::time_point deadline;
+        // Keeps its capacity once freed so the slot can be reused without
+        // allocating
+        std::vector<uint8_t> data;
+    };
+
+    Entry* Slot(uint32_t sequence) const;
+    void Release(Entry& entry);
+
+private:
+    // Allocated on the first reliable message
+    std::unique_ptr<Entry[]> mEntries;
+    size_t mSize{ 0 };
+    std::vector<uint32_t> mDue;
+    Stats mStats;
+};
+}
@@ -0,0 +1,293 @@
+#include "RoomManager.h"
+
+#include "Message.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+namespace Common
+{
+RoomManager::RoomManager(Params params)
+    : mParams(params)
+{
+    assert(mParams.maxInbox > 0);
+}
+
+RoomManager::~RoomManager()
+{
+    Stop();
+}
+
+uint32_t RoomManager::CreateRoom(std::unique_ptr<Game> game)
+{
+    assert(game);
+    assert(mWorkers.empty());
+
+    auto room = std::make_unique<Room>();
+    room->id = uint32_t(mRooms.size() + 1);
+    room->game = std::move(game);
+
+    mRoomIndex.emplace(room->id, uint32_t(mRooms.size()));
+    mRooms.push_back(std::move(room));
+
+    return mRooms.back()->id;
+}
+
+void RoomManager::Start()
+{
+    assert(mWorkers.empty());
+
+    {
+        std::lock_guard lock(mMutex);
+
+        // Rooms start ticking together and drift onto their own cadence
+        const Clock::time_point now = Now();
+
+        for (uint32_t i = 0; i < mRooms.size(); ++i)
+        {
+            mDue.push({ now, i });
+        }
+
+        mRunning = true;
+    }
+
+    for (uint32_t i = 0; i < mParams.workers; ++i)
+    {
+        mWorkers.emplace_back([this] { Work(); });
+    }
+}
+
+void RoomManager::Stop()
+{
+    {
+        std::lock_guard lock(mMutex);
+        mRunning = false;
+    }
+
+    mCond.notify_all();
+
+    for (std::thread& worker : mWorkers)
+    {
+        worker.join();
+    }
+
+    mWorkers.clear();
+    mDue = {};
+}
+
+size_t RoomManager::RunDue()
+{
+    assert(mWorkers.empty());
+
+    // Rooms due again straight away wait for the next call, so a clock
+    // which does not move can not keep a room running
+    std::vector<Due> due;
+    const Clock::time_point now = Now();
+
+    while (!mDue.empty() && mDue.top().when <= now)
+    {
+        due.push_back(mDue.top());
+        mDue.pop();
+    }
+
+    for (const Due& room : due)
+    {
+        mDue.push({ RunRoom(*mRooms[room.index], room.when), room.index });
+    }
+
+    return due.size();
+}
+
+bool RoomManager::Route(const NetworkMessage& msg)
+{
+    Span<const uint8_t> data(msg.buffer.Data(), msg.buffer.Size());
+    Room* room = nullptr;
+    uint32_t id = 0;
+
+    if (ReadRoomHeader(data, id))
+    {
+        room = FindRoom(id);
+        data = data.Subspan(kRoomHeaderSize);
+    }
+    else if (!mRooms.empty())
+    {
+        room = mRooms.front().get();
+    }
+
+    if (!room)
+    {
+        ++mUnrouted;
+        return false;
+    }
+
+    std::lock_guard lock(room->mutex);
+
+    if (room->inboxSize >= mParams.maxInbox)
+    {
+        ++room->stats.dropped;
+        return false;
+    }
+
+    if (room->inboxSize == room->inbox.size())
+    {
+        room->inbox.emplace_back();
+    }
+
+    NetworkMessage& copy = room->inbox[room->inboxSize++];
+
+    assert(data.size <= copy.buffer.Capacity());
+    memcpy(copy.buffer.Data(), data.data, data.size);
+    copy.buffer.SetOffset(data.size);
+    copy.address = msg.address;
+    copy.port = msg.port;
+
+    ++room->stats.received;
+    return true;
+}
+
+RoomManager::RoomStats RoomManager::GetRoomStats(uint32_t id) const
+{
+    Room* room = FindRoom(id);
+
+    if (!room)
+    {
+        return {};
+    }
+
+    std::lock_guard lock(room->mutex);
+    return room->stats;
+}
+
+Game* RoomManager::GetGame(uint32_t id) const
+{
+    Room* room = FindRoom(id);
+    return room ? room->game.get() : nullptr;
+}
+
+void RoomManager::PrintStats() const
+{
+    using namespace std::chrono;
+
+    std::cout << "Rooms: " << mRooms.size() << " on " << mParams.workers
+        << " workers, " << mUnrouted << " datagrams for unknown rooms\n";
+
+    for (const auto& room : mRooms)
+    {
+        const RoomStats stats = GetRoomStats(room->id);
+        const auto busy = duration_cast<microseconds>(stats.busyTime).count();
+
+        std::cout << "  room '" << room->id << "': " << stats.ticks << " ticks, busy "
+            << busy << "us (avg " << (stats.ticks ? busy / int64_t(stats.ticks) : 0)
+            << "us, max " << duration_cast<microseconds>(stats.maxTickTime).count()
+            << "us), " << stats.late << " late, " << stats.throttled << " throttled, "
+            << stats.received << " received, " << stats.dropped << " dropped, "
+            << stats.invalid << " invalid\n";
+    }
+}
+
+void RoomManager::Work()
+{
+    std::unique_lock lock(mMutex);
+
+    while (mRunning)
+    {
+        if (mDue.empty())
+        {
+            mCond.wait(lock);
+            continue;
+        }
+
+        const Due due = mDue.top();
+        const Clock::time_point now = Now();
+
+        if (now < due.when)
+        {
+            mCond.wait_for(lock, due.when - now);
+            continue;
+        }
+
+        mDue.pop();
+        lock.unlock();
+
+        const Clock::time_point next = RunRoom(*mRooms[due.index], due.when);
+
+        lock.lock();
+        mDue.push({ next, due.index });
+
+        // The room may now be due before whatever the others wait for
+        mCond.notify_one();
+    }
+}
+
+RoomManager::Clock::time_point RoomManager::RunRoom(Room& room, Clock::time_point deadline)
+{
+    const Clock::time_point start = Now();
+    size_t count = 0;
+
+    {
+        std::lock_guard lock(room.mutex);
+        std::swap(room.inbox, room.batch);
+        count = std::exchange(room.inboxSize, 0);
+    }
+
+    uint64_t invalid = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        invalid += room.game->OnReceive(room.batch[i]) ? 0 : 1;
+    }
+
+    room.game->Tick();
+
+    const Clock::time_point end = Now();
+    const Clock::duration busy = end - start;
+    const Schedule schedule = ScheduleNext(
+        deadline,
+        start,
+        end,
+        room.game->GetParams().tickInterval,
+        mParams.tickBudget);
+
+    std::lock_guard lock(room.mutex);
+
+    RoomStats& stats = room.stats;
+    stats.ticks += 1;
+    stats.invalid += invalid;
+    stats.busyTime += busy;
+    stats.maxTickTime = std::max(stats.maxTickTime, busy);
+    stats.late += schedule.late ? 1 : 0;
+    stats.throttled += schedule.throttled ? 1 : 0;
+
+    return schedule.next;
+}
+
+RoomManager::Schedule RoomManager::ScheduleNext(
+    Clock::time_point deadline,
+    Clock::time_point start,
+    Clock::time_point end,
+    Clock::duration interval,
+    Clock::duration budget)
+{
+    const Clock::duration busy = end - start;
+
+    Schedule schedule;
+    schedule.next = std::max(deadline + interval, end);
+    schedule.late = start - deadline >= interval;
+    schedule.throttled = busy > budget;
+
+    if (schedule.throttled)
+    {
+        schedule.next = std::max(schedule.next, end + (busy - budget));
+    }
+
+    return schedule;
+}
+
+RoomManager::Room* RoomManager::FindRoom(uint32_t id) const
+{
+    auto it = mRoomIndex.find(id);
+    return it != mRoomIndex.end() ? mRooms[it->second].get() : nullptr;
+}
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "Game.h"
+#include "Network.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Common
+{
+// Runs many independent games, one per room, in a single process.
+//
+// The receive thread hands each datagram to its room by the room header
+// in front of it. A room only ever runs on one worker at a time, where it
+// first takes in what arrived since its last tick and then ticks, so a
+// Game never sees more than one thread. Workers pick whichever room is
+// due soonest, each room keeping the cadence of its own tick interval.
+//
+// Every run of a room is timed. A room whose tick goes over the budget has
+// its next tick pushed back by as much as it went over, so a hot room gets
+// fewer ticks instead of holding a worker from the rooms queued behind it.
+class RoomManager final
+{
+public:
+    RoomManager(const RoomManager&) = delete;
+    RoomManager& operator=(const RoomManager&) = delete;
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Params
+    {
+        // Threads running the rooms. With none the rooms only run from
+        // RunDue(), on the caller's thread.
+        uint32_t workers{ 4 };
+
+        // Time a room may spend on one tick, its received datagrams
+        // included, before its next tick is held back
+        std::chrono::microseconds tickBudget{ 5000 };
+
+        // Datagrams waiting for a room beyond which more are dropped
+        uint32_t maxInbox{ 1024 };
+
+        // Time the rooms are scheduled and timed by, Clock::now() when
+        // empty
+        std::function<Clock::time_point()> clock;
+    };
+
+    struct RoomStats
+    {
+        uint64_t ticks{ 0 };
+        uint64_t received{ 0 };
+        // Arrived while the inbox was full
+        uint64_t dropped{ 0 };
+        // Turned down by the game
+        uint64_t invalid{ 0 };
+        // Time spent running the room
+        Clock::duration busyTime{ 0 };
+        Clock::duration maxTickTime{ 0 };
+        // Started a whole interval or more behind its cadence
+        uint64_t late{ 0 };
+        // Went over budget and had the next tick held back
+        uint64_t throttled{ 0 };
+    };
+
+    // When a room runs next after a run from start to end which was due at
+    // deadline
+    struct Schedule
+    {
+        Clock::time_point next;
+        // Started a whole interval or more behind its cadence
+        bool late{ false };
+        // Went over budget and was held back by as much
+        bool throttled{ false };
+    };
+
+public:
+    explicit RoomManager(Params params);
+    ~RoomManager();
+
+    // Add a room running game and return its id. Ids start at 1 and rooms
+    // are all added before Start().
+    uint32_t CreateRoom(std::unique_ptr<Game> game);
+
+    void Start();
+
+    // Wait for the rooms running to finish their tick and stop the workers
+    void Stop();
+
+    // Run, once each, the rooms due by now on the calling thread. Only
+    // for a manager started without workers. Returns the rooms run.
+    size_t RunDue();
+
+    // Queue a datagram for the room it is addressed to. Datagrams without
+    // a room header go to the first room. Returns false if the datagram
+    // was dropped.
+    bool Route(const NetworkMessage& msg);
+
+    size_t GetRoomCount() const { return mRooms.size(); }
+
+    // Datagrams for rooms which do not exist
+    uint64_t GetUnrouted() const { return mUnrouted; }
+
+    RoomStats GetRoomStats(uint32_t room) const;
+
+    // Game of a room, to be touched only while stopped
+    Game* GetGame(uint32_t room) const;
+
+    void PrintStats() const;
+
+    // Keeps the cadence of interval from deadline, but a room which fell
+    // behind carries on from end rather than running the ticks it missed
+    // back to back, and one over budget is pushed back by as much
+    static Schedule ScheduleNext(
+        Clock::time_point deadline,
+        Clock::time_point start,
+        Clock::time_point end,
+        Clock::duration interval,
+        Clock::duration budget);
+
+private:
+    struct Room
+    {
+        uint32_t id{ 0 };
+        std::unique_ptr<Game> game;
+
+        // Guards the inbox and the stats
+        mutable std::mutex mutex;
+        // Filled by the receive thread. Swapped with the worker's batch so
+        // messages and their buffers are reused tick after tick.
+        std::vector<NetworkMessage> inbox;
+        size_t inboxSize{ 0 };
+        std::vector<NetworkMessage> batch;
+        RoomStats stats;
+    };
+
+    struct Due
+    {
+        Clock::time_point when;
+        uint32_t index{ 0 };
+
+        bool operator>(const Due& other) const { return when > other.when; }
+    };
+
+    void Work();
+
+    // Take in the room's datagrams and tick it. Returns when it is due
+    // next.
+    Clock::time_point RunRoom(Room& room, Clock::time_point deadline);
+
+    Room* FindRoom(uint32_t id) const;
+
+    Clock::time_point Now() const
+    {
+        return mParams.clock ? mParams.clock() : Clock::now();
+    }
+
+private:
+    Params mParams;
+    std::vector<std::unique_ptr<Room>> mRooms;
+    std::unordered_map<uint32_t, uint32_t> mRoomIndex;
+    std::atomic<uint64_t> mUnrouted{ 0 };
+
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    // Rooms not running, soonest due first
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> mDue;
+    bool mRunning{ false };
+};
+}
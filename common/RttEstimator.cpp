@@ -0,0 +1,78 @@
+#include "RttEstimator.h"
+
+#include <algorithm>
+
+namespace Common
+{
+void RttEstimator::AddSample(Clock::duration rtt)
+{
+    rtt = std::max(rtt, Clock::duration{ 0 });
+    mLatestRtt = rtt;
+
+    if (mSamples++ == 0)
+    {
+        mSmoothedRtt = rtt;
+        mRttVariance = rtt / 2;
+        mMinRtt = rtt;
+        return;
+    }
+
+    const Clock::duration error = rtt > mSmoothedRtt
+        ? rtt - mSmoothedRtt
+        : mSmoothedRtt - rtt;
+
+    // Variance first, it measures the error against the old average
+    mRttVariance += (error - mRttVariance) / 4;
+    mSmoothedRtt += (rtt - mSmoothedRtt) / 8;
+    mMinRtt = std::min(mMinRtt, rtt);
+}
+
+RttEstimator::Clock::duration RttEstimator::GetRto() const
+{
+    if (mSamples == 0)
+    {
+        return kInitialRto;
+    }
+
+    return std::clamp<Clock::duration>(
+        mSmoothedRtt + 4 * mRttVariance,
+        kMinRto,
+        kMaxRto);
+}
+
+bool ClockOffsetEstimator::AddSample(
+    uint32_t localSend,
+    uint32_t remoteReceive,
+    uint32_t remoteSend,
+    uint32_t localReceive)
+{
+    const int32_t elapsed = int32_t(localReceive - localSend);
+    const int32_t held = int32_t(remoteSend - remoteReceive);
+
+    if (elapsed < 0 || held < 0 || held > elapsed)
+    {
+        return false;
+    }
+
+    // Each leg's difference is the offset plus or minus its one way
+    // delay, their mean cancels the delays out when the legs are even
+    const uint32_t outbound = remoteReceive - localSend;
+    const uint32_t inbound = remoteSend - localReceive;
+    const uint32_t offset = outbound + uint32_t(int32_t(inbound - outbound) / 2);
+
+    mWindow[mNext] = Sample{ offset, uint32_t(elapsed - held) };
+    mNext = (mNext + 1) % kWindow;
+
+    const Sample& best = *std::min_element(mWindow.begin(), mWindow.end(),
+        [](const Sample& a, const Sample& b) { return a.rtt < b.rtt; });
+
+    if (mSamples++ == 0)
+    {
+        mOffset = best.offset;
+        return true;
+    }
+
+    mOffset += uint32_t(int32_t(best.offset - mOffset) / 8);
+    return true;
+}
+}
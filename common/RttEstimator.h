@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Common.h"
+
+#include <array>
+#include <chrono>
+
+namespace Common
+{
+// Smoothed round trip time and its mean deviation to one peer, kept the
+// way TCP keeps them (Jacobson/Karels), and the retransmission timeout
+// which follows from them.
+class RttEstimator final
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Timeout until the first sample arrives
+    static constexpr std::chrono::milliseconds kInitialRto{ 200 };
+
+    static constexpr std::chrono::milliseconds kMinRto{ 50 };
+    static constexpr std::chrono::milliseconds kMaxRto{ 2000 };
+
+public:
+    RttEstimator() = default;
+
+    void AddSample(Clock::duration rtt);
+
+    bool HasSample() const { return mSamples > 0; }
+    uint64_t GetSampleCount() const { return mSamples; }
+
+    // All zero until the first sample
+    Clock::duration GetSmoothedRtt() const { return mSmoothedRtt; }
+    Clock::duration GetRttVariance() const { return mRttVariance; }
+    Clock::duration GetMinRtt() const { return mMinRtt; }
+    Clock::duration GetLatestRtt() const { return mLatestRtt; }
+
+    // How long to wait for an acknowledgement before sending again
+    Clock::duration GetRto() const;
+
+private:
+    uint64_t mSamples{ 0 };
+    Clock::duration mSmoothedRtt{ 0 };
+    Clock::duration mRttVariance{ 0 };
+    Clock::duration mMinRtt{ 0 };
+    Clock::duration mLatestRtt{ 0 };
+};
+
+// Offset of a peer's clock from ours, from the four timestamps of a ping
+// exchange the way NTP takes them. Clocks are microsecond counters which
+// wrap, so offsets are kept modulo 2^32 as well.
+//
+// A sample taken over a slow round trip may be off by up to half of it,
+// so the estimate follows the sample with the fastest round trip among
+// the last few, moving a fraction of the way towards it each time.
+class ClockOffsetEstimator final
+{
+public:
+    // Samples the fastest round trip is picked from
+    static constexpr uint32_t kWindow = 8;
+
+public:
+    ClockOffsetEstimator() = default;
+
+    // Add an exchange: we sent at localSend, the peer received it at
+    // remoteReceive and answered at remoteSend, and the answer got back to
+    // us at localReceive. Returns false if the timestamps make no sense.
+    bool AddSample(
+        uint32_t localSend,
+        uint32_t remoteReceive,
+        uint32_t remoteSend,
+        uint32_t localReceive);
+
+    bool HasOffset() const { return mSamples > 0; }
+    uint64_t GetSampleCount() const { return mSamples; }
+
+    // Remote clock minus ours
+    uint32_t GetOffset() const { return mOffset; }
+
+    // Remote clock at the given local time
+    uint32_t ToRemote(uint32_t local) const { return local + mOffset; }
+
+private:
+    struct Sample
+    {
+        uint32_t offset{ 0 };
+        uint32_t rtt{ UINT32_MAX };
+    };
+
+    std::array<Sample, kWindow> mWindow{};
+    uint32_t mNext{ 0 };
+    uint64_t mSamples{ 0 };
+    uint32_t mOffset{ 0 };
+};
+}
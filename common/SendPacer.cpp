@@ -0,0 +1,195 @@
+#include "SendPacer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Common
+{
+namespace
+{
+// Sequences covered by one acknowledgement bitfield
+constexpr uint32_t kAckBits = 32;
+}
+
+SendPacer::SendPacer(uint32_t rate)
+    : mRate(std::clamp(rate, kMinRate, kMaxRate))
+{
+    mTokens = GetBucketSize();
+}
+
+double SendPacer::GetBucketSize() const
+{
+    using namespace std::chrono;
+
+    return std::max(
+        double(kNetworkBufferSize),
+        double(mRate) * duration<double>(kBurst).count());
+}
+
+void SendPacer::Refill(Clock::time_point now)
+{
+    using namespace std::chrono;
+
+    if (mLastRefill == Clock::time_point{})
+    {
+        mLastRefill = now;
+        return;
+    }
+
+    if (now > mLastRefill)
+    {
+        const double elapsed = duration<double>(now - mLastRefill).count();
+        mTokens = std::min(GetBucketSize(), mTokens + double(mRate) * elapsed);
+        mLastRefill = now;
+    }
+}
+
+void SendPacer::Push(uint32_t sequence, Span<const uint8_t> data, Clock::time_point now)
+{
+    if (!mQueue)
+    {
+        mQueue = std::make_unique<Packet[]>(kQueueCapacity);
+    }
+
+    if (mCount == kQueueCapacity)
+    {
+        mHead = (mHead + 1) % kQueueCapacity;
+        mCount -= 1;
+        mStats.dropped += 1;
+    }
+
+    Packet& packet = mQueue[(mHead + mCount) % kQueueCapacity];
+
+    if (packet.buffer.Capacity() < data.size)
+    {
+        packet.buffer = NetworkBuffer(std::max(kNetworkBufferSize, data.size));
+    }
+
+    memcpy(packet.buffer.Data(), data.data, data.size);
+    packet.buffer.SetOffset(data.size);
+    packet.sequence = sequence;
+    packet.queued = now;
+
+    mCount += 1;
+    mStats.maxQueue = std::max<size_t>(mStats.maxQueue, mCount);
+}
+
+const NetworkBuffer* SendPacer::Next(Clock::time_point now)
+{
+    if (mCount == 0)
+    {
+        return nullptr;
+    }
+
+    Refill(now);
+
+    // A packet may take the bucket into debt, which later packets wait
+    // out, so datagrams larger than the bucket still go
+    return mTokens > 0.0 ? &mQueue[mHead].buffer : nullptr;
+}
+
+void SendPacer::Pop(Clock::time_point now)
+{
+    assert(mCount > 0);
+
+    Packet& packet = mQueue[mHead];
+    const size_t size = packet.buffer.Size();
+
+    mTokens -= double(size);
+
+    if (now > packet.queued)
+    {
+        const Clock::duration delay = now - packet.queued;
+
+        mStats.delayed += 1;
+        mStats.totalDelay += delay;
+        mStats.maxDelay = std::max(mStats.maxDelay, delay);
+    }
+
+    mStats.sent += 1;
+    mStats.bytesSent += size;
+
+    mSent[packet.sequence % kHistory] = Sent{ packet.sequence, true };
+
+    mHead = (mHead + 1) % kQueueCapacity;
+    mCount -= 1;
+}
+
+void SendPacer::OnAck(
+    uint32_t ack,
+    uint32_t ackBits,
+    const RttEstimator& rtt,
+    Clock::time_point now)
+{
+    // Only acknowledgements which moved forward say anything new
+    if (mHasAck && int32_t(ack - mLastAck) <= 0)
+    {
+        return;
+    }
+
+    const uint32_t first = mHasAck && ack - mLastAck <= kAckBits
+        ? mLastAck + 1
+        : ack - kAckBits;
+
+    mHasAck = true;
+    mLastAck = ack;
+
+    uint32_t delivered = 0;
+    uint32_t lost = 0;
+
+    for (uint32_t sequence = first; sequence != ack + 1; ++sequence)
+    {
+        Sent& sent = mSent[sequence % kHistory];
+
+        if (!sent.pending || sent.sequence != sequence)
+        {
+            continue;
+        }
+
+        sent.pending = false;
+
+        const uint32_t behind = ack - sequence;
+
+        if (behind == 0 || (ackBits & (1u << (behind - 1))))
+        {
+            delivered += 1;
+        }
+        else
+        {
+            lost += 1;
+        }
+    }
+
+    mStats.delivered += delivered;
+    mStats.lost += lost;
+
+    const bool queueing = rtt.HasSample()
+        && rtt.GetSmoothedRtt() - rtt.GetMinRtt() > kMaxQueueingDelay;
+
+    if (lost > 0 || queueing)
+    {
+        Decrease(rtt, now);
+    }
+    else if (delivered > 0)
+    {
+        mRate = std::min(kMaxRate, mRate + kRateIncrease);
+    }
+}
+
+void SendPacer::Decrease(const RttEstimator& rtt, Clock::time_point now)
+{
+    // Once per round trip, the feedback for packets sent at the old rate
+    // is still on its way
+    const Clock::duration interval = std::max<Clock::duration>(rtt.GetSmoothedRtt(), kBurst);
+
+    if (mLastDecrease != Clock::time_point{} && now - mLastDecrease < interval)
+    {
+        return;
+    }
+
+    mRate = std::max(kMinRate, mRate / 4 * 3);
+    mTokens = std::min(mTokens, GetBucketSize());
+    mLastDecrease = now;
+    mStats.decreases += 1;
+}
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Common.h"
+#include "Network.h"
+#include "RttEstimator.h"
+
+#include <array>
+#include <chrono>
+#include <memory>
+
+namespace Common
+{
+// Paces the packets sent to one client through a token bucket, so a burst
+// of state waits its turn here instead of overflowing the queues on a
+// slow link.
+//
+// The bucket refills at an estimated rate which adapts to what the client
+// acknowledges. Losses, or a smoothed round trip that climbs well above
+// the lowest seen, cut the rate at most once per round trip. Feedback with
+// neither raises it a step at a time. Round trips come from the client's
+// RttEstimator. Packets which find no room wait in a bounded queue, the
+// oldest is dropped when it is full.
+class SendPacer final
+{
+public:
+    SendPacer(const SendPacer&) = delete;
+    SendPacer& operator=(const SendPacer&) = delete;
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Rate bounds and starting point in bytes per second
+    static constexpr uint32_t kMinRate = 8 * 1024;
+    static constexpr uint32_t kMaxRate = 1024 * 1024;
+    static constexpr uint32_t kInitialRate = 64 * 1024;
+
+    // Rate added for each feedback without loss or delay
+    static constexpr uint32_t kRateIncrease = 2 * 1024;
+
+    // Smoothed round trip above the lowest one at which the link is taken
+    // to be queueing
+    static constexpr std::chrono::milliseconds kMaxQueueingDelay{ 50 };
+
+    // Time worth of tokens the bucket holds, at least a full datagram
+    static constexpr std::chrono::milliseconds kBurst{ 50 };
+
+    static constexpr uint32_t kQueueCapacity = 32;
+
+    // Sent packets remembered for acknowledgements
+    static constexpr uint32_t kHistory = 64;
+
+    struct Stats
+    {
+        uint64_t sent{ 0 };
+        uint64_t bytesSent{ 0 };
+        // Packets which waited in the queue before going out
+        uint64_t delayed{ 0 };
+        Clock::duration totalDelay{ 0 };
+        Clock::duration maxDelay{ 0 };
+        // Pushed out of a full queue
+        uint64_t dropped{ 0 };
+        size_t maxQueue{ 0 };
+        uint64_t delivered{ 0 };
+        uint64_t lost{ 0 };
+        uint64_t decreases{ 0 };
+    };
+
+public:
+    explicit SendPacer(uint32_t rate = kInitialRate);
+    SendPacer(SendPacer&&) = default;
+    SendPacer& operator=(SendPacer&&) = default;
+
+    // Queue the packet with this sequence to go out once the bucket
+    // allows it
+    void Push(uint32_t sequence, Span<const uint8_t> data, Clock::time_point now);
+
+    // The oldest queued packet if the bucket has room for it now, null
+    // otherwise. Call Pop() once it has been sent.
+    const NetworkBuffer* Next(Clock::time_point now);
+
+    // Take the packet handed out by Next() once it was sent
+    void Pop(Clock::time_point now);
+
+    // The client's acknowledgements: the newest sequence it has and a bit
+    // for each of the 32 before it
+    void OnAck(
+        uint32_t ack,
+        uint32_t ackBits,
+        const RttEstimator& rtt,
+        Clock::time_point now);
+
+    uint32_t GetRate() const { return mRate; }
+    size_t GetQueueDepth() const { return mCount; }
+    bool IsEmpty() const { return mCount == 0; }
+
+    const Stats& GetStats() const { return mStats; }
+
+private:
+    struct Packet
+    {
+        uint32_t sequence{ 0 };
+        NetworkBuffer buffer{ 0 };
+        Clock::time_point queued;
+    };
+
+    struct Sent
+    {
+        uint32_t sequence{ 0 };
+        // Cleared once the acknowledgements have covered it
+        bool pending{ false };
+    };
+
+    void Refill(Clock::time_point now);
+    void Decrease(const RttEstimator& rtt, Clock::time_point now);
+    double GetBucketSize() const;
+
+private:
+    uint32_t mRate;
+    double mTokens{ 0.0 };
+    Clock::time_point mLastRefill;
+    Clock::time_point mLastDecrease;
+
+    // Allocated on the first packet, each slot keeps its buffer
+    std::unique_ptr<Packet[]> mQueue;
+    uint32_t mHead{ 0 };
+    uint32_t mCount{ 0 };
+
+    std::array<Sent, kHistory> mSent{};
+    bool mHasAck{ false };
+    uint32_t mLastAck{ 0 };
+
+    Stats mStats;
+};
+}
@@ -88,6 +88,32 @@ bool UdpServer::Initialize()
     return true;
 }
 
+bool UdpServer::StartCapture(const std::string& path)
+{
+    std::lock_guard lock(mMutex);
+
+    auto capture = std::make_unique<CaptureWriter>();
+
+    if (!capture->Open(path))
+    {
+        return false;
+    }
+
+    mCapture = std::move(capture);
+    return true;
+}
+
+void UdpServer::StopCapture()
+{
+    std::lock_guard lock(mMutex);
+
+    if (mCapture)
+    {
+        mCapture->Close();
+        mCapture.reset();
+    }
+}
+
 void UdpServer::OnRecv(RecvFn fn)
 {
     mRecvFn = std::move(fn);
@@ -110,6 +136,10 @@ void UdpServer::Run(
 
     steady_clock::time_point lastTick;
 
+    // A single receive buffer is reused for every datagram. The game
+    // decodes what it needs during the callback and keeps no reference.
+    NetworkMessage msg;
+
     std::cout << "UDP Server running on '" << mAddress << ':' << mPort << "'\n";
     SCOPE_GUARD([] { std::cout << "UDP Server stopped\n"; });
 
@@ -171,8 +201,6 @@ void UdpServer::Run(
                 {
                     // We have something available on the on the socket to
                     // read from.
-                    NetworkMessage msg;
-
                     SockAddrStorage storage = { 0 };
                     auto* address = reinterpret_cast<sockaddr*>(storage.data());
                     int socklen = int(storage.size());
@@ -217,6 +245,17 @@ void UdpServer::Run(
                     msg.address = AddressToString(&add4->sin_addr);
                     msg.port = ntohs(add4->sin_port);
 
+                    if (mCapture)
+                    {
+                        // Recorded as received, the buffer is reused for the next
+                        // datagram once the callback returns
+                        mCapture->Append(
+                            steady_clock::now(),
+                            reinterpret_cast<const uint8_t*>(&add4->sin_addr),
+                            msg.port,
+                            { msg.buffer.Data(), msg.buffer.Size() });
+                    }
+
                     mRecvFn(msg);
                 }
             }
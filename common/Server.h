@@ -1,11 +1,13 @@
 #pragma once
 
+#include "Capture.h"
 #include "Network.h"
 
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -28,6 +30,10 @@ public:
         std::function<bool()> tick);
     void Shutdown();
 
+    // Record every received datagram to a capture file for later replay
+    bool StartCapture(const std::string& path);
+    void StopCapture();
+
 public:
     using RecvFn = std::function<void(Common::NetworkMessage&)>;
 
@@ -49,5 +55,6 @@ private:
 
 private:
     RecvFn mRecvFn;
+    std::unique_ptr<CaptureWriter> mCapture;
 };
 }
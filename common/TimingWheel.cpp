@@ -0,0 +1,211 @@
+#include "TimingWheel.h"
+
+#include <algorithm>
+
+namespace Common
+{
+TimingWheel::TimingWheel(uint64_t now)
+    : mNow(now)
+{
+    mLists.fill(kNone);
+}
+
+uint32_t TimingWheel::GetList(uint64_t when) const
+{
+    // The lowest level whose slot span still holds both now and when
+    for (uint32_t level = 0; level < kLevels; ++level)
+    {
+        const uint32_t shift = kSlotBits * (level + 1);
+
+        if ((when >> shift) == (mNow >> shift))
+        {
+            const uint32_t slot = uint32_t(when >> (kSlotBits * level)) & (kSlots - 1);
+            return level * kSlots + slot;
+        }
+    }
+
+    return kOverflowList;
+}
+
+void TimingWheel::Link(uint32_t index)
+{
+    Node& node = mNodes[index];
+    const uint32_t list = GetList(node.when);
+
+    node.list = list;
+    mLevelSizes[list / kSlots] += 1;
+    node.prev = kNone;
+    node.next = mLists[list];
+
+    if (node.next != kNone)
+    {
+        mNodes[node.next].prev = index;
+    }
+    mLists[list] = index;
+}
+
+void TimingWheel::Unlink(uint32_t index)
+{
+    Node& node = mNodes[index];
+
+    if (node.prev != kNone)
+    {
+        mNodes[node.prev].next = node.next;
+    }
+    else
+    {
+        mLists[node.list] = node.next;
+    }
+
+    if (node.next != kNone)
+    {
+        mNodes[node.next].prev = node.prev;
+    }
+
+    mLevelSizes[node.list / kSlots] -= 1;
+    node.prev = kNone;
+    node.next = kNone;
+}
+
+void TimingWheel::Free(uint32_t index)
+{
+    Node& node = mNodes[index];
+    node.list = kNone;
+    node.generation += 1;
+
+    mFreeNodes.push_back(index);
+    mSize -= 1;
+}
+
+TimerHandle TimingWheel::Schedule(uint64_t when, Timer timer)
+{
+    uint32_t index = uint32_t(mNodes.size());
+
+    if (!mFreeNodes.empty())
+    {
+        index = mFreeNodes.back();
+        mFreeNodes.pop_back();
+    }
+    else
+    {
+        mNodes.emplace_back();
+    }
+
+    Node& node = mNodes[index];
+    node.when = std::max(when, mNow + 1);
+    node.timer = timer;
+    Link(index);
+
+    mSize += 1;
+    return TimerHandle{ index, node.generation };
+}
+
+bool TimingWheel::IsPending(TimerHandle handle) const
+{
+    return handle.index < mNodes.size()
+        && mNodes[handle.index].generation == handle.generation
+        && mNodes[handle.index].list != kNone;
+}
+
+bool TimingWheel::Reschedule(TimerHandle handle, uint64_t when)
+{
+    if (!IsPending(handle))
+    {
+        return false;
+    }
+
+    Unlink(handle.index);
+    mNodes[handle.index].when = std::max(when, mNow + 1);
+    Link(handle.index);
+    return true;
+}
+
+bool TimingWheel::Cancel(TimerHandle handle)
+{
+    if (!IsPending(handle))
+    {
+        return false;
+    }
+
+    Unlink(handle.index);
+    Free(handle.index);
+    return true;
+}
+
+void TimingWheel::Cascade(uint32_t list)
+{
+    uint32_t index = mLists[list];
+    mLists[list] = kNone;
+
+    while (index != kNone)
+    {
+        const uint32_t next = mNodes[index].next;
+        mLevelSizes[list / kSlots] -= 1;
+        Link(index);
+        index = next;
+    }
+}
+
+Span<const TimingWheel::Timer> TimingWheel::Advance(uint64_t now)
+{
+    mExpired.clear();
+
+    while (mNow < now)
+    {
+        if (mSize == 0)
+        {
+            // Nothing to find on the way
+            mNow = now;
+            break;
+        }
+
+        // Nothing below the lowest occupied level can fire or cascade
+        // before that level's next slot boundary, so go straight there.
+        uint32_t level = 0;
+        while (level < kLevels && mLevelSizes[level] == 0)
+        {
+            ++level;
+        }
+
+        if (level > 0)
+        {
+            const uint64_t span = uint64_t(1) << (kSlotBits * level);
+            mNow = std::max(mNow, std::min(mNow | (span - 1), now - 1));
+        }
+
+        mNow += 1;
+
+        // Bring down the timers of every level which just turned over,
+        // highest first so they can keep falling to the level below.
+        if ((mNow & ((uint64_t(1) << (kSlotBits * kLevels)) - 1)) == 0)
+        {
+            Cascade(kOverflowList);
+        }
+
+        for (uint32_t level = kLevels - 1; level > 0; --level)
+        {
+            const uint32_t shift = kSlotBits * level;
+
+            if ((mNow & ((uint64_t(1) << shift) - 1)) == 0)
+            {
+                Cascade(level * kSlots + (uint32_t(mNow >> shift) & (kSlots - 1)));
+            }
+        }
+
+        const uint32_t list = uint32_t(mNow) & (kSlots - 1);
+        uint32_t index = mLists[list];
+        mLists[list] = kNone;
+
+        while (index != kNone)
+        {
+            const uint32_t next = mNodes[index].next;
+            mExpired.push_back(mNodes[index].timer);
+            mLevelSizes[0] -= 1;
+            Free(index);
+            index = next;
+        }
+    }
+
+    return { mExpired.data(), mExpired.size() };
+}
+}
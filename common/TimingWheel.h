@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Common.h"
+
+#include <array>
+#include <vector>
+
+namespace Common
+{
+// Reference to a timer in a TimingWheel. Like a PlayerHandle the
+// generation changes when the timer fires or is cancelled, so an old
+// handle can never touch a timer which reused its node.
+struct TimerHandle
+{
+    static constexpr uint32_t kInvalidIndex{ UINT32_MAX };
+
+    uint32_t index{ kInvalidIndex };
+    uint32_t generation{ 0 };
+
+    explicit operator bool() const { return index != kInvalidIndex; }
+};
+
+// Hierarchical timing wheel holding one-shot timers.
+//
+// Time is a plain counter, the owner decides the unit. Each level has 64
+// slots and each slot one level up spans the whole level below, so four
+// levels reach 2^24 units ahead. Timers further away wait in an overflow
+// list which is looked at again each time the top level turns over.
+// Every timer lives in an intrusive list so scheduling, rescheduling and
+// cancelling are constant time, and advancing skips over the parts of the
+// wheel which are empty.
+class TimingWheel final
+{
+public:
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+public:
+    static constexpr uint32_t kSlotBits = 6;
+    static constexpr uint32_t kSlots = 1 << kSlotBits;
+    static constexpr uint32_t kLevels = 4;
+
+    // What the owner asked to be told about, handed back on expiry
+    struct Timer
+    {
+        uint32_t kind{ 0 };
+        uint64_t data{ 0 };
+    };
+
+public:
+    explicit TimingWheel(uint64_t now = 0);
+
+    uint64_t GetTime() const { return mNow; }
+
+    // Timers waiting to fire
+    size_t Size() const { return mSize; }
+
+    // Fire at when, or on the next advance if when has already passed
+    TimerHandle Schedule(uint64_t when, Timer timer);
+
+    // Move a pending timer. Returns false if it already fired or was
+    // cancelled.
+    bool Reschedule(TimerHandle handle, uint64_t when);
+
+    bool Cancel(TimerHandle handle);
+    bool IsPending(TimerHandle handle) const;
+
+    // Move time forward to now and return every timer which came due,
+    // earliest first. The span is valid until the next call.
+    Span<const Timer> Advance(uint64_t now);
+
+private:
+    static constexpr uint32_t kNone{ UINT32_MAX };
+    static constexpr uint32_t kOverflowList{ kLevels * kSlots };
+
+    struct Node
+    {
+        uint64_t when{ 0 };
+        Timer timer;
+        uint32_t prev{ kNone };
+        uint32_t next{ kNone };
+        // Slot list holding the node, kNone when free
+        uint32_t list{ kNone };
+        uint32_t generation{ 0 };
+    };
+
+    uint32_t GetList(uint64_t when) const;
+    void Link(uint32_t index);
+    void Unlink(uint32_t index);
+    void Free(uint32_t index);
+
+    // Place every timer of a list again, once time has reached the slot
+    void Cascade(uint32_t list);
+
+private:
+    uint64_t mNow{ 0 };
+    size_t mSize{ 0 };
+    std::vector<Node> mNodes;
+    std::vector<uint32_t> mFreeNodes;
+    // Head node of every slot list, level by level, then the overflow
+    std::array<uint32_t, kLevels * kSlots + 1> mLists;
+    // Timers held by each level and the overflow, so advancing can skip
+    // over stretches where the lower levels are empty
+    std::array<size_t, kLevels + 1> mLevelSizes{};
+    std::vector<Timer> mExpired;
+};
+}
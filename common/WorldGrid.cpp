@@ -0,0 +1,148 @@
+#include "WorldGrid.h"
+
+namespace Common
+{
+WorldGrid::WorldGrid(uint32_t width, uint32_t height, Backend backend)
+    : mWidth(width)
+    , mHeight(height)
+    , mBackend(backend)
+{
+    if (mBackend == Backend::Dense)
+    {
+        mCells = std::make_unique<PositionState[]>(size_t(width) * height);
+
+        for (uint32_t i = 0; i < mHeight; ++i)
+        {
+            for (uint32_t j = 0; j < mWidth; ++j)
+            {
+                mCells[size_t(i) * mWidth + j].pos = Position{ j, i };
+            }
+        }
+    }
+}
+
+WorldGrid::~WorldGrid()
+{ }
+
+WorldGrid::Tile& WorldGrid::GetTile(uint32_t x, uint32_t y)
+{
+    auto [it, inserted] = mTiles.try_emplace(TileKey(x, y));
+
+    if (inserted)
+    {
+        if (!mSpareTiles.empty())
+        {
+            it->second = std::move(mSpareTiles.back());
+            mSpareTiles.pop_back();
+        }
+        else
+        {
+            it->second = std::make_unique<Tile>();
+        }
+
+        const uint32_t left = x & ~(kTileSize - 1);
+        const uint32_t top = y & ~(kTileSize - 1);
+
+        for (uint32_t i = 0; i < kTileSize; ++i)
+        {
+            for (uint32_t j = 0; j < kTileSize; ++j)
+            {
+                it->second->cells[i * kTileSize + j].pos = Position{ left + j, top + i };
+            }
+        }
+    }
+
+    return *it->second;
+}
+
+PositionState* WorldGrid::Get(uint32_t x, uint32_t y)
+{
+    assert(IsValid(x, y));
+
+    if (mBackend == Backend::Dense)
+    {
+        return &mCells[size_t(y) * mWidth + x];
+    }
+
+    return &GetTile(x, y).cells[CellIndex(x, y)];
+}
+
+const PositionState* WorldGrid::Find(uint32_t x, uint32_t y) const
+{
+    assert(IsValid(x, y));
+
+    if (mBackend == Backend::Dense)
+    {
+        return &mCells[size_t(y) * mWidth + x];
+    }
+
+    if (auto it = mTiles.find(TileKey(x, y)); it != mTiles.end())
+    {
+        return &it->second->cells[CellIndex(x, y)];
+    }
+    return nullptr;
+}
+
+Player* WorldGrid::GetPlayer(uint32_t x, uint32_t y) const
+{
+    const PositionState* cell = Find(x, y);
+    return cell ? cell->player : nullptr;
+}
+
+void WorldGrid::SetPlayer(uint32_t x, uint32_t y, Player* player)
+{
+    assert(IsValid(x, y));
+
+    if (mBackend == Backend::Dense)
+    {
+        mCells[size_t(y) * mWidth + x].player = player;
+        return;
+    }
+
+    if (!player)
+    {
+        auto it = mTiles.find(TileKey(x, y));
+
+        if (it == mTiles.end())
+        {
+            return;
+        }
+
+        Tile& tile = *it->second;
+        PositionState& cell = tile.cells[CellIndex(x, y)];
+
+        if (cell.player)
+        {
+            cell.player = nullptr;
+
+            if (--tile.occupied == 0)
+            {
+                if (mSpareTiles.size() < kMaxSpareTiles)
+                {
+                    mSpareTiles.push_back(std::move(it->second));
+                }
+                mTiles.erase(it);
+            }
+        }
+        return;
+    }
+
+    Tile& tile = GetTile(x, y);
+    PositionState& cell = tile.cells[CellIndex(x, y)];
+
+    if (!cell.player)
+    {
+        tile.occupied += 1;
+    }
+    cell.player = player;
+}
+
+size_t WorldGrid::GetMemoryUsage() const
+{
+    if (mBackend == Backend::Dense)
+    {
+        return size_t(mWidth) * mHeight * sizeof(PositionState);
+    }
+    return (mTiles.size() + mSpareTiles.size()) * sizeof(Tile);
+}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Common.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Common
+{
+struct PositionState
+{
+    // Position in the game
+    Position pos;
+    // Player at this poistion (if one is currently there)
+    Player* player{ nullptr };
+};
+
+// Storage for the cells of the game board.
+//
+// The Dense backend allocates and initializes every cell up front, which
+// is the fastest lookup but needs width * height cells of memory. The
+// Chunked backend splits the board into kTileSize x kTileSize tiles which
+// are only allocated when a cell in them is first used, and freed again
+// when the last player leaves, so memory follows the occupied area rather
+// than the size of the map.
+class WorldGrid final
+{
+public:
+    WorldGrid(const WorldGrid&) = delete;
+    WorldGrid& operator=(const WorldGrid&) = delete;
+
+public:
+    enum class Backend : uint32_t
+    {
+        Dense = 0,
+        Chunked
+    };
+
+    // Width and height of a tile in cells
+    static constexpr uint32_t kTileBits = 6;
+    static constexpr uint32_t kTileSize = 1 << kTileBits;
+
+    // Number of freed tiles kept around instead of being released
+    static constexpr size_t kMaxSpareTiles = 4;
+
+public:
+    WorldGrid(uint32_t width, uint32_t height, Backend backend);
+    ~WorldGrid();
+
+    Backend GetBackend() const { return mBackend; }
+
+    bool IsValid(uint32_t x, uint32_t y) const
+    {
+        return x < mWidth && y < mHeight;
+    }
+
+    // Cell at x, y. The Chunked backend allocates the tile holding the
+    // cell if needed. The pointer stays valid until the tile is freed by
+    // SetPlayer() removing its last player.
+    PositionState* Get(uint32_t x, uint32_t y);
+
+    // Cell at x, y or nullptr if its tile has not been allocated. Never
+    // allocates.
+    const PositionState* Find(uint32_t x, uint32_t y) const;
+
+    Player* GetPlayer(uint32_t x, uint32_t y) const;
+
+    // Place a player in a cell, or clear it with nullptr. Keeps the
+    // per-tile occupancy counts used to free empty tiles.
+    void SetPlayer(uint32_t x, uint32_t y, Player* player);
+
+    size_t GetTileCount() const { return mTiles.size(); }
+
+    // Bytes of cell storage currently allocated, including spare tiles
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Tile
+    {
+        uint32_t occupied{ 0 };
+        PositionState cells[kTileSize * kTileSize];
+    };
+
+    // Tile holding x, y, allocated on first use
+    Tile& GetTile(uint32_t x, uint32_t y);
+
+    static uint64_t TileKey(uint32_t x, uint32_t y)
+    {
+        return (uint64_t(y >> kTileBits) << 32) | (x >> kTileBits);
+    }
+
+    static size_t CellIndex(uint32_t x, uint32_t y)
+    {
+        return size_t(y & (kTileSize - 1)) * kTileSize + (x & (kTileSize - 1));
+    }
+
+private:
+    uint32_t mWidth{ 0 };
+    uint32_t mHeight{ 0 };
+    Backend mBackend{ Backend::Dense };
+
+    // Dense backend
+    std::unique_ptr<PositionState[]> mCells;
+
+    // Chunked backend
+    std::unordered_map<uint64_t, std::unique_ptr<Tile>> mTiles;
+    // Recently freed tiles kept for reuse so a player moving back and forth
+    // across a tile edge does not allocate every time.
+    std::vector<std::unique_ptr<Tile>> mSpareTiles;
+};
+}
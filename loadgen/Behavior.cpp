@@ -0,0 +1,172 @@
+#include "Behavior.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace LoadGen
+{
+namespace
+{
+// xorshift32, every simulated client carries its own state so a run with
+// the same seed makes the same moves
+uint32_t NextRandom(uint32_t& state)
+{
+    uint32_t x = state ? state : 0x9E3779B9u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state = x;
+    return x;
+}
+}
+
+std::optional<Behavior> Behavior::Parse(const std::string& script)
+{
+    using namespace Common;
+
+    Behavior behavior;
+    behavior.mScript = script;
+
+    for (char c : script)
+    {
+        Entry entry;
+
+        switch (c)
+        {
+        case 'U':
+            entry = { Step::Move, Movement::Up };
+            break;
+        case 'D':
+            entry = { Step::Move, Movement::Down };
+            break;
+        case 'L':
+            entry = { Step::Move, Movement::Left };
+            break;
+        case 'R':
+            entry = { Step::Move, Movement::Right };
+            break;
+        case '?':
+            entry.step = Step::Random;
+            break;
+        case '.':
+            entry.step = Step::Wait;
+            break;
+        default:
+            return std::nullopt;
+        }
+
+        behavior.mSteps.push_back(entry);
+    }
+
+    if (behavior.mSteps.empty())
+    {
+        return std::nullopt;
+    }
+
+    return behavior;
+}
+
+bool Behavior::GetMovement(size_t index, uint32_t& rng, Common::Movement& movement) const
+{
+    const Entry& entry = mSteps[index % mSteps.size()];
+
+    switch (entry.step)
+    {
+    case Step::Move:
+        movement = entry.movement;
+        return true;
+    case Step::Random:
+        movement = Common::Movement(NextRandom(rng) % 4);
+        return true;
+    case Step::Wait:
+    default:
+        return false;
+    }
+}
+
+std::optional<RampProfile> RampProfile::Parse(const std::string& profile)
+{
+    RampProfile ramp;
+    size_t start = 0;
+
+    while (start <= profile.size())
+    {
+        size_t end = profile.find(',', start);
+        if (end == std::string::npos)
+        {
+            end = profile.size();
+        }
+
+        const std::string stage = profile.substr(start, end - start);
+        const size_t at = stage.find('@');
+
+        if (at == std::string::npos || at == 0 || at + 1 == stage.size())
+        {
+            return std::nullopt;
+        }
+
+        char* clientsEnd = nullptr;
+        char* timeEnd = nullptr;
+        const unsigned long clients = strtoul(stage.c_str(), &clientsEnd, 10);
+        const double seconds = strtod(stage.c_str() + at + 1, &timeEnd);
+
+        if (clientsEnd != stage.c_str() + at || *timeEnd != '\0' || seconds < 0.0)
+        {
+            return std::nullopt;
+        }
+
+        const std::chrono::milliseconds time{ int64_t(seconds * 1000.0) };
+
+        if (!ramp.mStages.empty() && time < ramp.mStages.back().time)
+        {
+            return std::nullopt;
+        }
+
+        ramp.mStages.push_back({ uint32_t(clients), time });
+        start = end + 1;
+    }
+
+    return ramp;
+}
+
+uint32_t RampProfile::GetClients(std::chrono::steady_clock::duration elapsed) const
+{
+    using namespace std::chrono;
+
+    const double now = duration<double, std::milli>(elapsed).count();
+
+    uint32_t fromClients = 0;
+    double fromTime = 0.0;
+
+    for (const Stage& stage : mStages)
+    {
+        const double toTime = double(stage.time.count());
+
+        if (now < toTime)
+        {
+            const double t = (now - fromTime) / (toTime - fromTime);
+            return uint32_t(double(fromClients) + (double(stage.clients) - double(fromClients)) * t);
+        }
+
+        fromClients = stage.clients;
+        fromTime = toTime;
+    }
+
+    return fromClients;
+}
+
+uint32_t RampProfile::GetMaxClients() const
+{
+    uint32_t clients = 0;
+    for (const Stage& stage : mStages)
+    {
+        clients = std::max(clients, stage.clients);
+    }
+    return clients;
+}
+
+std::chrono::milliseconds RampProfile::GetDuration() const
+{
+    return mStages.empty() ? std::chrono::milliseconds(0) : mStages.back().time;
+}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Common.h"
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace LoadGen
+{
+// What a simulated client does once it is logged in, one step a tick,
+// going round the script for as long as it runs. 'U', 'D', 'L' and 'R'
+// move a cell, '?' moves a random way and '.' waits, so "RRRR...." walks
+// right and rests while "?" wanders every tick and "." only pings.
+class Behavior final
+{
+public:
+    enum class Step : uint8_t
+    {
+        Wait,
+        Move,
+        Random
+    };
+
+public:
+    // Returns nothing if the script is empty or has an unknown step
+    static std::optional<Behavior> Parse(const std::string& script);
+
+    const std::string& GetScript() const { return mScript; }
+    size_t Size() const { return mSteps.size(); }
+
+    // Movement for step index of the script, false when the step waits.
+    // Random steps draw from rng.
+    bool GetMovement(size_t index, uint32_t& rng, Common::Movement& movement) const;
+
+private:
+    struct Entry
+    {
+        Step step{ Step::Wait };
+        Common::Movement movement{ Common::Movement::Up };
+    };
+
+    std::string mScript;
+    std::vector<Entry> mSteps;
+};
+
+// How many clients should be running over time. Stages are reached one
+// after the other in a straight line from the one before, starting from no
+// clients, so "100@10,100@20,500@30" climbs to 100 clients over ten
+// seconds, holds them for ten and climbs to 500 over the next ten.
+class RampProfile final
+{
+public:
+    struct Stage
+    {
+        uint32_t clients{ 0 };
+        std::chrono::milliseconds time{ 0 };
+    };
+
+public:
+    // Stages as "<clients>@<seconds>" separated by commas, with times
+    // which never go backwards. Returns nothing if it does not parse.
+    static std::optional<RampProfile> Parse(const std::string& profile);
+
+    // Clients which should be running elapsed into the run
+    uint32_t GetClients(std::chrono::steady_clock::duration elapsed) const;
+
+    uint32_t GetMaxClients() const;
+
+    // Time the last stage is reached at
+    std::chrono::milliseconds GetDuration() const;
+
+    const std::vector<Stage>& GetStages() const { return mStages; }
+
+private:
+    std::vector<Stage> mStages;
+};
+}
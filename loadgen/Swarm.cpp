@@ -0,0 +1,481 @@
+#include "Swarm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include <mswsock.h>
+
+namespace LoadGen
+{
+namespace
+{
+// Room for the state and acknowledgements of a tick, a simulated client
+// hears from nobody else
+constexpr uint32_t kMaxEventsPerTick = 64;
+
+// Every client's state lands on the same few sockets at once each tick
+constexpr int kReceiveBufferSize = 4 * 1024 * 1024;
+
+uint64_t Micros(std::chrono::steady_clock::duration d)
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+}
+}
+
+void Swarm::Histogram::Add(std::chrono::steady_clock::duration sample)
+{
+    mSamples.push_back(uint32_t(std::min<uint64_t>(Micros(sample), UINT32_MAX)));
+    mSorted = false;
+}
+
+uint32_t Swarm::Histogram::GetPercentile(double p) const
+{
+    if (mSamples.empty())
+    {
+        return 0;
+    }
+
+    if (!mSorted)
+    {
+        std::sort(mSamples.begin(), mSamples.end());
+        mSorted = true;
+    }
+
+    // Nearest rank
+    const size_t rank = size_t(std::ceil(std::clamp(p, 0.0, 1.0) * double(mSamples.size())));
+    return mSamples[std::max<size_t>(rank, 1) - 1];
+}
+
+uint32_t Swarm::Histogram::GetMax() const
+{
+    return GetPercentile(1.0);
+}
+
+Swarm::Swarm(Params params)
+    : mParams(std::move(params))
+{
+    assert(mParams.sockets > 0);
+    assert(mParams.tickInterval.count() > 0);
+
+    if (mParams.behaviors.empty())
+    {
+        mParams.behaviors.push_back(*Behavior::Parse("?"));
+    }
+}
+
+Swarm::~Swarm()
+{
+    for (Common::Socket sock : mSockets)
+    {
+        ::closesocket(sock);
+    }
+}
+
+bool Swarm::Initialize()
+{
+    using namespace Common;
+
+    for (uint32_t i = 0; i < mParams.sockets; ++i)
+    {
+        const uint32_t port = mParams.basePort + i;
+
+        Socket sock = WSASocketW(AF_INET, SOCK_DGRAM, IPPROTO_UDP, nullptr, 0, 0);
+
+        if (sock == kInvalidSocket)
+        {
+            const int err = WSAGetLastError();
+
+            std::cout << "Failed to create swarm socket: [" << err << "] "
+                << ErrorToString(err) << '\n';
+            return false;
+        }
+
+        mSockets.push_back(sock);
+
+        if (!SetNonBlocking(sock))
+        {
+            const int err = WSAGetLastError();
+
+            std::cout << "Failed to set non-blocking on swarm socket '" << sock
+                << "': [" << err << "] " << ErrorToString(err) << '\n';
+            return false;
+        }
+
+        // Tells which client a datagram is for
+        DWORD enable = 1;
+        if (setsockopt(sock, IPPROTO_IP, IP_PKTINFO,
+            reinterpret_cast<const char*>(&enable), sizeof(enable)) == SOCKET_ERROR)
+        {
+            const int err = WSAGetLastError();
+
+            std::cout << "Failed to enable IP_PKTINFO on swarm socket '" << sock
+                << "': [" << err << "] " << ErrorToString(err) << '\n';
+            return false;
+        }
+
+        if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF,
+            reinterpret_cast<const char*>(&kReceiveBufferSize),
+            sizeof(kReceiveBufferSize)) == SOCKET_ERROR)
+        {
+            const int err = WSAGetLastError();
+
+            std::cout << "Failed to grow the receive buffer of swarm socket '" << sock
+                << "': [" << err << "] " << ErrorToString(err) << '\n';
+        }
+
+        // Bound to every address so it takes the datagrams of all the
+        // clients' loopback addresses
+        SockAddrStorage storage = { 0 };
+        sockaddr* addr = ToSockAddr(storage.data(), "0.0.0.0", port);
+
+        if (::bind(sock, addr, int(kAddr4SockLen)) == SOCKET_ERROR)
+        {
+            const int err = WSAGetLastError();
+
+            std::cout << "Failed to bind swarm socket '" << sock << "' to port '"
+                << port << "': [" << err << "] " << ErrorToString(err) << '\n';
+            return false;
+        }
+
+        if (!mRecvMsg)
+        {
+            GUID guid = WSAID_WSARECVMSG;
+            LPFN_WSARECVMSG recvMsg = nullptr;
+            DWORD bytes = 0;
+
+            if (WSAIoctl(sock, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid),
+                &recvMsg, sizeof(recvMsg), &bytes, nullptr, nullptr) == SOCKET_ERROR)
+            {
+                const int err = WSAGetLastError();
+
+                std::cout << "Failed to look up WSARecvMsg: [" << err << "] "
+                    << ErrorToString(err) << '\n';
+                return false;
+            }
+
+            mRecvMsg = reinterpret_cast<void*>(recvMsg);
+        }
+    }
+
+    mClients.reserve(std::min(mParams.ramp.GetMaxClients(), kMaxClients));
+    return true;
+}
+
+void Swarm::AddClient()
+{
+    using namespace Common;
+
+    const uint32_t index = uint32_t(mClients.size());
+    const uint32_t socket = index % uint32_t(mSockets.size());
+    const uint32_t address = htonl(kFirstAddress + index);
+
+    Client::GameLoop::Params params;
+    params.commonParams.playerTimeout = mParams.playerTimeout;
+    params.commonParams.tickInterval = mParams.tickInterval;
+    params.commonParams.room = mParams.room;
+    params.commonParams.gridBackend = WorldGrid::Backend::Chunked;
+    params.commonParams.maxEventsPerTick = kMaxEventsPerTick;
+    params.commonParams.verbose = false;
+    params.commonParams.sendSocket = mSockets[socket];
+    params.serverAddress = mParams.serverAddress;
+    params.serverPort = mParams.serverPort;
+    params.clientAddress = AddressToString(&address);
+    params.clientPort = mParams.basePort + socket;
+
+    SimulatedClient client;
+    client.game = std::make_unique<Client::GameLoop>(std::move(params));
+    client.behavior = &mParams.behaviors[index % mParams.behaviors.size()];
+    client.rng = mParams.seed * 2654435761u + index + 1;
+    // Start somewhere along the script so the clients do not move in step
+    client.step = client.rng % client.behavior->Size();
+
+    mClients.push_back(std::move(client));
+}
+
+void Swarm::Receive(size_t socket)
+{
+    using namespace Common;
+
+    auto recvMsg = reinterpret_cast<LPFN_WSARECVMSG>(mRecvMsg);
+
+    while (true)
+    {
+        SockAddrStorage storage = { 0 };
+        char control[WSA_CMSG_SPACE(sizeof(IN_PKTINFO))] = { 0 };
+
+        WSABUF buf;
+        buf.buf = reinterpret_cast<char*>(mMessage.buffer.Data());
+        buf.len = static_cast<unsigned long>(mMessage.buffer.Capacity());
+
+        WSAMSG msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.name = reinterpret_cast<sockaddr*>(storage.data());
+        msg.namelen = int(storage.size());
+        msg.lpBuffers = &buf;
+        msg.dwBufferCount = 1;
+        msg.Control.buf = control;
+        msg.Control.len = sizeof(control);
+
+        DWORD received = 0;
+
+        if (recvMsg(mSockets[socket], &msg, &received, nullptr, nullptr) == SOCKET_ERROR)
+        {
+            const int err = WSAGetLastError();
+
+            if (err == WSAEWOULDBLOCK)
+            {
+                break;
+            }
+
+            // Left over from a send which went nowhere, or a datagram too
+            // large for any client, neither stops the others
+            if (err == WSAECONNRESET || err == WSAECONNREFUSED || err == WSAEMSGSIZE)
+            {
+                continue;
+            }
+
+            std::cout << "Failed to receive on swarm socket '" << mSockets[socket]
+                << "': [" << err << "] " << ErrorToString(err) << '\n';
+            break;
+        }
+
+        uint32_t destination = 0;
+
+        for (WSACMSGHDR* header = WSA_CMSG_FIRSTHDR(&msg);
+            header;
+            header = WSA_CMSG_NXTHDR(&msg, header))
+        {
+            if (header->cmsg_level == IPPROTO_IP && header->cmsg_type == IP_PKTINFO)
+            {
+                const auto* info = reinterpret_cast<const IN_PKTINFO*>(WSA_CMSG_DATA(header));
+                destination = ntohl(info->ipi_addr.s_addr);
+            }
+        }
+
+        const uint32_t index = destination - kFirstAddress;
+
+        if (destination < kFirstAddress || index >= mClients.size())
+        {
+            mUnrouted += 1;
+            continue;
+        }
+
+        const sockaddr_in* from = reinterpret_cast<const sockaddr_in*>(storage.data());
+
+        mMessage.buffer.SetOffset(size_t(received));
+        mMessage.address = AddressToString(&from->sin_addr);
+        mMessage.port = ntohs(from->sin_port);
+
+        mClients[index].game->OnReceive(mMessage);
+    }
+}
+
+void Swarm::Tick()
+{
+    using namespace std::chrono;
+
+    const steady_clock::time_point start = steady_clock::now();
+
+    for (SimulatedClient& client : mClients)
+    {
+        Client::GameLoop& game = *client.game;
+
+        // Login and ping go out from the client's own timers
+        game.Tick();
+
+        if (!game.IsLoggedIn())
+        {
+            continue;
+        }
+
+        if (!client.loggedIn)
+        {
+            client.loggedIn = true;
+            mLoginTimes.Add(game.GetLoginTime());
+        }
+
+        const Common::RttEstimator& rtt = game.GetRtt();
+
+        if (rtt.GetSampleCount() != client.rttSamples)
+        {
+            client.rttSamples = rtt.GetSampleCount();
+            mRtt.Add(rtt.GetLatestRtt());
+            mRecentRtt.Add(rtt.GetLatestRtt());
+        }
+
+        Common::Movement movement;
+
+        if (client.behavior->GetMovement(client.step++, client.rng, movement)
+            && game.SendMove(movement))
+        {
+            mMovesSent += 1;
+        }
+    }
+
+    mTicks += 1;
+    mMaxTickTime = std::max(mMaxTickTime, steady_clock::now() - start);
+}
+
+void Swarm::Run()
+{
+    using namespace std::chrono;
+
+    assert(!mSockets.empty());
+
+    const steady_clock::time_point start = steady_clock::now();
+    const steady_clock::duration end = mParams.ramp.GetDuration() + mParams.hold;
+
+    steady_clock::time_point nextTick = start;
+    steady_clock::time_point nextReport = start + mParams.reportInterval;
+    steady_clock::time_point now = start;
+
+    while (!mShutdown && now - start < end)
+    {
+        fd_set reads;
+        FD_ZERO(&reads);
+        for (Common::Socket sock : mSockets)
+        {
+            FD_SET(sock, &reads);
+        }
+
+        // Wait on the sockets until the next tick is due
+        const microseconds wait = duration_cast<microseconds>(
+            std::max(nextTick - now, steady_clock::duration(0)));
+
+        struct timeval timeout;
+        timeout.tv_sec = static_cast<long>(wait.count() / 1000000);
+        timeout.tv_usec = static_cast<long>(wait.count() % 1000000);
+
+        const int result = ::select(0 /* ignored */, &reads, nullptr, nullptr, &timeout);
+
+        if (result == SOCKET_ERROR)
+        {
+            const int err = WSAGetLastError();
+
+            if (err != WSAEINTR)
+            {
+                std::cout << "Error waiting on the swarm sockets: [" << err << "] "
+                    << Common::ErrorToString(err) << '\n';
+                break;
+            }
+        }
+        else if (result > 0)
+        {
+            for (size_t i = 0; i < mSockets.size(); ++i)
+            {
+                if (FD_ISSET(mSockets[i], &reads))
+                {
+                    Receive(i);
+                }
+            }
+        }
+
+        now = steady_clock::now();
+
+        if (now >= nextTick)
+        {
+            const uint32_t clients = std::min(mParams.ramp.GetClients(now - start), kMaxClients);
+
+            while (mClients.size() < clients)
+            {
+                AddClient();
+            }
+
+            Tick();
+
+            // A swarm which falls behind skips ticks rather than bursting,
+            // the late count says the generator itself is the limit
+            nextTick += mParams.tickInterval;
+            if (nextTick <= now)
+            {
+                mLateTicks += 1;
+                nextTick = now + mParams.tickInterval;
+            }
+        }
+
+        if (now >= nextReport)
+        {
+            PrintProgress(now - start);
+            nextReport += mParams.reportInterval;
+        }
+    }
+
+    mRunTime = now - start;
+}
+
+Swarm::Totals Swarm::GetTotals() const
+{
+    Totals totals;
+
+    for (const SimulatedClient& client : mClients)
+    {
+        const Client::GameLoop::SessionStats& stats = client.game->GetSessionStats();
+
+        totals.loggedIn += client.loggedIn;
+        totals.pingsSent += stats.pingsSent;
+        totals.acksReceived += stats.acksReceived;
+        totals.statesReceived += stats.statesReceived;
+    }
+
+    totals.movesSent = mMovesSent;
+    return totals;
+}
+
+void Swarm::PrintProgress(std::chrono::steady_clock::duration elapsed)
+{
+    using namespace std::chrono;
+
+    const Totals totals = GetTotals();
+    const uint64_t pings = totals.pingsSent - mLastTotals.pingsSent;
+    const uint64_t acks = totals.acksReceived - mLastTotals.acksReceived;
+    const double lost = pings > acks ? 100.0 * double(pings - acks) / double(pings) : 0.0;
+
+    std::cout << "[" << duration_cast<milliseconds>(elapsed).count() << "ms] "
+        << mClients.size() << " clients, " << totals.loggedIn << " logged in, "
+        << pings << " pings (" << lost << "% lost), "
+        << totals.statesReceived - mLastTotals.statesReceived << " states, "
+        << totals.movesSent - mLastTotals.movesSent << " moves, rtt p50 "
+        << mRecentRtt.GetPercentile(0.5) << "us p99 " << mRecentRtt.GetPercentile(0.99)
+        << "us\n";
+
+    mRecentRtt.Clear();
+    mLastTotals = totals;
+}
+
+void Swarm::PrintReport() const
+{
+    using namespace std::chrono;
+
+    const Totals totals = GetTotals();
+    const double seconds = duration<double>(mRunTime).count();
+    const uint64_t lost = totals.pingsSent > totals.acksReceived
+        ? totals.pingsSent - totals.acksReceived
+        : 0;
+
+    std::cout << "Swarm of " << mClients.size() << " clients over " << mSockets.size()
+        << " sockets ran " << duration_cast<milliseconds>(mRunTime).count() << "ms, "
+        << mTicks << " ticks (" << mLateTicks << " late, slowest " << Micros(mMaxTickTime)
+        << "us)\n";
+
+    std::cout << "Logins: " << totals.loggedIn << " of " << mClients.size()
+        << " in p50 " << mLoginTimes.GetPercentile(0.5) << "us, p90 "
+        << mLoginTimes.GetPercentile(0.9) << "us, p99 " << mLoginTimes.GetPercentile(0.99)
+        << "us, max " << mLoginTimes.GetMax() << "us\n";
+
+    std::cout << "Round trips: " << mRtt.Size() << " samples, p50 " << mRtt.GetPercentile(0.5)
+        << "us, p90 " << mRtt.GetPercentile(0.9) << "us, p99 " << mRtt.GetPercentile(0.99)
+        << "us, max " << mRtt.GetMax() << "us\n";
+
+    std::cout << "Loss: " << totals.pingsSent << " pings, " << totals.acksReceived
+        << " answered, " << lost << " lost ("
+        << (totals.pingsSent ? 100.0 * double(lost) / double(totals.pingsSent) : 0.0)
+        << "%), " << totals.statesReceived << " states ("
+        << (seconds > 0.0 && totals.loggedIn
+            ? double(totals.statesReceived) / seconds / double(totals.loggedIn)
+            : 0.0)
+        << " per client per second), " << totals.movesSent << " moves sent, "
+        << mUnrouted << " datagrams unrouted\n";
+}
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "Behavior.h"
+#include "GameLoop.h"
+#include "Network.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace LoadGen
+{
+// Thousands of simulated clients in one process, each a full
+// Client::GameLoop logging in, pinging and moving as a real one does.
+//
+// A handful of sockets are bound to the wildcard address and every client
+// advertises one of them along with a loopback address of its own, from
+// 127.1.0.1 up. The server keys players by the address they advertise, so
+// each client is a separate player, and every datagram is handed to its
+// client by the address it was sent to, which the sockets report with
+// IP_PKTINFO. Clients are started along a ramp profile and walk their
+// behavior scripts, while login times, round trips and lost pings are
+// recorded to find where the server stops keeping up.
+class Swarm final
+{
+public:
+    Swarm(const Swarm&) = delete;
+    Swarm& operator=(const Swarm&) = delete;
+
+public:
+    // First address handed to a client, 127.1.0.1
+    static constexpr uint32_t kFirstAddress = 0x7F010001;
+
+    // Most clients the addresses are handed out for
+    static constexpr uint32_t kMaxClients = 0xFFFE;
+
+    struct Params
+    {
+        std::string serverAddress{ "127.0.0.1" };
+        uint32_t serverPort{ 8088 };
+        // Room to join on a server hosting several
+        uint32_t room{ 0 };
+
+        // Sockets to spread the clients over, bound to consecutive ports
+        uint32_t sockets{ 4 };
+        uint32_t basePort{ 9000 };
+
+        RampProfile ramp;
+        // Keep running at the last stage of the ramp this long
+        std::chrono::milliseconds hold{ 10000 };
+        // Handed to the clients in turn
+        std::vector<Behavior> behaviors;
+        // Seeds the random steps and where each client starts its script
+        uint32_t seed{ 1 };
+
+        std::chrono::milliseconds tickInterval{ 30 };
+        std::chrono::milliseconds playerTimeout{ 10000 };
+        // Time between two progress lines
+        std::chrono::milliseconds reportInterval{ 1000 };
+    };
+
+    // Latency samples in microseconds, summarised into percentiles
+    class Histogram final
+    {
+    public:
+        void Add(std::chrono::steady_clock::duration sample);
+        void Clear() { mSamples.clear(); }
+
+        size_t Size() const { return mSamples.size(); }
+
+        // Sample below which the fraction p of them fall, 0 when empty
+        uint32_t GetPercentile(double p) const;
+        uint32_t GetMax() const;
+
+    private:
+        // Sorted lazily by GetPercentile()
+        mutable std::vector<uint32_t> mSamples;
+        mutable bool mSorted{ true };
+    };
+
+public:
+    explicit Swarm(Params params);
+    ~Swarm();
+
+    // Create and bind the sockets
+    bool Initialize();
+
+    // Ramp the clients up, hold and return once done or shut down
+    void Run();
+    void Shutdown() { mShutdown = true; }
+
+    void PrintReport() const;
+
+private:
+    struct SimulatedClient
+    {
+        std::unique_ptr<Client::GameLoop> game;
+        const Behavior* behavior{ nullptr };
+        size_t step{ 0 };
+        uint32_t rng{ 0 };
+        bool loggedIn{ false };
+        // RTT samples already taken from the game
+        uint64_t rttSamples{ 0 };
+    };
+
+    // Totals over every client, as of the last report
+    struct Totals
+    {
+        uint32_t loggedIn{ 0 };
+        uint64_t pingsSent{ 0 };
+        uint64_t acksReceived{ 0 };
+        uint64_t statesReceived{ 0 };
+        uint64_t movesSent{ 0 };
+    };
+
+    void AddClient();
+
+    // Hand every datagram waiting on a socket to its client
+    void Receive(size_t socket);
+
+    void Tick();
+
+    Totals GetTotals() const;
+    void PrintProgress(std::chrono::steady_clock::duration elapsed);
+
+private:
+    Params mParams;
+    std::vector<Common::Socket> mSockets;
+    // LPFN_WSARECVMSG, looked up on the first socket
+    void* mRecvMsg{ nullptr };
+    std::vector<SimulatedClient> mClients;
+    std::atomic<bool> mShutdown{ false };
+    // Holds a received datagram while its client decodes it
+    Common::NetworkMessage mMessage;
+
+    Histogram mLoginTimes;
+    Histogram mRtt;
+    // Round trips since the last progress line
+    Histogram mRecentRtt;
+    Totals mLastTotals;
+    uint64_t mMovesSent{ 0 };
+    uint64_t mUnrouted{ 0 };
+    uint64_t mTicks{ 0 };
+    // Ticks started after the next one was already due
+    uint64_t mLateTicks{ 0 };
+    std::chrono::steady_clock::duration mRunTime{ 0 };
+    // Longest a tick of every client took
+    std::chrono::steady_clock::duration mMaxTickTime{ 0 };
+};
+}
@@ -0,0 +1,148 @@
+// Common Includes
+#include "Network.h"
+// Load Generator Includes
+#include "Behavior.h"
+#include "Swarm.h"
+// Other Includes
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <Windows.h>
+
+namespace
+{
+using ShutdownFn = std::function<void()>;
+static ShutdownFn shutdownFn;
+
+void PrintUsage(const char* program)
+{
+    std::cout << "Usage: " << program << " [--server <address>] [--port <port>] [--room <id>] "
+        << "[--sockets <count>] [--base-port <port>] [--ramp <clients>@<seconds>,...] "
+        << "[--hold <seconds>] [--behavior <script>]... [--seed <value>] [--report <ms>]\n"
+        << "  Behavior scripts are made of U, D, L and R to move, ? to move at random "
+        << "and . to wait, one step a tick\n";
+}
+}
+
+int main(int argc, char** argv)
+{
+    using namespace Common;
+
+    LoadGen::Swarm::Params params;
+    params.ramp = *LoadGen::RampProfile::Parse("100@10");
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--server") == 0 && i + 1 < argc)
+        {
+            params.serverAddress = argv[++i];
+        }
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+        {
+            params.serverPort = uint32_t(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--room") == 0 && i + 1 < argc)
+        {
+            params.room = uint32_t(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--sockets") == 0 && i + 1 < argc)
+        {
+            params.sockets = std::max(uint32_t(strtoul(argv[++i], nullptr, 10)), 1u);
+        }
+        else if (strcmp(argv[i], "--base-port") == 0 && i + 1 < argc)
+        {
+            params.basePort = uint32_t(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--ramp") == 0 && i + 1 < argc)
+        {
+            auto ramp = LoadGen::RampProfile::Parse(argv[++i]);
+            if (!ramp)
+            {
+                std::cout << "Invalid ramp profile '" << argv[i] << "'\n";
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            params.ramp = std::move(*ramp);
+        }
+        else if (strcmp(argv[i], "--hold") == 0 && i + 1 < argc)
+        {
+            params.hold = std::chrono::milliseconds(
+                int64_t(std::max(strtod(argv[++i], nullptr), 0.0) * 1000.0));
+        }
+        else if (strcmp(argv[i], "--behavior") == 0 && i + 1 < argc)
+        {
+            auto behavior = LoadGen::Behavior::Parse(argv[++i]);
+            if (!behavior)
+            {
+                std::cout << "Invalid behavior script '" << argv[i] << "'\n";
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            params.behaviors.push_back(std::move(*behavior));
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            params.seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc)
+        {
+            params.reportInterval = std::chrono::milliseconds(
+                std::max(strtoul(argv[++i], nullptr, 10), 1ul));
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (params.ramp.GetMaxClients() > LoadGen::Swarm::kMaxClients)
+    {
+        std::cout << "At most " << LoadGen::Swarm::kMaxClients << " clients are supported\n";
+        return 1;
+    }
+
+    auto CtrlHandler = [](DWORD ev) -> BOOL
+    {
+        switch (ev)
+        {
+        case CTRL_C_EVENT:
+        case CTRL_BREAK_EVENT:
+        case CTRL_CLOSE_EVENT:
+            if (shutdownFn)
+            {
+                shutdownFn();
+            }
+            return TRUE;
+        default:
+            return FALSE;
+        }
+    };
+
+    if (!SetConsoleCtrlHandler(CtrlHandler, TRUE))
+    {
+        std::cout << "Failed to set console handler\n";
+        return 1;
+    }
+
+    WinSock winsock;
+
+    LoadGen::Swarm swarm(std::move(params));
+
+    if (!swarm.Initialize())
+    {
+        std::cout << "Failed to initialize the swarm\n";
+        return 1;
+    }
+
+    shutdownFn = [&swarm] { swarm.Shutdown(); };
+
+    swarm.Run();
+
+    shutdownFn = nullptr;
+
+    swarm.PrintReport();
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include "GameLoop.h"
 
+#include <algorithm>
 #include <iostream>
 
 namespace Server
@@ -15,42 +16,75 @@ void GameLoop::HandleLogin(LoginEvent* ev)
     using namespace Common;
 
     std::string address = AddressToString(ev->login.address);
-    auto [state, created] = CreatePlayer(address, ev->login.port);
+    auto [player, created] = CreatePlayer(address, ev->login.port);
 
-    if (created)
+    if (!player)
     {
-        std::cout << "Created new player entry for '" << address << ':'
+        std::cout << "Invalid login endpoint '" << address << ':'
             << ev->login.port << "'" << '\n';
+        return;
+    }
+
+    if (created)
+    {
+        if (GetParams().verbose)
+        {
+            std::cout << "Created new player entry for '" << address << ':'
+                << ev->login.port << "'" << '\n';
+        }
+
+        Position spawn;
+
+        if (!FindFreePosition(GetPlayers().GetId(player), spawn)
+            || !PlacePlayer(player, spawn))
+        {
+            std::cout << "No free position for player '" << GetPlayers().GetId(player)
+                << "'\n";
+        }
+        else
+        {
+            AnnouncePlayer(player);
+        }
     }
     else
     {
-        std::cout << "Existing player entry found for '" << address << ':'
-            << ev->login.port << "'" << '\n';
+        if (GetParams().verbose)
+        {
+            std::cout << "Existing player entry found for '" << address << ':'
+                << ev->login.port << "'" << '\n';
+        }
+
+        TouchPlayer(player);
     }
 
+    ReceiveHeader(player, *ev);
+
     NetworkBuffer buffer;
     Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
 
     LoginMessage login;
-    login.message.messageId = state->nextMessage++;
+    login.message.messageId = GetPlayers().GetNextMessage(player)++;
     memcpy(login.address, ev->login.address, sizeof(login.address));
     login.port = ev->login.port;
-    login.session = state->player->GetId();
+    login.session = GetPlayers().GetId(player);
     buffer.SetOffset(Serializer<LoginMessage>::Serialize(login, data));
 
-    if (!SendMessage(address.c_str(), ev->login.port, buffer))
+    const PlayerInfo& info = GetPlayers().GetInfo(player);
+
+    if (!SendPacket(address.c_str(), ev->login.port, buffer, GetHeaderAcks(info)))
     {
         std::cout << "Failed to send login message back to client '" << address << ':'
             << ev->login.port << "'" << '\n';
     }
     else
     {
-        std::cout << "Sent login message back to client '" << address << ':'
-            << ev->login.port << "'" << '\n';
+        if (GetParams().verbose)
+        {
+            std::cout << "Sent login message back to client '" << address << ':'
+                << ev->login.port << "'" << '\n';
+        }
 
-        state->messages.try_emplace(
-            login.message.messageId,
-            std::move(buffer));
+        BufferMessage(player, login.message.messageId, buffer);
     }
 }
 
@@ -63,50 +97,626 @@ void GameLoop::HandlePing(PingEvent* ev)
 
     if (ping.playerId == PingMessage::kInvalidPlayer)
     {
-        std::cout << "Invalid playerId on ping from '" << ev->msg.address
-            << ':' << ev->msg.port << "'\n";
+        std::cout << "Invalid playerId on ping from '" << ev->address
+            << ':' << ev->port << "'\n";
         return;
     }
 
-    PlayerState* state = GetPlayerById(ping.playerId);
+    PlayerHandle player = GetPlayerById(ping.playerId);
 
-    if (!state)
+    if (!player)
     {
         std::cout << "Unknown playerId '" << ping.playerId << "' on ping from '"
-            << ev->msg.address << ':' << ev->msg.port << "'\n";
+            << ev->address << ':' << ev->port << "'\n";
         return;
     }
 
-    state->lastMessage = steady_clock::now();
+    PlayerTable& players = GetPlayers();
+    PlayerInfo& info = players.GetInfo(player);
+
+    TouchPlayer(player);
+
+    // The client echoes the newest acknowledgement it had from us, less
+    // the time it held on to it
+    const MessageTimes& times = ping.times;
+
+    if (times.echoDelay != MessageTimes::kNoEcho)
+    {
+        const int32_t elapsed = int32_t(GetWireTime(ev->received) - times.echoTime);
+
+        if (elapsed >= 0 && uint32_t(elapsed) >= times.echoDelay)
+        {
+            info.rtt.AddSample(microseconds(uint32_t(elapsed) - times.echoDelay));
+        }
+    }
+
+    ReceiveHeader(player, *ev);
+
+    // The client has everything up to ping.messageId, stop resending it
+    if (!info.reliable.IsEmpty())
+    {
+        const RetransmitBuffer::Stats before = info.reliable.GetStats();
+        info.reliable.AcknowledgeUpTo(ping.messageId);
+        AddReliableStats(before, info.reliable.GetStats());
 
-    // TODO: Do something with the ping.messageId and ping.message.messageId
-    //       values. If the client is behind on ACKs we should have the buffered
-    //       messages to resend.
+        ArmRetransmit(player);
+    }
 
+    // Every ping is answered, compact clients have their messages
+    // acknowledged in the header already but the reply carries the
+    // timestamps both ends measure round trips with
     NetworkBuffer buffer;
     Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
 
+    const steady_clock::time_point now = steady_clock::now();
+
     AcknowledgeMessage ack;
-    ack.message.messageId = state->nextMessage++;
+    ack.message.messageId = players.GetNextMessage(player)++;
     ack.messageId = ping.messageId;
+    ack.times.sendTime = GetWireTime(now);
+    ack.times.echoTime = times.sendTime;
+    ack.times.echoDelay = uint32_t(duration_cast<microseconds>(now - ev->received).count());
     buffer.SetOffset(Serializer<AcknowledgeMessage>::Serialize(ack, data));
 
-    if (!SendMessage(state->address.c_str(), ev->msg.port, buffer))
+    if (!SendPacket(info.address.c_str(), ev->port, buffer, GetHeaderAcks(info)))
     {
         std::cout << "Failed to send acknowledge message back to client '"
-            << state->address << ':' << ev->msg.port << "'" << '\n';
+            << info.address << ':' << ev->port << "'" << '\n';
     }
-    else
+    else if (GetParams().verbose)
     {
+        // Not kept, the next ping gets a fresh acknowledgement anyway
         std::cout << "Sent acknowledge message back to client '"
-            << state->address << ':' << ev->msg.port << "'" << '\n';
-
-        state->messages.try_emplace(
-            ack.message.messageId,
-            std::move(buffer));
+            << info.address << ':' << ev->port << "'" << '\n';
     }
 }
 
 void GameLoop::HandleAcknowledge(AcknowledgeEvent* ev)
 {}
+
+void GameLoop::HandleState(StateEvent* ev)
+{
+    // State only flows from the server to clients
+    std::cout << "Ignoring state message from client '" << ev->address << ':'
+        << ev->port << "'\n";
+}
+
+void GameLoop::HandleMove(MoveEvent* ev)
+{
+    using namespace Common;
+
+    MoveMessage& move = ev->move;
+    PlayerHandle player = GetPlayerById(move.playerId);
+
+    if (!player)
+    {
+        std::cout << "Unknown playerId '" << move.playerId << "' on move from '"
+            << ev->address << ':' << ev->port << "'\n";
+        return;
+    }
+
+    TouchPlayer(player);
+    ReceiveHeader(player, *ev);
+
+    // Held until the tick the client stamped it for, then applied with
+    // every other move for that tick
+    if (QueueInput(player, move.tick, move.movement) == JitterBuffer::Result::TooEarly)
+    {
+        std::cout << "Dropped move for tick '" << move.tick << "' from player '"
+            << move.playerId << "' on tick '" << GetTick() << "'\n";
+    }
+}
+
+void GameLoop::HandleTimer(TimerKind kind, uint64_t data)
+{
+    using namespace Common;
+
+    switch (kind)
+    {
+    case TimerKind::Retransmit:
+        Retransmit(PlayerHandle::Unpack(data));
+        break;
+    default:
+        Game::HandleTimer(kind, data);
+        break;
+    }
+}
+
+void GameLoop::BufferMessage(
+    Common::PlayerHandle player,
+    uint32_t messageId,
+    const Common::NetworkBuffer& buffer)
+{
+    using namespace Common;
+
+    PlayerInfo& info = GetPlayers().GetInfo(player);
+
+    const RetransmitBuffer::Stats before = info.reliable.GetStats();
+    info.reliable.Add(
+        messageId,
+        { buffer.Data(), buffer.Size() },
+        std::chrono::steady_clock::now(),
+        info.rtt.GetRto());
+    AddReliableStats(before, info.reliable.GetStats());
+
+    ArmRetransmit(player);
+}
+
+void GameLoop::Retransmit(Common::PlayerHandle player)
+{
+    using namespace Common;
+
+    if (!GetPlayers().IsAlive(player))
+    {
+        return;
+    }
+
+    PlayerInfo& info = GetPlayers().GetInfo(player);
+
+    const RetransmitBuffer::Stats before = info.reliable.GetStats();
+    Span<const uint32_t> due = info.reliable.TakeDue(std::chrono::steady_clock::now());
+
+    for (size_t i = 0; i < due.size; ++i)
+    {
+        Span<const uint8_t> message = info.reliable.Find(due.data[i]);
+
+        memcpy(mResendBuffer.Data(), message.data, message.size);
+        mResendBuffer.SetOffset(message.size);
+
+        if (!SendPacket(info.address.c_str(), info.port, mResendBuffer, GetHeaderAcks(info)))
+        {
+            std::cout << "Failed to resend message '" << due.data[i] << "' to client '"
+                << info.address << ':' << info.port << "'\n";
+        }
+    }
+
+    if (info.reliable.GetStats().abandoned != before.abandoned)
+    {
+        std::cout << "Gave up on " << info.reliable.GetStats().abandoned - before.abandoned
+            << " messages to client '" << info.address << ':' << info.port << "'\n";
+    }
+
+    AddReliableStats(before, info.reliable.GetStats());
+    ArmRetransmit(player);
+}
+
+void GameLoop::ArmRetransmit(Common::PlayerHandle player)
+{
+    using namespace Common;
+    using namespace std::chrono;
+
+    PlayerInfo& info = GetPlayers().GetInfo(player);
+    std::optional<steady_clock::time_point> deadline = info.reliable.GetNextDeadline();
+
+    if (!deadline)
+    {
+        CancelTimer(info.retransmit);
+        return;
+    }
+
+    const steady_clock::duration delay
+        = std::max<steady_clock::duration>(*deadline - steady_clock::now(), {});
+
+    if (!RescheduleTimer(info.retransmit, delay))
+    {
+        info.retransmit = ScheduleTimer(delay, TimerKind::Retransmit, player.Pack());
+    }
+}
+
+void GameLoop::ReceiveHeader(Common::PlayerHandle player, const Event& ev)
+{
+    using namespace Common;
+
+    PlayerTable& players = GetPlayers();
+    PlayerInfo& info = players.GetInfo(player);
+
+    // Answer in whichever header the client used last
+    info.compact = ev.compact;
+
+    if (!ev.compact)
+    {
+        return;
+    }
+
+    info.acks.Receive(ev.header.sequence);
+
+    if (!(ev.header.flags & CompactHeader::kFlagAck))
+    {
+        return;
+    }
+
+    // Widened around the newest message sent to the client
+    const uint32_t ack = ExpandSequence(ev.header.ack, players.GetNextMessage(player) - 1);
+
+    info.pacer.OnAck(ack, ev.header.ackBits, info.rtt, std::chrono::steady_clock::now());
+
+    if (info.reliable.IsEmpty())
+    {
+        return;
+    }
+
+    const RetransmitBuffer::Stats before = info.reliable.GetStats();
+
+    info.reliable.Acknowledge(ack);
+
+    for (uint32_t i = 0; i < AckWindow::kBits; ++i)
+    {
+        if (ev.header.ackBits & (1u << i))
+        {
+            info.reliable.Acknowledge(ack - 1 - i);
+        }
+    }
+
+    AddReliableStats(before, info.reliable.GetStats());
+    ArmRetransmit(player);
+}
+
+const Common::AckWindow* GameLoop::GetHeaderAcks(const Common::PlayerInfo& info)
+{
+    return info.compact ? &info.acks : nullptr;
+}
+
+void GameLoop::AddReliableStats(
+    const Common::RetransmitBuffer::Stats& before,
+    const Common::RetransmitBuffer::Stats& after)
+{
+    mReliableStats.stored += after.stored - before.stored;
+    mReliableStats.acknowledged += after.acknowledged - before.acknowledged;
+    mReliableStats.resent += after.resent - before.resent;
+    mReliableStats.evicted += after.evicted - before.evicted;
+    mReliableStats.abandoned += after.abandoned - before.abandoned;
+}
+
+bool GameLoop::Tick()
+{
+    bool result = Game::Tick();
+
+    if (result)
+    {
+        Replicate();
+        Flush();
+    }
+
+    return result;
+}
+
+void GameLoop::Replicate()
+{
+    using namespace Common;
+
+    PlayerTable& players = GetPlayers();
+    Span<Position> positions = players.GetPositions();
+
+    size_t placed = 0;
+    for (size_t i = 0; i < positions.size; ++i)
+    {
+        placed += IsValidPosition(positions.data[i].x, positions.data[i].y);
+    }
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const size_t jobs = GetPlayerJobCount();
+
+    if (mReplicateJobs.size() < jobs)
+    {
+        mReplicateJobs.resize(jobs);
+    }
+
+    // Every job encodes into its own scratch and only pushes to the pacers
+    // of its own players, nothing goes out until Flush()
+    RunPlayerJobs(
+        [this, placed, now](size_t begin, size_t end, size_t job)
+        {
+            ReplicatePlayers(begin, end, placed, now, mReplicateJobs[job]);
+        });
+
+    for (size_t i = 0; i < jobs; ++i)
+    {
+        mReplicationStats.broadcastBytes += std::exchange(mReplicateJobs[i].broadcastBytes, 0);
+    }
+
+    // The retransmit timers are not the jobs' to touch
+    ReplicateRemovals();
+
+    mReplicationStats.ticks += 1;
+}
+
+void GameLoop::ReplicateRemovals()
+{
+    using namespace Common;
+
+    PlayerTable& players = GetPlayers();
+    Span<Position> positions = players.GetPositions();
+
+    for (size_t i = 0; i < positions.size; ++i)
+    {
+        // Only the players just replicated have their view brought up to
+        // date
+        if (!IsValidPosition(positions.data[i].x, positions.data[i].y))
+        {
+            continue;
+        }
+
+        PlayerHandle handle = players.GetHandle(i);
+        PlayerInfo& info = players.GetInfo(handle);
+        Span<const uint32_t> left = info.priority.GetLeft();
+
+        for (size_t first = 0; first < left.size; first += StateMessage::kMaxRemoved)
+        {
+            // Stamped with the tick the client gets state for, so the
+            // positions of older states do not bring the players back
+            StateMessage state;
+            state.message.messageId = players.GetNextMessage(handle)++;
+            state.tick = GetTick();
+            state.removedCount = uint16_t(
+                std::min(left.size - first, size_t(StateMessage::kMaxRemoved)));
+            std::copy_n(left.data + first, state.removedCount, state.removed);
+
+            Span<uint8_t> data{ mRemoveBuffer.Data(), mRemoveBuffer.Capacity() };
+            mRemoveBuffer.SetOffset(
+                Serializer<StateMessage>::Serialize(state, GetPositionCodec(), data));
+
+            if (!SendPacket(info.address.c_str(), info.port, mRemoveBuffer,
+                GetHeaderAcks(info)))
+            {
+                std::cout << "Failed to send removals to client '" << info.address
+                    << ':' << info.port << "'\n";
+            }
+
+            // Sent once, a client which missed it would keep the players
+            BufferMessage(handle, state.message.messageId, mRemoveBuffer);
+        }
+    }
+}
+
+void GameLoop::ReplicatePlayers(
+    size_t begin,
+    size_t end,
+    size_t placed,
+    std::chrono::steady_clock::time_point now,
+    ReplicateJob& job)
+{
+    using namespace Common;
+
+    PlayerTable& players = GetPlayers();
+    Span<const uint32_t> ids = players.GetIds();
+    Span<Position> positions = players.GetPositions();
+
+    NetworkBuffer& buffer = job.buffer;
+    StateMessage& state = job.state;
+    const std::chrono::milliseconds tickInterval = GetParams().tickInterval;
+    const PositionCodec& codec = GetPositionCodec();
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        if (!IsValidPosition(positions.data[i].x, positions.data[i].y))
+        {
+            continue;
+        }
+
+        PlayerHandle handle = players.GetHandle(i);
+        PlayerInfo& info = players.GetInfo(handle);
+        Span<const uint32_t> visible = GetInterest().GetVisible(ids.data[i]);
+
+        job.positions.clear();
+        for (size_t j = 0; j < visible.size; ++j)
+        {
+            job.positions.push_back(players.GetPosition(players.Find(visible.data[j])));
+        }
+
+        info.priority.Update(GetTick(), positions.data[i], GetInterest().GetRadius(),
+            visible, { job.positions.data(), job.positions.size() });
+
+        // One message a tick, as many entries as fit in a datagram and in
+        // what the client's link takes in a tick. The rest wait for a later
+        // tick with their priority still growing. Entries are bit packed,
+        // so the room is counted in bits.
+        const size_t budget = std::min(kNetworkBufferSize,
+            size_t(uint64_t(info.pacer.GetRate()) * tickInterval.count() / 1000));
+        const size_t room = budget > GetStateMessageBytes(1, codec)
+            ? (budget - GetStateMessageBytes(1, codec)) * 8 / GetStateEntryBits(codec)
+            : 0;
+
+        Span<const PriorityAccumulator::Entry> picked = info.priority.Select(
+            GetTick(), std::min(room, size_t(StateMessage::kMaxEntries - 1)));
+
+        state.tick = GetTick();
+        state.inputOffset = int16_t(std::clamp(info.inputs.GetLeadError(),
+            int32_t(INT16_MIN), int32_t(INT16_MAX)));
+
+        // The client's own position always goes first
+        state.count = 0;
+        state.entries[state.count++] = { ids.data[i], positions.data[i].x,
+            positions.data[i].y };
+
+        for (size_t j = 0; j < picked.size; ++j)
+        {
+            state.entries[state.count++] = { picked.data[j].id, picked.data[j].pos.x,
+                picked.data[j].pos.y };
+        }
+
+        state.message.messageId = players.GetNextMessage(handle)++;
+
+        Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+        const size_t size = Serializer<StateMessage>::Serialize(state, codec, data);
+
+        // Goes out with Flush() as the client's link allows
+        info.pacer.Push(state.message.messageId, { buffer.Data(), size }, now);
+
+        job.broadcastBytes += GetStateMessageBytes(placed, codec);
+    }
+}
+
+void GameLoop::Flush()
+{
+    using namespace Common;
+
+    PlayerTable& players = GetPlayers();
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < players.Size(); ++i)
+    {
+        PlayerInfo& info = players.GetInfo(players.GetHandle(i));
+
+        while (const NetworkBuffer* packet = info.pacer.Next(now))
+        {
+            if (!SendPacket(info.address.c_str(), info.port, *packet, GetHeaderAcks(info)))
+            {
+                std::cout << "Failed to send state message to client '"
+                    << info.address << ':' << info.port << "'\n";
+            }
+            else
+            {
+                mReplicationStats.messages += 1;
+                mReplicationStats.bytesSent += packet->Size();
+            }
+
+            info.pacer.Pop(now);
+        }
+    }
+}
+
+void GameLoop::AnnouncePlayer(Common::PlayerHandle player)
+{
+    using namespace Common;
+
+    PlayerTable& players = GetPlayers();
+    const uint32_t id = players.GetId(player);
+    Span<const uint32_t> visible = GetInterest().GetVisible(id);
+
+    mAnnounceTargets.clear();
+    for (size_t i = 0; i < visible.size; ++i)
+    {
+        if (PlayerHandle target = players.Find(visible.data[i]))
+        {
+            mAnnounceTargets.push_back(target);
+        }
+    }
+
+    if (mAnnounceTargets.empty())
+    {
+        return;
+    }
+
+    // Stamped with the tick the clients last had state for, so it does
+    // not move their clocks or input lead
+    StateMessage state;
+    state.tick = GetTick();
+    const Position& pos = players.GetPosition(player);
+    state.count = 1;
+    state.entries[0] = { id, pos.x, pos.y };
+
+    Span<uint8_t> data{ mAnnounceBuffer.Data(), mAnnounceBuffer.Capacity() };
+    mAnnounceBuffer.SetOffset(
+        Serializer<StateMessage>::Serialize(state, GetPositionCodec(), data));
+
+    Broadcast(mAnnounceBuffer, { mAnnounceTargets.data(), mAnnounceTargets.size() });
+}
+
+void GameLoop::PrintReplicationStats() const
+{
+    using namespace Common;
+    using namespace std::chrono;
+
+    const PlayerTable& players = GetPlayers();
+    Span<const uint32_t> ids = players.GetIds();
+
+    const ReplicationStats& stats = mReplicationStats;
+    const uint64_t saved = stats.broadcastBytes > stats.bytesSent
+        ? stats.broadcastBytes - stats.bytesSent
+        : 0;
+
+    std::cout << "Replication over " << stats.ticks << " ticks: sent "
+        << stats.messages << " messages, " << stats.bytesSent << " bytes, "
+        << stats.broadcastBytes << " bytes with broadcast (saved " << saved
+        << " bytes, interest radius " << GetInterest().GetRadius() << ")\n";
+
+    const InputStats& inputs = GetInputStats();
+
+    std::cout << "Inputs up to tick " << GetTick() << ": " << inputs.buffered
+        << " on time, " << inputs.late << " late, " << inputs.tooEarly
+        << " too early, " << inputs.full << " overflowed, " << inputs.released
+        << " released\n";
+
+    const RetransmitBuffer::Stats& reliable = mReliableStats;
+
+    std::cout << "Reliable messages: " << reliable.stored << " stored, "
+        << reliable.acknowledged << " acknowledged, " << reliable.resent
+        << " resent, " << reliable.evicted << " evicted, " << reliable.abandoned
+        << " abandoned\n";
+
+    const JobSystem::Stats jobs = GetJobStats();
+
+    std::cout << "Player jobs: " << jobs.jobs << " over " << jobs.batches
+        << " batches on " << GetParams().jobThreads << " threads, " << jobs.stolen
+        << " stolen\n";
+
+    const CheckpointWriter::Stats checkpoints = GetCheckpointStats();
+
+    std::cout << "Checkpoints: " << checkpoints.written << " written ("
+        << checkpoints.lastSize << " bytes last), " << checkpoints.skipped << " skipped, "
+        << checkpoints.failed << " failed, slowest write "
+        << duration_cast<microseconds>(checkpoints.maxWriteTime).count() << "us\n";
+
+    const BroadcastStats& broadcasts = GetBroadcastStats();
+
+    std::cout << "Broadcasts: " << broadcasts.broadcasts << " sent as "
+        << broadcasts.copies << " copies, " << broadcasts.bytes << " bytes, "
+        << broadcasts.failed << " failed\n";
+
+    if (GetParams().dryRun)
+    {
+        const DryRunStats& dryRun = GetDryRunStats();
+
+        std::cout << "Dry run: " << dryRun.datagrams << " datagrams, " << dryRun.bytes
+            << " bytes not sent\n";
+    }
+
+    const FragmentAssembler::Stats& fragments = GetFragmentStats();
+
+    std::cout << "Fragments: " << fragments.fragments << " received, "
+        << fragments.messages << " messages reassembled, " << fragments.duplicates
+        << " duplicates, " << fragments.invalid << " invalid, " << fragments.expired
+        << " expired, " << fragments.evicted << " evicted, " << fragments.dropped
+        << " dropped\n";
+
+    PriorityAccumulator::Stats priority;
+    for (size_t i = 0; i < ids.size; ++i)
+    {
+        const PriorityAccumulator::Stats& player =
+            players.GetInfo(players.GetHandle(i)).priority.GetStats();
+
+        priority.selected += player.selected;
+        priority.deferred += player.deferred;
+        priority.totalAge += player.totalAge;
+        priority.maxAge = std::max(priority.maxAge, player.maxAge);
+    }
+
+    std::cout << "Priority: " << priority.selected << " entries sent, "
+        << priority.deferred << " deferred, waited "
+        << (priority.selected ? priority.totalAge / priority.selected : 0)
+        << " ticks avg, " << priority.maxAge << " ticks max\n";
+
+    for (size_t i = 0; i < ids.size; ++i)
+    {
+        const PlayerInfo& info = players.GetInfo(players.GetHandle(i));
+        const SendPacer& pacer = info.pacer;
+        const SendPacer::Stats& sent = pacer.GetStats();
+        const auto averageDelay = sent.delayed
+            ? duration_cast<milliseconds>(sent.totalDelay / sent.delayed).count()
+            : 0;
+
+        std::cout << "  player '" << ids.data[i] << "' sees "
+            << GetInterest().GetVisible(ids.data[i]).size << " players, oldest "
+            << info.priority.GetMaxAge(GetTick()) << " ticks ago, rate "
+            << pacer.GetRate() << " B/s, sent " << sent.bytesSent << " bytes, queue "
+            << pacer.GetQueueDepth() << " (max " << sent.maxQueue << ", dropped "
+            << sent.dropped << "), delayed " << sent.delayed << " for "
+            << averageDelay << "ms avg, "
+            << duration_cast<milliseconds>(sent.maxDelay).count() << "ms max, lost "
+            << sent.lost << " of " << sent.delivered + sent.lost << ", srtt "
+            << duration_cast<microseconds>(info.rtt.GetSmoothedRtt()).count() << "us, rttvar "
+            << duration_cast<microseconds>(info.rtt.GetRttVariance()).count() << "us, rto "
+            << duration_cast<milliseconds>(info.rtt.GetRto()).count() << "ms\n";
+    }
+}
 }
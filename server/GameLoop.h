@@ -14,5 +14,95 @@ public:
     void HandleLogin(LoginEvent* ev) override;
     void HandlePing(PingEvent* ev) override;
     void HandleAcknowledge(AcknowledgeEvent* ev) override;
+    void HandleState(StateEvent* ev) override;
+    void HandleMove(MoveEvent* ev) override;
+    void HandleTimer(TimerKind kind, uint64_t data) override;
+
+public:
+    bool Tick() override;
+
+    // Totals for the state sent to clients, compared with sending every
+    // client the state of every player.
+    struct ReplicationStats
+    {
+        uint64_t ticks{ 0 };
+        uint64_t messages{ 0 };
+        uint64_t bytesSent{ 0 };
+        uint64_t broadcastBytes{ 0 };
+    };
+
+    const ReplicationStats& GetReplicationStats() const { return mReplicationStats; }
+    void PrintReplicationStats() const;
+
+    // Totals of the reliable messages over every client, including those
+    // which have since left
+    const Common::RetransmitBuffer::Stats& GetReliableStats() const { return mReliableStats; }
+
+private:
+    // Scratch of one replication job
+    struct ReplicateJob
+    {
+        Common::NetworkBuffer buffer;
+        Common::StateMessage state;
+        std::vector<Common::Position> positions;
+        uint64_t broadcastBytes{ 0 };
+    };
+
+    // Queue for every client the positions of the players it can see which
+    // matter most to it, spread over the job threads
+    void Replicate();
+
+    // Replicate to the players in rows [begin, end) of the player table
+    void ReplicatePlayers(
+        size_t begin,
+        size_t end,
+        size_t placed,
+        std::chrono::steady_clock::time_point now,
+        ReplicateJob& job);
+
+    // Tell every client reliably which players left its view, or the
+    // game, this tick
+    void ReplicateRemovals();
+
+    // Send each client the state its pacer has room for
+    void Flush();
+
+    // Tell every client which can see a player which just spawned where
+    // it is, in one broadcast instead of waiting for replication to pick
+    // it
+    void AnnouncePlayer(Common::PlayerHandle player);
+
+    // Keep a copy of a sent message until the client acknowledges it,
+    // resending it with a growing timeout, starting from the client's
+    // retransmission timeout, until then
+    void BufferMessage(
+        Common::PlayerHandle player,
+        uint32_t messageId,
+        const Common::NetworkBuffer& buffer);
+    void Retransmit(Common::PlayerHandle player);
+
+    // Point the player's retransmit timer at its earliest deadline
+    void ArmRetransmit(Common::PlayerHandle player);
+
+    // Take the sequence and acknowledgements from a compact header and
+    // note which header the client speaks
+    void ReceiveHeader(Common::PlayerHandle player, const Event& ev);
+
+    // Acknowledgements to send a client, null for version 1 clients
+    static const Common::AckWindow* GetHeaderAcks(const Common::PlayerInfo& info);
+
+    // Add what one client's buffer counted since before
+    void AddReliableStats(
+        const Common::RetransmitBuffer::Stats& before,
+        const Common::RetransmitBuffer::Stats& after);
+
+private:
+    ReplicationStats mReplicationStats;
+    Common::RetransmitBuffer::Stats mReliableStats;
+    Common::NetworkBuffer mResendBuffer;
+    std::vector<ReplicateJob> mReplicateJobs;
+    Common::NetworkBuffer mRemoveBuffer;
+    Common::NetworkBuffer mAnnounceBuffer;
+    std::vector<Common::PlayerHandle> mAnnounceTargets;
 };
 }
@@ -1,12 +1,18 @@
 // Common Includes
+#include "Capture.h"
 #include "Game.h"
 #include "Message.h"
 #include "Network.h"
+#include "Replay.h"
+#include "RoomManager.h"
 #include "Server.h"
 // Server Includes
 #include "GameLoop.h"
 #include "Tests.h"
 // Other Includes
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include <Windows.h>
@@ -23,6 +29,64 @@ int main(int argc, char** argv)
 
     using namespace Common;
 
+    std::string capturePath;
+    std::string replayPath;
+    std::string checkpointPath;
+    Replay::Pacing pacing = Replay::Pacing::Original;
+    uint32_t roomCount = 0;
+    uint32_t jobThreads = 1;
+    bool verbose = true;
+    RoomManager::Params roomParams;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+        {
+            capturePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+        {
+            checkpointPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--fast") == 0)
+        {
+            pacing = Replay::Pacing::Fast;
+        }
+        else if (strcmp(argv[i], "--rooms") == 0 && i + 1 < argc)
+        {
+            roomCount = uint32_t(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            jobThreads = std::max(uint32_t(strtoul(argv[++i], nullptr, 10)), 1u);
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+        {
+            roomParams.workers = std::max(uint32_t(strtoul(argv[++i], nullptr, 10)), 1u);
+        }
+        else if (strcmp(argv[i], "--quiet") == 0)
+        {
+            verbose = false;
+        }
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--capture <file>] "
+                << "[--replay <file> [--fast]] [--rooms <count> [--workers <count>]] [--threads <count>] [--checkpoint <file>] [--quiet]\n";
+            return 1;
+        }
+    }
+
+    // Checkpoints are written from the single game loop, rooms have none
+    if (!checkpointPath.empty() && roomCount > 0)
+    {
+        std::cout << "--checkpoint can not be used with --rooms\n";
+        return 1;
+    }
+
     auto CtrlHandler = [](DWORD ev) -> BOOL
     {
         switch (ev)
@@ -52,8 +116,69 @@ int main(int argc, char** argv)
 
     Common::Game::Params params;
     params.playerTimeout = 10s;  // 2000ms
+    params.jobThreads = jobThreads;
+    params.verbose = verbose;
+    // A replay answers clients which are not there, so nothing is sent
+    params.dryRun = !replayPath.empty();
     Server::GameLoop game(params);
 
+    if (!replayPath.empty())
+    {
+        using namespace std::chrono;
+
+        // Feed a previously captured session through the game loop instead
+        // of listening on the network.
+        CaptureReader reader;
+
+        if (!reader.Open(replayPath))
+        {
+            return 1;
+        }
+
+        Replay replay(reader, game);
+        Replay::Stats stats = replay.Run(pacing, params.tickInterval);
+
+        auto Micros = [](steady_clock::duration d)
+        {
+            return duration_cast<microseconds>(d).count();
+        };
+
+        std::cout << "Replayed " << stats.records << " records (" << stats.rejected
+            << " rejected) over " << stats.ticks << " ticks in " << Micros(stats.wallTime)
+            << "us\n"
+            << "  receive total: " << Micros(stats.receiveTime) << "us\n"
+            << "  tick total: " << Micros(stats.tickTime) << "us, max: "
+            << Micros(stats.maxTickTime) << "us, avg: "
+            << (stats.ticks ? Micros(stats.tickTime) / int64_t(stats.ticks) : 0) << "us\n";
+
+        game.PrintReplicationStats();
+        return 0;
+    }
+
+    if (!checkpointPath.empty())
+    {
+        using namespace std::chrono;
+
+        // Pick up where the last run left off, the players carry on
+        // without logging in again
+        const steady_clock::time_point start = steady_clock::now();
+
+        if (game.RestoreCheckpoint(checkpointPath))
+        {
+            std::cout << "Resumed in " << duration_cast<microseconds>(
+                steady_clock::now() - start).count() << "us\n";
+        }
+        else
+        {
+            std::cout << "Starting without a checkpoint\n";
+        }
+
+        if (!game.StartCheckpoints(checkpointPath))
+        {
+            return 1;
+        }
+    }
+
     std::string address = "127.0.0.1";
     uint32_t port = 8088;
 
@@ -66,30 +191,52 @@ int main(int argc, char** argv)
             return 1;
         }
 
+        if (!capturePath.empty() && !server.StartCapture(capturePath))
+        {
+            return 1;
+        }
+
+        shutdownFn = [&server] { server.Shutdown(); };
+    }
+
+    if (roomCount > 0)
+    {
+        // Host many games, each client naming its room with --room. The
+        // receive thread only routes, the rooms tick on the workers.
+        RoomManager rooms(roomParams);
+
+        // The rooms already share the workers, each ticks on one thread
+        Common::Game::Params roomGameParams = params;
+        roomGameParams.jobThreads = 1;
+
+        for (uint32_t i = 0; i < roomCount; ++i)
+        {
+            rooms.CreateRoom(std::make_unique<Server::GameLoop>(roomGameParams));
+        }
+
         server.OnRecv(
-            [&game](Common::NetworkMessage& msg)
+            [&rooms](Common::NetworkMessage& msg)
             {
-                Span<const uint8_t> data(msg.buffer.Data(), msg.buffer.Size());
-                std::optional<Message> result = Serializer<Message>::Deserialize(data);
-
-                if (!result)
-                {
-                    std::cout << "invalid message received from '" << msg.address << "'";
-                }
-                else
-                {
-                    std::cout << "received message type '" << uint32_t(result->action) << "' from '"
-                        << msg.address << ':' << msg.port << "' (payload="
-                        << result->header.payloadSize << ", hash=" << result->header.hash
-                        << ")" << '\n';
-
-                    game.OnMessage(result->action, msg);
-                }
+                rooms.Route(msg);
             });
 
-        shutdownFn = [&server] { server.Shutdown(); };
+        rooms.Start();
+        server.Run(params.tickInterval, []() -> bool { return true; });
+        rooms.Stop();
+
+        rooms.PrintStats();
+        return 0;
     }
 
-    server.Run(30ms, [&game]() -> bool { return game.Tick(); });
+    server.OnRecv(
+        [&game](Common::NetworkMessage& msg)
+        {
+            game.OnReceive(msg);
+        });
+
+    server.Run(params.tickInterval, [&game]() -> bool { return game.Tick(); });
+
+    game.StopCheckpoints();
+    game.PrintReplicationStats();
     return 0;
 }
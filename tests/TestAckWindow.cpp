@@ -0,0 +1,71 @@
+#include "TestAckWindow.h"
+
+#include "AckWindow.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace Tests
+{
+void TestExpandSequence()
+{
+    using namespace Common;
+
+    assert(ExpandSequence(5, 3) == 5);
+    assert(ExpandSequence(1, 3) == 1);
+    assert(ExpandSequence(0x0002, 0x1FFFE) == 0x20002);
+    assert(ExpandSequence(0xFFFE, 0x20001) == 0x1FFFE);
+
+    // Both ways across the 32-bit wrap
+    assert(ExpandSequence(1, UINT32_MAX) == 1);
+    assert(ExpandSequence(0xFFFF, 0) == UINT32_MAX);
+}
+
+void TestAckWindowReceive()
+{
+    using namespace Common;
+
+    AckWindow window;
+    assert(!window.HasReceived());
+    assert(!window.IsReceived(0));
+
+    assert(window.Receive(10) == 10);
+    assert(window.GetAck() == 10 && window.GetAckBits() == 0);
+
+    // Gaps leave clear bits behind the newest
+    assert(window.Receive(12) == 12);
+    assert(window.GetAckBits() == 0b10);
+    assert(window.IsReceived(10) && !window.IsReceived(11) && window.IsReceived(12));
+
+    // Late arrivals fill them in without moving the newest
+    assert(window.Receive(11) == 11);
+    assert(window.GetAck() == 12 && window.GetAckBits() == 0b11);
+
+    // A duplicate changes nothing
+    assert(window.Receive(12) == 12);
+    assert(window.GetAckBits() == 0b11);
+
+    // The oldest bit reaches 32 back, anything older falls off
+    assert(window.Receive(12 + AckWindow::kBits) == 12 + AckWindow::kBits);
+    assert(window.GetAckBits() == 1u << 31);
+    assert(window.IsReceived(12) && !window.IsReceived(11));
+
+    assert(window.Receive(100) == 100);
+    assert(window.GetAckBits() == 0);
+
+    // The 16-bit sequences keep counting past their wrap
+    AckWindow wrapping;
+    wrapping.Receive(0xFFFE);
+    assert(wrapping.Receive(0x0001) == 0x10001);
+    assert(wrapping.Receive(0xFFFF) == 0xFFFF);
+    assert(wrapping.GetAck() == 0x0001 && wrapping.GetAckBits() == 0b110);
+}
+
+void AckWindowTests()
+{
+    std::cout << "Running ack window tests...\n";
+    TestExpandSequence();
+    TestAckWindowReceive();
+    std::cout << "All ack window tests completed\n";
+}
+}
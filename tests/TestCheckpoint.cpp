@@ -0,0 +1,214 @@
+#include "TestCheckpoint.h"
+
+#include "Checkpoint.h"
+#include "Game.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <Windows.h>
+
+namespace Tests
+{
+namespace
+{
+// The tests run at every startup, so each process writes its own file in
+// the temp directory rather than racing the others started alongside it or
+// clobbering a checkpoint in the working directory
+std::string GetCheckpointPath(const char* name)
+{
+    char directory[MAX_PATH + 1] = { 0 };
+    const DWORD length = GetTempPathA(sizeof(directory), directory);
+
+    std::string path;
+    if (length > 0 && length < sizeof(directory))
+    {
+        path.assign(directory, length);
+    }
+
+    return path + "udp-game-" + name + "-" + std::to_string(GetCurrentProcessId()) + ".bin";
+}
+
+class CheckpointGame final : public Common::Game
+{
+public:
+    CheckpointGame(Common::Game::Params params)
+        : Game(params)
+    { }
+
+    using Game::CreatePlayer;
+    using Game::GetPlayerByEndpoint;
+    using Game::GetPlayers;
+    using Game::PlacePlayer;
+
+protected:
+    void HandleLogin(LoginEvent*) override { }
+    void HandlePing(PingEvent*) override { }
+    void HandleAcknowledge(AcknowledgeEvent*) override { }
+    void HandleState(StateEvent*) override { }
+    void HandleMove(MoveEvent*) override { }
+};
+}
+
+void TestCheckpointFile()
+{
+    using namespace Common;
+
+    const std::string path = GetCheckpointPath("checkpoint-file");
+
+    {
+        CheckpointWriter writer;
+        CheckpointHeader* header = nullptr;
+        Span<CheckpointPlayer> players;
+
+        // Nothing to write to before it is opened
+        assert(!writer.Begin(1, header, players));
+        assert(writer.Open(path));
+
+        assert(writer.Begin(3, header, players));
+        assert(players.size == 3);
+        header->tick = 77;
+        header->nextPlayerId = 4;
+
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            players.data[i] = CheckpointPlayer{};
+            players.data[i].id = i + 1;
+            players.data[i].x = i * 10;
+            players.data[i].y = i * 20;
+        }
+
+        writer.Commit();
+        writer.Wait();
+        writer.Close();
+
+        assert(writer.GetStats().written == 1);
+        assert(writer.GetStats().skipped == 1);
+        assert(writer.GetStats().lastSize
+            == sizeof(CheckpointHeader) + 3 * sizeof(CheckpointPlayer));
+    }
+
+    {
+        CheckpointReader reader;
+        assert(reader.Open(path));
+        assert(reader.GetHeader()->tick == 77);
+        assert(reader.GetHeader()->nextPlayerId == 4);
+        assert(reader.GetPlayers().size == 3);
+        assert(reader.GetPlayers().data[2].id == 3);
+        assert(reader.GetPlayers().data[2].y == 40);
+    }
+
+    // A damaged record is caught by the checksum
+    {
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        assert(file);
+        std::fseek(file, long(sizeof(CheckpointHeader) + 4), SEEK_SET);
+        std::fputc(0x5A, file);
+        std::fclose(file);
+
+        CheckpointReader reader;
+        assert(!reader.Open(path));
+    }
+
+    // As is a file cut short
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        assert(file);
+        std::fputs("GAMECKPT", file);
+        std::fclose(file);
+
+        CheckpointReader reader;
+        assert(!reader.Open(path));
+    }
+
+    std::remove(path.c_str());
+}
+
+void TestCheckpointRestore()
+{
+    using namespace Common;
+
+    const std::string path = GetCheckpointPath("checkpoint-restore");
+
+    Game::Params params;
+    params.width = 32;
+    params.height = 32;
+    params.checkpointInterval = 2;
+
+    uint32_t firstId = 0;
+    uint32_t tick = 0;
+
+    {
+        CheckpointGame game(params);
+        assert(game.StartCheckpoints(path));
+
+        for (uint32_t i = 0; i < 5; ++i)
+        {
+            auto [handle, added] = game.CreatePlayer("10.0.0." + std::to_string(i + 1), 4000 + i);
+            assert(added);
+            game.GetPlayers().GetNextMessage(handle) = 100 + i;
+            firstId = i == 0 ? game.GetPlayers().GetId(handle) : firstId;
+
+            // One player stays off the board
+            if (i != 3)
+            {
+                assert(game.PlacePlayer(handle, Position(i, i * 2)));
+            }
+        }
+
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            game.Tick();
+        }
+
+        game.StopCheckpoints();
+        tick = game.GetTick();
+
+        // One every two ticks, unless the last was still being written,
+        // and the last one on stopping
+        const CheckpointWriter::Stats stats = game.GetCheckpointStats();
+        assert(stats.written + stats.skipped == 3);
+        assert(stats.written >= 2 && stats.failed == 0);
+    }
+
+    CheckpointGame game(params);
+    assert(game.RestoreCheckpoint(path));
+    assert(game.GetTick() == tick);
+    assert(game.GetPlayers().Size() == 5);
+
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        PlayerHandle handle = game.GetPlayerByEndpoint("10.0.0." + std::to_string(i + 1), 4000 + i);
+        assert(handle);
+        assert(game.GetPlayers().GetId(handle) == firstId + i);
+        assert(game.GetPlayers().GetNextMessage(handle) == 100 + i);
+
+        const Position& pos = game.GetPlayers().GetPosition(handle);
+        assert(i == 3 ? pos.x == UINT32_MAX : pos.x == i && pos.y == i * 2);
+    }
+
+    // The board and the id counter carry on from where they were
+    assert(!game.PlacePlayer(game.GetPlayerByEndpoint("10.0.0.5", 4004), Position(1, 2)));
+    auto [handle, added] = game.CreatePlayer("10.0.0.9", 5000);
+    assert(added && game.GetPlayers().GetId(handle) == firstId + 5);
+
+    // A checkpoint of another board is turned away
+    Game::Params other = params;
+    other.width = 64;
+    CheckpointGame mismatched(other);
+    assert(!mismatched.RestoreCheckpoint(path));
+
+    std::remove(path.c_str());
+}
+
+void CheckpointTests()
+{
+    std::cout << "Running checkpoint tests...\n";
+    TestCheckpointFile();
+    TestCheckpointRestore();
+    std::cout << "All checkpoint tests completed\n";
+}
+}
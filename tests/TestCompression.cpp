@@ -0,0 +1,209 @@
+#include "TestCompression.h"
+
+#include "Compression.h"
+#include "Message.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace Tests
+{
+void TestLzRoundTrip()
+{
+    using namespace Common;
+
+    std::vector<uint8_t> input(4096);
+    uint32_t seed = 1;
+
+    // A mix of repeated structure and noise
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        input[i] = (i % 64 < 40)
+            ? uint8_t(i % 7)
+            : uint8_t(seed >> 16);
+    }
+
+    std::vector<uint8_t> compressed(input.size() * 2);
+    std::vector<uint8_t> output(input.size());
+
+    size_t size = LzCompress(
+        { input.data(), input.size() },
+        { compressed.data(), compressed.size() });
+    assert(size > 0 && size < input.size());
+
+    size_t expanded = LzDecompress(
+        { compressed.data(), size },
+        { output.data(), output.size() });
+    assert(expanded == input.size());
+    assert(memcmp(input.data(), output.data(), input.size()) == 0);
+
+    // A truncated block or short output buffer is rejected
+    assert(LzDecompress(
+        { compressed.data(), size },
+        { output.data(), output.size() - 1 }) == 0);
+    // Not enough room to compress into
+    assert(LzCompress(
+        { input.data(), input.size() },
+        { compressed.data(), 16 }) == 0);
+}
+
+void TestLzDictionary()
+{
+    using namespace Common;
+
+    // The dictionary alone should let us compress a copy of itself to a
+    // fraction of its size.
+    Span<const uint8_t> dictionary = GetLzDictionary();
+
+    uint8_t compressed[64] = { 0 };
+    uint8_t output[256] = { 0 };
+
+    size_t size = LzCompress(dictionary, { compressed, sizeof(compressed) });
+    assert(size > 0 && size < dictionary.size / 4);
+
+    size_t expanded = LzDecompress(
+        { compressed, size },
+        { output, sizeof(output) });
+    assert(expanded == dictionary.size);
+    assert(memcmp(output, dictionary.data, dictionary.size) == 0);
+}
+
+void TestCompressMessage()
+{
+    using namespace Common;
+
+    NetworkBuffer buffer(kMaxMessageSize);
+    Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+
+    // Build a message larger than a datagram out of repeated login
+    // messages, each one followed by the next.
+    size_t offset = 0;
+    LoginMessage login;
+    login.message.messageId = 7;
+    login.session = 7;
+
+    offset = Serializer<LoginMessage>::Serialize(login, data);
+    assert(offset == kLoginMessageSize);
+
+    while (offset + kLoginMessageSize < 4 * kNetworkBufferSize)
+    {
+        offset += Serializer<LoginMessage>::Serialize(
+            login,
+            data.Subspan(offset));
+    }
+
+    Span<const uint8_t> input{ buffer.Data(), offset };
+    assert(!IsCompressed(input));
+
+    NetworkBuffer compressed;
+    size_t compressedSize = CompressMessage(
+        input,
+        { compressed.Data(), compressed.Capacity() });
+    assert(compressedSize > 0 && compressedSize < kNetworkBufferSize);
+
+    Span<const uint8_t> compressedData{ compressed.Data(), compressedSize };
+    assert(IsCompressed(compressedData));
+    assert(!Serializer<LoginMessage>::Deserialize(compressedData));
+
+    NetworkBuffer expanded(kMaxMessageSize);
+    size_t expandedSize = DecompressMessage(
+        compressedData,
+        { expanded.Data(), expanded.Capacity() });
+    assert(expandedSize == offset);
+
+    Span<const uint8_t> expandedData{ expanded.Data(), expandedSize };
+    assert(!IsCompressed(expandedData));
+    assert(memcmp(
+        expanded.Data() + kMessageHeaderSize,
+        buffer.Data() + kMessageHeaderSize,
+        offset - kMessageHeaderSize) == 0);
+
+    std::optional<LoginMessage> result
+        = Serializer<LoginMessage>::Deserialize(expandedData);
+    assert(result.has_value());
+    assert(result->message.messageId == login.message.messageId);
+    assert(result->session == login.session);
+}
+
+void TestCompressMessageNoSavings()
+{
+    using namespace Common;
+
+    NetworkBuffer buffer;
+    Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+
+    AcknowledgeMessage ack;
+    ack.message.messageId = 0x5A5A5A5A;
+    ack.messageId = 0x0123456789ABCDEFULL;
+
+    size_t size = Serializer<AcknowledgeMessage>::Serialize(ack, data);
+
+    // Nothing in this message is worth compressing so we should be told to
+    // send the original.
+    NetworkBuffer compressed;
+    assert(CompressMessage(
+        { buffer.Data(), size },
+        { compressed.Data(), compressed.Capacity() }) == 0);
+}
+
+void TestCompressStateMessage()
+{
+    using namespace Common;
+
+    NetworkBuffer buffer;
+    Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+
+    // A crowd standing on the spawn cell, the State shape that repeats
+    // the most
+    const PositionCodec codec(64, 64);
+    StateMessage state;
+    state.message.messageId = 1;
+    state.tick = 1;
+    state.count = StateMessage::kMaxEntries;
+    for (uint16_t i = 0; i < state.count; ++i)
+    {
+        state.entries[i] = { 1u + i, 5, 5 };
+    }
+
+    size_t size = Serializer<StateMessage>::Serialize(state, codec, data);
+    assert(size > 0);
+
+    NetworkBuffer compressed;
+    size_t compressedSize = CompressMessage(
+        { buffer.Data(), size },
+        { compressed.Data(), compressed.Capacity() });
+    assert(compressedSize > 0 && compressedSize < size);
+
+    NetworkBuffer expanded;
+    size_t expandedSize = DecompressMessage(
+        { compressed.Data(), compressedSize },
+        { expanded.Data(), expanded.Capacity() });
+    assert(expandedSize == size);
+
+    std::optional<StateMessage> result = Serializer<StateMessage>::Deserialize(
+        { expanded.Data(), expandedSize },
+        codec);
+    assert(result && result->count == state.count);
+    assert(result->entries[31].playerId == 32);
+    assert(result->entries[31].x == 5 && result->entries[31].y == 5);
+
+    // Told to send the original when the output would not be smaller
+    assert(CompressMessage(
+        { buffer.Data(), size },
+        { compressed.Data(), compressedSize - 1 }) == 0);
+}
+
+void CompressionTests()
+{
+    std::cout << "Running compression tests...\n";
+    TestLzRoundTrip();
+    TestLzDictionary();
+    TestCompressMessage();
+    TestCompressMessageNoSavings();
+    TestCompressStateMessage();
+    std::cout << "All compression tests completed\n";
+}
+}
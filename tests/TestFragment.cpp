@@ -0,0 +1,234 @@
+#include "TestFragment.h"
+
+#include "Fragment.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace Tests
+{
+namespace
+{
+using Fragments = std::vector<std::vector<uint8_t>>;
+
+Fragments Split(const std::vector<uint8_t>& message, uint32_t source, uint16_t group)
+{
+    using namespace Common;
+
+    Fragments fragments;
+    uint8_t buffer[kNetworkBufferSize];
+
+    for (uint32_t i = 0; i < GetFragmentCount(message.size()); ++i)
+    {
+        const size_t size = WriteFragment(
+            { message.data(), message.size() },
+            source,
+            group,
+            i,
+            { buffer, sizeof(buffer) });
+
+        assert(size > kFragmentHeaderSize && size <= kNetworkBufferSize);
+        fragments.emplace_back(buffer, buffer + size);
+    }
+
+    return fragments;
+}
+
+std::vector<uint8_t> MakeMessage(size_t size)
+{
+    std::vector<uint8_t> message(size);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        message[i] = uint8_t(i * 7 + i / 251);
+    }
+
+    return message;
+}
+
+Common::FragmentAssembler::Result Add(
+    Common::FragmentAssembler& assembler,
+    const std::vector<uint8_t>& fragment,
+    Common::FragmentAssembler::Clock::time_point now,
+    Common::Span<const uint8_t>& message,
+    const char* address = "10.0.0.1")
+{
+    return assembler.Add(address, { fragment.data(), fragment.size() }, now, message);
+}
+}
+
+void TestFragmentWire()
+{
+    using namespace Common;
+
+    assert(GetFragmentCount(1) == 1);
+    assert(GetFragmentCount(kFragmentPayload) == 1);
+    assert(GetFragmentCount(kFragmentPayload + 1) == 2);
+    assert(GetFragmentCount(kMaxMessageSize) == kMaxFragments);
+
+    const std::vector<uint8_t> message = MakeMessage(3 * kFragmentPayload + 10);
+    const Fragments fragments = Split(message, 42, 7);
+    assert(fragments.size() == 4);
+    assert(fragments.back().size() == kFragmentHeaderSize + 10);
+
+    FragmentHeader header;
+    Span<const uint8_t> data;
+    assert(ReadFragment({ fragments[2].data(), fragments[2].size() }, header, data));
+    assert(header.source == 42 && header.group == 7);
+    assert(header.index == 2 && header.count == 4);
+    assert(header.size == message.size());
+    assert(data.size == kFragmentPayload);
+    assert(memcmp(data.data, message.data() + 2 * kFragmentPayload, data.size) == 0);
+
+    // Never mistaken for the other headers
+    assert(IsFragment({ fragments[0].data(), fragments[0].size() }));
+    assert(!IsCompact({ fragments[0].data(), fragments[0].size() }));
+    assert(!IsCompressed({ fragments[0].data(), fragments[0].size() }));
+
+    // Corrupted or cut short
+    std::vector<uint8_t> corrupt = fragments[1];
+    corrupt[kFragmentHeaderSize + 5] ^= 0x10;
+    assert(!ReadFragment({ corrupt.data(), corrupt.size() }, header, data));
+    assert(!ReadFragment({ fragments[1].data(), fragments[1].size() - 1 }, header, data));
+
+    // Too large to send at all
+    const std::vector<uint8_t> huge(kMaxMessageSize + 1);
+    uint8_t buffer[kNetworkBufferSize];
+    assert(!WriteFragment({ huge.data(), huge.size() }, 1, 1, 0, { buffer, sizeof(buffer) }));
+}
+
+void TestFragmentReassembly()
+{
+    using namespace Common;
+
+    FragmentAssembler assembler;
+    const FragmentAssembler::Clock::time_point now;
+
+    const std::vector<uint8_t> message = MakeMessage(kMaxMessageSize);
+    const Fragments fragments = Split(message, 1, 100);
+    Span<const uint8_t> result;
+
+    // Out of order, with a duplicate along the way
+    for (size_t i = fragments.size() - 1; i > 0; --i)
+    {
+        assert(Add(assembler, fragments[i], now, result) == FragmentAssembler::Result::Incomplete);
+    }
+    assert(Add(assembler, fragments[3], now, result) == FragmentAssembler::Result::Duplicate);
+    assert(assembler.GetPartialCount() == 1);
+
+    assert(Add(assembler, fragments[0], now, result) == FragmentAssembler::Result::Complete);
+    assert(result.size == message.size());
+    assert(memcmp(result.data, message.data(), message.size()) == 0);
+    assert(assembler.GetPartialCount() == 0);
+
+    // The finished buffer is reused once the next fragment arrives
+    const Fragments next = Split(MakeMessage(2 * kFragmentPayload), 1, 101);
+    assert(Add(assembler, next[0], now, result) == FragmentAssembler::Result::Incomplete);
+    assert(assembler.GetPooledCount() == 0);
+    assert(Add(assembler, next[1], now, result) == FragmentAssembler::Result::Complete);
+
+    const FragmentAssembler::Stats& stats = assembler.GetStats();
+    assert(stats.messages == 2);
+    assert(stats.duplicates == 1);
+    assert(stats.fragments == fragments.size() + 3);
+
+    // A corrupted fragment is turned away and the message completes once
+    // the good copy arrives
+    std::vector<uint8_t> corrupt = next[0];
+    corrupt.back() ^= 1;
+    assert(Add(assembler, corrupt, now, result) == FragmentAssembler::Result::Invalid);
+    assert(assembler.GetStats().invalid == 1);
+}
+
+void TestFragmentSources()
+{
+    using namespace Common;
+
+    FragmentAssembler assembler;
+    const FragmentAssembler::Clock::time_point now;
+    Span<const uint8_t> result;
+
+    // The same group from two senders at one address stays apart
+    const std::vector<uint8_t> a = MakeMessage(2 * kFragmentPayload);
+    std::vector<uint8_t> b = MakeMessage(2 * kFragmentPayload);
+    b[0] ^= 0xFF;
+    const Fragments fa = Split(a, 1, 5);
+    const Fragments fb = Split(b, 2, 5);
+
+    assert(Add(assembler, fa[0], now, result) == FragmentAssembler::Result::Incomplete);
+    assert(Add(assembler, fb[0], now, result) == FragmentAssembler::Result::Incomplete);
+    assert(Add(assembler, fa[1], now, result) == FragmentAssembler::Result::Complete);
+    assert(memcmp(result.data, a.data(), a.size()) == 0);
+    assert(Add(assembler, fb[1], now, result) == FragmentAssembler::Result::Complete);
+    assert(memcmp(result.data, b.data(), b.size()) == 0);
+
+    // As do the same sender and group from two addresses
+    assert(Add(assembler, fa[0], now, result, "10.0.0.1") == FragmentAssembler::Result::Incomplete);
+    assert(Add(assembler, fa[0], now, result, "10.0.0.2") == FragmentAssembler::Result::Incomplete);
+    assert(assembler.GetPartialCount() == 2);
+
+    // Not an address at all
+    assert(Add(assembler, fa[1], now, result, "nowhere") == FragmentAssembler::Result::Invalid);
+}
+
+void TestFragmentBounds()
+{
+    using namespace Common;
+    using namespace std::chrono;
+
+    FragmentAssembler assembler;
+    const FragmentAssembler::Clock::time_point start;
+    Span<const uint8_t> result;
+
+    const std::vector<uint8_t> message = MakeMessage(2 * kFragmentPayload);
+
+    // One sender starting more messages than it may have in flight pushes
+    // out its oldest
+    for (uint16_t group = 0; group <= FragmentAssembler::kMaxPartials; ++group)
+    {
+        const Fragments fragments = Split(message, 9, group);
+        assert(Add(assembler, fragments[0], start + milliseconds(group), result)
+            == FragmentAssembler::Result::Incomplete);
+    }
+
+    assert(assembler.GetPartialCount() == FragmentAssembler::kMaxPartials);
+    assert(assembler.GetStats().evicted == 1);
+
+    // The evicted message starts over instead of completing
+    assert(Add(assembler, Split(message, 9, 0)[1], start, result)
+        == FragmentAssembler::Result::Incomplete);
+    assert(assembler.GetStats().evicted == 2);
+
+    // Partial messages time out, freeing their buffers for reuse
+    assembler.Expire(start + FragmentAssembler::kTimeout - milliseconds(1));
+    assert(assembler.GetPartialCount() == FragmentAssembler::kMaxPartials);
+
+    assembler.Expire(start + FragmentAssembler::kTimeout + milliseconds(10));
+    assert(assembler.GetPartialCount() == 0);
+    assert(assembler.GetStats().expired == FragmentAssembler::kMaxPartials);
+    assert(assembler.GetPooledCount() == FragmentAssembler::kMaxPartials);
+
+    // Only so many senders may have partial messages at once
+    for (uint32_t source = 0; source < FragmentAssembler::kMaxSenders; ++source)
+    {
+        assert(Add(assembler, Split(message, source, 0)[0], start, result)
+            == FragmentAssembler::Result::Incomplete);
+    }
+
+    assert(Add(assembler, Split(message, UINT32_MAX, 0)[0], start, result)
+        == FragmentAssembler::Result::Dropped);
+    assert(assembler.GetStats().dropped == 1);
+}
+
+void FragmentTests()
+{
+    std::cout << "Running fragment tests...\n";
+    TestFragmentWire();
+    TestFragmentReassembly();
+    TestFragmentSources();
+    TestFragmentBounds();
+    std::cout << "All fragment tests completed\n";
+}
+}
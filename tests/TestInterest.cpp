@@ -0,0 +1,114 @@
+#include "TestInterest.h"
+
+#include "Interest.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+namespace Tests
+{
+void TestInterestBasic()
+{
+    using namespace Common;
+
+    InterestManager interest(4);
+
+    interest.Update(1, Position(10, 10));
+    interest.Update(2, Position(14, 6));
+    interest.Update(3, Position(15, 10));
+
+    // 2 is exactly at the radius, 3 is one past it
+    Span<const uint32_t> visible = interest.GetVisible(1);
+    assert(visible.size == 1 && visible.data[0] == 2);
+    assert(interest.GetVisible(2).size == 2);
+    assert(interest.GetVisible(3).size == 1);
+
+    // Moving 3 into range updates both sides
+    interest.Update(3, Position(12, 8));
+    assert(interest.GetVisible(1).size == 2);
+    assert(interest.GetVisible(3).size == 2);
+
+    // And moving 1 far away clears it from everyone
+    interest.Update(1, Position(1000, 1000));
+    assert(interest.GetVisible(1).size == 0);
+    assert(interest.GetVisible(2).size == 1);
+    assert(interest.GetVisible(3).size == 1);
+
+    interest.Remove(2);
+    assert(interest.GetVisible(3).size == 0);
+    assert(interest.GetVisible(2).size == 0);
+    assert(interest.Size() == 2);
+}
+
+void TestInterestMatchesBruteForce()
+{
+    using namespace Common;
+
+    constexpr uint32_t kPlayers = 200;
+    constexpr uint32_t kSize = 128;
+
+    InterestManager interest(10);
+    std::vector<Position> positions(kPlayers);
+
+    uint32_t seed = 7;
+    auto Random = [&seed](uint32_t range)
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 8) % range;
+    };
+
+    for (uint32_t id = 0; id < kPlayers; ++id)
+    {
+        positions[id] = Position(Random(kSize), Random(kSize));
+        interest.Update(id, positions[id]);
+    }
+
+    // Mostly small steps with the odd teleport
+    for (uint32_t step = 0; step < 2000; ++step)
+    {
+        const uint32_t id = Random(kPlayers);
+        Position& pos = positions[id];
+
+        if (Random(10) == 0)
+        {
+            pos = Position(Random(kSize), Random(kSize));
+        }
+        else
+        {
+            pos.x = std::min(kSize - 1, pos.x + Random(3) - std::min(pos.x, 1u));
+            pos.y = std::min(kSize - 1, pos.y + Random(3) - std::min(pos.y, 1u));
+        }
+        interest.Update(id, pos);
+    }
+
+    for (uint32_t id = 0; id < kPlayers; ++id)
+    {
+        std::vector<uint32_t> expected;
+        for (uint32_t other = 0; other < kPlayers; ++other)
+        {
+            if (other != id && interest.IsVisible(positions[id], positions[other]))
+            {
+                expected.push_back(other);
+            }
+        }
+
+        Span<const uint32_t> visible = interest.GetVisible(id);
+        assert(visible.size == expected.size());
+
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            assert(visible.data[i] == expected[i]);
+        }
+    }
+}
+
+void InterestTests()
+{
+    std::cout << "Running interest tests...\n";
+    TestInterestBasic();
+    TestInterestMatchesBruteForce();
+    std::cout << "All interest tests completed\n";
+}
+}
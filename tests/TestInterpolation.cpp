@@ -0,0 +1,100 @@
+#include "TestInterpolation.h"
+
+#include "Interpolation.h"
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+namespace Tests
+{
+void TestSnapshotBuffer()
+{
+    using namespace Common;
+
+    SnapshotBuffer buffer;
+    RenderPosition pos;
+
+    assert(buffer.GetPosition(0.0, pos) == SnapshotBuffer::Sample::None);
+
+    // Out of order and duplicate snapshots end up sorted once
+    buffer.Add(10, Position(4, 4));
+    buffer.Add(12, Position(6, 4));
+    buffer.Add(11, Position(5, 4));
+    buffer.Add(11, Position(9, 9));
+    assert(buffer.Size() == 3);
+    assert(buffer.Get(1).tick == 11 && buffer.Get(1).pos.x == 5);
+
+    assert(buffer.GetPosition(10.5, pos) == SnapshotBuffer::Sample::Interpolated);
+    assert(pos.x == 4.5 && pos.y == 4.0);
+
+    assert(buffer.GetPosition(9.0, pos) == SnapshotBuffer::Sample::Held);
+    assert(pos.x == 4.0);
+
+    // Past the newest snapshot motion carries on for a bounded time
+    assert(buffer.GetPosition(13.0, pos) == SnapshotBuffer::Sample::Extrapolated);
+    assert(pos.x == 7.0);
+    assert(buffer.GetPosition(20.0, pos) == SnapshotBuffer::Sample::Extrapolated);
+    assert(pos.x == 6.0 + SnapshotBuffer::kMaxExtrapolation);
+
+    // A jump no walk could make is not smoothed
+    buffer.Add(13, Position(30, 4));
+    assert(buffer.GetPosition(12.5, pos) == SnapshotBuffer::Sample::Held);
+    assert(pos.x == 6.0);
+    assert(buffer.GetPosition(14.0, pos) == SnapshotBuffer::Sample::Held);
+    assert(pos.x == 30.0);
+
+    // Full buffers forget the oldest snapshot
+    for (uint32_t tick = 14; tick < 14 + SnapshotBuffer::kCapacity; ++tick)
+    {
+        buffer.Add(tick, Position(30, 4));
+    }
+    assert(buffer.Size() == SnapshotBuffer::kCapacity);
+    assert(buffer.Get(0).tick == 14);
+}
+
+void TestSnapshotClock()
+{
+    using namespace Common;
+    using namespace std::chrono;
+
+    constexpr milliseconds kInterval(30);
+
+    const steady_clock::time_point start = steady_clock::now();
+
+    // A steady stream keeps the minimum delay
+    SnapshotClock steady(kInterval);
+    for (uint32_t tick = 100; tick < 200; ++tick)
+    {
+        steady.OnSnapshot(tick, start + (tick - 100) * kInterval);
+    }
+
+    assert(steady.GetDelay() < SnapshotClock::kMinDelay + 0.01);
+
+    const double render = steady.GetRenderTick(start + 99 * kInterval);
+    assert(std::abs(render - (199.0 - SnapshotClock::kMinDelay)) < 0.01);
+
+    // Render time never goes backwards
+    assert(steady.GetRenderTick(start) == render);
+
+    // Arrivals bunching up raise the delay, a little at a time
+    SnapshotClock jittery(kInterval);
+    for (uint32_t tick = 100; tick < 300; ++tick)
+    {
+        const milliseconds late((tick % 3) * 25);
+        jittery.OnSnapshot(tick, start + (tick - 100) * kInterval + late);
+    }
+
+    assert(jittery.GetJitter() > 0.0);
+    assert(jittery.GetDelay() > SnapshotClock::kMinDelay);
+    assert(jittery.GetDelay() <= SnapshotClock::kMaxDelay);
+}
+
+void InterpolationTests()
+{
+    std::cout << "Running interpolation tests...\n";
+    TestSnapshotBuffer();
+    TestSnapshotClock();
+    std::cout << "All interpolation tests completed\n";
+}
+}
@@ -0,0 +1,117 @@
+#include "TestJitterBuffer.h"
+
+#include "JitterBuffer.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace Tests
+{
+void TestJitterBufferRelease()
+{
+    using namespace Common;
+
+    JitterBuffer buffer;
+    Movement movement;
+
+    // Inputs come out in tick order whatever order they arrived in
+    assert(buffer.Push(12, 9, Movement::Down) == JitterBuffer::Result::Buffered);
+    assert(buffer.Push(10, 9, Movement::Left) == JitterBuffer::Result::Buffered);
+    assert(buffer.Push(11, 9, Movement::Up) == JitterBuffer::Result::Buffered);
+    assert(buffer.Size() == 3);
+
+    assert(!buffer.Pop(9, movement));
+    assert(buffer.Pop(10, movement) && movement == Movement::Left);
+    assert(!buffer.Pop(10, movement));
+
+    // The latest input for a tick wins
+    assert(buffer.Push(11, 10, Movement::Right) == JitterBuffer::Result::Buffered);
+    assert(buffer.Size() == 2);
+    assert(buffer.Pop(11, movement) && movement == Movement::Right);
+
+    // One input per tick, a backlog drains a tick at a time
+    assert(buffer.Pop(20, movement) && movement == Movement::Down);
+    assert(buffer.IsEmpty());
+
+    // Late inputs run on the current tick
+    assert(buffer.Push(5, 8, Movement::Up) == JitterBuffer::Result::Late);
+    assert(!buffer.Pop(7, movement));
+    assert(buffer.Pop(8, movement) && movement == Movement::Up);
+
+    // A late input never replaces one which arrived in time, it takes the
+    // next tick without an input
+    assert(buffer.Push(8, 8, Movement::Left) == JitterBuffer::Result::Buffered);
+    assert(buffer.Push(9, 8, Movement::Right) == JitterBuffer::Result::Buffered);
+    assert(buffer.Push(6, 8, Movement::Down) == JitterBuffer::Result::Late);
+    assert(buffer.Size() == 3);
+    assert(buffer.Pop(8, movement) && movement == Movement::Left);
+    assert(buffer.Pop(9, movement) && movement == Movement::Right);
+    assert(!buffer.Pop(9, movement));
+    assert(buffer.Pop(10, movement) && movement == Movement::Down);
+    assert(buffer.IsEmpty());
+
+    assert(buffer.Push(8 + JitterBuffer::kMaxLead + 1, 8, Movement::Up)
+        == JitterBuffer::Result::TooEarly);
+    assert(buffer.IsEmpty());
+
+    for (uint32_t i = 0; i < JitterBuffer::kCapacity; ++i)
+    {
+        assert(buffer.Push(10 + i, 9, Movement::Left) == JitterBuffer::Result::Buffered);
+    }
+    assert(buffer.Push(10 + JitterBuffer::kCapacity, 9, Movement::Left)
+        == JitterBuffer::Result::Full);
+}
+
+void TestJitterBufferAdaptation()
+{
+    using namespace Common;
+
+    Movement movement;
+
+    // A steady client three ticks early can cut its lead to nothing
+    JitterBuffer steady;
+    assert(steady.GetLeadError() == 0);
+
+    for (uint32_t now = 0; now < 64; ++now)
+    {
+        steady.Push(now + 3, now, Movement::Left);
+        steady.Pop(now, movement);
+    }
+
+    assert(steady.GetTargetLead() == 0);
+    assert(steady.GetLeadError() == 3);
+
+    // The same average lead with jitter needs a margin, so there is less
+    // to give back
+    JitterBuffer jittery;
+
+    for (uint32_t now = 0; now < 64; ++now)
+    {
+        jittery.Push(now + ((now & 1) ? 5 : 1), now, Movement::Left);
+        jittery.Pop(now, movement);
+    }
+
+    assert(jittery.GetTargetLead() >= 2);
+    assert(jittery.GetTargetLead() <= JitterBuffer::kMaxTargetLead);
+    assert(jittery.GetLeadError() < steady.GetLeadError());
+
+    // Inputs arriving after their tick ask for more lead
+    JitterBuffer late;
+
+    for (uint32_t now = 10; now < 64; ++now)
+    {
+        late.Push(now - 2, now, Movement::Left);
+        late.Pop(now, movement);
+    }
+
+    assert(late.GetLeadError() < 0);
+}
+
+void JitterBufferTests()
+{
+    std::cout << "Running jitter buffer tests...\n";
+    TestJitterBufferRelease();
+    TestJitterBufferAdaptation();
+    std::cout << "All jitter buffer tests completed\n";
+}
+}
@@ -0,0 +1,117 @@
+#include "TestJobSystem.h"
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+namespace Tests
+{
+void TestJobSystemCoverage()
+{
+    using namespace Common;
+
+    assert(JobSystem::GetJobCount(0, 8) == 0);
+    assert(JobSystem::GetJobCount(8, 8) == 1);
+    assert(JobSystem::GetJobCount(9, 8) == 2);
+
+    for (uint32_t threads : { 1u, 2u, 3u, 8u })
+    {
+        JobSystem jobs(threads);
+        assert(jobs.GetThreadCount() == threads);
+
+        // Every item is handed to exactly one job, batch after batch
+        for (size_t count : { size_t(0), size_t(1), size_t(7), size_t(1000) })
+        {
+            std::vector<uint32_t> seen(count, 0);
+            std::vector<size_t> jobBegins(JobSystem::GetJobCount(count, 7), SIZE_MAX);
+
+            jobs.Run(count, 7, [&](size_t begin, size_t end, size_t job)
+            {
+                assert(begin == job * 7);
+                assert(end == std::min(count, begin + 7));
+                jobBegins[job] = begin;
+
+                for (size_t i = begin; i < end; ++i)
+                {
+                    seen[i] += 1;
+                }
+            });
+
+            for (uint32_t n : seen)
+            {
+                assert(n == 1);
+            }
+
+            for (size_t begin : jobBegins)
+            {
+                assert(begin != SIZE_MAX);
+            }
+        }
+
+        assert(jobs.GetStats().batches == 3);
+        assert(jobs.GetStats().jobs == 1 + 1 + 143);
+    }
+}
+
+void TestJobSystemDeterminism()
+{
+    using namespace Common;
+
+    constexpr size_t kItems = 5000;
+    constexpr size_t kJobSize = 64;
+
+    // Uneven work per item, with per-job sums folded in job order
+    auto Run = [](uint32_t threads)
+    {
+        JobSystem jobs(threads);
+        std::vector<uint64_t> sums(JobSystem::GetJobCount(kItems, kJobSize), 0);
+        std::vector<uint64_t> items(kItems, 0);
+
+        for (uint32_t batch = 0; batch < 20; ++batch)
+        {
+            jobs.Run(kItems, kJobSize, [&](size_t begin, size_t end, size_t job)
+            {
+                uint64_t sum = 0;
+
+                for (size_t i = begin; i < end; ++i)
+                {
+                    uint64_t value = items[i] + i + batch;
+
+                    for (size_t n = 0; n < (i % 17) * 10; ++n)
+                    {
+                        value = value * 6364136223846793005ull + 1442695040888963407ull;
+                    }
+
+                    items[i] = value;
+                    sum ^= value + sum * 31;
+                }
+
+                sums[job] = sums[job] * 33 + sum;
+            });
+        }
+
+        uint64_t result = 0;
+        for (uint64_t sum : sums)
+        {
+            result = result * 1099511628211ull + sum;
+        }
+        return result;
+    };
+
+    const uint64_t expected = Run(1);
+    assert(Run(2) == expected);
+    assert(Run(4) == expected);
+    assert(Run(7) == expected);
+}
+
+void JobSystemTests()
+{
+    std::cout << "Running job system tests...\n";
+    TestJobSystemCoverage();
+    TestJobSystemDeterminism();
+    std::cout << "All job system tests completed\n";
+}
+}
@@ -1,8 +1,10 @@
 #include "TestMessages.h"
 
+#include "Memory.h"
 #include "Message.h"
 
 #include <cassert>
+#include <cstring>
 #include <iostream>
 
 namespace Tests
@@ -68,7 +70,7 @@ void TestLoginMessageSerializer()
     assert(result.has_value());
     assert(result->message.action == login.message.action);
     assert(result->message.messageId == login.message.messageId);
-    assert(result->message.header.payloadSize == kMessageHeaderSize + payload.size);
+    assert(result->message.header.payloadSize == payload.size);
     assert(result->message.header.hash == login.message.header.hash);
 }
 
@@ -85,6 +87,9 @@ void TestPingMessageSerializer()
     ping.message.messageId = 99;
     ping.playerId = 99;
     ping.messageId = 99;
+    ping.times.sendTime = 123456;
+    ping.times.echoTime = 654321;
+    ping.times.echoDelay = 1000;
 
     size_t serializedSize = Serializer<PingMessage>::Serialize(
         ping,
@@ -99,9 +104,26 @@ void TestPingMessageSerializer()
     assert(result.has_value());
     assert(result->message.action == ping.message.action);
     assert(result->message.messageId == ping.message.messageId);
-    assert(result->message.header.payloadSize == kMessageHeaderSize + payload.size);
+    assert(result->message.header.payloadSize == payload.size);
     assert(result->message.header.hash == ping.message.header.hash);
     assert(result->messageId == ping.messageId);
+    assert(result->times.sendTime == ping.times.sendTime);
+    assert(result->times.echoTime == ping.times.echoTime);
+    assert(result->times.echoDelay == ping.times.echoDelay);
+
+    // Pings from before the timestamps still parse, with nothing to echo
+    const size_t oldSize = serializedSize - kMessageTimesSize;
+    SerializeHeader(
+        ping.message.header,
+        data.Subspan(0, kMessageHeaderSize),
+        constData.Subspan(kMessageHeaderSize, oldSize));
+
+    std::optional<PingMessage> old = Serializer<PingMessage>::Deserialize(
+        constData.Subspan(0, oldSize));
+
+    assert(old.has_value());
+    assert(old->messageId == ping.messageId);
+    assert(old->times.echoDelay == MessageTimes::kNoEcho);
 }
 
 void TestAckMessageSerializer()
@@ -116,6 +138,9 @@ void TestAckMessageSerializer()
     AcknowledgeMessage ack;
     ack.message.messageId = 99;
     ack.messageId = 99;
+    ack.times.sendTime = 5;
+    ack.times.echoTime = UINT32_MAX;
+    ack.times.echoDelay = 70;
 
     size_t serializedSize = Serializer<AcknowledgeMessage>::Serialize(
         ack,
@@ -130,9 +155,372 @@ void TestAckMessageSerializer()
     assert(result.has_value());
     assert(result->message.action == ack.message.action);
     assert(result->message.messageId == ack.message.messageId);
-    assert(result->message.header.payloadSize == kMessageHeaderSize + payload.size);
+    assert(result->message.header.payloadSize == payload.size);
     assert(result->message.header.hash == ack.message.header.hash);
     assert(result->messageId == ack.messageId);
+    assert(result->times.sendTime == ack.times.sendTime);
+    assert(result->times.echoTime == ack.times.echoTime);
+    assert(result->times.echoDelay == ack.times.echoDelay);
+}
+
+void TestStateMessageSerializer()
+{
+    using namespace Common;
+
+    NetworkBuffer buffer;
+
+    Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+    Span<const uint8_t> constData{ buffer.Data(), buffer.Capacity() };
+
+    StateMessage state;
+    state.message.messageId = 99;
+    state.tick = 123456;
+    state.inputOffset = -3;
+    state.count = 3;
+    state.entries[0] = { 1, 10, 20 };
+    state.entries[1] = { 7, 0, 63 };
+    state.entries[2] = { 0xFFFFFFF0, 63, 5 };
+
+    // 32 bit ids and 6 + 6 bit positions on a 64x64 board
+    const PositionCodec codec(64, 64);
+    assert(GetStateEntryBits(codec) == 44);
+
+    size_t serializedSize = Serializer<StateMessage>::Serialize(
+        state,
+        codec,
+        data);
+    assert(serializedSize == GetStateMessageBytes(3, codec));
+    assert(serializedSize == kStateMessageSize + 17);
+
+    std::optional<StateMessage> result = Serializer<StateMessage>::Deserialize(
+        constData,
+        codec);
+
+    assert(result.has_value());
+    assert(result->message.action == Action::State);
+    assert(result->message.messageId == state.message.messageId);
+    assert(result->tick == state.tick);
+    assert(result->inputOffset == state.inputOffset);
+    assert(result->count == state.count);
+
+    for (uint16_t i = 0; i < state.count; ++i)
+    {
+        assert(result->entries[i].playerId == state.entries[i].playerId);
+        assert(result->entries[i].x == state.entries[i].x);
+        assert(result->entries[i].y == state.entries[i].y);
+    }
+
+    // A count larger than the payload is rejected
+    std::optional<StateMessage> truncated = Serializer<StateMessage>::Deserialize(
+        constData.Subspan(0, serializedSize - 1),
+        codec);
+    assert(!truncated);
+
+    // Removed ids follow the entries
+    state.removedCount = 2;
+    state.removed[0] = 4;
+    state.removed[1] = 0xFFFFFFFE;
+
+    serializedSize = Serializer<StateMessage>::Serialize(state, codec, data);
+    assert(serializedSize == GetStateMessageBytes(3, codec) + 8);
+
+    result = Serializer<StateMessage>::Deserialize(constData, codec);
+    assert(result && result->count == state.count && result->removedCount == 2);
+    assert(result->entries[2].playerId == state.entries[2].playerId);
+    assert(result->removed[0] == 4 && result->removed[1] == 0xFFFFFFFE);
+
+    truncated = Serializer<StateMessage>::Deserialize(
+        constData.Subspan(0, serializedSize - 1),
+        codec);
+    assert(!truncated);
+
+    state.removedCount = 0;
+
+    // Positions off the board cannot be packed
+    state.entries[2] = { 9, 64, 5 };
+    assert(Serializer<StateMessage>::Serialize(state, codec, data) == 0);
+
+    assert(GetStateMessageBytes(0, codec) == kStateMessageSize);
+    assert(GetStateMessageBytes(32, codec) == kStateMessageSize + 176);
+    assert(GetStateMessageBytes(33, codec) == 2 * kStateMessageSize + 176 + 6);
+}
+
+void TestMoveMessageSerializer()
+{
+    using namespace Common;
+
+    NetworkBuffer buffer;
+
+    Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+    Span<const uint8_t> constData{ buffer.Data(), buffer.Capacity() };
+
+    MoveMessage move;
+    move.message.messageId = 99;
+    move.playerId = 12;
+    move.tick = 70000;
+    move.movement = Movement::Down;
+
+    size_t serializedSize = Serializer<MoveMessage>::Serialize(
+        move,
+        data);
+    assert(serializedSize == kMoveMessageSize);
+
+    std::optional<MoveMessage> result = Serializer<MoveMessage>::Deserialize(
+        constData);
+
+    assert(result.has_value());
+    assert(result->message.action == Action::Move);
+    assert(result->message.messageId == move.message.messageId);
+    assert(result->playerId == move.playerId);
+    assert(result->tick == move.tick);
+    assert(result->movement == move.movement);
+}
+
+void TestCompactMessage()
+{
+    using namespace Common;
+
+    NetworkBuffer buffer;
+    NetworkBuffer compact;
+    NetworkBuffer expanded;
+
+    Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+    Span<const uint8_t> constData{ buffer.Data(), buffer.Capacity() };
+
+    MoveMessage move;
+    move.message.messageId = 0x12345;
+    move.playerId = 12;
+    move.tick = 70000;
+    move.movement = Movement::Up;
+
+    const size_t serializedSize = Serializer<MoveMessage>::Serialize(move, data);
+
+    const size_t compactSize = EncodeCompactMessage(
+        constData.Subspan(0, serializedSize),
+        CompactHeader::kFlagAck,
+        0xBEEF,
+        0x80000001,
+        { compact.Data(), compact.Capacity() });
+    Span<const uint8_t> compactData{ compact.Data(), compactSize };
+
+    assert(compactSize == serializedSize - kMessageSize + kCompactHeaderSize);
+    assert(IsCompact(compactData));
+    assert(!IsCompact(constData));
+    assert(!IsCompressed(compactData));
+
+    CompactHeader header;
+    const size_t expandedSize = DecodeCompactMessage(
+        compactData,
+        { expanded.Data(), expanded.Capacity() },
+        header);
+
+    assert(expandedSize == serializedSize);
+    assert(header.flags == CompactHeader::kFlagAck);
+    assert(header.action == uint8_t(Action::Move));
+    assert(header.sequence == 0x2345);
+    assert(header.ack == 0xBEEF);
+    assert(header.ackBits == 0x80000001);
+
+    // Reads back as the original, with the id cut to the sequence
+    std::optional<MoveMessage> result = Serializer<MoveMessage>::Deserialize(
+        { expanded.Data(), expandedSize });
+
+    assert(result.has_value());
+    assert(result->message.messageId == 0x2345);
+    assert(result->playerId == move.playerId);
+    assert(result->tick == move.tick);
+    assert(result->movement == move.movement);
+
+    // Signed as every older peer expects, the header before the payload
+    // and the version 1 body in order
+    {
+        uint8_t ordered[kNetworkBufferSize];
+        const size_t headerSize = kCompactHeaderSize - sizeof(uint32_t);
+        memcpy(ordered, compact.Data(), headerSize);
+        memcpy(
+            ordered + headerSize,
+            compact.Data() + kCompactHeaderSize,
+            compactSize - kCompactHeaderSize);
+        assert(header.checksum == FNV1A_32(ordered, compactSize - sizeof(uint32_t)));
+
+        assert(move.message.header.flags == 0);
+        assert(move.message.header.hash == FNV1A_64(
+            buffer.Data() + kMessageHeaderSize,
+            serializedSize - kMessageHeaderSize));
+    }
+
+    // Older builds wrote the size of the whole datagram as payloadSize,
+    // which still reads
+    {
+        NetworkBuffer legacy;
+        memcpy(legacy.Data(), buffer.Data(), serializedSize);
+        MemoryWriter(legacy.Data(), kMessageHeaderSize).Put32_BE(
+            kMessageHeaderSize - sizeof(uint32_t),
+            uint32_t(serializedSize));
+
+        std::optional<MoveMessage> old = Serializer<MoveMessage>::Deserialize(
+            { legacy.Data(), serializedSize });
+        assert(old && old->message.header.payloadSize == serializedSize);
+        assert(old->tick == move.tick);
+    }
+
+    // Encoding in place gives the same bytes
+    assert(EncodeCompactMessage(
+        constData.Subspan(0, serializedSize),
+        CompactHeader::kFlagAck,
+        0xBEEF,
+        0x80000001,
+        data) == compactSize);
+    assert(memcmp(buffer.Data(), compact.Data(), compactSize) == 0);
+
+    // Any flipped bit fails the checksum
+    for (size_t i = 1; i < compactSize; ++i)
+    {
+        compact.Data()[i] ^= 0x10;
+        assert(!DecodeCompactMessage(
+            compactData,
+            { expanded.Data(), expanded.Capacity() },
+            header));
+        compact.Data()[i] ^= 0x10;
+    }
+
+    // Compressed messages stay version 1
+    const PositionCodec codec(64, 64);
+    StateMessage state;
+    state.count = StateMessage::kMaxEntries;
+
+    const size_t stateSize = Serializer<StateMessage>::Serialize(state, codec, data);
+    const size_t compressedSize = CompressMessage(
+        constData.Subspan(0, stateSize),
+        { expanded.Data(), expanded.Capacity() });
+
+    assert(compressedSize > 0);
+    assert(!EncodeCompactMessage(
+        { expanded.Data(), compressedSize },
+        0,
+        0,
+        0,
+        { compact.Data(), compact.Capacity() }));
+}
+
+void TestBroadcastMessage()
+{
+    using namespace Common;
+
+    NetworkBuffer buffer;
+    NetworkBuffer expected;
+    NetworkBuffer copy;
+
+    Span<uint8_t> data{ buffer.Data(), buffer.Capacity() };
+
+    const PositionCodec codec(64, 64);
+    StateMessage state;
+    state.message.messageId = 7;
+    state.tick = 1234;
+    state.count = 3;
+    for (uint16_t i = 0; i < state.count; ++i)
+    {
+        state.entries[i] = { 10u + i, 20u + i, 30u + i };
+    }
+
+    const size_t size = Serializer<StateMessage>::Serialize(state, codec, data);
+
+    BroadcastMessage broadcast;
+    assert(!broadcast.IsPrepared());
+    assert(broadcast.Prepare({ buffer.Data(), size }));
+    assert(broadcast.GetSize() == size);
+    assert(broadcast.GetCompactSize() == size - kMessageSize + kCompactHeaderSize);
+
+    // Every copy reads back as the message serialized for that recipient,
+    // in either header, and is only signed the other way round
+    for (uint32_t messageId : { 0u, 1u, 0x12345u, UINT32_MAX })
+    {
+        StateMessage recipient = state;
+        recipient.message.messageId = messageId;
+        const size_t expectedSize = Serializer<StateMessage>::Serialize(
+            recipient,
+            codec,
+            { expected.Data(), expected.Capacity() });
+
+        assert(broadcast.Write(messageId, { copy.Data(), copy.Capacity() }) == expectedSize);
+        assert(memcmp(
+            copy.Data() + kMessageHeaderSize,
+            expected.Data() + kMessageHeaderSize,
+            expectedSize - kMessageHeaderSize) == 0);
+
+        std::optional<StateMessage> result = Serializer<StateMessage>::Deserialize(
+            { copy.Data(), expectedSize },
+            codec);
+        assert(result && result->message.messageId == messageId);
+        assert(result->message.header.flags == MessageHeader::kFlagPayloadFirst);
+        assert(result->message.header.payloadSize == recipient.message.header.payloadSize);
+        assert(result->tick == state.tick && result->count == state.count);
+
+        // Re-signing the copy the same way gives the same hash
+        uint8_t headerData[kMessageHeaderSize];
+        MessageHeader resigned = { { 0, 0 }, MessageHeader::kFlagPayloadFirst, 0, 0 };
+        SerializeHeader(
+            resigned,
+            { headerData, sizeof(headerData) },
+            { copy.Data() + kMessageHeaderSize, expectedSize - kMessageHeaderSize });
+        assert(resigned.hash == result->message.header.hash);
+        assert(resigned.hash != recipient.message.header.hash);
+
+        const size_t compactSize = EncodeCompactMessage(
+            { expected.Data(), expectedSize },
+            CompactHeader::kFlagAck,
+            uint16_t(messageId + 3),
+            messageId ^ 0x5555,
+            { expected.Data(), expected.Capacity() });
+
+        assert(broadcast.WriteCompact(
+            messageId,
+            CompactHeader::kFlagAck,
+            uint16_t(messageId + 3),
+            messageId ^ 0x5555,
+            { copy.Data(), copy.Capacity() }) == compactSize);
+
+        // Both expand to the same version 1 message
+        NetworkBuffer decoded;
+        NetworkBuffer decodedCopy;
+        CompactHeader header;
+        assert(DecodeCompactMessage(
+            { expected.Data(), compactSize },
+            { decoded.Data(), decoded.Capacity() },
+            header) == size);
+        assert(header.flags == CompactHeader::kFlagAck);
+        assert(DecodeCompactMessage(
+            { copy.Data(), compactSize },
+            { decodedCopy.Data(), decodedCopy.Capacity() },
+            header) == size);
+        assert(header.flags == (CompactHeader::kFlagAck | CompactHeader::kFlagPayloadFirst));
+        assert(header.sequence == uint16_t(messageId));
+        assert(header.ack == uint16_t(messageId + 3));
+        assert(memcmp(decoded.Data(), decodedCopy.Data(), size) == 0);
+
+        // The flag picks the checksum, a copy without it does not validate
+        copy.Data()[1] &= ~CompactHeader::kFlagPayloadFirst;
+        assert(!DecodeCompactMessage(
+            { copy.Data(), compactSize },
+            { decodedCopy.Data(), decodedCopy.Capacity() },
+            header));
+    }
+
+    // Copies only go where they fit
+    assert(!broadcast.Write(1, { copy.Data(), size - 1 }));
+    assert(!broadcast.WriteCompact(1, 0, 0, 0, { copy.Data(), broadcast.GetCompactSize() - 1 }));
+
+    // Compressed messages are turned away
+    state.count = StateMessage::kMaxEntries;
+    const size_t stateSize = Serializer<StateMessage>::Serialize(state, codec, data);
+    const size_t compressedSize = CompressMessage(
+        { buffer.Data(), stateSize },
+        { expected.Data(), expected.Capacity() });
+
+    assert(compressedSize > 0);
+    assert(!broadcast.Prepare({ expected.Data(), compressedSize }));
+    assert(!broadcast.IsPrepared());
+    assert(!broadcast.Write(1, { copy.Data(), copy.Capacity() }));
 }
 
 void MessageTests()
@@ -142,6 +530,10 @@ void MessageTests()
     TestLoginMessageSerializer();
     TestAckMessageSerializer();
     TestPingMessageSerializer();
+    TestStateMessageSerializer();
+    TestMoveMessageSerializer();
+    TestCompactMessage();
+    TestBroadcastMessage();
     std::cout << "All message tests completed\n";
 }
 }
@@ -0,0 +1,175 @@
+#include "TestMovement.h"
+
+#include "Movement.h"
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+namespace Tests
+{
+void TestOccupancyBitboard()
+{
+    using namespace Common;
+
+    // Rows are padded to whole words, 130 cells take three
+    OccupancyBitboard board(130, 100);
+    assert(board.GetStride() == 3);
+    assert(board.GetMemoryUsage() == 3 * 100 * sizeof(uint64_t));
+
+    assert(!board.Test(5, 5));
+    board.Set(5, 5);
+    board.Set(70, 5);
+    board.Set(129, 99);
+    assert(board.Test(5, 5));
+    assert(board.Test(70, 5));
+    assert(board.Test(129, 99));
+    assert(!board.Test(6, 5));
+    assert(!board.Test(5, 6));
+
+    assert(board.GetRow(0, 5) == (uint64_t(1) << 5));
+    assert(board.GetRow(64, 5) == (uint64_t(1) << 6));
+    assert(board.GetRow(128, 99) == (uint64_t(1) << 1));
+
+    board.Clear(70, 5);
+    board.Clear(70, 5);
+    assert(!board.Test(70, 5));
+    assert(board.GetRow(64, 5) == 0);
+    assert(board.Test(5, 5));
+}
+
+void TestMovementConflicts()
+{
+    using namespace Common;
+
+    MovementSystem movement(16, 16);
+    OccupancyBitboard& board = movement.GetOccupancy();
+
+    // Players 3 and 7 both step into (5, 5), the lower id wins
+    board.Set(4, 5);
+    board.Set(6, 5);
+    assert(movement.Queue(7, Position(4, 5), Movement::Right));
+    assert(movement.Queue(3, Position(6, 5), Movement::Left));
+
+    // Off the board is dropped straight away
+    assert(!movement.Queue(9, Position(0, 0), Movement::Up));
+
+    Span<const MovementSystem::Move> moves = movement.Resolve();
+    assert(moves.size == 1);
+    assert(moves.data[0].playerId == 3);
+    assert(board.Test(5, 5));
+    assert(!board.Test(6, 5));
+    assert(board.Test(4, 5));
+    assert(movement.GetStats().conflicts == 1);
+}
+
+void TestMovementChains()
+{
+    using namespace Common;
+
+    MovementSystem movement(16, 16);
+    OccupancyBitboard& board = movement.GetOccupancy();
+
+    // A line of players all stepping right advances together, whatever
+    // order their inputs arrive in.
+    for (uint32_t x = 1; x <= 4; ++x)
+    {
+        board.Set(x, 0);
+    }
+    for (uint32_t id = 1; id <= 4; ++id)
+    {
+        movement.Queue(id, Position(id, 0), Movement::Right);
+    }
+
+    Span<const MovementSystem::Move> moves = movement.Resolve();
+    assert(moves.size == 4);
+    assert(!board.Test(1, 0));
+    for (uint32_t x = 2; x <= 5; ++x)
+    {
+        assert(board.Test(x, 0));
+    }
+
+    // Two players swapping places block each other
+    board.Set(0, 8);
+    board.Set(1, 8);
+    movement.Queue(10, Position(0, 8), Movement::Right);
+    movement.Queue(11, Position(1, 8), Movement::Left);
+
+    assert(movement.Resolve().size == 0);
+    assert(movement.GetStats().blocked == 2);
+
+    // Only the latest input from a player is applied
+    board.Set(8, 8);
+    movement.Queue(12, Position(8, 8), Movement::Up);
+    movement.Queue(12, Position(8, 8), Movement::Down);
+
+    moves = movement.Resolve();
+    assert(moves.size == 1);
+    assert(moves.data[0].to.y == 9);
+}
+
+void TestMovementDeterministic()
+{
+    using namespace Common;
+
+    // A crowded board resolved from the same inputs in two different
+    // arrival orders ends up identical.
+    constexpr uint32_t kSize = 32;
+    constexpr uint32_t kPlayers = 400;
+
+    std::vector<Position> positions;
+    std::vector<Movement> inputs;
+
+    uint32_t seed = 3;
+    auto Random = [&seed](uint32_t range)
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 8) % range;
+    };
+
+    MovementSystem a(kSize, kSize);
+    MovementSystem b(kSize, kSize);
+
+    for (uint32_t id = 0; id < kPlayers; ++id)
+    {
+        Position pos(Random(kSize), Random(kSize));
+        while (a.GetOccupancy().Test(pos.x, pos.y))
+        {
+            pos = Position(Random(kSize), Random(kSize));
+        }
+
+        positions.push_back(pos);
+        inputs.push_back(Movement(Random(4)));
+        a.GetOccupancy().Set(pos.x, pos.y);
+        b.GetOccupancy().Set(pos.x, pos.y);
+    }
+
+    for (uint32_t id = 0; id < kPlayers; ++id)
+    {
+        a.Queue(id, positions[id], inputs[id]);
+    }
+    for (uint32_t id = kPlayers; id-- > 0;)
+    {
+        b.Queue(id, positions[id], inputs[id]);
+    }
+
+    const size_t accepted = a.Resolve().size;
+    assert(accepted == b.Resolve().size);
+    assert(accepted > 0);
+
+    for (uint32_t y = 0; y < kSize; ++y)
+    {
+        assert(a.GetOccupancy().GetRow(0, y) == b.GetOccupancy().GetRow(0, y));
+    }
+}
+
+void MovementTests()
+{
+    std::cout << "Running movement tests...\n";
+    TestOccupancyBitboard();
+    TestMovementConflicts();
+    TestMovementChains();
+    TestMovementDeterministic();
+    std::cout << "All movement tests completed\n";
+}
+}
@@ -0,0 +1,88 @@
+#include "TestPlayerTable.h"
+
+#include "PlayerTable.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace Tests
+{
+void TestPlayerTableInsertFind()
+{
+    using namespace Common;
+
+    PlayerTable table;
+    table.Reserve(4);
+
+    PlayerHandle a = table.Insert(10);
+    PlayerHandle b = table.Insert(20);
+
+    assert(a && b && a != b);
+    assert(table.Size() == 2);
+    assert(table.Find(10) == a);
+    assert(table.Find(20) == b);
+    assert(!table.Find(30));
+
+    // Ids are unique
+    assert(!table.Insert(10));
+    assert(table.Size() == 2);
+
+    table.GetNextMessage(a) = 5;
+    table.GetAckCount(b) = 7;
+    table.GetInfo(b).port = 8081;
+
+    assert(table.GetId(a) == 10);
+    assert(table.GetNextMessages().data[0] == 5);
+    assert(table.GetAckCounts().data[1] == 7);
+    assert(table.GetHandle(1) == b);
+}
+
+void TestPlayerTableRemove()
+{
+    using namespace Common;
+
+    PlayerTable table;
+
+    PlayerHandle a = table.Insert(1);
+    PlayerHandle b = table.Insert(2);
+    PlayerHandle c = table.Insert(3);
+
+    table.GetNextMessage(c) = 33;
+    table.GetInfo(c).address = "127.0.0.1";
+
+    // Removing from the middle moves the last player into the hole and
+    // its handle keeps resolving to its own data.
+    assert(table.Remove(a));
+    assert(table.Size() == 2);
+    assert(!table.IsAlive(a));
+    assert(!table.Remove(a));
+    assert(table.IsAlive(c));
+    assert(table.GetId(c) == 3);
+    assert(table.GetNextMessage(c) == 33);
+    assert(table.GetInfo(c).address == "127.0.0.1");
+    assert(table.GetHandle(0) == c);
+
+    // A reused slot gets a new generation so the stale handle stays dead
+    PlayerHandle d = table.Insert(4);
+    assert(d.index == a.index);
+    assert(d.generation != a.generation);
+    assert(!table.IsAlive(a));
+    assert(table.IsAlive(d));
+    assert(table.Find(1) != d);
+    assert(table.GetNextMessage(d) == 0);
+
+    assert(table.Remove(b));
+    assert(table.Remove(c));
+    assert(table.Remove(d));
+    assert(table.Size() == 0);
+    assert(!table.Find(3));
+}
+
+void PlayerTableTests()
+{
+    std::cout << "Running player table tests...\n";
+    TestPlayerTableInsertFind();
+    TestPlayerTableRemove();
+    std::cout << "All player table tests completed\n";
+}
+}
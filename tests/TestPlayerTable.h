@@ -0,0 +1,6 @@
+#pragma once
+
+namespace Tests
+{
+void PlayerTableTests();
+}
@@ -0,0 +1,123 @@
+#include "TestPositionCodec.h"
+
+#include "PositionCodec.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace Tests
+{
+void TestPositionCodecSizes()
+{
+    using namespace Common;
+
+    static_assert(BitsFor(1) == 0);
+    static_assert(BitsFor(2) == 1);
+    static_assert(BitsFor(64) == 6);
+    static_assert(BitsFor(65) == 7);
+    static_assert(BitsFor(100000) == 17);
+
+    // The default 64x64 board needs 12 bits instead of the 64 bits of a
+    // Position.
+    PositionCodec codec(64, 64);
+    assert(codec.GetBitsX() == 6);
+    assert(codec.GetBitsY() == 6);
+    assert(codec.GetPositionBits() == 12);
+    assert(codec.GetDeltaBits() == 9);
+    assert(codec.GetEncodedSize(1) == 2);
+    assert(codec.GetEncodedSize(8) == 12);
+}
+
+void TestPositionCodecRoundTrip()
+{
+    using namespace Common;
+
+    PositionCodec codec(64, 48);
+
+    uint8_t buffer[32] = { 0 };
+    BitWriter writer(Span<uint8_t>(buffer, sizeof(buffer)));
+
+    const Position positions[] = {
+        Position(0, 0),
+        Position(63, 47),
+        Position(17, 5),
+    };
+
+    for (const Position& pos : positions)
+    {
+        assert(codec.Encode(writer, pos));
+    }
+
+    // Out of bounds positions are rejected without writing anything
+    assert(!codec.Encode(writer, Position(64, 0)));
+    assert(!codec.Encode(writer, Position()));
+    assert(writer.BitOffset() == 3 * codec.GetPositionBits());
+
+    BitReader reader(Span<const uint8_t>(buffer, writer.Size()));
+
+    for (const Position& expected : positions)
+    {
+        Position pos;
+        assert(codec.Decode(reader, pos));
+        assert(pos.x == expected.x && pos.y == expected.y);
+    }
+}
+
+void TestPositionCodecDelta()
+{
+    using namespace Common;
+
+    PositionCodec codec(64, 64);
+
+    uint8_t buffer[32] = { 0 };
+    BitWriter writer(Span<uint8_t>(buffer, sizeof(buffer)));
+
+    const Position previous(10, 10);
+    const Position small(9, 11);
+    const Position large(40, 2);
+
+    assert(codec.EncodeDelta(writer, previous, small));
+    assert(writer.BitOffset() == codec.GetDeltaBits());
+    assert(codec.EncodeDelta(writer, small, large));
+    assert(writer.BitOffset() == codec.GetDeltaBits() + codec.GetDeltaFallbackBits());
+    // Without a valid previous value the absolute form is used
+    assert(codec.EncodeDelta(writer, Position(), small));
+
+    BitReader reader(Span<const uint8_t>(buffer, writer.Size()));
+    Position pos;
+
+    assert(codec.DecodeDelta(reader, previous, pos));
+    assert(pos.x == small.x && pos.y == small.y);
+    assert(codec.DecodeDelta(reader, small, pos));
+    assert(pos.x == large.x && pos.y == large.y);
+    assert(codec.DecodeDelta(reader, Position(), pos));
+    assert(pos.x == small.x && pos.y == small.y);
+}
+
+void TestBitWriterOverflow()
+{
+    using namespace Common;
+
+    uint8_t buffer[2] = { 0 };
+    BitWriter writer(Span<uint8_t>(buffer, sizeof(buffer)));
+
+    assert(writer.Put(0x3FF, 10));
+    assert(!writer.Put(0x7F, 7));
+    assert(writer.Overflow());
+
+    BitReader reader(Span<const uint8_t>(buffer, sizeof(buffer)));
+    assert(reader.Read(10) == 0x3FF);
+    assert(reader.Read(6) == 0);
+    assert(reader.Read(1) == 0 && reader.Overflow());
+}
+
+void PositionCodecTests()
+{
+    std::cout << "Running position codec tests...\n";
+    TestPositionCodecSizes();
+    TestPositionCodecRoundTrip();
+    TestPositionCodecDelta();
+    TestBitWriterOverflow();
+    std::cout << "All position codec tests completed\n";
+}
+}
@@ -0,0 +1,105 @@
+#include "TestPrediction.h"
+
+#include "Movement.h"
+#include "Prediction.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace Tests
+{
+void TestPredictionRing()
+{
+    using namespace Common;
+
+    Prediction prediction;
+
+    // Every input gets its own tick, even when sent faster than ticks run
+    assert(prediction.GetNextTick(10) == 10);
+    prediction.Push(10, Movement::Right);
+    assert(prediction.GetNextTick(10) == 11);
+    prediction.Push(11, Movement::Right);
+    prediction.Push(12, Movement::Down);
+    assert(prediction.GetNextTick(20) == 20);
+
+    // States for tick 12 include everything stamped before it
+    prediction.Acknowledge(12);
+    assert(prediction.Size() == 1);
+    assert(prediction.Get(0).tick == 12);
+    assert(prediction.Get(0).movement == Movement::Down);
+
+    prediction.Acknowledge(13);
+    assert(prediction.IsEmpty());
+
+    // The ring wraps and forgets the oldest input when full
+    for (uint32_t i = 0; i < Prediction::kCapacity + 3; ++i)
+    {
+        prediction.Push(100 + i, Movement::Left);
+    }
+
+    assert(prediction.Size() == Prediction::kCapacity);
+    assert(prediction.Get(0).tick == 103);
+    assert(prediction.GetStats().dropped == 3);
+    assert(prediction.GetStats().predicted == Prediction::kCapacity + 6);
+}
+
+void TestPredictionReplay()
+{
+    using namespace Common;
+
+    constexpr uint32_t kSize = 8;
+
+    Prediction prediction;
+    Position predicted(3, 3);
+
+    // Three steps right, predicted locally
+    for (uint32_t tick = 0; tick < 3; ++tick)
+    {
+        prediction.Push(tick, Movement::Right);
+        assert(StepPosition(predicted, Movement::Right, kSize, kSize, predicted));
+    }
+    assert(predicted.x == 6);
+
+    // The server ran the first step as predicted, replaying the other two
+    // lands on the same cell
+    auto Replay = [&](Position pos)
+    {
+        for (size_t i = 0; i < prediction.Size(); ++i)
+        {
+            StepPosition(pos, prediction.Get(i).movement, kSize, kSize, pos);
+        }
+        return pos;
+    };
+
+    prediction.Acknowledge(1);
+    Position corrected = Replay(Position(4, 3));
+    prediction.Reconcile(predicted, corrected);
+
+    assert(corrected.x == 6 && corrected.y == 3);
+    assert(prediction.GetStats().mispredicted == 0);
+
+    // The server refused the second step, the replay is one cell short
+    prediction.Acknowledge(2);
+    corrected = Replay(Position(4, 3));
+    prediction.Reconcile(predicted, corrected);
+
+    assert(corrected.x == 5);
+    assert(prediction.GetStats().reconciled == 2);
+    assert(prediction.GetStats().mispredicted == 1);
+    assert(prediction.GetStats().correctionDistance == 1);
+    assert(prediction.GetMispredictionRate() == 0.5);
+
+    // Steps off the board are never predicted
+    Position edge(kSize - 1, 0);
+    assert(!StepPosition(edge, Movement::Right, kSize, kSize, edge));
+    assert(!StepPosition(edge, Movement::Up, kSize, kSize, edge));
+}
+
+void PredictionTests()
+{
+    std::cout << "Running prediction tests...\n";
+    TestPredictionRing();
+    TestPredictionReplay();
+    std::cout << "All prediction tests completed\n";
+}
+}
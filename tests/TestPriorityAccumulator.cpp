@@ -0,0 +1,140 @@
+#include "TestPriorityAccumulator.h"
+
+#include "PriorityAccumulator.h"
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+namespace Tests
+{
+namespace
+{
+void Update(
+    Common::PriorityAccumulator& priority,
+    uint32_t tick,
+    const std::vector<uint32_t>& ids,
+    const std::vector<Common::Position>& positions)
+{
+    priority.Update(tick, { 50, 50 }, 16, { ids.data(), ids.size() },
+        { positions.data(), positions.size() });
+}
+}
+
+void TestPriorityStarvation()
+{
+    using namespace Common;
+
+    PriorityAccumulator priority;
+    const std::vector<uint32_t> ids{ 1, 2, 3, 4 };
+    const std::vector<Position> positions{ { 51, 50 }, { 52, 50 }, { 60, 50 }, { 66, 50 } };
+
+    // Nobody moves and only one fits a tick. The closest goes first but
+    // even the one at the edge of view gets its turn.
+    std::vector<uint32_t> sends(ids.size(), 0);
+    uint32_t maxAge = 0;
+
+    for (uint32_t tick = 1; tick <= 200; ++tick)
+    {
+        Update(priority, tick, ids, positions);
+        maxAge = std::max(maxAge, priority.GetMaxAge(tick));
+
+        Span<const PriorityAccumulator::Entry> picked = priority.Select(tick, 1);
+        assert(picked.size == 1);
+        assert(picked.data[0].priority == 0.0f && picked.data[0].lastSent == tick);
+        assert(priority.GetAge(picked.data[0].id, tick) == 0);
+        sends[picked.data[0].id - 1] += 1;
+    }
+
+    assert(sends[0] >= sends[1] && sends[1] >= sends[2] && sends[2] >= sends[3]);
+    assert(sends[0] > sends[3]);
+    assert(sends[3] > 0);
+    assert(priority.GetStats().maxAge == maxAge);
+    // Gains of 16, 15, 7 and 1 parts share one slot, so the furthest waits
+    // about 39 ticks between sends
+    assert(maxAge >= 30 && maxAge < 50);
+    assert(priority.GetStats().selected == 200);
+    assert(priority.GetStats().deferred == 600);
+}
+
+void TestPriorityMovement()
+{
+    using namespace Common;
+
+    PriorityAccumulator priority;
+    const std::vector<uint32_t> ids{ 1, 2 };
+    std::vector<Position> positions{ { 55, 50 }, { 55, 50 } };
+
+    // Both are new, so both count as moved and the lower id wins the tie
+    Update(priority, 1, ids, positions);
+    Span<const PriorityAccumulator::Entry> picked = priority.Select(1, 1);
+    assert(picked.size == 1 && picked.data[0].id == 1);
+
+    Update(priority, 2, ids, positions);
+    picked = priority.Select(2, 1);
+    assert(picked.size == 1 && picked.data[0].id == 2);
+
+    // From then on the one which keeps moving is sent more often than the
+    // idle one at the same distance
+    uint32_t moving = 0;
+    for (uint32_t tick = 3; tick < 103; ++tick)
+    {
+        positions[0].y = 50 + (tick % 2);
+        Update(priority, tick, ids, positions);
+
+        picked = priority.Select(tick, 1);
+        moving += picked.data[0].id == 1;
+    }
+    assert(moving > 70 && moving < 100);
+
+    // Asking for more than is in view sends all of it
+    Update(priority, 103, ids, positions);
+    picked = priority.Select(103, 8);
+    assert(picked.size == 2);
+}
+
+void TestPriorityVisibility()
+{
+    using namespace Common;
+
+    PriorityAccumulator priority;
+    Update(priority, 1, { 2, 5, 9 }, { { 50, 51 }, { 50, 52 }, { 50, 53 } });
+    assert(priority.Size() == 3);
+    assert(priority.GetLeft().size == 0);
+
+    // Ids which left view are forgotten and new ones start waiting from
+    // the tick they came into view
+    Update(priority, 4, { 5, 7 }, { { 50, 52 }, { 50, 54 } });
+    assert(priority.Size() == 2);
+    assert(priority.GetEntries().data[0].id == 5 && priority.GetEntries().data[1].id == 7);
+    assert(priority.GetAge(5, 4) == 3);
+    assert(priority.GetAge(7, 4) == 0);
+    assert(priority.GetAge(2, 4) == 0);
+    assert(priority.GetMaxAge(4) == 3);
+
+    // Both which left are reported, whether they were sent or not
+    assert(priority.GetLeft().size == 2);
+    assert(priority.GetLeft().data[0] == 2 && priority.GetLeft().data[1] == 9);
+
+    // Nothing selected when nothing fits
+    assert(priority.Select(4, 0).size == 0);
+    assert(priority.GetStats().deferred == 2);
+
+    Update(priority, 5, {}, {});
+    assert(priority.Size() == 0 && priority.GetMaxAge(5) == 0);
+    assert(priority.GetLeft().size == 2);
+
+    // Only for the one Update()
+    Update(priority, 6, {}, {});
+    assert(priority.GetLeft().size == 0);
+}
+
+void PriorityAccumulatorTests()
+{
+    std::cout << "Running priority accumulator tests...\n";
+    TestPriorityStarvation();
+    TestPriorityMovement();
+    TestPriorityVisibility();
+    std::cout << "All priority accumulator tests completed\n";
+}
+}
@@ -0,0 +1,108 @@
+#include "TestRetransmitBuffer.h"
+
+#include "RetransmitBuffer.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace Tests
+{
+void TestRetransmitBufferAcknowledge()
+{
+    using namespace Common;
+    using namespace std::chrono;
+
+    RetransmitBuffer buffer;
+    const RetransmitBuffer::Clock::time_point start;
+    const uint8_t message[] = { 1, 2, 3 };
+
+    assert(buffer.IsEmpty());
+    assert(!buffer.GetNextDeadline());
+    assert(buffer.Find(0).size == 0);
+
+    for (uint32_t seq = 10; seq < 15; ++seq)
+    {
+        buffer.Add(seq, { message, sizeof(message) }, start, milliseconds(200));
+    }
+
+    assert(buffer.Size() == 5);
+    assert(buffer.Find(12).size == sizeof(message) && buffer.Find(12).data[2] == 3);
+    assert(*buffer.GetNextDeadline() == start + milliseconds(200));
+
+    // Selective and cumulative acknowledgements
+    assert(buffer.Acknowledge(13));
+    assert(!buffer.Acknowledge(13));
+    assert(buffer.Find(13).size == 0);
+    assert(buffer.AcknowledgeUpTo(12) == 3);
+    assert(buffer.Size() == 1 && buffer.Find(14).size == sizeof(message));
+
+    // A slot only answers for the sequence it holds
+    assert(!buffer.Acknowledge(14 + RetransmitBuffer::kCapacity));
+    assert(buffer.Find(14 + RetransmitBuffer::kCapacity).size == 0);
+
+    // A message still held when its slot comes around is evicted
+    buffer.Add(14 + RetransmitBuffer::kCapacity, { message, 1 }, start, milliseconds(200));
+    assert(buffer.Size() == 1);
+    assert(buffer.Find(14).size == 0);
+    assert(buffer.GetStats().evicted == 1);
+
+    // Cumulative acknowledgements work across the sequence wrapping
+    RetransmitBuffer wrapping;
+    wrapping.Add(UINT32_MAX - 1, { message, 1 }, start, milliseconds(200));
+    wrapping.Add(UINT32_MAX, { message, 1 }, start, milliseconds(200));
+    wrapping.Add(0, { message, 1 }, start, milliseconds(200));
+    wrapping.Add(1, { message, 1 }, start, milliseconds(200));
+    assert(wrapping.AcknowledgeUpTo(0) == 3);
+    assert(wrapping.Size() == 1 && wrapping.Find(1).size == 1);
+}
+
+void TestRetransmitBufferResend()
+{
+    using namespace Common;
+    using namespace std::chrono;
+
+    RetransmitBuffer buffer;
+    const RetransmitBuffer::Clock::time_point start;
+    const uint8_t message[] = { 7 };
+
+    buffer.Add(1, { message, 1 }, start, milliseconds(100));
+    buffer.Add(2, { message, 1 }, start + milliseconds(50), milliseconds(100));
+
+    // Only what is overdue goes out again
+    assert(buffer.TakeDue(start + milliseconds(99)).size == 0);
+
+    Span<const uint32_t> due = buffer.TakeDue(start + milliseconds(100));
+    assert(due.size == 1 && due.data[0] == 1);
+
+    // The resent message backs off to twice its timeout
+    assert(*buffer.GetNextDeadline() == start + milliseconds(150));
+    due = buffer.TakeDue(start + milliseconds(300));
+    assert(due.size == 2 && due.data[0] == 1 && due.data[1] == 2);
+    assert(*buffer.GetNextDeadline() == start + milliseconds(500));
+
+    // Timeouts stop growing at the ceiling and the message is given up on
+    // after its last send
+    RetransmitBuffer::Clock::time_point now = start + milliseconds(300);
+    uint32_t sends = 2;
+
+    while (buffer.Find(2).size != 0)
+    {
+        now += RetransmitBuffer::kMaxTimeout;
+        sends += buffer.TakeDue(now).size != 0 && buffer.Find(2).size != 0;
+    }
+
+    assert(sends == RetransmitBuffer::kMaxSends);
+    assert(buffer.IsEmpty());
+    assert(buffer.GetStats().abandoned == 2);
+    assert(buffer.GetStats().stored == 2);
+    assert(buffer.GetStats().acknowledged == 0);
+}
+
+void RetransmitBufferTests()
+{
+    std::cout << "Running retransmit buffer tests...\n";
+    TestRetransmitBufferAcknowledge();
+    TestRetransmitBufferResend();
+    std::cout << "All retransmit buffer tests completed\n";
+}
+}
@@ -0,0 +1,258 @@
+#include "TestRoomManager.h"
+
+#include "Message.h"
+#include "RoomManager.h"
+#include "Serializer.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+namespace Tests
+{
+namespace
+{
+using Clock = Common::RoomManager::Clock;
+
+// Time the rooms are run on, moved on by the tests and the rooms' ticks
+// alone
+struct TestClock
+{
+    Clock::time_point now{ Clock::time_point() + std::chrono::seconds(10) };
+
+    std::function<Clock::time_point()> Get()
+    {
+        return [this] { return now; };
+    }
+};
+
+// Counts the pings it is handed, and can be made to take its time over
+// each tick
+class RoomGame final : public Common::Game
+{
+public:
+    RoomGame(
+        Common::Game::Params params,
+        TestClock* clock = nullptr,
+        std::chrono::milliseconds tickCost = {})
+        : Game(params)
+        , mClock(clock)
+        , mTickCost(tickCost)
+    { }
+
+    bool Tick() override
+    {
+        if (mClock)
+        {
+            mClock->now += mTickCost;
+        }
+
+        return Game::Tick();
+    }
+
+    uint64_t pings{ 0 };
+
+protected:
+    void HandleLogin(LoginEvent*) override { }
+    void HandlePing(PingEvent*) override { ++pings; }
+    void HandleAcknowledge(AcknowledgeEvent*) override { }
+    void HandleState(StateEvent*) override { }
+    void HandleMove(MoveEvent*) override { }
+
+private:
+    TestClock* mClock{ nullptr };
+    std::chrono::milliseconds mTickCost;
+};
+
+// A ping, behind a room header unless room is zero
+Common::NetworkMessage MakePing(uint32_t room)
+{
+    using namespace Common;
+
+    NetworkMessage msg;
+    msg.address = "127.0.0.1";
+    msg.port = 9000;
+
+    const size_t offset = room ? WriteRoomHeader(room, { msg.buffer.Data(), msg.buffer.Capacity() }) : 0;
+
+    PingMessage ping;
+    const size_t size = Serializer<PingMessage>::Serialize(
+        ping,
+        { msg.buffer.Data() + offset, msg.buffer.Capacity() - offset });
+    assert(size > 0);
+
+    msg.buffer.SetOffset(offset + size);
+    return msg;
+}
+
+}
+
+void TestRoomHeader()
+{
+    using namespace Common;
+
+    uint8_t buffer[kRoomHeaderSize];
+    uint32_t room = 0;
+
+    assert(WriteRoomHeader(0x01020304, { buffer, sizeof(buffer) }) == kRoomHeaderSize);
+    assert(IsRoomAddressed({ buffer, sizeof(buffer) }));
+    assert(ReadRoomHeader({ buffer, sizeof(buffer) }, room) && room == 0x01020304);
+
+    assert(!WriteRoomHeader(1, { buffer, kRoomHeaderSize - 1 }));
+    assert(!ReadRoomHeader({ buffer, kRoomHeaderSize - 1 }, room));
+
+    // Other headers are never taken for a room header
+    const NetworkMessage ping = MakePing(0);
+    assert(!IsRoomAddressed({ ping.buffer.Data(), ping.buffer.Size() }));
+}
+
+void TestRoomManagerRouting()
+{
+    using namespace Common;
+
+    TestClock clock;
+
+    RoomManager::Params params;
+    params.workers = 0;
+    params.maxInbox = 2;
+    params.clock = clock.Get();
+
+    RoomManager rooms(params);
+    const uint32_t first = rooms.CreateRoom(std::make_unique<RoomGame>(Game::Params{}));
+    const uint32_t second = rooms.CreateRoom(std::make_unique<RoomGame>(Game::Params{}));
+    assert(first == 1 && second == 2);
+
+    // Queued until the room runs, up to the inbox bound
+    assert(rooms.Route(MakePing(second)));
+    assert(rooms.Route(MakePing(second)));
+    assert(!rooms.Route(MakePing(second)));
+    assert(rooms.GetRoomStats(second).received == 2);
+    assert(rooms.GetRoomStats(second).dropped == 1);
+
+    // Datagrams without a room go to the first room, those for a room
+    // which does not exist nowhere
+    assert(rooms.Route(MakePing(0)));
+    assert(!rooms.Route(MakePing(99)));
+    assert(rooms.GetUnrouted() == 1);
+
+    NetworkMessage garbage = MakePing(first);
+    garbage.buffer.Data()[kRoomHeaderSize] ^= 0xFF;
+    assert(rooms.Route(garbage));
+
+    rooms.Start();
+    assert(rooms.RunDue() == 2);
+    rooms.Stop();
+
+    const auto* a = static_cast<const RoomGame*>(rooms.GetGame(first));
+    const auto* b = static_cast<const RoomGame*>(rooms.GetGame(second));
+    assert(a->pings == 1);
+    assert(b->pings == 2);
+    assert(rooms.GetRoomStats(first).invalid == 1);
+    assert(rooms.GetRoomStats(second).invalid == 0);
+
+    // Once stopped the inboxes are simply held
+    assert(rooms.Route(MakePing(first)));
+    assert(a->pings == 1);
+}
+
+void TestRoomManagerSchedule()
+{
+    using namespace Common;
+    using namespace std::chrono;
+    using Clock = RoomManager::Clock;
+
+    const Clock::time_point due = Clock::time_point() + seconds(10);
+    const milliseconds interval(5);
+    const milliseconds budget(2);
+
+    // On time and under budget keeps the cadence
+    RoomManager::Schedule schedule = RoomManager::ScheduleNext(
+        due, due, due + milliseconds(1), interval, budget);
+    assert(schedule.next == due + interval);
+    assert(!schedule.late && !schedule.throttled);
+
+    // Started a little behind, still on the cadence
+    schedule = RoomManager::ScheduleNext(
+        due, due + milliseconds(3), due + milliseconds(4), interval, budget);
+    assert(schedule.next == due + interval);
+    assert(!schedule.late && !schedule.throttled);
+
+    // A whole interval behind carries on from the end of the run rather
+    // than catching up
+    schedule = RoomManager::ScheduleNext(
+        due, due + milliseconds(12), due + milliseconds(13), interval, budget);
+    assert(schedule.next == due + milliseconds(13));
+    assert(schedule.late && !schedule.throttled);
+
+    // Over budget is held back by as much as it went over
+    schedule = RoomManager::ScheduleNext(
+        due, due, due + milliseconds(10), interval, budget);
+    assert(schedule.next == due + milliseconds(18));
+    assert(!schedule.late && schedule.throttled);
+
+    // Only just over budget is never brought forward of the cadence
+    schedule = RoomManager::ScheduleNext(
+        due, due, due + milliseconds(3), interval, budget);
+    assert(schedule.next == due + interval);
+    assert(schedule.throttled);
+}
+
+void TestRoomManagerThrottle()
+{
+    using namespace Common;
+    using namespace std::chrono;
+
+    TestClock clock;
+
+    RoomManager::Params params;
+    params.workers = 0;
+    params.tickBudget = milliseconds(2);
+    params.clock = clock.Get();
+
+    Game::Params gameParams;
+    gameParams.tickInterval = milliseconds(5);
+
+    RoomManager rooms(params);
+    const uint32_t hot = rooms.CreateRoom(
+        std::make_unique<RoomGame>(gameParams, &clock, milliseconds(10)));
+    const uint32_t cold = rooms.CreateRoom(
+        std::make_unique<RoomGame>(gameParams, &clock, milliseconds(1)));
+
+    // 100ms of run time a millisecond at a time, the clock also moving on
+    // by what each tick costs
+    const Clock::time_point end = clock.now + milliseconds(100);
+
+    rooms.Start();
+    while (clock.now < end)
+    {
+        rooms.RunDue();
+        clock.now += milliseconds(1);
+    }
+    rooms.Stop();
+
+    const RoomManager::RoomStats hotStats = rooms.GetRoomStats(hot);
+    const RoomManager::RoomStats coldStats = rooms.GetRoomStats(cold);
+
+    // Every tick of the hot room went over budget and was held back by
+    // 8ms on top of its 10ms, so it came round every 18ms or so
+    assert(hotStats.ticks >= 5 && hotStats.ticks <= 7);
+    assert(hotStats.throttled == hotStats.ticks);
+    assert(hotStats.busyTime == hotStats.ticks * milliseconds(10));
+    assert(hotStats.maxTickTime == milliseconds(10));
+
+    // The cold room kept to its budget and ticked far more often
+    assert(coldStats.throttled == 0);
+    assert(coldStats.ticks > 2 * hotStats.ticks);
+    assert(coldStats.maxTickTime == milliseconds(1));
+}
+
+void RoomManagerTests()
+{
+    std::cout << "Running room manager tests...\n";
+    TestRoomHeader();
+    TestRoomManagerRouting();
+    TestRoomManagerSchedule();
+    TestRoomManagerThrottle();
+    std::cout << "All room manager tests completed\n";
+}
+}
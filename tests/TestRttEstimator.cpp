@@ -0,0 +1,98 @@
+#include "TestRttEstimator.h"
+
+#include "RttEstimator.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace Tests
+{
+void TestRttEstimatorSmoothing()
+{
+    using namespace Common;
+    using namespace std::chrono;
+
+    RttEstimator rtt;
+    assert(!rtt.HasSample());
+    assert(rtt.GetRto() == RttEstimator::kInitialRto);
+
+    // The first sample sets the average and half of it as the variance
+    rtt.AddSample(milliseconds(100));
+    assert(rtt.GetSmoothedRtt() == milliseconds(100));
+    assert(rtt.GetRttVariance() == milliseconds(50));
+    assert(rtt.GetRto() == milliseconds(300));
+
+    // Later ones move the average an eighth and the variance a quarter
+    rtt.AddSample(milliseconds(200));
+    assert(rtt.GetRttVariance() == microseconds(62500));
+    assert(rtt.GetSmoothedRtt() == microseconds(112500));
+    assert(rtt.GetRto() == microseconds(362500));
+    assert(rtt.GetMinRtt() == milliseconds(100));
+    assert(rtt.GetLatestRtt() == milliseconds(200));
+
+    // A steady link settles on its round trip with a tight timeout
+    for (uint32_t i = 0; i < 200; ++i)
+    {
+        rtt.AddSample(milliseconds(20));
+    }
+    assert(rtt.GetSmoothedRtt() < microseconds(20100));
+    assert(rtt.GetRto() == RttEstimator::kMinRto);
+    assert(rtt.GetMinRtt() == milliseconds(20));
+
+    // And the timeout never runs away on a terrible one
+    RttEstimator slow;
+    slow.AddSample(seconds(5));
+    assert(slow.GetRto() == RttEstimator::kMaxRto);
+}
+
+void TestClockOffsetEstimator()
+{
+    using namespace Common;
+
+    // The remote clock is 5 seconds ahead, 10ms each way and a 2ms hold
+    ClockOffsetEstimator clock;
+    const uint32_t offset = 5000000;
+
+    assert(!clock.HasOffset());
+    assert(clock.AddSample(1000, 11000 + offset, 13000 + offset, 23000));
+    assert(clock.GetOffset() == offset);
+    assert(clock.ToRemote(100) == 100 + offset);
+
+    // A lopsided exchange over a slower round trip is outweighed by the
+    // fast one still in the window
+    assert(clock.AddSample(30000, 70000 + offset, 70000 + offset, 80000));
+    assert(clock.GetOffset() == offset);
+
+    // Replies from before they were sent are rejected
+    assert(!clock.AddSample(1000, offset, offset + 10, 500));
+    assert(!clock.AddSample(1000, offset + 100, offset, 2000));
+    assert(clock.GetSampleCount() == 2);
+
+    // Clocks which wrap between the two ends
+    ClockOffsetEstimator wrapped;
+    const uint32_t behind = uint32_t(0) - 3000;
+
+    assert(wrapped.AddSample(1000, 1500 + behind, 1600 + behind, 2100));
+    assert(wrapped.GetOffset() == behind);
+    assert(wrapped.ToRemote(2000) == uint32_t(2000 - 3000));
+
+    // Drift is followed a little at a time
+    ClockOffsetEstimator drifting;
+    drifting.AddSample(0, 1000, 1000, 2000);
+
+    for (uint32_t i = 1; i <= 64; ++i)
+    {
+        const uint32_t now = i * 10000;
+        drifting.AddSample(now, now + 1000 + 800, now + 1000 + 800, now + 2000);
+    }
+    assert(drifting.GetOffset() > 790 && drifting.GetOffset() <= 800);
+}
+
+void RttEstimatorTests()
+{
+    std::cout << "Running round trip estimator tests...\n";
+    TestRttEstimatorSmoothing();
+    TestClockOffsetEstimator();
+    std::cout << "All round trip estimator tests completed\n";
+}
+}
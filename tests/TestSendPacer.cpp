@@ -0,0 +1,147 @@
+#include "TestSendPacer.h"
+
+#include "SendPacer.h"
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+namespace Tests
+{
+void TestSendPacerBucket()
+{
+    using namespace Common;
+    using namespace std::chrono;
+
+    // A full datagram worth of bucket at the lowest rate
+    SendPacer pacer(SendPacer::kMinRate);
+    const SendPacer::Clock::time_point start = SendPacer::Clock::time_point{} + seconds(1);
+    const std::vector<uint8_t> packet(1000, 0xAB);
+
+    assert(pacer.GetRate() == SendPacer::kMinRate);
+    assert(!pacer.Next(start));
+
+    for (uint32_t sequence = 0; sequence < 4; ++sequence)
+    {
+        pacer.Push(sequence, { packet.data(), packet.size() }, start);
+    }
+    assert(pacer.GetQueueDepth() == 4);
+
+    // The first two fit, the second taking the bucket into debt
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        const NetworkBuffer* next = pacer.Next(start);
+        assert(next && next->Size() == packet.size() && next->Data()[0] == 0xAB);
+        pacer.Pop(start);
+    }
+    assert(!pacer.Next(start));
+
+    // The rest wait for the bucket to refill, 8 KB/s is 1000 bytes in
+    // about 122ms
+    assert(!pacer.Next(start + milliseconds(60)));
+    assert(pacer.Next(start + milliseconds(120)));
+    pacer.Pop(start + milliseconds(120));
+    assert(!pacer.Next(start + milliseconds(120)));
+    assert(pacer.Next(start + milliseconds(250)));
+    pacer.Pop(start + milliseconds(250));
+    assert(pacer.IsEmpty());
+
+    const SendPacer::Stats& stats = pacer.GetStats();
+    assert(stats.sent == 4 && stats.bytesSent == 4 * packet.size());
+    assert(stats.delayed == 2);
+    assert(stats.maxDelay == milliseconds(250));
+    assert(stats.maxQueue == 4);
+
+    // A full queue drops its oldest packet
+    for (uint32_t sequence = 0; sequence < SendPacer::kQueueCapacity + 3; ++sequence)
+    {
+        pacer.Push(sequence, { packet.data(), 1 }, start);
+    }
+    assert(pacer.GetQueueDepth() == SendPacer::kQueueCapacity);
+    assert(pacer.GetStats().dropped == 3);
+}
+
+void TestSendPacerAdaptation()
+{
+    using namespace Common;
+    using namespace std::chrono;
+
+    SendPacer pacer;
+    RttEstimator rtt;
+    SendPacer::Clock::time_point now = SendPacer::Clock::time_point{} + seconds(1);
+    const uint8_t packet[100] = {};
+    uint32_t sequence = 0;
+
+    auto send = [&](uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            pacer.Push(sequence++, { packet, sizeof(packet) }, now);
+            assert(pacer.Next(now));
+            pacer.Pop(now);
+        }
+    };
+
+    // Everything delivered, the rate climbs
+    rtt.AddSample(milliseconds(40));
+    send(4);
+    now += milliseconds(40);
+    pacer.OnAck(sequence - 1, 0b111, rtt, now);
+
+    assert(pacer.GetRate() == SendPacer::kInitialRate + SendPacer::kRateIncrease);
+    assert(pacer.GetStats().delivered == 4 && pacer.GetStats().lost == 0);
+
+    // Acknowledgements which do not move forward change nothing
+    pacer.OnAck(sequence - 2, 0, rtt, now);
+    assert(pacer.GetStats().delivered == 4);
+
+    // A hole in the bitfield is a loss and cuts the rate
+    const uint32_t rate = pacer.GetRate();
+    send(4);
+    now += milliseconds(40);
+    pacer.OnAck(sequence - 1, 0b101, rtt, now);
+
+    assert(pacer.GetStats().lost == 1 && pacer.GetStats().delivered == 7);
+    assert(pacer.GetRate() == rate / 4 * 3);
+    assert(pacer.GetStats().decreases == 1);
+
+    // At most one cut per round trip
+    send(2);
+    pacer.OnAck(sequence - 1, 0, rtt, now + milliseconds(1));
+    assert(pacer.GetStats().lost == 2);
+    assert(pacer.GetStats().decreases == 1);
+
+    // Round trips growing well past the lowest mean a queue is building
+    for (uint32_t i = 0; i < 32 && pacer.GetStats().decreases < 3; ++i)
+    {
+        rtt.AddSample(milliseconds(400));
+        send(1);
+        now += milliseconds(400);
+        pacer.OnAck(sequence - 1, ~0u, rtt, now);
+    }
+
+    assert(pacer.GetStats().decreases == 3);
+    assert(rtt.GetSmoothedRtt() - rtt.GetMinRtt() > SendPacer::kMaxQueueingDelay);
+
+    // The rate never falls below the floor
+    SendPacer slow(SendPacer::kMinRate);
+
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        slow.Push(i, { packet, sizeof(packet) }, now);
+        assert(slow.Next(now));
+        slow.Pop(now);
+        now += seconds(1);
+        slow.OnAck(i + 1, 0, rtt, now);
+    }
+    assert(slow.GetRate() == SendPacer::kMinRate);
+}
+
+void SendPacerTests()
+{
+    std::cout << "Running send pacer tests...\n";
+    TestSendPacerBucket();
+    TestSendPacerAdaptation();
+    std::cout << "All send pacer tests completed\n";
+}
+}
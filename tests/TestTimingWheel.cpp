@@ -0,0 +1,136 @@
+#include "TestTimingWheel.h"
+
+#include "TimingWheel.h"
+
+#include <cassert>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace Tests
+{
+void TestTimingWheelBasic()
+{
+    using namespace Common;
+
+    TimingWheel wheel(1000);
+
+    TimerHandle a = wheel.Schedule(1010, { 1, 10 });
+    TimerHandle b = wheel.Schedule(1005, { 2, 20 });
+    TimerHandle c = wheel.Schedule(1010 + 5000, { 3, 30 });
+    assert(wheel.Size() == 3);
+
+    assert(wheel.Advance(1004).size == 0);
+
+    Span<const TimingWheel::Timer> expired = wheel.Advance(1010);
+    assert(expired.size == 2);
+    assert(expired.data[0].kind == 2 && expired.data[0].data == 20);
+    assert(expired.data[1].kind == 1 && expired.data[1].data == 10);
+    assert(!wheel.IsPending(a) && !wheel.IsPending(b));
+
+    // Fired handles are dead even when their node is reused
+    TimerHandle d = wheel.Schedule(1020, { 4, 40 });
+    assert(d.index == a.index || d.index == b.index);
+    assert(!wheel.Cancel(a) && !wheel.Cancel(b));
+    assert(wheel.IsPending(d));
+
+    // Rescheduling moves a timer either way
+    assert(wheel.Reschedule(c, 1015));
+    assert(wheel.Reschedule(d, 1030));
+    expired = wheel.Advance(1025);
+    assert(expired.size == 1 && expired.data[0].kind == 3);
+
+    assert(wheel.Cancel(d));
+    assert(!wheel.IsPending(d));
+    assert(wheel.Size() == 0);
+    assert(wheel.Advance(2000).size == 0);
+
+    // Timers in the past fire on the next advance
+    wheel.Schedule(10, { 5, 50 });
+    expired = wheel.Advance(2001);
+    assert(expired.size == 1 && expired.data[0].kind == 5);
+}
+
+void TestTimingWheelMatchesReference()
+{
+    using namespace Common;
+
+    // Delays covering every level and the overflow list, checked against a
+    // sorted map of due times
+    TimingWheel wheel(123);
+    std::multimap<uint64_t, uint64_t> reference;
+    std::vector<TimerHandle> handles;
+    std::vector<uint64_t> due;
+
+    uint32_t seed = 7;
+    auto Random = [&seed]()
+    {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 8;
+    };
+
+    const uint64_t delays[] = { 1, 63, 64, 65, 4095, 4097, 262143, 262145, 16777215,
+        16777217, 40000000 };
+
+    for (uint64_t id = 0; id < 2000; ++id)
+    {
+        const uint64_t when = 123 + delays[id % std::size(delays)] + Random() % 100;
+        handles.push_back(wheel.Schedule(when, { 0, id }));
+        due.push_back(when);
+    }
+
+    // Cancel and move a few
+    for (uint64_t id = 0; id < handles.size(); id += 7)
+    {
+        if (id % 2)
+        {
+            assert(wheel.Cancel(handles[id]));
+            due[id] = 0;
+        }
+        else
+        {
+            due[id] = 200 + Random() % 100000;
+            assert(wheel.Reschedule(handles[id], due[id]));
+        }
+    }
+
+    for (uint64_t id = 0; id < due.size(); ++id)
+    {
+        if (due[id])
+        {
+            reference.emplace(due[id], id);
+        }
+    }
+
+    assert(wheel.Size() == reference.size());
+
+    uint64_t now = 123;
+    while (wheel.Size())
+    {
+        now += 1 + Random() % 200000;
+
+        Span<const TimingWheel::Timer> expired = wheel.Advance(now);
+
+        for (size_t i = 0; i < expired.size; ++i)
+        {
+            const uint64_t id = expired.data[i].data;
+
+            // Earliest first, never early and never missed
+            assert(reference.begin()->first == due[id]);
+            assert(due[id] <= now);
+            reference.erase(reference.begin());
+        }
+
+        assert(reference.empty() || reference.begin()->first > now);
+    }
+}
+
+void TimingWheelTests()
+{
+    std::cout << "Running timing wheel tests...\n";
+    TestTimingWheelBasic();
+    TestTimingWheelMatchesReference();
+    std::cout << "All timing wheel tests completed\n";
+}
+}
@@ -0,0 +1,83 @@
+#include "TestWorldGrid.h"
+
+#include "Player.h"
+#include "WorldGrid.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace Tests
+{
+void TestWorldGridDense()
+{
+    using namespace Common;
+
+    // Not square so a swapped width and height would show up
+    WorldGrid grid(48, 32, WorldGrid::Backend::Dense);
+
+    assert(grid.IsValid(47, 31));
+    assert(!grid.IsValid(48, 0));
+    assert(!grid.IsValid(0, 32));
+
+    PositionState* cell = grid.Get(47, 31);
+    assert(cell->pos.x == 47 && cell->pos.y == 31);
+    assert(grid.Find(5, 7)->pos.x == 5);
+    assert(grid.GetMemoryUsage() == 48 * 32 * sizeof(PositionState));
+}
+
+void TestWorldGridChunked()
+{
+    using namespace Common;
+
+    // Far too large to allocate densely
+    constexpr uint32_t kSize = 100000;
+    WorldGrid grid(kSize, kSize, WorldGrid::Backend::Chunked);
+
+    assert(grid.IsValid(kSize - 1, kSize - 1));
+    assert(!grid.IsValid(kSize, 0));
+    assert(grid.GetTileCount() == 0);
+    assert(!grid.Find(99999, 12345));
+    assert(!grid.GetPlayer(99999, 12345));
+
+    Player a;
+    Player b;
+
+    grid.SetPlayer(99999, 12345, &a);
+    assert(grid.GetTileCount() == 1);
+    assert(grid.GetPlayer(99999, 12345) == &a);
+
+    const PositionState* cell = grid.Find(99999, 12345);
+    assert(cell && cell->pos.x == 99999 && cell->pos.y == 12345);
+
+    // Same tile, then a different one
+    grid.SetPlayer(99998, 12346, &b);
+    assert(grid.GetTileCount() == 1);
+    grid.SetPlayer(0, 0, &b);
+    assert(grid.GetTileCount() == 2);
+    assert(grid.GetMemoryUsage() < 1024 * 1024);
+
+    // Tiles are freed once their last player leaves
+    grid.SetPlayer(99999, 12345, nullptr);
+    assert(grid.GetTileCount() == 2);
+    grid.SetPlayer(99998, 12346, nullptr);
+    assert(grid.GetTileCount() == 1);
+    assert(!grid.Find(99999, 12345));
+
+    // Clearing an empty cell is harmless
+    grid.SetPlayer(50000, 50000, nullptr);
+    assert(grid.GetTileCount() == 1);
+
+    // Get() allocates the tile so the cell can be used
+    PositionState* got = grid.Get(70000, 1);
+    assert(got->pos.x == 70000 && got->pos.y == 1);
+    assert(grid.GetTileCount() == 2);
+}
+
+void WorldGridTests()
+{
+    std::cout << "Running world grid tests...\n";
+    TestWorldGridDense();
+    TestWorldGridChunked();
+    std::cout << "All world grid tests completed\n";
+}
+}
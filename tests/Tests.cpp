@@ -1,6 +1,25 @@
 #include "Tests.h"
 
+#include "TestAckWindow.h"
+#include "TestCheckpoint.h"
+#include "TestCompression.h"
+#include "TestFragment.h"
+#include "TestInterest.h"
+#include "TestInterpolation.h"
+#include "TestJitterBuffer.h"
+#include "TestJobSystem.h"
 #include "TestMessages.h"
+#include "TestMovement.h"
+#include "TestPlayerTable.h"
+#include "TestPositionCodec.h"
+#include "TestPrediction.h"
+#include "TestPriorityAccumulator.h"
+#include "TestRetransmitBuffer.h"
+#include "TestRoomManager.h"
+#include "TestRttEstimator.h"
+#include "TestSendPacer.h"
+#include "TestTimingWheel.h"
+#include "TestWorldGrid.h"
 
 #include <iostream>
 
@@ -10,6 +29,25 @@ void RunAllTests()
 {
     std::cout << "Running all tests...\n";
     MessageTests();
+    PositionCodecTests();
+    CompressionTests();
+    PlayerTableTests();
+    WorldGridTests();
+    InterestTests();
+    MovementTests();
+    JitterBufferTests();
+    PredictionTests();
+    InterpolationTests();
+    TimingWheelTests();
+    RetransmitBufferTests();
+    AckWindowTests();
+    SendPacerTests();
+    PriorityAccumulatorTests();
+    RttEstimatorTests();
+    FragmentTests();
+    RoomManagerTests();
+    JobSystemTests();
+    CheckpointTests();
     std::cout << "All tests successfully passed\n";
 }
 }